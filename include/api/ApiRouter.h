@@ -0,0 +1,154 @@
+#ifndef API_ROUTER_H
+#define API_ROUTER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Path-trie router for one URL namespace (e.g. /api)
+ *
+ * Mounted as a single AsyncWebHandler, so a request is matched once
+ * instead of against every registered handler in turn. Routes are
+ * compiled into a trie of path segments when setupWebServer() runs; a
+ * lookup walks one node per segment (binary search over the literal
+ * children, then the parameter child) and never allocates.
+ *
+ * Patterns are relative to the namespace and may contain typed
+ * parameters:
+ *
+ *   api.on("/aquariums/{id:uint}", HTTP_GET, handler);
+ *   api.on("/devices/{mac:mac}/schedules", HTTP_GET, handler);
+ *
+ *  - uint: decimal, fits in 32 bits
+ *  - mac:  AA:BB:CC:DD:EE:FF (either case)
+ *  - str:  any non-empty segment
+ *
+ * A segment that fails its type does not match, so the next candidate
+ * (or a 404) is used rather than the handler seeing bad input. Literal
+ * segments win over parameters. Anything under the namespace that no
+ * route matches is answered here: 404, or 405 with an Allow header when
+ * only the method is wrong. Requests outside the namespace are left to
+ * the other handlers.
+ */
+class ApiRouter : public AsyncWebHandler {
+public:
+    static constexpr uint8_t MAX_PARAMS = 4;
+    static constexpr uint8_t MAX_DEPTH = 8;            // Segments per path
+
+    enum class ParamType : uint8_t {
+        NONE,
+        UINT,
+        MAC,
+        STRING
+    };
+
+    /**
+     * @brief Path parameters of the matched route
+     */
+    class Params {
+    public:
+        Params() : _count(0) {}
+
+        uint8_t count() const { return _count; }
+        bool has(const char* name) const { return _find(name) != nullptr; }
+
+        uint32_t getUint(const char* name) const;
+        const uint8_t* getMac(const char* name) const;     // nullptr if absent
+        String getString(const char* name) const;
+
+    private:
+        friend class ApiRouter;
+
+        struct Value {
+            const char* name;
+            ParamType type;
+            const char* text;       // Points into the request path
+            uint8_t length;
+            uint32_t number;
+            uint8_t mac[6];
+        };
+
+        Value _values[MAX_PARAMS];
+        uint8_t _count;
+
+        const Value* _find(const char* name) const;
+    };
+
+    typedef std::function<void(AsyncWebServerRequest*, const Params&)> RequestHandler;
+    typedef std::function<void(AsyncWebServerRequest*, const Params&,
+                               uint8_t*, size_t, size_t, size_t)> BodyHandler;
+
+    /**
+     * @param prefix Namespace, without trailing slash
+     */
+    explicit ApiRouter(const char* prefix);
+
+    /**
+     * @brief Register a route
+     * @param pattern Path below the namespace, e.g. "/aquariums/{id:uint}"
+     * @param methods HTTP method mask
+     * @param onRequest Called when the request is complete
+     * @param onBody Called per body chunk (index, total as AsyncWebServer)
+     * @return false if the pattern is malformed or already registered
+     */
+    bool on(const char* pattern, WebRequestMethodComposite methods, RequestHandler onRequest,
+            BodyHandler onBody = nullptr);
+
+    size_t getRouteCount() const { return _routes.size(); }
+    size_t getNodeCount() const { return _nodes.size(); }
+
+    /**
+     * @brief Match a path below the namespace (no allocation)
+     * @param path Path with the namespace already stripped
+     * @param length Path length
+     * @param method Request method
+     * @param params Receives the typed parameters
+     * @param allowed Receives the methods the path accepts (for 405)
+     * @return Route index, -1 if none matches path and method
+     */
+    int match(const char* path, size_t length, WebRequestMethodComposite method,
+              Params& params, WebRequestMethodComposite& allowed) const;
+
+    // ===== AsyncWebHandler =====
+    bool canHandle(AsyncWebServerRequest* request) override;
+    void handleRequest(AsyncWebServerRequest* request) override;
+    void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                    size_t index, size_t total) override;
+    bool isRequestHandlerTrivial() override { return false; }
+
+private:
+    struct Edge {
+        String literal;
+        uint16_t node;
+    };
+
+    struct Node {
+        std::vector<Edge> literals;     // Sorted by literal
+        int16_t paramChild;             // -1 = none
+        ParamType paramType;
+        String paramName;
+        std::vector<uint16_t> routes;   // Routes ending here (one per method set)
+    };
+
+    struct Route {
+        WebRequestMethodComposite methods;
+        RequestHandler onRequest;
+        BodyHandler onBody;
+    };
+
+    String _prefix;
+    std::vector<Node> _nodes;           // _nodes[0] is the namespace root
+    std::vector<Route> _routes;
+
+    bool _inNamespace(AsyncWebServerRequest* request, const char*& path, size_t& length) const;
+    int _resolve(AsyncWebServerRequest* request, Params& params, WebRequestMethodComposite& allowed) const;
+    bool _walk(uint16_t node, const char* path, size_t length, size_t pos, Params& params,
+               int16_t& found) const;
+    uint16_t _addNode();
+    static bool _parseParam(ParamType type, const char* text, size_t length, Params::Value& value);
+    static String _allowHeader(WebRequestMethodComposite methods);
+};
+
+#endif // API_ROUTER_H
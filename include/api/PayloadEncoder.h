@@ -0,0 +1,89 @@
+#ifndef PAYLOAD_ENCODER_H
+#define PAYLOAD_ENCODER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include <vector>
+
+/**
+ * @brief Wire encoding for REST responses and WebSocket telemetry
+ *
+ * Every payload the hub emits is built once as a JsonDocument and then
+ * rendered in whichever format the consumer asked for. JSON stays the
+ * default; MessagePack is selected with `Accept: application/msgpack`
+ * (REST) or a HELLO frame (WebSocket) and is typically 30-45% smaller
+ * for the numeric-heavy telemetry objects.
+ */
+namespace PayloadEncoder {
+
+    enum class Format : uint8_t {
+        JSON = 0,
+        MSGPACK = 1
+    };
+
+    constexpr const char* MIME_JSON = "application/json";
+    constexpr const char* MIME_MSGPACK = "application/msgpack";
+
+    /**
+     * @brief Parse a format name ("json", "msgpack")
+     * @param name Format name (case-insensitive)
+     * @return Parsed format, JSON if unknown
+     */
+    Format fromName(const String& name);
+
+    /**
+     * @brief Get format name for logging / HELLO replies
+     */
+    const char* name(Format format);
+
+    /**
+     * @brief Get MIME type for format
+     */
+    const char* contentType(Format format);
+
+    /**
+     * @brief Select response format from Accept header or ?format= query
+     * @param request Incoming HTTP request
+     * @return MSGPACK if client accepts it, JSON otherwise
+     */
+    Format negotiate(AsyncWebServerRequest* request);
+
+    /**
+     * @brief Encoded size of a document without rendering it
+     */
+    size_t measure(JsonVariantConst src, Format format);
+
+    /**
+     * @brief Render document into a byte buffer
+     * @param src Source document
+     * @param format Target encoding
+     * @param out Output buffer (replaced)
+     * @return Number of bytes written
+     */
+    size_t encode(JsonVariantConst src, Format format, std::vector<uint8_t>& out);
+
+    /**
+     * @brief Send document as HTTP response in the given format
+     * @param request Incoming HTTP request
+     * @param code HTTP status code
+     * @param src Source document
+     * @param format Target encoding
+     */
+    void send(AsyncWebServerRequest* request, int code, JsonVariantConst src, Format format);
+
+    /**
+     * @brief Send document with an ETag for conditional GET
+     * @param etag Quoted entity tag (also sets Cache-Control: no-cache)
+     */
+    void send(AsyncWebServerRequest* request, int code, JsonVariantConst src, Format format,
+              const String& etag);
+
+    /**
+     * @brief Send document as HTTP response, negotiating the format
+     */
+    void send(AsyncWebServerRequest* request, int code, JsonVariantConst src);
+
+}
+
+#endif // PAYLOAD_ENCODER_H
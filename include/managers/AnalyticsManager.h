@@ -0,0 +1,141 @@
+#ifndef ANALYTICS_MANAGER_H
+#define ANALYTICS_MANAGER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "protocol/messages.h"
+
+/**
+ * @brief Per-tank, per-day device usage counters
+ *
+ * Device state transitions are folded into today's record as they
+ * happen: every command sent through Device::sendCommand() and every
+ * heater STATUS first accrues the time spent in the previous state, then
+ * applies the new one. Nothing is recomputed from history.
+ *
+ *  - Light:  sum of channel level (0-255) x seconds, per channel
+ *  - Heater: seconds on, seconds its state was reported, off->on cycles
+ *  - CO2:    seconds injecting (Start/Stop, Timed)
+ *  - Feeder: portions and feedings
+ *
+ * Records live in a fixed-size ring file (analytics.bin), one slot per
+ * tank-day, overwritten oldest first. Today's slot is rewritten in place
+ * every CHECKPOINT_INTERVAL_MS and on day change, so a reboot loses at
+ * most one interval. Days are local calendar dates; until NTP sets the
+ * clock, counts accrue to an undated record that is dated (and merged with
+ * any stored record for today) once the clock is valid.
+ *
+ * Thread-safe: commands may be sent from the web server task.
+ */
+class AnalyticsManager {
+public:
+    static constexpr const char* ANALYTICS_FILE = "/config/analytics.bin";
+    static constexpr uint16_t RING_CAPACITY = 256;                 // Tank-days kept
+    static constexpr uint8_t MAX_TANKS = 8;                        // Tanks tracked at once
+    static constexpr uint32_t CHECKPOINT_INTERVAL_MS = 600000;     // 10 minutes
+    static constexpr uint32_t HEATER_STATUS_VALID_MS = 75000;      // 2.5 heater STATUS periods
+    static constexpr uint16_t DEFAULT_DAYS = 7;
+
+    /**
+     * @brief One tank-day, as stored in the ring
+     */
+    struct DailyRecord {
+        uint32_t date;                  // YYYYMMDD local, 0 = clock not set
+        uint8_t tankId;                 // 0 = free slot
+        uint8_t reserved;
+        uint16_t heaterCycles;          // Off -> on transitions
+        uint32_t lightLevelSec[3];      // White, blue, red: level (0-255) x s
+        uint32_t heaterOnSec;
+        uint32_t heaterKnownSec;        // Heater state was reported (duty denominator)
+        uint32_t co2OnSec;
+        uint16_t portions;
+        uint16_t feedings;
+    } __attribute__((packed));
+
+    static AnalyticsManager& getInstance();
+
+    /**
+     * @brief Open (or create) the ring file
+     * @return false if the file cannot be created; counting still works in RAM
+     */
+    bool begin();
+
+    /**
+     * @brief Accrue time, roll over days and checkpoint (call from loop())
+     */
+    void update();
+
+    /**
+     * @brief Fold a command that reached a device
+     * @param tankId Tank of the device
+     * @param type Device type (selects the payload schema)
+     * @param data commandData (opcode first)
+     */
+    void onCommand(uint8_t tankId, NodeType type, const uint8_t* data, size_t len);
+
+    /**
+     * @brief Fold a heater relay report (HeaterProtocol::Status)
+     */
+    void onHeaterStatus(uint8_t tankId, bool heating);
+
+    /**
+     * @brief Persist and stop tracking a removed tank
+     */
+    void forgetTank(uint8_t tankId);
+
+    /**
+     * @brief Build the /api/analytics response, newest day first
+     * @param tankId 0 = all tanks
+     * @param days Days per tank
+     */
+    void toJson(JsonObject out, uint8_t tankId, uint16_t days);
+
+private:
+    AnalyticsManager();
+
+    /**
+     * @brief Live accumulator for one tank
+     */
+    struct TankState {
+        bool used;
+        int16_t slot;                   // Ring slot of record (-1 = none yet)
+        DailyRecord record;             // Today so far
+        uint8_t light[3];               // Current channel levels
+        bool co2On;
+        uint32_t co2UntilMs;            // Timed injection end (0 = until Stop)
+        bool heaterKnown;               // A recent STATUS reported the relay
+        bool heaterOn;
+        uint32_t heaterStatusMs;        // millis() of that STATUS
+        uint32_t lastFoldMs;            // Time accrued up to here
+    };
+
+    struct RingHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t capacity;
+        uint16_t head;                  // Next slot to assign
+        uint16_t count;                 // Slots assigned so far (<= capacity)
+    } __attribute__((packed));
+
+    static constexpr uint32_t RING_MAGIC = 0x314C4E41;    // "ANL1"
+    static constexpr uint16_t RING_VERSION = 1;
+
+    SemaphoreHandle_t _mutex;
+    bool _fileReady;                    // Ring file usable
+    RingHeader _header;
+    TankState _tanks[MAX_TANKS];
+    uint32_t _lastUpdateMs;
+    uint32_t _lastCheckpointMs;
+
+    TankState* _tankState(uint8_t tankId, bool create);
+    void _fold(TankState& tank, uint32_t nowMs);
+    void _startDay(TankState& tank, uint32_t date);
+    void _attachSlot(TankState& tank);
+    bool _writeRecord(TankState& tank);
+    bool _writeHeader();
+    bool _createFile();
+    void _recordToJson(const DailyRecord& record, bool partial, JsonObject out) const;
+    static uint32_t _today();
+};
+
+#endif // ANALYTICS_MANAGER_H
@@ -4,8 +4,12 @@
 #include <Arduino.h>
 #include <map>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <ArduinoJson.h>
 #include "models/Aquarium.h"
 #include "models/Device.h"
+#include "models/ReadingMatcher.h"
 #include "protocol/messages.h"
 
 /**
@@ -20,6 +24,74 @@
  */
 class AquariumManager {
 public:
+    /**
+     * @brief Telemetry sink for WebSocket clients
+     * 
+     * Receives the event name and a structured document; the sink picks
+     * the wire encoding (JSON or MessagePack) per client.
+     */
+    typedef void (*TelemetryCallback)(const String& event, JsonVariantConst data);
+    
+    /**
+     * @brief One fresh-reading query fanned out to a tank's sensors
+     * 
+     * Created by gatherReadings() and advanced by updateReadingGathers()
+     * and handleStatus() on the main loop. Once isComplete() returns true
+     * the result is frozen and may be read from any task.
+     */
+    class ReadingGather {
+    public:
+        enum class Outcome : uint8_t {
+            WAITING,        // Request sent, no reading yet
+            FRESH,          // Reading received before the deadline
+            TIMEOUT,        // No reading before the deadline
+            OFFLINE,        // Sensor offline, not asked
+            SEND_FAILED     // Request could not be sent
+        };
+        
+        struct Sensor {
+            uint8_t mac[6];
+            String macStr;
+            String name;
+            uint8_t tankId;
+            Outcome outcome;
+            float temperature;      // Valid when FRESH
+            float ph;
+            uint16_t tds;
+            uint32_t latencyMs;     // Request to reading
+            ReadingMatcher match;   // Tells the answer from other readings
+        };
+        
+        ReadingGather(uint8_t tankId, uint32_t timeoutMs);
+        
+        uint8_t getTankId() const { return _tankId; }
+        bool isComplete() const { return _complete.load(std::memory_order_acquire); }
+        
+        /**
+         * @brief Consolidated result (only once complete)
+         * 
+         * Tank queries carry one "readings" object averaged over the
+         * sensors that answered; fleet queries (tank 0) carry one per tank.
+         */
+        void toJson(JsonObject out) const;
+        
+        static const char* outcomeString(Outcome outcome);
+        
+    private:
+        friend class AquariumManager;
+        
+        uint8_t _tankId;                // 0 = fleet
+        uint32_t _startedMs;
+        uint32_t _timeoutMs;
+        uint32_t _sentMs;               // 0 until scattered
+        uint32_t _elapsedMs;            // Set on completion
+        uint16_t _clients;              // Requests sharing this gather
+        std::vector<Sensor> _sensors;
+        std::atomic<bool> _complete;
+        
+        bool _averageTank(uint8_t tankId, JsonObject out) const;
+    };
+    
     /**
      * @brief Get singleton instance
      */
@@ -73,6 +145,16 @@ public:
      */
     size_t getAquariumCount() const { return _aquariums.size(); }
     
+    /**
+     * @brief Hold the aquarium and device registry across a rebuild
+     * 
+     * Recursive: the holder may still add and remove aquariums. The
+     * health check (watchdog task) and water check (executor) take it
+     * too, so they wait instead of walking devices being deleted.
+     */
+    void lockRegistry() { xSemaphoreTakeRecursive(_registryMutex, portMAX_DELAY); }
+    void unlockRegistry() { xSemaphoreGiveRecursive(_registryMutex); }
+    
     // ===== Device Discovery & Registration =====
     /**
      * @brief Handle device ANNOUNCE message
@@ -88,6 +170,13 @@ public:
      */
     void handleHeartbeat(const uint8_t* mac, const HeartbeatMessage& msg);
     
+    /**
+     * @brief Handle command timing appended to a node HEARTBEAT
+     * @param mac Device MAC address
+     * @param diagnostics Diagnostics tail
+     */
+    void handleHeartbeatDiagnostics(const uint8_t* mac, const HeartbeatDiagnostics& diagnostics);
+    
     /**
      * @brief Handle device STATUS message
      * @param mac Device MAC address
@@ -95,6 +184,30 @@ public:
      */
     void handleStatus(const uint8_t* mac, const StatusMessage& msg);
     
+    // ===== Fresh Readings =====
+    /**
+     * @brief Ask every sensor in a tank (or the fleet) for a reading now
+     * 
+     * Returns at once; the request goes out on the next
+     * updateReadingGathers() and the gather completes when every asked
+     * sensor has answered or the deadline passes. A gather already in
+     * flight for the same tank is shared (its deadline applies), so
+     * concurrent clients cost one round of requests.
+     * @param tankId Aquarium ID, 0 for every sensor in the fleet
+     * @param timeoutMs Deadline from now
+     * @return Gather to poll with isComplete()
+     */
+    std::shared_ptr<ReadingGather> gatherReadings(uint8_t tankId, uint32_t timeoutMs = GATHER_DEFAULT_TIMEOUT_MS);
+    
+    /**
+     * @brief Send pending gathers and complete finished ones (call from loop())
+     */
+    void updateReadingGathers();
+    
+    static constexpr uint32_t GATHER_DEFAULT_TIMEOUT_MS = 2000;
+    static constexpr uint32_t GATHER_MIN_TIMEOUT_MS = 200;
+    static constexpr uint32_t GATHER_MAX_TIMEOUT_MS = 10000;
+    
     /**
      * @brief Get device by MAC address
      * @param mac Device MAC address
@@ -176,19 +289,93 @@ public:
      */
     bool fromJson(const String& json);
     
+    // ===== Change Tracking =====
+    /**
+     * @brief Collections whose list endpoints carry an ETag
+     */
+    enum class Collection : uint8_t {
+        AQUARIUMS = 0,  // Aquarium registry and readings
+        DEVICES,        // Live devices and devices.json
+        UNMAPPED,       // unmapped-devices.json
+        COUNT
+    };
+    
+    /**
+     * @brief Current global state version
+     * 
+     * Monotonically increasing, bumped on every mutation. Starts at 0 on
+     * each boot; pair with getBootId() to detect restarts.
+     */
+    uint32_t getStateVersion() const { return _stateVersion; }
+    
+    /**
+     * @brief State version of the last change to a collection
+     */
+    uint32_t getCollectionVersion(Collection collection) const;
+    
+    /**
+     * @brief Random ID chosen at boot (invalidates client versions)
+     */
+    uint32_t getBootId() const { return _bootId; }
+    
+    /**
+     * @brief Record a change to an aquarium
+     * @return New state version
+     */
+    uint32_t touchAquarium(Aquarium* aquarium);
+    
+    /**
+     * @brief Record a change to a live device
+     * @return New state version
+     */
+    uint32_t touchDevice(Device* device);
+    
+    /**
+     * @brief Record a change not tied to a live entity (e.g. config files)
+     * @return New state version
+     */
+    uint32_t markChanged(Collection collection);
+    
+    /**
+     * @brief Build the change feed since a client's last seen version
+     * 
+     * Fills "version", "bootId", changed "aquariums"/"devices" and
+     * "removed" tombstones. Sets "full": true when the client must
+     * reload everything (other boot, or tombstones already dropped).
+     * @param since Last version the client has applied
+     * @param bootId Boot ID the client's version came from
+     * @param out Destination object
+     */
+    void changesToJson(uint32_t since, uint32_t bootId, JsonObject out) const;
+    
+    /**
+     * @brief A device removal (LAN federation deltas)
+     */
+    struct RemovedDevice {
+        uint8_t mac[6];
+        uint32_t version;           // State version of the removal
+    };
+    
+    /**
+     * @brief Collect devices removed after a version
+     * @return false if removals after since may have been dropped already
+     *         (send a full snapshot instead)
+     */
+    bool getRemovedDevices(uint32_t since, std::vector<RemovedDevice>& out) const;
+    
     // ===== WebSocket Notifications =====
     /**
      * @brief Broadcast update to all WebSocket clients
      * @param event Event name
-     * @param data Event data (JSON)
+     * @param data Event data document
      */
-    void broadcastUpdate(const String& event, const String& data);
+    void broadcastUpdate(const String& event, JsonVariantConst data);
     
     /**
      * @brief Set WebSocket broadcast callback
      * @param callback Function pointer
      */
-    void setWebSocketCallback(void (*callback)(const String&, const String&));
+    void setWebSocketCallback(TelemetryCallback callback);
     
     // ===== Statistics =====
     /**
@@ -233,6 +420,7 @@ private:
     // Timing
     uint32_t _startTime;
     uint32_t _lastScheduleCheck;
+    uint32_t _lastScheduleSecond;   // Unix second schedules were last evaluated
     uint32_t _lastHealthCheck;
     uint32_t _lastWaterCheck;
     
@@ -240,18 +428,75 @@ private:
     Statistics _stats;
     
     // WebSocket callback
-    void (*_wsCallback)(const String&, const String&);
+    TelemetryCallback _wsCallback;
+    
+    // Fused temperature last pushed to each tank's heaters
+    struct HeaterReference {
+        uint32_t sentMs;            // millis() of last push
+        int16_t sentX100;           // Value pushed (C x100)
+    };
+    std::map<uint8_t, HeaterReference> _heaterReferences;    // Tank ID -> last push
+    
+    // Water alerts currently raised, so the journal records transitions only
+    static constexpr uint8_t ALERT_TEMPERATURE = 0x01;
+    static constexpr uint8_t ALERT_PH = 0x02;
+    std::map<uint8_t, uint8_t> _raisedAlerts;                // Tank ID -> ALERT_* bits
+    
+    // Guards _aquariums/_globalDeviceRegistry against the other tasks
+    // that walk them (watchdog, executor) while loop() rebuilds them
+    SemaphoreHandle_t _registryMutex;
+    
+    // Fresh-reading gathers in flight (web server task + loop)
+    std::map<uint8_t, std::shared_ptr<ReadingGather>> _gathers;  // Tank ID (0 = fleet)
+    SemaphoreHandle_t _gatherMutex;
+    
+    // Change tracking
+    struct Tombstone {
+        Collection collection;      // AQUARIUMS (key = id) or DEVICES (key = MAC)
+        uint64_t key;               // Removed entity
+        uint32_t version;           // State version of removal
+    };
+    
+    uint32_t _stateVersion;                                    // Global version
+    uint32_t _bootId;                                          // Random per boot
+    uint32_t _collectionVersions[(size_t)Collection::COUNT];   // Last change per list
+    std::vector<Tombstone> _tombstones;                        // Oldest first
+    uint32_t _tombstoneFloor;                                  // Versions <= this may miss removals
+    mutable portMUX_TYPE _versionMux;                          // Loop + watchdog task
+    
+    uint32_t _bumpVersion(Collection collection);
+    void _addTombstone(Collection collection, uint64_t key);
     
     // Helper methods
     uint64_t _macToKey(const uint8_t* mac) const;
     Device* _createDevice(const uint8_t* mac, NodeType type, const String& name);
+    void _applyProtocol(Device* device, const uint8_t* mac);
     void _sendAck(const uint8_t* mac, uint8_t tankId, bool accepted);
+    void _broadcastDevice(const String& event, const Device* device);
+    void _broadcastAquarium(const String& event, const Aquarium* aquarium);
+    
+    // Alerts: snapshot now, broadcast from a TaskExecutor worker
+    void _alertDevice(const String& event, const Device* device);
+    void _alertAquarium(const String& event, const Aquarium* aquarium);
+    void _dispatchAlert(const String& event, std::shared_ptr<JsonDocument> doc);
+    void _ingestSensorReadings(Aquarium* aquarium, const Device* device, const StatusMessage& msg);
+    void _reportProbeHealth(const Aquarium* aquarium, const Device* device, const char* probe,
+                            uint8_t previousFlags, uint8_t flags);
+    void _ingestHeaterReadings(Aquarium* aquarium, const Device* device, const StatusMessage& msg);
+    void _pushHeaterReference(Aquarium* aquarium);
+    void _scatterReadingRequests(ReadingGather& gather, uint32_t now);
+    void _collectFreshReading(const Device* device, const StatusMessage& msg);
+    static bool _decodeLatestReading(const StatusMessage& msg, float& temperature, float& ph, uint16_t& tds);
     
     // Safety intervals
     static constexpr uint32_t HEARTBEAT_TIMEOUT_MS = 60000;     // 60 seconds
     static constexpr uint32_t HEALTH_CHECK_INTERVAL_MS = 5000;  // 5 seconds
     static constexpr uint32_t SCHEDULE_CHECK_INTERVAL_MS = 1000; // 1 second
     static constexpr uint32_t WATER_CHECK_INTERVAL_MS = 10000;  // 10 seconds
+    static constexpr size_t MAX_TOMBSTONES = 32;               // Removal history kept
+    static constexpr uint32_t HEATER_REFERENCE_INTERVAL_MS = 30000;  // Refresh period
+    static constexpr uint16_t HEATER_REFERENCE_VALID_SEC = 90;       // Heater falls back after this
+    static constexpr int16_t HEATER_REFERENCE_STEP_X100 = 10;        // Push early on a 0.1 C move
 };
 
 #endif // AQUARIUM_MANAGER_H
@@ -0,0 +1,88 @@
+#ifndef CALIBRATION_STORE_H
+#define CALIBRATION_STORE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "protocol/sensor_calibration.h"
+
+/**
+ * @brief Sensor calibrations and their history (calibration.json)
+ *
+ * apply() compiles 2-5 buffer readings into a SensorCalibration::Table,
+ * pushes it to the node and appends a history record for that probe. The
+ * record keeps the least-squares slope and offset of the points and their
+ * change from the previous calibration, so probe ageing shows up as a
+ * trend rather than a surprise.
+ *
+ * Not thread-safe; create one per request.
+ */
+class CalibrationStore {
+public:
+    static constexpr const char* CALIBRATION_FILE = "/config/calibration.json";
+    static constexpr size_t MAX_HISTORY = 16;   // Records kept per probe
+
+    /**
+     * @brief Outcome of apply()
+     */
+    enum class Error : uint8_t {
+        NONE = 0,
+        INVALID_MAC,        // MAC string did not parse
+        INVALID_PROBE,      // Not "ph" or "tds"
+        INVALID_POINTS,     // Table would not compile (count, order, range)
+        SEND_FAILED         // COMMAND frame could not be queued
+    };
+
+    struct Result {
+        Error error;
+        float slope;            // Reference units per 1000 counts
+        float offset;           // Reference value at 0 counts
+        float slopeDriftPct;    // Change vs previous calibration (0 if first)
+        float offsetDrift;
+
+        Result() : error(Error::NONE), slope(0), offset(0), slopeDriftPct(0), offsetDrift(0) {}
+        bool ok() const { return error == Error::NONE; }
+    };
+
+    CalibrationStore();
+
+    /**
+     * @brief Read calibration.json (a missing file starts empty)
+     */
+    bool load();
+
+    /**
+     * @brief Write back if changed (tmp file + rename)
+     */
+    bool commit();
+
+    /**
+     * @brief Compile, push to the node and record a calibration
+     * @param macStr Sensor node MAC ("AA:BB:CC:DD:EE:FF")
+     * @param probe Probe the points belong to
+     * @param points Buffer references with the raw counts the node reported
+     * @param count 2-5 points
+     * @param refTempC Water temperature while the points were taken
+     */
+    Result apply(const String& macStr, SensorCalibration::Probe probe,
+                 const SensorCalibration::CalPoint* points, uint8_t count, float refTempC);
+
+    /**
+     * @brief All probes, or only those of one MAC
+     */
+    void toJson(JsonArray out, const String& macStr = String()) const;
+
+    static const char* errorString(Error error);
+    static const char* probeName(SensorCalibration::Probe probe);
+    static bool parseProbe(const String& name, SensorCalibration::Probe& probe);
+
+private:
+    JsonDocument _doc;      // calibration.json contents
+    bool _dirty;            // Needs write on commit
+
+    JsonObject _findProbe(const String& macStr, SensorCalibration::Probe probe, bool create);
+    bool _sendTable(const uint8_t* mac, const SensorCalibration::Table& table);
+    static void _fitLine(const SensorCalibration::CalPoint* points, uint8_t count,
+                         float& slope, float& offset);
+};
+
+#endif // CALIBRATION_STORE_H
@@ -0,0 +1,151 @@
+#ifndef DEVICE_CONFIG_STORE_H
+#define DEVICE_CONFIG_STORE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "protocol/messages.h"
+
+/**
+ * @brief In-memory view of devices.json and unmapped-devices.json
+ *
+ * Loads both files once, applies any number of provision / unmap /
+ * rename / move operations to the in-memory documents (sending the
+ * matching CONFIG or UNMAP frame to each node), then writes each changed
+ * file exactly once on commit(). Used by the single-device endpoints and
+ * by POST /api/devices/batch.
+ *
+ * Create one per request. load() takes a lock on both files that is held
+ * until the store is destroyed, so a web handler and a provisioning
+ * commit on the main loop never interleave their read-modify-write.
+ */
+class DeviceConfigStore {
+public:
+    static constexpr const char* DEVICES_FILE = "/config/devices.json";
+    static constexpr const char* UNMAPPED_FILE = "/config/unmapped-devices.json";
+
+    /**
+     * @brief Outcome of a single operation
+     */
+    enum class Error : uint8_t {
+        NONE = 0,
+        INVALID_MAC,        // MAC string did not parse
+        INVALID_ARGUMENT,   // Missing/invalid name or tank ID
+        NOT_FOUND,          // MAC not in the expected list
+        SEND_FAILED,        // CONFIG frame could not be queued
+        BUSY,               // Another provisioning transaction owns this MAC
+        TOO_MANY            // Provisioning transaction table full
+    };
+
+    struct Result {
+        Error error;
+        String status;      // Resulting device status on success
+        bool frameSent;     // CONFIG/UNMAP frame accepted by radio
+
+        Result() : error(Error::NONE), frameSent(false) {}
+        bool ok() const { return error == Error::NONE; }
+    };
+
+    DeviceConfigStore();
+    ~DeviceConfigStore();
+
+    /**
+     * @brief Read both files into memory
+     * @return true if documents are usable (missing files start empty)
+     */
+    bool load();
+
+    /**
+     * @brief Write back every file changed since load()
+     *
+     * Each file is written to a .tmp sibling and renamed over the
+     * original so a power cut never leaves a truncated document.
+     * @return true if all dirty files were written
+     */
+    bool commit();
+
+    /**
+     * @brief Choose whether operations push CONFIG / UNMAP themselves
+     *
+     * ProvisioningManager turns this off: it delivers the frame and waits
+     * for the node's confirmation before applying the operation here.
+     */
+    void setSendFrames(bool send) { _sendFrames = send; }
+
+    /**
+     * @brief Move an unmapped device to a tank and push CONFIG
+     * @param macStr Device MAC ("AA:BB:CC:DD:EE:FF")
+     * @param name Friendly name (max 15 chars on the node)
+     * @param tankId Target tank (1-255)
+     */
+    Result provision(const String& macStr, const String& name, uint8_t tankId);
+
+    /**
+     * @brief Return a mapped device to the unmapped list and push UNMAP
+     *
+     * Succeeds even if the node is offline; it will be re-discovered
+     * on its next ANNOUNCE.
+     */
+    Result unmap(const String& macStr);
+
+    /**
+     * @brief Rename a mapped device
+     *
+     * The CONFIG frame is best effort: the hub-side name is
+     * authoritative for the UI.
+     */
+    Result rename(const String& macStr, const String& name);
+
+    /**
+     * @brief Reassign a mapped device to another tank
+     *
+     * Requires the CONFIG frame to go out, since the node stamps its
+     * tank ID on every message.
+     */
+    Result move(const String& macStr, uint8_t tankId);
+
+    /**
+     * @brief Find mapped device entry
+     * @return Entry or null object
+     */
+    JsonObject findDevice(const String& macStr);
+
+    /**
+     * @brief Whether a MAC is in the mapped / unmapped list
+     */
+    bool isMapped(const String& macStr);
+    bool isUnmapped(const String& macStr);
+
+    /**
+     * @brief Human readable error for API responses
+     */
+    static const char* errorString(Error error);
+
+    /**
+     * @brief Parse "AA:BB:CC:DD:EE:FF" into bytes
+     */
+    static bool parseMac(const String& macStr, uint8_t* mac);
+
+    /**
+     * @brief Push CONFIG / UNMAP to a node
+     * @param token Echoed in the node's confirming STATUS (0 = not tracked)
+     * @return true if the radio accepted the frame
+     */
+    static bool sendConfig(const uint8_t* mac, const String& name, uint8_t tankId, uint8_t token = 0);
+    static bool sendUnmap(const uint8_t* mac, uint8_t token = 0);
+
+private:
+    JsonDocument _devicesDoc;       // devices.json contents
+    JsonDocument _unmappedDoc;      // unmapped-devices.json contents
+    bool _devicesDirty;             // Needs write on commit
+    bool _unmappedDirty;            // Needs write on commit
+    bool _sendFrames;               // Push CONFIG/UNMAP from operations
+    bool _locked;                   // Holds the file lock (after load())
+
+    static SemaphoreHandle_t _fileLock();
+
+    int _indexOf(JsonArray list, const String& macStr) const;
+    static bool _readFile(const char* path, JsonDocument& doc);
+    static bool _writeFile(const char* path, const JsonDocument& doc);
+};
+
+#endif // DEVICE_CONFIG_STORE_H
@@ -0,0 +1,204 @@
+#ifndef EVENT_JOURNAL_H
+#define EVENT_JOURNAL_H
+
+#include <Arduino.h>
+#include <memory>
+
+/**
+ * @brief Append-only binary audit log of hub activity
+ *
+ * Fixed 32-byte records (CRC-protected) go into SEGMENT_COUNT segment
+ * files used round-robin: when the active segment is full the oldest one
+ * is truncated and reused, spreading writes over the whole journal on top
+ * of LittleFS's own wear levelling.
+ *
+ * log() only copies the record into a RAM queue (any task, any core);
+ * flush() from loop() appends the queue to flash in one write, so logging
+ * from the watchdog task or a web handler never touches the filesystem.
+ *
+ * A small RAM index keeps each segment's first sequence number and the
+ * latest timestamp of every INDEX_STRIDE records, so a query starting at
+ * `from` seeks straight to the first block that can match. Queries are
+ * served by a Query cursor that reads a few records per call and formats
+ * them as JSON text, never holding the journal in RAM.
+ */
+class EventJournal {
+public:
+    static constexpr uint8_t SEGMENT_COUNT = 8;
+    static constexpr uint16_t SEGMENT_RECORDS = 512;           // 16 KB per segment
+    static constexpr uint16_t INDEX_STRIDE = 64;               // Records per index block
+    static constexpr uint8_t PENDING_CAPACITY = 64;            // RAM queue before flush
+    static constexpr uint32_t FLUSH_INTERVAL_MS = 2000;
+    static constexpr uint16_t DEFAULT_QUERY_LIMIT = 500;
+    static constexpr uint16_t MAX_QUERY_LIMIT = 5000;
+
+    enum class Type : uint8_t {
+        BOOT = 1,
+        COMMAND = 2,            // data: commandId, command bytes
+        COMMAND_FAILED = 3,     // data: command bytes (not delivered)
+        STATUS = 4,             // data: commandId, statusCode, status bytes
+        SCHEDULE = 5,           // data: scheduleId (u32), opcode
+        ALERT = 6,              // data: Alert, value (float)
+        ALERT_CLEARED = 7,      // data: Alert
+        DEVICE_ONLINE = 8,
+        DEVICE_OFFLINE = 9,     // Heartbeat timeout, fail-safe triggered
+        CONFIG = 10             // data: Config
+    };
+
+    enum class Alert : uint8_t {
+        TEMPERATURE = 1,
+        PH = 2,
+        PROBE = 3,              // value = SensorStreamMonitor flags
+        EMERGENCY = 4
+    };
+
+    enum class Config : uint8_t {
+        AQUARIUM_ADDED = 1,
+        AQUARIUM_REMOVED = 2,
+        DEVICE_PROVISIONED = 3,
+        DEVICE_UNMAPPED = 4,
+        DEVICE_RENAMED = 5,
+        DEVICE_MOVED = 6,
+        CALIBRATION = 7
+    };
+
+    static constexpr size_t DATA_LEN = 9;
+
+    struct Record {
+        uint32_t seq;           // Journal-wide, monotonic
+        uint32_t time;          // Unix seconds, 0 = clock not set
+        uint32_t uptimeSec;     // Seconds since boot
+        Type type;
+        uint8_t tankId;
+        uint8_t mac[6];         // Zero for hub events
+        uint8_t dataLen;
+        uint8_t data[DATA_LEN];
+        uint16_t crc;           // CRC-16/CCITT of the bytes above
+    } __attribute__((packed));
+
+    static_assert(sizeof(Record) == 32, "Record must stay 32 bytes");
+
+    /**
+     * @brief Selection for a query; zero fields match everything
+     */
+    struct Filter {
+        uint32_t from;          // Unix seconds, inclusive
+        uint32_t to;            // Unix seconds, inclusive (0 = no limit)
+        uint8_t mac[6];
+        bool matchMac;
+        uint8_t tankId;
+        uint8_t type;           // Type value
+        uint16_t limit;
+
+        Filter() : from(0), to(0), matchMac(false), tankId(0), type(0), limit(DEFAULT_QUERY_LIMIT) {
+            memset(mac, 0, sizeof(mac));
+        }
+    };
+
+    /**
+     * @brief Streaming cursor over matching records
+     *
+     * read() fills the caller's buffer with the next part of
+     * {"events":[...],"truncated":bool} and returns 0 when done. Records
+     * overwritten by rotation while the cursor runs are skipped.
+     */
+    class Query {
+    public:
+        Query(EventJournal& journal, const Filter& filter);
+        size_t read(uint8_t* buffer, size_t maxLen);
+
+    private:
+        static constexpr uint8_t BATCH = 16;
+
+        EventJournal& _journal;
+        Filter _filter;
+        uint32_t _nextSeq;      // Next record to read from flash
+        Record _batch[BATCH];   // Records read, not yet examined
+        uint8_t _batchCount;
+        uint8_t _batchPos;
+        uint32_t _emitted;
+        uint8_t _stage;         // 0 = prefix, 1 = records, 2 = suffix, 3 = done
+        bool _truncated;
+        String _text;           // Formatted, not yet copied out
+        size_t _textPos;
+
+        bool _nextText();
+    };
+
+    static EventJournal& getInstance();
+
+    /**
+     * @brief Open segments, rebuild the index and resume the sequence
+     */
+    bool begin();
+
+    /**
+     * @brief Queue a record (safe from any task)
+     */
+    void log(Type type, uint8_t tankId = 0, const uint8_t* mac = nullptr,
+             const uint8_t* data = nullptr, size_t dataLen = 0);
+
+    void logCommand(uint8_t tankId, const uint8_t* mac, uint8_t commandId,
+                    const uint8_t* command, size_t length, bool delivered);
+    void logAlert(uint8_t tankId, Alert alert, float value, bool raised = true);
+    void logConfig(Config change, uint8_t tankId = 0, const uint8_t* mac = nullptr);
+
+    /**
+     * @brief Write queued records to flash (call from loop())
+     * @param force Write even if the queue is short and the interval not over
+     */
+    void flush(bool force = false);
+
+    /**
+     * @brief Start a query (caller owns the cursor)
+     */
+    std::shared_ptr<Query> query(const Filter& filter);
+
+    uint32_t getNextSeq() const { return _nextSeq; }
+    uint32_t getDropped() const { return _dropped; }
+
+    static const char* typeName(Type type);
+    static bool parseType(const String& name, uint8_t& type);
+
+private:
+    EventJournal();
+
+    struct SegmentIndex {
+        bool valid;
+        uint32_t firstSeq;
+        uint16_t count;                                      // Valid records
+        uint32_t blockMaxTime[SEGMENT_RECORDS / INDEX_STRIDE];
+    };
+
+    struct SegmentHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t index;             // Segment number
+        uint32_t firstSeq;
+    } __attribute__((packed));
+
+    static constexpr uint32_t SEGMENT_MAGIC = 0x314A5645;    // "EVJ1"
+    static constexpr uint16_t SEGMENT_VERSION = 1;
+
+    SemaphoreHandle_t _fileMutex;   // Segment files and index
+    portMUX_TYPE _queueMux;         // Pending queue and sequence
+    Record _pending[PENDING_CAPACITY];
+    uint8_t _pendingHead;
+    uint8_t _pendingCount;
+    uint32_t _nextSeq;
+    uint32_t _dropped;              // Queue overflows
+    uint32_t _lastFlushMs;
+
+    bool _ready;
+    uint8_t _active;                // Segment being appended to
+    SegmentIndex _index[SEGMENT_COUNT];
+
+    bool _scanSegment(uint8_t segment);
+    bool _startSegment(uint8_t segment, uint32_t firstSeq);
+    uint8_t _readBatch(uint32_t& seq, Record* out, uint8_t max, uint32_t minTime);
+    static void _segmentPath(uint8_t segment, char* path, size_t size);
+    static uint16_t _crc16(const uint8_t* data, size_t len);
+    static void _recordToJson(const Record& record, String& out);
+};
+
+#endif // EVENT_JOURNAL_H
@@ -0,0 +1,143 @@
+#ifndef FAILOVER_MANAGER_H
+#define FAILOVER_MANAGER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "managers/FailoverPolicy.h"
+#include "protocol/messages.h"
+
+/**
+ * @brief Hot-standby hub pairing over ESP-NOW
+ *
+ * Two hubs configured as partners (HUB_PARTNER in hub_config.txt) run the
+ * same firmware. FailoverPolicy decides which one is active; this class
+ * does the I/O around it:
+ * - Identity: every beacon carries the logical hubId and generation
+ *   (BeaconIdentity). Nodes that hear a higher generation for their
+ *   hubId move to the sender's MAC, so a takeover needs no
+ *   re-provisioning. The identity is persisted in failover.json.
+ * - Replication: the active hub streams each state file in FILES to the
+ *   standby whenever its size or CRC differs from what the standby last
+ *   acknowledged (REPLICATE frames, one file at a time per index). The
+ *   standby applies a file with tmp + rename only when it is complete and
+ *   its CRC matches, so it always holds a consistent copy of each file.
+ * - Takeover: the standby becomes active after TAKEOVER_BEACONS missed
+ *   partner beacons, and the TakeoverCallback reloads the replicated
+ *   state. An active hub that loses to its partner restarts into standby.
+ *
+ * Without a partner the hub is always active and only the identity is
+ * used. All methods run in loop() context (ESP-NOW callbacks included).
+ */
+class FailoverManager {
+public:
+    static constexpr const char* STATE_FILE = "/config/failover.json";
+    static constexpr uint8_t FILE_COUNT = 5;
+    static constexpr uint8_t TAKEOVER_BEACONS = 3;          // Missed partner beacons
+    static constexpr uint8_t LISTEN_BEACONS = 4;            // Boot listen window
+    static constexpr uint32_t SYNC_CHECK_INTERVAL_MS = 2000;
+    static constexpr uint32_t ACK_TIMEOUT_MS = 2000;
+    static constexpr uint32_t MAX_RETRY_DELAY_MS = 32000;   // Backoff cap while the standby is away
+    static constexpr uint8_t CHUNKS_PER_UPDATE = 4;         // Frames per loop() pass
+
+    /**
+     * @brief Replicated state, in REPLICATE fileIndex order
+     */
+    static const char* const FILES[FILE_COUNT];
+
+    typedef void (*TakeoverCallback)();
+
+    static FailoverManager& getInstance();
+
+    /**
+     * @brief Load the identity and start listening for the partner
+     * @param partnerMac Partner hub MAC, empty for a single hub
+     * @param preferStandby This hub is the configured standby
+     * @param beaconIntervalMs Beacon period (sets listen and takeover times)
+     * @return false if partnerMac is set but invalid (runs as single hub)
+     */
+    bool begin(const String& partnerMac, bool preferStandby, uint16_t beaconIntervalMs);
+
+    /**
+     * @brief Advance roles and replication (call from loop())
+     */
+    void update();
+
+    /**
+     * @brief BeaconIdentity tail received (ESP-NOW beacon callback)
+     */
+    void handleBeaconIdentity(const uint8_t* mac, const BeaconIdentity& identity);
+
+    /**
+     * @brief REPLICATE frame received (ESP-NOW callback)
+     */
+    void handleReplication(const uint8_t* mac, const uint8_t* data, size_t len);
+
+    void onTakeover(TakeoverCallback callback) { _takeoverCallback = callback; }
+
+    /**
+     * @brief This hub should beacon, answer nodes and run schedules
+     */
+    bool isActive() const { return !_paired || _policy.isActive(); }
+    bool isPaired() const { return _paired; }
+
+    void toJson(JsonObject out) const;
+
+private:
+    FailoverManager();
+
+    // Active side: what the standby has of each file
+    struct OutgoingFile {
+        bool sending;               // Stream in progress
+        bool complete;              // Every chunk sent, awaiting ACK
+        uint32_t size;              // Snapshot being sent
+        uint32_t crc;
+        uint32_t offset;            // Next byte to send
+        uint32_t ackedSize;         // Last version the standby applied
+        uint32_t ackedCrc;
+        bool acked;
+        uint32_t lastActivityMs;    // Last chunk sent / NACK
+        uint32_t retryDelayMs;      // Backoff after unanswered streams
+        uint32_t nextCheckMs;
+    };
+
+    // Standby side: file being received
+    struct IncomingFile {
+        bool receiving;
+        uint32_t size;
+        uint32_t crc;
+        uint32_t expected;          // Next offset to accept
+        uint32_t runningCrc;        // CRC state over bytes received
+        uint32_t appliedSize;       // File currently on flash
+        uint32_t appliedCrc;
+        uint32_t lastNackMs;
+    };
+
+    FailoverPolicy _policy;
+    bool _paired;
+    bool _wasStandby;               // Next activation is a takeover
+    uint8_t _ownMac[6];
+    uint8_t _partnerMac[6];
+    uint32_t _lastSyncCheckMs;
+    TakeoverCallback _takeoverCallback;
+    OutgoingFile _outgoing[FILE_COUNT];
+    IncomingFile _incoming[FILE_COUNT];
+    uint32_t _filesApplied;
+    uint32_t _takeovers;
+
+    void _handleEvent(FailoverPolicy::Event event);
+    void _applyIdentity();
+    bool _loadIdentity(FailoverPolicy::Identity& identity);
+    void _saveIdentity();
+
+    void _checkFiles(uint32_t now);
+    void _sendChunks(uint8_t index, uint32_t now);
+    void _handleAck(const ReplicationMessage& msg, uint32_t now);
+    void _handleNack(const ReplicationMessage& msg, uint32_t now);
+    void _handleChunk(const ReplicationMessage& msg, uint32_t now);
+    void _reply(ReplicationOp op, uint8_t index, uint32_t size, uint32_t crc, uint32_t offset);
+
+    static bool _fileDigest(const char* path, uint32_t& size, uint32_t& crc);
+    static uint32_t _crcUpdate(uint32_t state, const uint8_t* data, size_t len);
+};
+
+#endif // FAILOVER_MANAGER_H
@@ -0,0 +1,200 @@
+#ifndef FAILOVER_POLICY_H
+#define FAILOVER_POLICY_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Active/standby decision for a pair of hubs
+ *
+ * Pure state machine: no radio, flash or clock of its own, so two
+ * instances can be wired together and simulated on the host.
+ * FailoverManager feeds it the partner's beacons and millis() and acts on
+ * the returned events.
+ *
+ * Both hubs share one logical identity (hubId, the MAC the nodes were
+ * first provisioned by) and a generation that is bumped on every
+ * takeover:
+ * - At boot a hub listens for listenMs. Hearing the partner beacon makes
+ *   it the standby and adopts the partner's identity; otherwise the
+ *   preferred primary becomes active and the preferred standby waits.
+ * - A standby that has learned the identity takes over when no partner
+ *   beacon arrived for takeoverMs, with generation + 1.
+ * - An active hub that hears the partner at a higher generation (or the
+ *   same generation from a lower MAC) steps down. The higher generation
+ *   is what lets nodes and the partner tell the new active hub from a
+ *   stale one after a split.
+ */
+class FailoverPolicy {
+public:
+    enum class Role : uint8_t {
+        LISTENING,      // Boot: waiting to hear whether the partner is active
+        ACTIVE,         // Beaconing and serving nodes
+        STANDBY         // Receiving replicated state, watching beacons
+    };
+
+    enum class Event : uint8_t {
+        NONE,
+        BECAME_ACTIVE,      // Start beaconing (identity may have changed)
+        BECAME_STANDBY,     // Stay quiet
+        STEP_DOWN           // Was active, partner wins: drop live state
+    };
+
+    struct Identity {
+        uint8_t hubId[6];
+        uint16_t generation;
+        bool known;         // false until first activation or partner beacon
+    };
+
+    FailoverPolicy()
+        : _role(Role::LISTENING)
+        , _preferStandby(false)
+        , _listenMs(0)
+        , _takeoverMs(0)
+        , _startedMs(0)
+        , _lastPeerBeaconMs(0)
+        , _dirty(false) {
+        memset(_ownMac, 0, sizeof(_ownMac));
+        memset(&_identity, 0, sizeof(_identity));
+    }
+
+    /**
+     * @param ownMac This hub's radio MAC
+     * @param preferStandby Configured as the standby of the pair
+     * @param persisted Identity saved by a previous run (known = false if none)
+     */
+    void begin(const uint8_t* ownMac, bool preferStandby, const Identity& persisted,
+               uint32_t listenMs, uint32_t takeoverMs, uint32_t now) {
+        memcpy(_ownMac, ownMac, 6);
+        _preferStandby = preferStandby;
+        _identity = persisted;
+        _listenMs = listenMs;
+        _takeoverMs = takeoverMs;
+        _startedMs = now;
+        _lastPeerBeaconMs = now;
+        _role = Role::LISTENING;
+        _dirty = false;
+    }
+
+    /**
+     * @brief A beacon with identity arrived from the partner hub
+     */
+    Event onPeerBeacon(const uint8_t* peerMac, const uint8_t* hubId, uint16_t generation, uint32_t now) {
+        if (_identity.known && memcmp(hubId, _identity.hubId, 6) != 0 && _role == Role::ACTIVE) {
+            // Partner serves another identity: never merge two installations
+            return Event::NONE;
+        }
+
+        switch (_role) {
+            case Role::LISTENING:
+                _adopt(hubId, generation);
+                _lastPeerBeaconMs = now;
+                _role = Role::STANDBY;
+                return Event::BECAME_STANDBY;
+
+            case Role::STANDBY:
+                _adopt(hubId, generation);
+                _lastPeerBeaconMs = now;
+                return Event::NONE;
+
+            case Role::ACTIVE:
+                if (_newer(generation) ||
+                    (generation == _identity.generation && memcmp(peerMac, _ownMac, 6) < 0)) {
+                    _adopt(hubId, generation);
+                    _lastPeerBeaconMs = now;
+                    _role = Role::STANDBY;
+                    return Event::STEP_DOWN;
+                }
+                return Event::NONE;
+        }
+        return Event::NONE;
+    }
+
+    /**
+     * @brief Advance timers (call regularly)
+     */
+    Event update(uint32_t now) {
+        switch (_role) {
+            case Role::LISTENING:
+                if (now - _startedMs < _listenMs) {
+                    return Event::NONE;
+                }
+                if (_preferStandby) {
+                    _role = Role::STANDBY;
+                    return Event::BECAME_STANDBY;
+                }
+                if (!_identity.known) {
+                    memcpy(_identity.hubId, _ownMac, 6);
+                    _identity.generation = 1;
+                    _identity.known = true;
+                    _dirty = true;
+                }
+                _role = Role::ACTIVE;
+                return Event::BECAME_ACTIVE;
+
+            case Role::STANDBY:
+                // Without an identity there is nothing to take over
+                if (!_identity.known || now - _lastPeerBeaconMs < _takeoverMs) {
+                    return Event::NONE;
+                }
+                _identity.generation++;
+                _dirty = true;
+                _role = Role::ACTIVE;
+                return Event::BECAME_ACTIVE;
+
+            case Role::ACTIVE:
+                return Event::NONE;
+        }
+        return Event::NONE;
+    }
+
+    Role getRole() const { return _role; }
+    bool isActive() const { return _role == Role::ACTIVE; }
+    const Identity& getIdentity() const { return _identity; }
+    uint32_t getLastPeerBeaconMs() const { return _lastPeerBeaconMs; }
+
+    /**
+     * @brief true once after the identity changed (persist it)
+     */
+    bool takeDirty() {
+        bool dirty = _dirty;
+        _dirty = false;
+        return dirty;
+    }
+
+    static const char* roleString(Role role) {
+        switch (role) {
+            case Role::LISTENING: return "LISTENING";
+            case Role::ACTIVE: return "ACTIVE";
+            case Role::STANDBY: return "STANDBY";
+        }
+        return "UNKNOWN";
+    }
+
+private:
+    Role _role;
+    bool _preferStandby;
+    uint8_t _ownMac[6];
+    Identity _identity;
+    uint32_t _listenMs;
+    uint32_t _takeoverMs;
+    uint32_t _startedMs;
+    uint32_t _lastPeerBeaconMs;
+    bool _dirty;
+
+    // Generations wrap like sequence numbers
+    bool _newer(uint16_t generation) const {
+        return (int16_t)(generation - _identity.generation) > 0;
+    }
+
+    void _adopt(const uint8_t* hubId, uint16_t generation) {
+        if (!_identity.known || memcmp(hubId, _identity.hubId, 6) != 0 || _newer(generation)) {
+            memcpy(_identity.hubId, hubId, 6);
+            _identity.generation = generation;
+            _identity.known = true;
+            _dirty = true;
+        }
+    }
+};
+
+#endif // FAILOVER_POLICY_H
@@ -0,0 +1,172 @@
+#ifndef FEDERATION_MANAGER_H
+#define FEDERATION_MANAGER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <AsyncUDP.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "managers/FederationTable.h"
+#include "protocol/federation.h"
+
+/**
+ * @brief Several hubs on one LAN acting as one installation
+ *
+ * Every hub keeps its own ESP-NOW radio domain. Hubs with the same
+ * FEDERATION_GROUP exchange HELLO / DELTA / SYNC frames over UDP (see
+ * protocol/federation.h), so each of them can list every device of the
+ * installation (/api/federation/devices) and route a command to the hub
+ * that owns the device.
+ *
+ * UDP frames arrive in the AsyncUDP task and are queued; update() handles
+ * them in loop() like ESP-NOW frames, so device state is only touched
+ * from the main loop. The JSON accessors and routeCommand() are called
+ * from web handlers and take _mutex.
+ */
+class FederationManager {
+public:
+    static constexpr uint32_t HELLO_INTERVAL_MS = 2000;
+    static constexpr uint32_t PUBLISH_INTERVAL_MS = 500;     // DELTA broadcast check
+    static constexpr uint32_t COMMAND_TIMEOUT_MS = 2000;
+    static constexpr uint8_t RX_QUEUE_SIZE = 8;
+    static constexpr uint8_t MAX_STATIC_PEERS = 4;
+
+    /**
+     * @brief One command routed to the local radio or to the owning hub
+     *
+     * Created by routeCommand() and completed by update() on the main
+     * loop. Once isComplete() returns true the result is frozen and may
+     * be read from any task.
+     */
+    class RoutedCommand {
+    public:
+        enum class Outcome : uint8_t {
+            WAITING,
+            SENT,               // Handed to ESP-NOW (here or by the owner)
+            NOT_FOUND,          // No hub owns the device
+            OFFLINE,            // Device (or its hub) offline
+            SEND_FAILED,
+            TIMEOUT             // Owner did not answer
+        };
+
+        RoutedCommand(const uint8_t* mac, const uint8_t* data, uint8_t len);
+
+        bool isComplete() const { return _complete.load(std::memory_order_acquire); }
+        void toJson(JsonObject out) const;
+
+        static const char* outcomeString(Outcome outcome);
+
+    private:
+        friend class FederationManager;
+
+        uint8_t _mac[6];
+        uint8_t _data[MAX_COMMAND_DATA_LEN];
+        uint8_t _len;
+        uint16_t _ticket;           // 0 until forwarded
+        bool _remote;
+        uint8_t _hubId[6];          // Owning hub when _remote
+        String _hubName;
+        uint32_t _sentMs;
+        uint8_t _commandId;
+        Outcome _outcome;
+        std::atomic<bool> _complete;
+
+        void _finish(Outcome outcome, uint8_t commandId);
+    };
+
+    static FederationManager& getInstance();
+
+    /**
+     * @brief Start listening and announcing
+     * @param group Federation group name (empty = federation off)
+     * @param name Name shown on the other hubs
+     * @param port UDP port (same on every hub unless peers are listed)
+     * @param peers Comma-separated ip[:port] sent to in addition to broadcast
+     * @param httpPort This hub's web server port
+     * @return false if the group is empty or the socket could not open
+     */
+    bool begin(const String& group, const String& name, uint16_t port,
+               const String& peers, uint16_t httpPort);
+
+    /**
+     * @brief Handle received frames, publish changes, run routed
+     *        commands (call from loop(), also when not enabled)
+     */
+    void update();
+
+    bool isEnabled() const { return _enabled; }
+
+    /**
+     * @brief Send a command to a device of any hub in the federation
+     *
+     * Local devices are sent to directly; others are forwarded to the hub
+     * that published them. The result is filled in by update().
+     */
+    std::shared_ptr<RoutedCommand> routeCommand(const uint8_t* mac, const uint8_t* data, uint8_t len);
+
+    /**
+     * @brief This hub and its peers
+     */
+    void toJson(JsonObject out);
+
+    /**
+     * @brief Devices owned by the other hubs (Device::toJsonObject subset)
+     */
+    void remoteDevicesToJson(JsonArray out);
+
+private:
+    FederationManager();
+
+    struct RxFrame {
+        uint32_t ip;
+        uint16_t port;
+        uint16_t len;
+        uint8_t data[FEDERATION_MAX_FRAME];
+    };
+
+    struct StaticPeer {
+        IPAddress ip;
+        uint16_t port;
+    };
+
+    bool _enabled;
+    AsyncUDP _udp;
+    QueueHandle_t _rxQueue;
+    SemaphoreHandle_t _mutex;       // _table, _commands
+    FederationTable _table;
+    FederationHeader _header;       // Template for outgoing frames
+    char _name[FEDERATION_NAME_LEN + 1];
+    uint16_t _port;
+    uint16_t _httpPort;
+    StaticPeer _staticPeers[MAX_STATIC_PEERS];
+    uint8_t _staticPeerCount;
+    uint32_t _published;            // toVersion of the last DELTA broadcast
+    uint32_t _lastHelloMs;
+    uint32_t _lastPublishMs;
+    uint16_t _nextTicket;
+    std::vector<std::shared_ptr<RoutedCommand>> _commands;  // Waiting
+    uint32_t _framesReceived;
+    uint32_t _framesDropped;
+
+    void _handleFrame(const RxFrame& frame, uint32_t now);
+    void _handleSync(const FederationSync& sync, uint32_t ip, uint16_t port);
+    void _handleCommand(const FederationCommand& command, uint32_t ip, uint16_t port);
+    void _handleResult(const FederationCommandResult& result);
+    void _runCommands(uint32_t now);
+
+    void _sendHello();
+    void _publish();
+    void _sendDelta(uint32_t from, uint32_t to, bool full,
+                    const std::vector<FederationDeviceRecord>& records, uint32_t ip, uint16_t port);
+    bool _collectChanges(uint32_t since, bool full, std::vector<FederationDeviceRecord>& records);
+    void _sendSync(const FederationTable::Peer& peer);
+
+    void _fillHeader(FederationHeader& header, FederationType type);
+    void _sendToAll(const uint8_t* data, size_t len);
+    void _sendTo(const uint8_t* data, size_t len, uint32_t ip, uint16_t port);
+
+    static uint32_t _groupHash(const String& group);
+};
+
+#endif // FEDERATION_MANAGER_H
@@ -0,0 +1,241 @@
+#ifndef FEDERATION_TABLE_H
+#define FEDERATION_TABLE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include "protocol/federation.h"
+
+/**
+ * @brief What this hub knows about the other hubs of its federation
+ *
+ * Pure bookkeeping: no sockets, flash or clock of its own, so several
+ * hubs can be run against each other on the host. FederationManager feeds
+ * it the HELLO and DELTA frames it receives and sends a SYNC whenever a
+ * call returns Action::REQUEST_SYNC.
+ *
+ * Per peer it keeps the devices the peer owns, as of (bootId, version).
+ * Records are replaced only by a record with an equal or newer version,
+ * so an overlapping DELTA (e.g. a broadcast that crosses a SYNC reply)
+ * never rolls a device back.
+ */
+class FederationTable {
+public:
+    static constexpr uint8_t MAX_PEERS = 8;
+    static constexpr uint8_t MAX_DEVICES_PER_PEER = 64;
+    static constexpr uint32_t PEER_TIMEOUT_MS = 6000;       // 3 missed HELLOs
+    static constexpr uint32_t PEER_FORGET_MS = 300000;      // Drop silent peers
+    static constexpr uint32_t SYNC_RETRY_MS = 1000;
+
+    enum class Action : uint8_t {
+        NONE,
+        REQUEST_SYNC        // Send SYNC(peer.bootId, peer.version) to the peer
+    };
+
+    struct Peer {
+        uint8_t hubId[6];
+        char name[FEDERATION_NAME_LEN + 1];
+        uint32_t ip;                // Where its frames come from
+        uint16_t port;
+        uint16_t httpPort;
+        uint32_t bootId;            // 0 until the first FULL delta
+        uint32_t version;           // Devices known up to this version
+        uint32_t publishedVersion;  // From its last HELLO
+        uint32_t lastSeenMs;
+        uint32_t lastSyncMs;
+        bool syncSent;
+        std::vector<FederationDeviceRecord> devices;
+    };
+
+    FederationTable() {}
+
+    /**
+     * @brief HELLO from a peer (creates it if new)
+     * @param index Set to the peer's index
+     */
+    Action onHello(const FederationHello& hello, uint32_t ip, uint16_t port,
+                   uint32_t now, uint8_t& index) {
+        Peer* peer = _touch(hello.header.hubId, ip, port, now, index);
+        if (!peer) {
+            return Action::NONE;
+        }
+        memcpy(peer->name, hello.name, FEDERATION_NAME_LEN);
+        peer->name[FEDERATION_NAME_LEN] = '\0';
+        peer->httpPort = hello.httpPort;
+        peer->publishedVersion = hello.publishedVersion;
+
+        bool behind = peer->bootId != hello.header.bootId ||
+                      (int32_t)(hello.publishedVersion - peer->version) > 0;
+        return behind ? _requestSync(*peer, now) : Action::NONE;
+    }
+
+    /**
+     * @brief DELTA from a peer
+     * @param records count records following the DELTA header
+     */
+    Action onDelta(const FederationDelta& delta, const FederationDeviceRecord* records,
+                   uint32_t ip, uint16_t port, uint32_t now, uint8_t& index) {
+        Peer* peer = _touch(delta.header.hubId, ip, port, now, index);
+        if (!peer) {
+            return Action::NONE;
+        }
+
+        if (delta.flags & FEDERATION_DELTA_FULL) {
+            peer->devices.clear();
+            peer->bootId = delta.header.bootId;
+            peer->version = 0;
+        } else if (peer->bootId != delta.header.bootId ||
+                   (int32_t)(delta.fromVersion - peer->version) > 0) {
+            // Peer restarted, or we missed a DELTA in between
+            return _requestSync(*peer, now);
+        }
+
+        for (uint8_t i = 0; i < delta.count; i++) {
+            _apply(*peer, records[i]);
+        }
+        if ((int32_t)(delta.toVersion - peer->version) > 0) {
+            peer->version = delta.toVersion;
+        }
+        peer->syncSent = false;
+        return Action::NONE;
+    }
+
+    /**
+     * @brief Forget peers silent for PEER_FORGET_MS
+     */
+    void expire(uint32_t now) {
+        for (size_t i = 0; i < _peers.size(); ) {
+            if (now - _peers[i].lastSeenMs >= PEER_FORGET_MS) {
+                _peers.erase(_peers.begin() + i);
+            } else {
+                i++;
+            }
+        }
+    }
+
+    size_t peerCount() const { return _peers.size(); }
+    const Peer& getPeer(size_t index) const { return _peers[index]; }
+
+    bool isOnline(const Peer& peer, uint32_t now) const {
+        return now - peer.lastSeenMs < PEER_TIMEOUT_MS;
+    }
+
+    /**
+     * @return Peer index, or -1 if the hub never sent us a frame
+     */
+    int findPeer(const uint8_t* hubId) const {
+        for (size_t i = 0; i < _peers.size(); i++) {
+            if (memcmp(_peers[i].hubId, hubId, 6) == 0) {
+                return (int)i;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Peer owning a device (online peers first)
+     * @return Peer index, or -1
+     */
+    int findOwner(const uint8_t* mac, uint32_t now) const {
+        int fallback = -1;
+        for (size_t i = 0; i < _peers.size(); i++) {
+            for (const FederationDeviceRecord& record : _peers[i].devices) {
+                if (memcmp(record.mac, mac, 6) != 0) {
+                    continue;
+                }
+                if (isOnline(_peers[i], now)) {
+                    return (int)i;
+                }
+                if (fallback < 0) {
+                    fallback = (int)i;
+                }
+            }
+        }
+        return fallback;
+    }
+
+    /**
+     * @brief Order changes for one DELTA and cap them at FEDERATION_MAX_RECORDS
+     *
+     * Sorts by version; when records are dropped, toVersion is lowered to
+     * the last record sent so the next DELTA (or SYNC) continues there.
+     */
+    static void selectDelta(std::vector<FederationDeviceRecord>& changes, uint32_t& toVersion) {
+        std::sort(changes.begin(), changes.end(),
+                  [](const FederationDeviceRecord& a, const FederationDeviceRecord& b) {
+                      return (int32_t)(a.version - b.version) < 0;
+                  });
+        if (changes.size() > FEDERATION_MAX_RECORDS) {
+            changes.resize(FEDERATION_MAX_RECORDS);
+            toVersion = changes.back().version;
+        }
+    }
+
+private:
+    std::vector<Peer> _peers;
+
+    Peer* _touch(const uint8_t* hubId, uint32_t ip, uint16_t port, uint32_t now, uint8_t& index) {
+        for (size_t i = 0; i < _peers.size(); i++) {
+            if (memcmp(_peers[i].hubId, hubId, 6) == 0) {
+                _peers[i].ip = ip;
+                _peers[i].port = port;
+                _peers[i].lastSeenMs = now;
+                index = (uint8_t)i;
+                return &_peers[i];
+            }
+        }
+        if (_peers.size() >= MAX_PEERS) {
+            return nullptr;
+        }
+
+        Peer peer;
+        memcpy(peer.hubId, hubId, 6);
+        memset(peer.name, 0, sizeof(peer.name));
+        peer.ip = ip;
+        peer.port = port;
+        peer.httpPort = 0;
+        peer.bootId = 0;
+        peer.version = 0;
+        peer.publishedVersion = 0;
+        peer.lastSeenMs = now;
+        peer.lastSyncMs = 0;
+        peer.syncSent = false;
+        _peers.push_back(peer);
+        index = (uint8_t)(_peers.size() - 1);
+        return &_peers.back();
+    }
+
+    Action _requestSync(Peer& peer, uint32_t now) {
+        if (peer.syncSent && now - peer.lastSyncMs < SYNC_RETRY_MS) {
+            return Action::NONE;  // Reply still in flight
+        }
+        peer.syncSent = true;
+        peer.lastSyncMs = now;
+        return Action::REQUEST_SYNC;
+    }
+
+    static void _apply(Peer& peer, const FederationDeviceRecord& record) {
+        for (size_t i = 0; i < peer.devices.size(); i++) {
+            FederationDeviceRecord& known = peer.devices[i];
+            if (memcmp(known.mac, record.mac, 6) != 0) {
+                continue;
+            }
+            if ((int32_t)(record.version - known.version) < 0) {
+                return;  // Older than what we have
+            }
+            if (record.status == FEDERATION_STATUS_REMOVED) {
+                peer.devices.erase(peer.devices.begin() + i);
+            } else {
+                known = record;
+            }
+            return;
+        }
+        if (record.status != FEDERATION_STATUS_REMOVED &&
+            peer.devices.size() < MAX_DEVICES_PER_PEER) {
+            peer.devices.push_back(record);
+        }
+    }
+};
+
+#endif // FEDERATION_TABLE_H
@@ -0,0 +1,135 @@
+#ifndef PROVISIONING_MANAGER_H
+#define PROVISIONING_MANAGER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <functional>
+#include "managers/DeviceConfigStore.h"
+
+/**
+ * @brief Confirmed provision / unmap transactions
+ *
+ * A transaction sends CONFIG (or UNMAP) carrying a token, waits for the
+ * node's STATUS echoing that token, and only then applies the change to
+ * devices.json / unmapped-devices.json through DeviceConfigStore (one
+ * tmp + rename commit). A missing confirmation is retried; after
+ * MAX_ATTEMPTS the transaction rolls back: nothing is persisted, and a
+ * provision is compensated with a best-effort UNMAP so the node returns
+ * to discovery. If the commit itself fails after confirmation, the node
+ * is unmapped the same way and the transaction ends FAILED.
+ *
+ * Each transaction is a small continuation: begin*() validates and
+ * returns an ID at once, handleStatus() records the confirmation, update()
+ * advances it from the main loop, and the optional Completion runs when
+ * it settles. Everything confirmed between two update() passes is
+ * committed with one store load and one write; if that write fails, all
+ * of them end FAILED together. Web
+ * handlers therefore never wait on the radio, and any number of MACs
+ * (up to MAX_TRANSACTIONS) can be in flight together; one MAC has at
+ * most one open transaction.
+ *
+ * An unmap whose node is offline commits straight away (unconfirmed), as
+ * before: the node re-announces as unmapped when it returns.
+ */
+class ProvisioningManager {
+public:
+    static constexpr uint8_t MAX_TRANSACTIONS = 16;        // Open + finished kept for polling
+    static constexpr uint8_t MAX_ATTEMPTS = 3;
+    static constexpr uint32_t ATTEMPT_TIMEOUT_MS = 3000;   // Covers one power-save beacon interval
+    static constexpr uint32_t RESULT_TTL_MS = 300000;      // Finished results stay pollable
+
+    enum class Kind : uint8_t {
+        PROVISION,
+        UNMAP
+    };
+
+    enum class State : uint8_t {
+        PENDING,        // Frame sent, awaiting confirmation
+        COMMITTED,      // Confirmed (or node offline for unmap) and persisted
+        ROLLED_BACK,    // No confirmation; nothing persisted
+        FAILED          // Confirmed but persisting failed; node unmapped again
+    };
+
+    struct Transaction {
+        uint32_t id;                // 0 = free slot
+        Kind kind;
+        State state;
+        String macStr;
+        uint8_t mac[6];
+        String name;                // Provision only
+        uint8_t tankId;             // Provision only
+        uint8_t token;              // Echoed by the node, 1-255
+        uint8_t attempts;           // Frames sent so far
+        bool confirmed;             // Node acknowledged
+        uint32_t startedMs;
+        uint32_t lastSendMs;
+        uint32_t finishedMs;
+        String error;               // Set for ROLLED_BACK / FAILED
+    };
+
+    typedef std::function<void(const Transaction&)> Completion;
+
+    static ProvisioningManager& getInstance();
+
+    /**
+     * @brief Start provisioning an unmapped device
+     * @param error Set when 0 is returned
+     * @param store Loaded store to validate against (batches); nullptr loads one
+     * @return Transaction ID, 0 if rejected up front
+     */
+    uint32_t beginProvision(const String& macStr, const String& name, uint8_t tankId,
+                            DeviceConfigStore::Error& error, Completion onComplete = nullptr,
+                            DeviceConfigStore* store = nullptr);
+
+    /**
+     * @brief Start returning a mapped device to the unmapped list
+     */
+    uint32_t beginUnmap(const String& macStr, DeviceConfigStore::Error& error,
+                        Completion onComplete = nullptr, DeviceConfigStore* store = nullptr);
+
+    /**
+     * @brief Whether a MAC has a pending transaction (direct edits must wait)
+     */
+    bool isPending(const uint8_t* mac);
+
+    /**
+     * @brief Send, retry and time out transactions (call from loop())
+     */
+    void update();
+
+    /**
+     * @brief Record a CONFIG / UNMAP confirmation (ESP-NOW STATUS callback); update() commits it
+     * @return true if the STATUS was a confirmation and must not reach AquariumManager
+     */
+    bool handleStatus(const uint8_t* mac, const StatusMessage& msg);
+
+    /**
+     * @brief Copy a transaction for polling
+     * @return false if unknown or expired
+     */
+    bool get(uint32_t id, Transaction& out);
+
+    void toJson(JsonArray out);
+    static void toJson(const Transaction& transaction, JsonObject out);
+    static const char* stateString(State state);
+
+private:
+    ProvisioningManager();
+
+    Transaction _transactions[MAX_TRANSACTIONS];
+    Completion _completions[MAX_TRANSACTIONS];
+    SemaphoreHandle_t _mutex;
+    uint32_t _nextId;
+    uint8_t _nextToken;
+
+    uint32_t _begin(Kind kind, const String& macStr, const String& name, uint8_t tankId,
+                    DeviceConfigStore::Error& error, Completion onComplete,
+                    DeviceConfigStore* store);
+    int _allocate(const uint8_t* mac, DeviceConfigStore::Error& error);
+    void _commit(const uint8_t* slots, uint8_t count);
+    void _rollBack(uint8_t slot, const char* reason);
+    void _finish(uint8_t slot, State state, const char* error);
+    bool _send(const Transaction& transaction);
+};
+
+#endif // PROVISIONING_MANAGER_H
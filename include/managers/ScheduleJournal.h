@@ -0,0 +1,98 @@
+#ifndef SCHEDULE_JOURNAL_H
+#define SCHEDULE_JOURNAL_H
+
+#include <Arduino.h>
+#include <map>
+#include "models/Schedule.h"
+
+/**
+ * @brief Persisted firing state of every schedule
+ *
+ * Each firing appends one 24-byte record (device, schedule, scheduled
+ * time, execution count) to schedules.jnl *before* the command is sent.
+ * After a reboot the last record per schedule is restored into the
+ * Schedule, so a firing that was already taken is never taken again; a
+ * crash between the append and the send loses that one firing rather than
+ * repeating it (at-most-once). Firings missed while the hub was down are
+ * left to the schedule's CatchUp policy.
+ *
+ * Only the latest record per schedule matters, so once COMPACT_RECORDS
+ * have been appended the file is rewritten with one record per schedule
+ * (tmp file + rename, like the JSON config stores). A torn last record
+ * fails its CRC and is dropped on load.
+ *
+ * Records are keyed on epoch seconds; nothing runs until NTP has set the
+ * clock.
+ */
+class ScheduleJournal {
+public:
+    static constexpr const char* JOURNAL_FILE = "/config/schedules.jnl";
+    static constexpr uint16_t COMPACT_RECORDS = 512;    // Appends before rewrite (12 KB)
+
+    static ScheduleJournal& getInstance();
+
+    /**
+     * @brief Replay the journal into RAM
+     * @return false if the file is unreadable; firings then only dedupe in RAM
+     */
+    bool begin();
+
+    /**
+     * @brief Record a firing about to be executed
+     * @param firing Scheduled time (Schedule::dueFiring())
+     * @param count Execution count including this firing
+     * @return true if the record reached flash
+     */
+    bool recordFiring(const uint8_t* mac, uint32_t scheduleId, uint32_t firing, uint32_t count);
+
+    /**
+     * @brief Apply persisted state to a schedule attached to a device
+     */
+    void restore(const uint8_t* mac, Schedule& schedule) const;
+
+    /**
+     * @brief Drop a deleted schedule (takes effect at next compaction)
+     */
+    void forget(const uint8_t* mac, uint32_t scheduleId);
+
+    /**
+     * @brief Compact if due (call from loop())
+     */
+    void update();
+
+    size_t getTrackedCount() const { return _state.size(); }
+
+private:
+    ScheduleJournal();
+
+    struct JournalRecord {
+        uint8_t mac[6];
+        uint16_t reserved;
+        uint32_t scheduleId;
+        uint32_t firing;            // Unix seconds
+        uint32_t count;
+        uint16_t reserved2;
+        uint16_t crc;               // CRC-16/CCITT of the bytes above
+    } __attribute__((packed));
+
+    static_assert(sizeof(JournalRecord) == 24, "JournalRecord must stay 24 bytes");
+
+    struct FiringState {
+        uint32_t firing;
+        uint32_t count;
+    };
+
+    typedef std::pair<uint64_t, uint32_t> Key;     // MAC, schedule ID
+
+    SemaphoreHandle_t _mutex;
+    bool _ready;
+    std::map<Key, FiringState> _state;
+    uint16_t _appended;             // Records since last compaction
+    bool _compactPending;           // Compaction due (appends or torn tail)
+
+    bool _compact();
+    static Key _key(const uint8_t* mac, uint32_t scheduleId);
+    static uint16_t _crc16(const uint8_t* data, size_t len);
+};
+
+#endif // SCHEDULE_JOURNAL_H
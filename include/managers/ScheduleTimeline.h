@@ -0,0 +1,107 @@
+#ifndef SCHEDULE_TIMELINE_H
+#define SCHEDULE_TIMELINE_H
+
+#include <Arduino.h>
+#include <vector>
+#include <ArduinoJson.h>
+#include "models/Schedule.h"
+#include "protocol/messages.h"
+
+/**
+ * @brief Compiled, merged view of every device schedule
+ *
+ * DAILY and WEEKLY schedules repeat every week, so their firing minutes
+ * are compiled once into a single array sorted by minute-of-week. A
+ * preview of any window is then a binary search plus a linear walk over
+ * the entries inside it, independent of how many schedules exist. The
+ * index is rebuilt only when Schedule::getGeneration() changes.
+ *
+ * ONE_TIME and INTERVAL schedules depend on runtime state (execution
+ * count, last run) and are expanded per query from a short list.
+ *
+ * Times are Unix seconds, the scheduler's clock.
+ */
+class ScheduleTimeline {
+public:
+    static constexpr uint32_t DEFAULT_SPAN_SEC = 24 * 3600;     // Preview one day
+    static constexpr uint32_t MAX_SPAN_SEC = 7 * 24 * 3600;     // One full week
+    static constexpr size_t MAX_EVENTS = 256;                   // Per response
+
+    /**
+     * @brief One firing of a schedule
+     */
+    struct Event {
+        uint32_t time;              // Scheduler clock (seconds)
+        uint8_t mac[6];             // Target device
+        uint32_t scheduleId;
+        uint32_t commandHash;       // FNV-1a of the command bytes
+        uint8_t opcode;             // commandData[0]
+        NodeType nodeType;
+    };
+
+    static ScheduleTimeline& getInstance();
+
+    /**
+     * @brief Rebuild the weekly index if any schedule changed
+     * @return true if the index was rebuilt
+     */
+    bool refresh();
+
+    /**
+     * @brief Collect firings in [from, to), sorted by time then device
+     * @param out Receives at most maxEvents events
+     * @return true if more events exist than were returned
+     */
+    bool query(uint32_t from, uint32_t to, std::vector<Event>& out, size_t maxEvents);
+
+    /**
+     * @brief Build the /api/timeline response
+     *
+     * Lists the firings and analyses each device's sequence:
+     *  - conflict:  two schedules send different commands in the same minute
+     *  - duplicate: two schedules send the same command in the same minute
+     *  - no-change: a state command (light/heater/CO2) repeats the command
+     *               already in effect
+     */
+    void toJson(uint32_t from, uint32_t to, JsonObject out);
+
+    size_t getIndexedCount() const { return _weekly.size(); }
+
+private:
+    ScheduleTimeline();
+
+    /**
+     * @brief Compiled DAILY/WEEKLY firing
+     */
+    struct Entry {
+        uint16_t minute;            // Minutes since Sunday 00:00
+        uint8_t mac[6];
+        NodeType nodeType;
+        uint8_t opcode;
+        uint32_t scheduleId;
+        uint32_t commandHash;
+    };
+
+    /**
+     * @brief ONE_TIME/INTERVAL schedule, resolved live at query time
+     */
+    struct SparseRef {
+        uint8_t mac[6];
+        uint32_t scheduleId;
+    };
+
+    std::vector<Entry> _weekly;         // Sorted by minute, then MAC
+    std::vector<SparseRef> _sparse;
+    uint32_t _builtGeneration;
+    bool _built;
+
+    void _build();
+    void _appendSparse(const Schedule& schedule, const SparseRef& ref, NodeType nodeType,
+                       uint32_t from, uint32_t to, std::vector<Event>& out, size_t maxEvents) const;
+
+    static uint32_t _weekStart(uint32_t time);
+    static uint32_t _hashCommand(const uint8_t* data, size_t length);
+    static bool _isStateCommand(NodeType type);
+};
+
+#endif // SCHEDULE_TIMELINE_H
@@ -0,0 +1,160 @@
+#ifndef TASK_EXECUTOR_H
+#define TASK_EXECUTOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+
+/**
+ * @brief Fixed pool of background workers for hub housekeeping
+ *
+ * One worker per core, each owning a bounded FIFO per priority. A job is
+ * queued on the submitting core's worker; a worker takes the oldest job
+ * of the highest priority from its own queues, and when those are empty
+ * steals the newest job of that priority from another worker, so both
+ * S3 cores share slow work (file writes, checkpoints) instead of it
+ * running inline in loop() or an AsyncTCP handler.
+ *
+ * Deadlines are cooperative: a job is never interrupted, but it can ask
+ * its JobContext whether its deadline has passed and cut work short.
+ * Jobs that start after their deadline are counted as late.
+ *
+ * A non-zero key coalesces submissions and serializes their runs: while a
+ * job with that key is queued, submitting it again is a no-op; while it
+ * runs, submitting it again re-queues it once after it finishes. So at
+ * most one run per key is in flight, and a change made during a save is
+ * picked up by the next one.
+ *
+ * Until begin() succeeds, submit() runs the job inline. The platform layer
+ * is FreeRTOS on the hub and std::thread in native builds.
+ */
+class TaskExecutor {
+public:
+    static constexpr uint8_t MAX_WORKERS = 2;
+    static constexpr uint8_t QUEUE_CAPACITY = 16;          // Per worker and priority
+    static constexpr uint32_t IDLE_WAIT_MS = 100;          // Idle workers look for work to steal
+    static constexpr uint32_t STATS_WINDOW_MS = 1000;      // Minimum utilization window
+    static constexpr uint32_t WORKER_STACK_SIZE = 8192;
+    static constexpr uint8_t WORKER_PRIORITY = 1;          // Below the watchdog task
+
+    // Not HIGH/LOW: Arduino defines those as macros
+    enum class Priority : uint8_t {
+        URGENT = 0,
+        NORMAL = 1,
+        BACKGROUND = 2
+    };
+    static constexpr uint8_t PRIORITY_COUNT = 3;
+
+    /**
+     * @brief What a running job may ask about itself
+     */
+    class JobContext {
+    public:
+        JobContext(uint32_t deadlineMs, bool hasDeadline, uint8_t worker)
+            : _deadlineMs(deadlineMs), _hasDeadline(hasDeadline), _worker(worker) {}
+
+        bool expired() const;
+        uint32_t remainingMs() const;               // UINT32_MAX without deadline
+        uint8_t getWorker() const { return _worker; }
+
+    private:
+        uint32_t _deadlineMs;
+        bool _hasDeadline;
+        uint8_t _worker;
+    };
+
+    typedef std::function<void(const JobContext&)> Job;
+
+    /**
+     * @brief Counters since begin(); utilization and latency over the last window
+     */
+    struct Stats {
+        uint8_t workers;
+        uint32_t submitted;
+        uint32_t coalesced;         // Merged into a queued or running job of the same key
+        uint32_t rejected;          // Queues full
+        uint32_t executed;
+        uint32_t stolen;            // Run by a worker other than the one queued on
+        uint32_t late;              // Started after their deadline
+        uint16_t queued;
+        uint8_t utilizationPct[MAX_WORKERS];
+        uint32_t avgLatencyUs;      // Queue wait
+        uint32_t maxLatencyUs;
+        uint32_t windowMs;
+    };
+
+    static TaskExecutor& getInstance();
+
+    /**
+     * @brief Start the workers
+     * @param workers Number of workers (1 to MAX_WORKERS), pinned to cores 0..n-1
+     * @return false if no worker could be started (jobs then run inline)
+     */
+    bool begin(uint8_t workers = MAX_WORKERS);
+
+    /**
+     * @brief Stop and join the workers (native builds; jobs still queued run first)
+     */
+    void end();
+
+    /**
+     * @brief Queue a job
+     * @param job Work to run
+     * @param priority Queue to use
+     * @param deadlineMs Time budget from now (0 = none)
+     * @param key Coalescing key 1-31 (0 = always queue)
+     * @return false if every queue for that priority is full
+     */
+    bool submit(Job job, Priority priority = Priority::NORMAL, uint32_t deadlineMs = 0, uint8_t key = 0);
+
+    bool isRunning() const { return _workerCount > 0; }
+
+    /**
+     * @brief Snapshot counters; the window restarts after STATS_WINDOW_MS
+     */
+    Stats getStats();
+
+private:
+    TaskExecutor();
+
+    struct Slot;
+    struct Worker;
+
+    Worker* _workers[MAX_WORKERS];
+    uint8_t _workerCount;
+    std::atomic<bool> _stopping;
+    uint32_t _pendingKeys;                  // Bit per key queued or running
+    uint32_t _runningKeys;
+    uint32_t _rerunKeys;                    // Submitted again while running
+    std::atomic<uint32_t> _nextWorker;      // Native round-robin
+
+    std::atomic<uint32_t> _submitted;
+    std::atomic<uint32_t> _coalesced;
+    std::atomic<uint32_t> _rejected;
+    std::atomic<uint32_t> _executed;
+    std::atomic<uint32_t> _stolen;
+    std::atomic<uint32_t> _late;
+    std::atomic<uint32_t> _latencySumUs;    // Current window
+    std::atomic<uint32_t> _latencyCount;
+    std::atomic<uint32_t> _latencyMaxUs;
+
+    Stats _lastStats;                       // Returned within a window
+    uint32_t _windowStartMs;
+    uint32_t _windowBusyUs[MAX_WORKERS];
+
+    bool _enqueue(Slot& slot, uint8_t first);
+    bool _push(uint8_t worker, Slot& slot, uint8_t priority);
+    bool _take(uint8_t self, Slot& slot, bool& stolen);
+    void _run(uint8_t self);
+    void _releaseKey(uint8_t key);
+    void _finishKey(uint8_t self, Slot& slot);
+    void _wake(uint8_t worker);
+    uint8_t _localWorker();
+
+    static void _workerEntry(void* parameter);
+    static uint32_t _nowMs();
+    static uint32_t _nowUs();
+};
+
+#endif // TASK_EXECUTOR_H
@@ -4,7 +4,10 @@
 #include <Arduino.h>
 #include <vector>
 #include <map>
+#include <ArduinoJson.h>
 #include "Device.h"
+#include "SensorStreamMonitor.h"
+#include "TemperatureFusion.h"
 
 /**
  * @brief Aquarium class representing a single aquarium/tank
@@ -45,11 +48,30 @@ public:
     uint16_t getMinTds() const { return _minTds; }
     uint16_t getMaxTds() const { return _maxTds; }
     
-    // Current readings (from sensors)
+    // Current readings (temperature: fused estimate; pH/TDS: last reading not flagged suspect)
     float getCurrentTemperature() const { return _currentTemperature; }
+    float getTemperatureConfidence() const { return _temperatureFusion.getConfidence(millis()); }
     float getCurrentPh() const { return _currentPh; }
     uint16_t getCurrentTds() const { return _currentTds; }
     uint32_t getLastSensorUpdate() const { return _lastSensorUpdate; }
+    uint32_t getVersion() const { return _version; }
+    
+    // Probe health (see SensorStreamMonitor)
+    const SensorStreamMonitor& getTemperatureMonitor() const { return _temperatureMonitor; }
+    const SensorStreamMonitor& getPhMonitor() const { return _phMonitor; }
+    const SensorStreamMonitor& getTdsMonitor() const { return _tdsMonitor; }
+    const TemperatureFusion& getTemperatureFusion() const { return _temperatureFusion; }
+    
+    /**
+     * @brief Reading is recent and not flagged suspect
+     * 
+     * Control loops should act only on trusted readings. Temperature is
+     * trusted while the fused estimate's confidence is at least
+     * MIN_TEMPERATURE_CONFIDENCE.
+     */
+    bool hasTrustedTemperature() const { return getTemperatureConfidence() >= MIN_TEMPERATURE_CONFIDENCE; }
+    bool hasTrustedPh() const { return _isTrusted(_phMonitor); }
+    bool hasTrustedTds() const { return _isTrusted(_tdsMonitor); }
     
     // ===== Setters =====
     void setName(const String& name) { _name = name; }
@@ -58,6 +80,7 @@ public:
     void setLocation(const String& loc) { _location = loc; }
     void setDescription(const String& desc) { _description = desc; }
     void setEnabled(bool enabled) { _enabled = enabled; }
+    void setVersion(uint32_t version) { _version = version; }
     
     // Water parameters
     void setTargetTemperature(float temp) { _targetTemperature = temp; }
@@ -75,10 +98,27 @@ public:
         _maxTds = max;
     }
     
-    // Current readings update
-    void updateTemperature(float temp);
-    void updatePh(float ph);
-    void updateTds(uint16_t tds);
+    /**
+     * @brief Feed a sensor reading through its stream monitor
+     * 
+     * Suspect readings (spike, rate, flatline) are recorded by the monitor
+     * but do not replace the current value. Temperature readings that pass
+     * are fused with the other temperature sources of this tank.
+     * @param timestampMs millis() the reading was taken (0 = now)
+     * @param sourceMac Sensor node the reading came from (temperature only)
+     * @return SensorStreamMonitor::FLAG_* bits for this reading
+     */
+    uint8_t updateTemperature(float temp, uint32_t timestampMs = 0, const uint8_t* sourceMac = nullptr);
+    uint8_t updatePh(float ph, uint32_t timestampMs = 0);
+    uint8_t updateTds(uint16_t tds, uint32_t timestampMs = 0);
+    
+    /**
+     * @brief Fuse a reading from a heater's own probe
+     * 
+     * Not anomaly-checked on its own; the fusion gate rejects outliers.
+     * @return Outcome of the fusion update
+     */
+    TemperatureFusion::Result updateHeaterTemperature(float temp, const uint8_t* heaterMac, uint32_t timestampMs = 0);
     
     // ===== Device Management =====
     /**
@@ -131,13 +171,15 @@ public:
     // ===== Status Checks =====
     /**
      * @brief Check if temperature is within safe range
-     * @return true if within range
+     * @return true if within range, or no probe has reported yet.
+     *         Stale or suspect data counts as unsafe.
      */
     bool isTemperatureSafe() const;
     
     /**
      * @brief Check if pH is within safe range
-     * @return true if within range
+     * @return true if within range, or no probe has reported yet.
+     *         Stale or suspect data counts as unsafe.
      */
     bool isPhSafe() const;
     
@@ -160,6 +202,15 @@ public:
      */
     String toJson() const;
     
+    /**
+     * @brief Write aquarium fields into an existing JSON object
+     * 
+     * Shared by toJson(), the REST handlers and WebSocket telemetry so
+     * that every wire encoding renders the same document.
+     * @param obj Destination object
+     */
+    void toJsonObject(JsonObject obj) const;
+    
     /**
      * @brief Load aquarium from JSON
      * @param json JSON string
@@ -202,11 +253,25 @@ private:
     uint16_t _maxTds;               // Max TDS (ppm)
     
     // Current sensor readings
-    float _currentTemperature;      // Last reading (°C)
+    float _currentTemperature;      // Fused estimate (°C)
     float _currentPh;               // Last reading
     uint16_t _currentTds;           // Last reading (ppm)
     uint32_t _lastSensorUpdate;     // millis() of last update
     
+    // Per-stream anomaly detection
+    SensorStreamMonitor _temperatureMonitor;
+    SensorStreamMonitor _phMonitor;
+    SensorStreamMonitor _tdsMonitor;
+    
+    // Sensor + heater probes -> one temperature
+    TemperatureFusion _temperatureFusion;
+    
+    static constexpr uint32_t SENSOR_STALE_MS = 300000;  // 5 minutes
+    static constexpr float MIN_TEMPERATURE_CONFIDENCE = 0.5f;
+    
+    // Change tracking
+    uint32_t _version;              // Manager state version of last change
+    
     // Device registry (MAC address -> Device pointer)
     std::map<uint64_t, Device*> _devices;
     
@@ -214,6 +279,8 @@ private:
      * @brief Convert MAC address to uint64_t key
      */
     uint64_t _macToKey(const uint8_t* mac) const;
+    
+    bool _isTrusted(const SensorStreamMonitor& monitor) const;
 };
 
 #endif // AQUARIUM_H
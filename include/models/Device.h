@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <vector>
+#include <ArduinoJson.h>
 #include "protocol/messages.h"
 #include "Schedule.h"
 
@@ -42,18 +43,19 @@ public:
     const uint8_t* getMac() const { return _mac; }
     String getMacString() const;
     NodeType getType() const { return _type; }
-    String getTypeName() const;
+    String getTypeName() const { return typeName(_type); }
     String getName() const { return _name; }
     uint8_t getTankId() const { return _tankId; }
     uint8_t getFirmwareVersion() const { return _firmwareVersion; }
     Status getStatus() const { return _status; }
-    String getStatusString() const;
+    String getStatusString() const { return statusName(_status); }
     bool isOnline() const { return _status == Status::ONLINE; }
     bool isEnabled() const { return _enabled; }
     
     // Timing info
     uint32_t getLastHeartbeat() const { return _lastHeartbeat; }
     uint32_t getLastCommandSent() const { return _lastCommandSent; }
+    uint8_t getLastCommandId() const { return _lastCommandId; }
     uint32_t getLastStatusReceived() const { return _lastStatusReceived; }
     uint16_t getUptimeMinutes() const { return _uptimeMinutes; }
     uint8_t getHealth() const { return _health; }
@@ -63,6 +65,10 @@ public:
     uint32_t getMessagesSent() const { return _messagesSent; }
     uint32_t getCommandsSent() const { return _commandsSent; }
     uint32_t getErrorCount() const { return _errorCount; }
+    uint32_t getVersion() const { return _version; }
+    
+    static const char* typeName(NodeType type);
+    static const char* statusName(Status status);
     
     // ===== Setters =====
     void setName(const String& name) { _name = name; }
@@ -70,6 +76,7 @@ public:
     void setFirmwareVersion(uint8_t version) { _firmwareVersion = version; }
     void setEnabled(bool enabled) { _enabled = enabled; }
     void setStatus(Status status) { _status = status; }
+    void setVersion(uint32_t version) { _version = version; }
     
     // ===== Heartbeat Management =====
     /**
@@ -86,9 +93,41 @@ public:
      */
     bool hasHeartbeatTimedOut(uint32_t timeoutMs) const;
     
+    /**
+     * @brief Store command timing reported in the latest heartbeat
+     * @param diagnostics Diagnostics tail of a HeartbeatDiagMessage
+     */
+    void updateDiagnostics(const HeartbeatDiagnostics& diagnostics);
+    
+    bool hasDiagnostics() const { return _hasDiagnostics; }
+    const HeartbeatDiagnostics& getDiagnostics() const { return _diagnostics; }
+    
+    /**
+     * @brief Store the hub's view of the radio link (rate adaptation)
+     * @param rateKbps ESP-NOW PHY rate used towards the device
+     * @param rssi RSSI of its frames in dBm (0 = unknown)
+     * @param deliveryPercent Sends the device acknowledged
+     */
+    void updateLink(uint16_t rateKbps, int8_t rssi, uint8_t deliveryPercent);
+    
+    /**
+     * @brief Store the protocol agreed in the device's last ANNOUNCE
+     * @return true if it differs from the stored one
+     */
+    bool setProtocol(const ProtocolInfo& protocol);
+    
+    const ProtocolInfo& getProtocol() const { return _protocol; }
+    
     // ===== Command Management =====
     /**
      * @brief Send command to device
+     * 
+     * commandData is an encoded protocol/commands.h payload. Each send
+     * gets the next per-device transaction ID (1-255, never 0) in
+     * commandId, which the node echoes back in its STATUS. ESPNowManager
+     * sends it in one frame or in fragments, whichever the device
+     * negotiated; commands longer than the device accepts are truncated.
+     * 
      * @param commandData Byte array of command data
      * @param length Length of command data
      * @return true if sent successfully
@@ -154,6 +193,15 @@ public:
      */
     virtual String toJson() const;
     
+    /**
+     * @brief Write device fields into an existing JSON object
+     * 
+     * Subclasses extend this with type-specific state; toJson() and the
+     * binary telemetry encoders both render from it.
+     * @param obj Destination object
+     */
+    virtual void toJsonObject(JsonObject obj) const;
+    
     /**
      * @brief Load device from JSON
      * @param json JSON string
@@ -174,9 +222,16 @@ protected:
     Status _status;                 // Current status
     uint32_t _lastHeartbeat;        // Last heartbeat millis()
     uint32_t _lastCommandSent;      // Last command sent millis()
+    uint8_t _lastCommandId;         // Transaction ID of last command
     uint32_t _lastStatusReceived;   // Last status received millis()
     uint16_t _uptimeMinutes;        // Device uptime
     uint8_t _health;                // Health indicator (0-100)
+    HeartbeatDiagnostics _diagnostics;  // Latest node command timing
+    bool _hasDiagnostics;           // Node reports diagnostics?
+    uint16_t _linkRateKbps;         // 0 = rate adaptation off
+    int8_t _linkRssi;
+    uint8_t _linkDelivery;
+    ProtocolInfo _protocol;         // Agreed with the node (version 0 = legacy)
     
     // Statistics
     uint32_t _messagesReceived;     // Total messages from device
@@ -184,6 +239,9 @@ protected:
     uint32_t _commandsSent;         // Total commands sent
     uint32_t _errorCount;           // Total errors
     
+    // Change tracking
+    uint32_t _version;              // Manager state version of last change
+    
     // Schedules
     std::vector<Schedule*> _schedules;
 };
@@ -0,0 +1,102 @@
+#ifndef READING_MATCHER_H
+#define READING_MATCHER_H
+
+#include <stdint.h>
+
+/**
+ * @brief Picks a sensor's answer to one REQUEST_READING out of its STATUS stream
+ *
+ * The node answers from its command handler: it sends a regular reading
+ * (commandId 0) and then the acknowledgement (commandId = the request's),
+ * both numbered by the node's single frame counter. The answer is the
+ * reading whose header.sequenceNum is one below the ACK's:
+ * - A periodic reading already in flight when the request went out has
+ *   an older number and is not taken as the answer
+ * - The answer is still recognised if it arrives after the ACK
+ * - An ACK without its reading leaves the request unanswered
+ *
+ * Pure state, no radio or clock; AquariumManager keeps one per sensor
+ * of a gather.
+ */
+class ReadingMatcher {
+public:
+    struct Reading {
+        float temperature;
+        float ph;
+        uint16_t tds;
+    };
+
+    ReadingMatcher() { expect(0); }
+
+    /**
+     * @brief Start matching a request sent with this command ID
+     */
+    void expect(uint8_t commandId) {
+        _commandId = commandId;
+        _acked = false;
+        _answerSeq = 0;
+        _hasCandidate = false;
+        _candidateSeq = 0;
+        _matched = false;
+        _reading.temperature = 0;
+        _reading.ph = 0;
+        _reading.tds = 0;
+    }
+
+    /**
+     * @brief Feed an unsolicited reading (commandId 0)
+     * @return true if this reading is the answer
+     */
+    bool onReading(uint8_t sequenceNum, const Reading& reading) {
+        if (_commandId == 0 || _matched) {
+            return false;
+        }
+        if (_acked) {
+            if (sequenceNum != _answerSeq) {
+                return false;
+            }
+            _reading = reading;
+            _matched = true;
+            return true;
+        }
+        // Not acknowledged yet: the newest reading is the answer candidate
+        _candidate = reading;
+        _candidateSeq = sequenceNum;
+        _hasCandidate = true;
+        return false;
+    }
+
+    /**
+     * @brief Feed a command STATUS
+     * @return true if it acknowledges the request and the answer is known
+     */
+    bool onAck(uint8_t commandId, uint8_t sequenceNum) {
+        if (_commandId == 0 || _matched || _acked || commandId != _commandId) {
+            return false;
+        }
+        _acked = true;
+        _answerSeq = (uint8_t)(sequenceNum - 1);
+        if (_hasCandidate && _candidateSeq == _answerSeq) {
+            _reading = _candidate;
+            _matched = true;
+        }
+        return _matched;
+    }
+
+    uint8_t getCommandId() const { return _commandId; }
+    bool isAcked() const { return _acked; }
+    bool isMatched() const { return _matched; }
+    const Reading& getReading() const { return _reading; }    // Valid once matched
+
+private:
+    uint8_t _commandId;         // Request's command ID, 0 = none
+    bool _acked;
+    uint8_t _answerSeq;         // Sequence number the answer must carry
+    bool _hasCandidate;
+    uint8_t _candidateSeq;
+    Reading _candidate;         // Newest reading before the ACK
+    bool _matched;
+    Reading _reading;
+};
+
+#endif
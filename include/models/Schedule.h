@@ -9,6 +9,12 @@
  * 
  * Supports one-time and recurring schedules with flexible time specifications.
  * Can handle daily, weekly, or interval-based scheduling.
+ * 
+ * All times are Unix seconds. Each firing is identified by its scheduled
+ * time; _lastExecution holds the scheduled time of the last firing taken,
+ * so a firing can never be taken twice, and ScheduleJournal persists it
+ * across reboots. Firings missed while the hub was down (or the device
+ * offline) are handled by the schedule's CatchUp policy.
  */
 class Schedule {
 public:
@@ -22,6 +28,18 @@ public:
         INTERVAL        // Repeat at fixed intervals
     };
     
+    /**
+     * @brief What to do with firings more than ON_TIME_GRACE_SEC late
+     */
+    enum class CatchUp : uint8_t {
+        SKIP,           // Drop them (feeders, dosing)
+        LATEST,         // Run the most recent one once (lights, heater, CO2)
+        ALL             // Run each one in order, within the catch-up window
+    };
+    
+    static constexpr uint32_t ON_TIME_GRACE_SEC = 120;              // Late but still on time
+    static constexpr uint32_t DEFAULT_CATCH_UP_WINDOW_SEC = 6 * 3600;
+    
     /**
      * @brief Days of week bitmask
      */
@@ -80,6 +98,8 @@ public:
     uint32_t getLastExecution() const { return _lastExecution; }
     uint32_t getNextExecution() const { return _nextExecution; }
     uint32_t getExecutionCount() const { return _executionCount; }
+    CatchUp getCatchUp() const { return _catchUp; }
+    uint32_t getCatchUpWindow() const { return _catchUpWindowSec; }
     
     // Time settings
     std::vector<TimeSpec> getTimes() const { return _times; }
@@ -92,37 +112,37 @@ public:
     
     // ===== Setters =====
     void setName(const String& name) { _name = name; }
-    void setEnabled(bool enabled) { _enabled = enabled; }
+    void setEnabled(bool enabled) { _enabled = enabled; _generation++; }
     
     /**
      * @brief Set execution time(s) for daily schedule
      * @param times Vector of TimeSpec
      */
-    void setTimes(const std::vector<TimeSpec>& times) { _times = times; }
+    void setTimes(const std::vector<TimeSpec>& times) { _times = times; _generation++; }
     
     /**
      * @brief Add execution time
      * @param time TimeSpec to add
      */
-    void addTime(const TimeSpec& time) { _times.push_back(time); }
+    void addTime(const TimeSpec& time) { _times.push_back(time); _generation++; }
     
     /**
      * @brief Set days of week for weekly schedule
      * @param daysMask Bitmask of DayOfWeek values
      */
-    void setDaysMask(uint8_t daysMask) { _daysMask = daysMask; }
+    void setDaysMask(uint8_t daysMask) { _daysMask = daysMask; _generation++; }
     
     /**
      * @brief Set interval for interval-based schedule
      * @param seconds Interval in seconds
      */
-    void setInterval(uint32_t seconds) { _intervalSeconds = seconds; }
+    void setInterval(uint32_t seconds) { _intervalSeconds = seconds; _generation++; }
     
     /**
      * @brief Set one-time execution timestamp
-     * @param timestamp Unix timestamp or millis()
+     * @param timestamp Unix timestamp (seconds)
      */
-    void setOneTimeExecution(uint32_t timestamp) { _nextExecution = timestamp; }
+    void setOneTimeExecution(uint32_t timestamp) { _nextExecution = timestamp; _generation++; }
     
     /**
      * @brief Set command data to execute
@@ -131,24 +151,52 @@ public:
      */
     void setCommandData(const uint8_t* data, size_t length);
     
+    /**
+     * @brief Set the policy for missed firings
+     * @param policy SKIP, LATEST or ALL
+     * @param windowSec Firings older than this are never caught up
+     */
+    void setCatchUp(CatchUp policy, uint32_t windowSec = DEFAULT_CATCH_UP_WINDOW_SEC) {
+        _catchUp = policy;
+        _catchUpWindowSec = windowSec;
+    }
+    
     // ===== Execution Logic =====
     /**
      * @brief Check if schedule is due for execution
-     * @param currentTime Current time (Unix timestamp or millis)
+     * @param currentTime Current Unix time (seconds)
      * @return true if should execute now
      */
-    bool isDue(uint32_t currentTime) const;
+    bool isDue(uint32_t currentTime) const { return dueFiring(currentTime) != 0; }
+    
+    /**
+     * @brief Firing to run now, after the catch-up policy
+     * 
+     * On-time firings (within ON_TIME_GRACE_SEC) always run. A schedule
+     * that never ran has nothing to catch up, except ONE_TIME.
+     * 
+     * @param currentTime Current Unix time (seconds)
+     * @return Scheduled time of the firing, 0 if none is due
+     */
+    uint32_t dueFiring(uint32_t currentTime) const;
+    
+    /**
+     * @brief Mark a firing as taken
+     * @param firing Scheduled time returned by dueFiring()
+     */
+    void markExecuted(uint32_t firing);
     
     /**
-     * @brief Mark schedule as executed
-     * @param currentTime Execution timestamp
+     * @brief Restore execution state persisted before a reboot
+     * @param lastFiring Scheduled time of the last firing taken
+     * @param count Total executions
      */
-    void markExecuted(uint32_t currentTime);
+    void restoreExecution(uint32_t lastFiring, uint32_t count);
     
     /**
      * @brief Calculate next execution time
-     * @param currentTime Current time
-     * @return Next execution timestamp
+     * @param currentTime Current Unix time (seconds)
+     * @return Next scheduled firing after currentTime, 0 if none
      */
     uint32_t calculateNextExecution(uint32_t currentTime) const;
     
@@ -157,6 +205,26 @@ public:
      */
     void resetExecutionCount() { _executionCount = 0; }
     
+    // ===== Timeline Support =====
+    static constexpr uint16_t MINUTES_PER_WEEK = 7 * 24 * 60;
+    
+    /**
+     * @brief Append the weekly firing minutes of a DAILY/WEEKLY schedule
+     * @param out Minutes since Sunday 00:00 (0-10079), unsorted
+     * @return Number of minutes appended (0 for ONE_TIME/INTERVAL)
+     */
+    size_t appendWeekMinutes(std::vector<uint16_t>& out) const;
+    
+    /**
+     * @brief Edit counter shared by all schedules
+     * 
+     * Bumped when any schedule is created, destroyed, attached to a device
+     * or has its timing/command changed. Execution bookkeeping does not
+     * bump it. Derived indexes compare it to decide when to rebuild.
+     */
+    static uint32_t getGeneration() { return _generation; }
+    static void touchGeneration() { _generation++; }
+    
     // ===== Validation =====
     /**
      * @brief Validate schedule configuration
@@ -189,28 +257,36 @@ private:
     uint8_t _daysMask;              // Days of week (for weekly)
     uint32_t _intervalSeconds;      // Interval (for interval type)
     
-    // Execution tracking
-    uint32_t _lastExecution;        // Last execution timestamp
-    uint32_t _nextExecution;        // Next execution timestamp
+    // Execution tracking (Unix seconds)
+    uint32_t _lastExecution;        // Scheduled time of last firing taken
+    uint32_t _nextExecution;        // Next firing (ONE_TIME: the firing)
     uint32_t _executionCount;       // Total executions
+    CatchUp _catchUp;               // Missed firing policy
+    uint32_t _catchUpWindowSec;     // Oldest firing worth catching up
     
     // Command data
     uint8_t _commandData[32];       // Command to execute
     size_t _commandLength;          // Length of command data
     
+    static uint32_t _generation;    // See getGeneration()
+    
+    /**
+     * @brief Latest scheduled firing at or before a time
+     * @return Firing time, 0 if none
+     */
+    uint32_t _firingAtOrBefore(uint32_t time) const;
+    
     /**
-     * @brief Check if current day matches daysMask
-     * @param currentTime Current timestamp
-     * @return true if day matches
+     * @brief First scheduled firing strictly after a time
+     * @return Firing time, 0 if none
      */
-    bool _isDayMatching(uint32_t currentTime) const;
+    uint32_t _firingAfter(uint32_t time) const;
     
     /**
-     * @brief Check if current time matches any TimeSpec
-     * @param currentTime Current timestamp
-     * @return true if time matches
+     * @brief Check if a day of week is enabled (DAILY ignores the mask)
+     * @param weekday 0 = Sunday
      */
-    bool _isTimeMatching(uint32_t currentTime) const;
+    bool _isDayEnabled(uint8_t weekday) const;
 };
 
 #endif // SCHEDULE_H
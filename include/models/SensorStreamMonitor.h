@@ -0,0 +1,101 @@
+#ifndef SENSOR_STREAM_MONITOR_H
+#define SENSOR_STREAM_MONITOR_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * @brief Incremental health check for one sensor stream
+ *
+ * O(1) time and memory per sample, no history buffer:
+ * - EWMA mean/variance (fast) for spike detection
+ * - Two-sided CUSUM against a slow EWMA baseline for drift
+ * - Run length of (near) identical values for a stuck probe
+ * - Rate of change against a physical limit
+ *
+ * Spikes and rate violations are kept out of the statistics so a single
+ * glitch cannot poison the baseline. If the same-signed outlier persists
+ * for persistSamples readings, it is taken as a real level shift and the
+ * baseline re-seeds.
+ */
+class SensorStreamMonitor {
+public:
+    // Per-sample flags
+    static constexpr uint8_t FLAG_SPIKE = 0x01;        // Far outside the running spread
+    static constexpr uint8_t FLAG_RATE = 0x02;         // Changed faster than physically plausible
+    static constexpr uint8_t FLAG_FLATLINE = 0x04;     // Same value for too long (stuck probe)
+    static constexpr uint8_t FLAG_DRIFT_UP = 0x08;     // CUSUM: sustained rise vs baseline
+    static constexpr uint8_t FLAG_DRIFT_DOWN = 0x10;   // CUSUM: sustained fall vs baseline
+
+    // Control loops should ignore readings with any of these set
+    static constexpr uint8_t SUSPECT_MASK = FLAG_SPIKE | FLAG_RATE | FLAG_FLATLINE;
+
+    /**
+     * @brief Detector tuning, in the stream's own units
+     */
+    struct Config {
+        float alpha;            // Fast EWMA weight (mean/variance)
+        float alphaSlow;        // Baseline EWMA weight for CUSUM
+        float minSigma;         // Spread floor (sensor resolution)
+        float spikeSigma;       // Spike threshold in sigmas
+        float maxRatePerMin;    // Largest credible change per minute
+        float flatEpsilon;      // |delta| at or below this counts as "unchanged"
+        uint16_t flatSamples;   // Unchanged run that flags a flatline
+        float cusumK;           // CUSUM slack (sigmas)
+        float cusumH;           // CUSUM alarm threshold (sigmas)
+        uint8_t warmupSamples;  // No spike/drift flags before this many samples
+        uint8_t persistSamples; // Same-signed outliers accepted as a level shift
+    };
+
+    static Config temperatureConfig();
+    static Config phConfig();
+    static Config tdsConfig();
+
+    explicit SensorStreamMonitor(const Config& config);
+
+    /**
+     * @brief Feed one reading
+     * @param value Reading in stream units
+     * @param timestampMs millis() the reading was taken
+     * @return FLAG_* bits for this reading
+     */
+    uint8_t addSample(float value, uint32_t timestampMs);
+
+    /**
+     * @brief Forget all statistics (e.g. after recalibration)
+     */
+    void reset();
+
+    // ===== Getters =====
+    uint8_t getFlags() const { return _flags; }
+    bool isSuspect() const { return (_flags & SUSPECT_MASK) != 0; }
+    float getMean() const { return _mean; }
+    float getSigma() const;
+    float getBaseline() const { return _baseline; }
+    uint32_t getSampleCount() const { return _count; }
+    uint32_t getLastSampleTime() const { return _lastTime; }
+
+    /**
+     * @brief Flag names ("spike", "rate", "flatline", "driftUp", "driftDown")
+     */
+    static void flagsToJson(uint8_t flags, JsonArray out);
+
+    void toJsonObject(JsonObject obj) const;
+
+private:
+    Config _config;
+    uint32_t _count;            // Samples seen
+    float _mean;                // Fast EWMA mean
+    float _variance;            // Fast EWMA variance
+    float _baseline;            // Slow EWMA mean (CUSUM reference)
+    float _baselineVar;         // Slow EWMA variance (CUSUM scale)
+    float _cusumHigh;           // Upper CUSUM sum (sigmas)
+    float _cusumLow;            // Lower CUSUM sum (sigmas)
+    float _lastValue;
+    uint32_t _lastTime;
+    uint16_t _flatRun;          // Consecutive unchanged readings
+    int8_t _outlierRun;         // Consecutive outliers, signed by direction
+    uint8_t _flags;             // Flags of the latest reading
+};
+
+#endif // SENSOR_STREAM_MONITOR_H
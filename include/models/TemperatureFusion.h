@@ -0,0 +1,116 @@
+#ifndef TEMPERATURE_FUSION_H
+#define TEMPERATURE_FUSION_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * @brief One temperature estimate per tank from several probes
+ *
+ * A scalar Kalman filter over a random-walk tank temperature:
+ * - Predict: variance grows by processNoise per second since the last
+ *   update, so an estimate nobody refreshes loses confidence on its own
+ * - Update: each reading is weighted by its source's noise variance,
+ *   which adapts from that source's residuals (a heater probe sitting
+ *   next to the element earns a wider spread than a mid-tank probe)
+ * - Gate: readings more than gateSigma from the prediction are rejected.
+ *   A source that keeps disagreeing while others agree is down-weighted;
+ *   if it is the only live source, the estimate re-seeds on it (level shift)
+ *
+ * O(1) per sample, fixed storage for MAX_SOURCES probes.
+ */
+class TemperatureFusion {
+public:
+    enum class SourceKind : uint8_t {
+        PROBE = 0,      // Sensor node probe
+        HEATER = 1      // Heater node's own probe
+    };
+
+    enum class Result : uint8_t {
+        ACCEPTED = 0,   // Fused into the estimate
+        REJECTED,       // Outside the gate, ignored
+        RESEEDED,       // Estimate restarted from this reading
+        NO_SLOT         // Too many sources
+    };
+
+    static constexpr uint8_t MAX_SOURCES = 4;
+
+    /**
+     * @brief Filter tuning (°C, seconds)
+     */
+    struct Config {
+        float processNoise;     // Variance added per second (°C²/s)
+        float probeNoise;       // Initial variance of a PROBE reading
+        float heaterNoise;      // Initial variance of a HEATER reading
+        float minNoise;         // Noise variance floor (resolution)
+        float maxNoise;         // Noise variance ceiling
+        float noiseAlpha;       // Residual EWMA weight for noise adaptation
+        float gateSigma;        // Innovation gate (sigmas)
+        float usefulVariance;   // Variance at which confidence is 0.5
+        uint32_t freshMs;       // Source counts as live for this long
+        uint8_t persistSamples; // Consecutive rejections before acting
+    };
+
+    static Config defaultConfig();
+
+    TemperatureFusion();
+    explicit TemperatureFusion(const Config& config);
+
+    /**
+     * @brief Fuse one reading
+     * @param mac Source MAC (nullptr = anonymous probe)
+     * @param kind Source type, picks the initial noise
+     * @param value Reading in °C
+     * @param timestampMs millis() the reading was taken
+     */
+    Result addSample(const uint8_t* mac, SourceKind kind, float value, uint32_t timestampMs);
+
+    /**
+     * @brief Forget estimate and sources
+     */
+    void reset();
+
+    // ===== Getters =====
+    bool hasEstimate() const { return _hasEstimate; }
+    float getEstimate() const { return _estimate; }
+    uint32_t getLastUpdate() const { return _lastUpdate; }
+
+    /**
+     * @brief Estimate variance predicted forward to nowMs
+     */
+    float getVariance(uint32_t nowMs) const;
+
+    /**
+     * @brief 0..1, falls as the variance grows past usefulVariance
+     */
+    float getConfidence(uint32_t nowMs) const;
+
+    void toJsonObject(JsonObject obj, uint32_t nowMs) const;
+
+private:
+    struct Source {
+        bool used;
+        uint8_t mac[6];
+        SourceKind kind;
+        float noise;            // Measurement variance (°C²)
+        float lastValue;
+        uint32_t lastTime;
+        uint32_t accepted;
+        uint32_t rejected;
+        uint8_t rejectRun;      // Consecutive rejections
+    };
+
+    Config _config;
+    bool _hasEstimate;
+    float _estimate;            // °C
+    float _variance;            // Estimate variance at _lastUpdate
+    uint32_t _lastUpdate;       // millis() of the last accepted reading
+    int8_t _lastSource;         // Slot that last moved the estimate
+    Source _sources[MAX_SOURCES];
+
+    Source* _findSource(const uint8_t* mac, SourceKind kind);
+    bool _otherSourceLive(const Source* source, uint32_t nowMs) const;
+    void _seed(Source* source, float value, uint32_t timestampMs);
+};
+
+#endif // TEMPERATURE_FUSION_H
@@ -2,6 +2,7 @@
 #define CO2_DEVICE_H
 
 #include "models/Device.h"
+#include "protocol/commands.h"
 
 /**
  * @brief CO₂ Regulator device controller
@@ -108,19 +109,14 @@ private:
     uint32_t _totalInjectionTime;   // Total seconds injected (lifetime)
     uint32_t _injectionCount;       // Total injection cycles
     uint32_t _maxInjectionDuration; // Safety limit (default 3600s = 1 hour)
-    
-    /**
-     * @brief Build CO₂ command
-     */
-    void _buildCO2Command(uint8_t* buffer, uint8_t cmdType, uint32_t duration);
 };
 
-// Command types for CO₂ device
+// Command types for CO₂ device (payloads: CO2Protocol in protocol/commands.h)
 namespace CO2Commands {
-    constexpr uint8_t CMD_START = 0x01;
-    constexpr uint8_t CMD_STOP = 0x02;
-    constexpr uint8_t CMD_TIMED = 0x03;
-    constexpr uint8_t CMD_EMERGENCY_STOP = 0xFF;
+    constexpr uint8_t CMD_START = CO2Protocol::Start::OPCODE;
+    constexpr uint8_t CMD_STOP = CO2Protocol::Stop::OPCODE;
+    constexpr uint8_t CMD_TIMED = CO2Protocol::Timed::OPCODE;
+    constexpr uint8_t CMD_EMERGENCY_STOP = CO2Protocol::EmergencyStop::OPCODE;
 }
 
 // Safety constants
@@ -2,6 +2,7 @@
 #define FEEDER_DEVICE_H
 
 #include "models/Device.h"
+#include "protocol/commands.h"
 
 /**
  * @brief Fish Feeder device controller
@@ -111,18 +112,13 @@ private:
     uint32_t _totalPortions;        // Total portions dispensed
     uint8_t _maxPortionsPerFeed;    // Max portions (default 5)
     uint32_t _minFeedInterval;      // Min seconds between feeds (default 3600)
-    
-    /**
-     * @brief Build feeder command
-     */
-    void _buildFeederCommand(uint8_t* buffer, uint8_t cmdType, uint8_t portions);
 };
 
-// Command types for feeder device
+// Command types for feeder device (payloads: FeederProtocol in protocol/commands.h)
 namespace FeederCommands {
-    constexpr uint8_t CMD_FEED = 0x01;
-    constexpr uint8_t CMD_TEST = 0x02;
-    constexpr uint8_t CMD_CANCEL = 0x03;
+    constexpr uint8_t CMD_FEED = FeederProtocol::Feed::OPCODE;
+    constexpr uint8_t CMD_TEST = FeederProtocol::Test::OPCODE;
+    constexpr uint8_t CMD_CANCEL = FeederProtocol::Cancel::OPCODE;
 }
 
 // Safety constants
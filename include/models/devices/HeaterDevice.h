@@ -2,6 +2,7 @@
 #define HEATER_DEVICE_H
 
 #include "models/Device.h"
+#include "protocol/commands.h"
 
 /**
  * @brief Heater device controller
@@ -130,21 +131,16 @@ private:
     uint32_t _heatingTime;          // Total seconds heating
     uint32_t _heatingCycles;        // Total on/off cycles
     uint32_t _lastTemperatureUpdate; // Last sensor update
-    
-    /**
-     * @brief Build heater command
-     */
-    void _buildHeaterCommand(uint8_t* buffer, uint8_t cmdType, float value);
 };
 
-// Command types for heater device
+// Command types for heater device (payloads: HeaterProtocol in protocol/commands.h)
 namespace HeaterCommands {
-    constexpr uint8_t CMD_SET_MODE = 0x01;
-    constexpr uint8_t CMD_SET_TARGET = 0x02;
-    constexpr uint8_t CMD_SET_HYSTERESIS = 0x03;
-    constexpr uint8_t CMD_MANUAL_ON = 0x04;
-    constexpr uint8_t CMD_MANUAL_OFF = 0x05;
-    constexpr uint8_t CMD_ENABLE_AUTO = 0x06;
+    constexpr uint8_t CMD_SET_MODE = HeaterProtocol::SetMode::OPCODE;
+    constexpr uint8_t CMD_SET_TARGET = HeaterProtocol::SetTarget::OPCODE;
+    constexpr uint8_t CMD_SET_HYSTERESIS = HeaterProtocol::SetHysteresis::OPCODE;
+    constexpr uint8_t CMD_MANUAL_ON = HeaterProtocol::ManualOn::OPCODE;
+    constexpr uint8_t CMD_MANUAL_OFF = HeaterProtocol::ManualOff::OPCODE;
+    constexpr uint8_t CMD_ENABLE_AUTO = HeaterProtocol::EnableAuto::OPCODE;
 }
 
 // Safety constants
@@ -1,7 +1,9 @@
 #ifndef LIGHT_DEVICE_H
 #define LIGHT_DEVICE_H
 
-#include "Device.h"
+#include "models/Device.h"
+#include "protocol/commands.h"
+#include "protocol/light_effects.h"
 
 /**
  * @brief Light device controller (3-channel PWM LED)
@@ -102,6 +104,25 @@ public:
      */
     bool fadeTo(const LightState& targetState, uint16_t durationMs);
     
+    // ===== Effects =====
+    /**
+     * @brief Start a procedural effect rendered on the node
+     * 
+     * Only the parameters are sent; the node animates the effect locally,
+     * so no per-frame traffic crosses ESP-NOW.
+     * 
+     * @param params Effect type, channels, seed, duration and arguments
+     * @return true if command sent successfully
+     */
+    bool startEffect(const LightEffects::EffectParams& params);
+    
+    /**
+     * @brief Stop a running effect
+     * @param type Effect to stop (NONE = all effects)
+     * @return true if command sent successfully
+     */
+    bool stopEffect(LightEffects::EffectType type = LightEffects::EffectType::NONE);
+    
     // ===== State Management =====
     /**
      * @brief Update current state from device status
@@ -204,23 +225,20 @@ private:
     
     PhotoPeriod _morningPeriod;     // Morning photo period schedule
     PhotoPeriod _eveningPeriod;     // Evening photo period schedule
-    
-    /**
-     * @brief Build command data for light control
-     */
-    void _buildLightCommand(uint8_t* buffer, const LightState& state, uint16_t transition);
 };
 
-// Command types for light device
+// Command types for light device (payloads: LightProtocol in protocol/commands.h)
 namespace LightCommands {
-    constexpr uint8_t CMD_ALL_OFF = 0;        // All 3 channels OFF
-    constexpr uint8_t CMD_ALL_ON = 1;         // All 3 channels ON
-    constexpr uint8_t CMD_CH1_OFF = 10;       // Channel 1 (White) OFF
-    constexpr uint8_t CMD_CH1_ON = 11;        // Channel 1 (White) ON
-    constexpr uint8_t CMD_CH2_OFF = 20;       // Channel 2 (Blue) OFF
-    constexpr uint8_t CMD_CH2_ON = 21;        // Channel 2 (Blue) ON
-    constexpr uint8_t CMD_CH3_OFF = 30;       // Channel 3 (Red) OFF
-    constexpr uint8_t CMD_CH3_ON = 31;        // Channel 3 (Red) ON
+    constexpr uint8_t CMD_ALL_OFF = LightProtocol::AllOff::OPCODE;            // All 3 channels OFF
+    constexpr uint8_t CMD_ALL_ON = LightProtocol::AllOn::OPCODE;              // All 3 channels ON
+    constexpr uint8_t CMD_CH1_OFF = LightProtocol::WhiteOff::OPCODE;          // Channel 1 (White) OFF
+    constexpr uint8_t CMD_CH1_ON = LightProtocol::WhiteOn::OPCODE;            // Channel 1 (White) ON
+    constexpr uint8_t CMD_CH2_OFF = LightProtocol::BlueOff::OPCODE;           // Channel 2 (Blue) OFF
+    constexpr uint8_t CMD_CH2_ON = LightProtocol::BlueOn::OPCODE;             // Channel 2 (Blue) ON
+    constexpr uint8_t CMD_CH3_OFF = LightProtocol::RedOff::OPCODE;            // Channel 3 (Red) OFF
+    constexpr uint8_t CMD_CH3_ON = LightProtocol::RedOn::OPCODE;              // Channel 3 (Red) ON
+    constexpr uint8_t CMD_EFFECT_START = LightProtocol::EffectStart::OPCODE;  // Start effect
+    constexpr uint8_t CMD_EFFECT_STOP = LightProtocol::EffectStop::OPCODE;    // Stop effect (type, 0 = all)
 }
 
 // Status data structure (placeholder for future use)
@@ -228,5 +246,6 @@ namespace LightCommands {
 // Byte 1: Channel 2 level (0-255)
 // Byte 2: Channel 3 level (0-255)
 // Byte 3: Enabled (0=off, 1=on)
+// Byte 4: Active effect mask (bit n = LightEffects::EffectType n)
 
 #endif // LIGHT_DEVICE_H
@@ -2,6 +2,8 @@
 #define SENSOR_DEVICE_H
 
 #include "models/Device.h"
+#include "protocol/commands.h"
+#include "protocol/sensor_calibration.h"
 
 /**
  * @brief Water Quality Sensor device
@@ -28,15 +30,17 @@ public:
     };
     
     /**
-     * @brief Calibration data
+     * @brief Calibration tables held by the node
+     * 
+     * Built with SensorCalibration::compile() from 2-5 buffer readings
+     * (see CalibrationStore). A table with count 0 leaves that probe on
+     * the node's default mapping.
      */
     struct Calibration {
-        float phOffset;         // pH calibration offset
-        float phSlope;          // pH calibration slope
-        float tempOffset;       // Temperature offset
-        float tdsMultiplier;    // TDS calibration multiplier
+        SensorCalibration::Table ph;
+        SensorCalibration::Table tds;
         
-        Calibration() : phOffset(0), phSlope(1.0), tempOffset(0), tdsMultiplier(1.0) {}
+        Calibration() : ph(), tds() {}
     };
     
     /**
@@ -77,9 +81,9 @@ public:
     bool setReadingInterval(uint32_t seconds);
     
     /**
-     * @brief Set calibration data
-     * @param calibration Calibration parameters
-     * @return true if command sent successfully
+     * @brief Push calibration tables to the node
+     * @param calibration Compiled tables (invalid tables are skipped)
+     * @return true if every valid table was sent
      */
     bool setCalibration(const Calibration& calibration);
     
@@ -90,15 +94,15 @@ public:
     bool resetCalibration();
     
     /**
-     * @brief Calibrate pH sensor
-     * @param knownPh Known pH value for calibration
+     * @brief Single-point trim of the node's pH table
+     * @param knownPh pH of the solution the probe is in now
      * @return true if command sent successfully
      */
     bool calibratePh(float knownPh);
     
     /**
-     * @brief Calibrate TDS sensor
-     * @param knownTds Known TDS value for calibration
+     * @brief Single-point trim of the node's TDS table
+     * @param knownTds ppm of the solution the probe is in now
      * @return true if command sent successfully
      */
     bool calibrateTds(uint16_t knownTds);
@@ -162,25 +166,20 @@ private:
     std::vector<Readings> _history;
     size_t _maxHistorySize;
     
-    /**
-     * @brief Build sensor command
-     */
-    void _buildSensorCommand(uint8_t* buffer, uint8_t cmdType, const uint8_t* data, size_t len);
-    
     /**
      * @brief Parse readings from status data
      */
     Readings _parseReadings(const uint8_t* data) const;
 };
 
-// Command types for sensor device
+// Command types for sensor device (payloads: SensorProtocol in protocol/commands.h)
 namespace SensorCommands {
-    constexpr uint8_t CMD_REQUEST_READING = 0x01;
-    constexpr uint8_t CMD_SET_INTERVAL = 0x02;
-    constexpr uint8_t CMD_SET_CALIBRATION = 0x03;
-    constexpr uint8_t CMD_RESET_CALIBRATION = 0x04;
-    constexpr uint8_t CMD_CALIBRATE_PH = 0x05;
-    constexpr uint8_t CMD_CALIBRATE_TDS = 0x06;
+    constexpr uint8_t CMD_REQUEST_READING = SensorProtocol::RequestReading::OPCODE;
+    constexpr uint8_t CMD_SET_INTERVAL = SensorProtocol::SetInterval::OPCODE;
+    constexpr uint8_t CMD_SET_CALIBRATION = SensorProtocol::SET_CALIBRATION;
+    constexpr uint8_t CMD_RESET_CALIBRATION = SensorProtocol::ResetCalibration::OPCODE;
+    constexpr uint8_t CMD_CALIBRATE_PH = SensorProtocol::CalibratePh::OPCODE;
+    constexpr uint8_t CMD_CALIBRATE_TDS = SensorProtocol::CalibrateTds::OPCODE;
 }
 
 // Default settings
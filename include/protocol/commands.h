@@ -0,0 +1,261 @@
+#ifndef PROTOCOL_COMMANDS_H
+#define PROTOCOL_COMMANDS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "protocol/messages.h"
+#include "protocol/light_effects.h"
+
+// ============================================================================
+// COMMAND SCHEMA - single source of opcodes and payload layouts
+// ============================================================================
+// Every command is declared once as Command<OPCODE, Args...>. The same type
+// encodes on the hub and decodes on the node:
+//
+//   commandData[0]    = OPCODE
+//   commandData[1..]  = Args, packed little-endian, no padding
+//
+//   uint8_t buf[HeaterProtocol::SetTarget::SIZE];
+//   HeaterProtocol::SetTarget::encode(buf, 2550);        // 25.50 C
+//
+//   int16_t centi;
+//   if (HeaterProtocol::SetTarget::decode(data, len, centi)) { ... }
+//
+// decode() only succeeds when the opcode matches and len is exactly SIZE,
+// so handlers never parse bytes by hand. CommandMessage::commandId is a
+// transaction ID echoed in STATUS; it no longer selects the command.
+//
+// Header-only with no Arduino dependencies so encoders and decoders can be
+// round-tripped natively on a host compiler.
+// ============================================================================
+
+namespace Protocol {
+
+// ----------------------------------------------------------------------------
+// Field codecs (little-endian)
+// ----------------------------------------------------------------------------
+
+template <typename T> struct Field;
+
+template <> struct Field<uint8_t> {
+    static constexpr size_t SIZE = 1;
+    static void write(uint8_t* p, uint8_t v) { p[0] = v; }
+    static uint8_t read(const uint8_t* p) { return p[0]; }
+};
+
+template <> struct Field<bool> {
+    static constexpr size_t SIZE = 1;
+    static void write(uint8_t* p, bool v) { p[0] = v ? 1 : 0; }
+    static bool read(const uint8_t* p) { return p[0] != 0; }
+};
+
+template <> struct Field<uint16_t> {
+    static constexpr size_t SIZE = 2;
+    static void write(uint8_t* p, uint16_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+    }
+    static uint16_t read(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+};
+
+template <> struct Field<int16_t> {
+    static constexpr size_t SIZE = 2;
+    static void write(uint8_t* p, int16_t v) { Field<uint16_t>::write(p, (uint16_t)v); }
+    static int16_t read(const uint8_t* p) { return (int16_t)Field<uint16_t>::read(p); }
+};
+
+template <> struct Field<uint32_t> {
+    static constexpr size_t SIZE = 4;
+    static void write(uint8_t* p, uint32_t v) {
+        for (size_t i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+    }
+    static uint32_t read(const uint8_t* p) {
+        uint32_t v = 0;
+        for (size_t i = 0; i < 4; i++) v |= (uint32_t)p[i] << (8 * i);
+        return v;
+    }
+};
+
+// Packed wire structs already defined little-endian in the protocol headers
+template <> struct Field<LightEffects::EffectParams> {
+    static constexpr size_t SIZE = sizeof(LightEffects::EffectParams);
+    static void write(uint8_t* p, const LightEffects::EffectParams& v) { memcpy(p, &v, SIZE); }
+    static LightEffects::EffectParams read(const uint8_t* p) {
+        LightEffects::EffectParams v;
+        memcpy(&v, p, SIZE);
+        return v;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Argument list codec (recursive; no fold expressions so the hub builds as C++11)
+// ----------------------------------------------------------------------------
+
+template <typename... Ts> struct Fields;
+
+template <> struct Fields<> {
+    static constexpr size_t SIZE = 0;
+    static void write(uint8_t*) {}
+    static void read(const uint8_t*) {}
+};
+
+template <typename T, typename... Rest> struct Fields<T, Rest...> {
+    static constexpr size_t SIZE = Field<T>::SIZE + Fields<Rest...>::SIZE;
+
+    static void write(uint8_t* p, const T& v, const Rest&... rest) {
+        Field<T>::write(p, v);
+        Fields<Rest...>::write(p + Field<T>::SIZE, rest...);
+    }
+
+    static void read(const uint8_t* p, T& v, Rest&... rest) {
+        v = Field<T>::read(p);
+        Fields<Rest...>::read(p + Field<T>::SIZE, rest...);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Command
+// ----------------------------------------------------------------------------
+
+template <uint8_t OPCODE_VALUE, typename... Args>
+struct Command {
+    static constexpr uint8_t OPCODE = OPCODE_VALUE;
+    static constexpr size_t SIZE = 1 + Fields<Args...>::SIZE;
+
+    static_assert(1 + Fields<Args...>::SIZE <= MAX_COMMAND_DATA_LEN, "Command payload exceeds commandData");
+
+    /**
+     * @brief Write opcode and arguments
+     * @param out Buffer of at least SIZE bytes
+     * @return Bytes written (SIZE)
+     */
+    static size_t encode(uint8_t* out, const Args&... args) {
+        out[0] = OPCODE_VALUE;
+        Fields<Args...>::write(out + 1, args...);
+        return 1 + Fields<Args...>::SIZE;
+    }
+
+    /**
+     * @brief Parse a payload of exactly this command
+     * @return false (arguments untouched) on opcode or length mismatch
+     */
+    static bool decode(const uint8_t* data, size_t len, Args&... args) {
+        if (len != 1 + Fields<Args...>::SIZE || data[0] != OPCODE_VALUE) {
+            return false;
+        }
+        Fields<Args...>::read(data + 1, args...);
+        return true;
+    }
+
+    /**
+     * @brief Opcode check only (for dispatch before decode)
+     */
+    static bool matches(const uint8_t* data, size_t len) {
+        return len >= 1 && data[0] == OPCODE_VALUE;
+    }
+};
+
+}  // namespace Protocol
+
+// ============================================================================
+// LIGHT (NodeType::LIGHT)
+// ============================================================================
+
+namespace LightProtocol {
+    typedef Protocol::Command<0> AllOff;
+    typedef Protocol::Command<1, uint8_t, uint8_t, uint8_t> AllOn;          // white, blue, red
+    typedef Protocol::Command<10> WhiteOff;
+    typedef Protocol::Command<11, uint8_t> WhiteOn;                         // level
+    typedef Protocol::Command<20> BlueOff;
+    typedef Protocol::Command<21, uint8_t> BlueOn;
+    typedef Protocol::Command<30> RedOff;
+    typedef Protocol::Command<31, uint8_t> RedOn;
+    typedef Protocol::Command<40, LightEffects::EffectParams> EffectStart;
+    typedef Protocol::Command<41, uint8_t> EffectStop;                     // EffectType (0 = all)
+}
+
+// ============================================================================
+// HEATER (NodeType::HEATER)
+// ============================================================================
+
+namespace HeaterProtocol {
+    typedef Protocol::Command<0x01, uint8_t> SetMode;                       // HeaterDevice::Mode
+    typedef Protocol::Command<0x02, int16_t> SetTarget;                     // centi-°C
+    typedef Protocol::Command<0x03, uint16_t> SetHysteresis;                // centi-°C
+    typedef Protocol::Command<0x04> ManualOn;
+    typedef Protocol::Command<0x05> ManualOff;
+    typedef Protocol::Command<0x06, int16_t> EnableAuto;                    // target, centi-°C
+    typedef Protocol::Command<0x07, int16_t, uint16_t> SetReference;        // fused tank temp centi-°C, valid seconds
+    
+    constexpr uint16_t MAX_REFERENCE_VALID_SEC = 600;
+    
+    // Unsolicited STATUS (commandId 0), sent periodically while connected
+    struct Status {
+        uint8_t mode;                   // HeaterDevice::Mode
+        uint8_t flags;                  // STATUS_*
+        int16_t probeX100;              // Heater's own probe, C x100 (STATUS_PROBE_OK)
+        int16_t controlX100;            // Temperature auto mode regulates on, C x100
+    } __attribute__((packed));
+    
+    constexpr uint8_t STATUS_HEATING = 0x01;       // Relay on
+    constexpr uint8_t STATUS_PROBE_OK = 0x02;      // probeX100 is a real reading
+    constexpr uint8_t STATUS_REFERENCE = 0x04;     // controlX100 is the hub's fused value
+}
+
+// ============================================================================
+// CO2 (NodeType::CO2)
+// ============================================================================
+
+namespace CO2Protocol {
+    typedef Protocol::Command<0x01> Start;                                  // Until stopped
+    typedef Protocol::Command<0x02> Stop;
+    typedef Protocol::Command<0x03, uint16_t> Timed;                        // seconds
+    typedef Protocol::Command<0xFF> EmergencyStop;
+}
+
+// ============================================================================
+// FEEDER (NodeType::FISH_FEEDER)
+// ============================================================================
+
+namespace FeederProtocol {
+    typedef Protocol::Command<0x01, uint8_t> Feed;                          // portions
+    typedef Protocol::Command<0x02> Test;
+    typedef Protocol::Command<0x03> Cancel;
+}
+
+// ============================================================================
+// SENSOR (NodeType::SENSOR)
+// ============================================================================
+
+namespace SensorProtocol {
+    typedef Protocol::Command<0x01> RequestReading;
+    typedef Protocol::Command<0x02, uint16_t> SetInterval;                  // seconds
+    constexpr uint8_t SET_CALIBRATION = 0x03;                               // Table, protocol/sensor_calibration.h
+    typedef Protocol::Command<0x04> ResetCalibration;
+    typedef Protocol::Command<0x05, uint16_t> CalibratePh;                  // known pH x100
+    typedef Protocol::Command<0x06, uint16_t> CalibrateTds;                 // known ppm
+    
+    // Unsolicited STATUS (commandId 0) from a deep-sleeping node: samples
+    // taken on earlier wakes, oldest first, plus the previous cycle's cost.
+    // The legacy single reading starts with the pH integer part (< 15).
+    constexpr uint8_t READINGS_BATCH = 0xB0;                                // statusData[0]
+    
+    struct BatchSample {
+        uint16_t phX100;
+        uint16_t tdsPpm;
+        int16_t tempX100;               // C x100
+    } __attribute__((packed));
+    
+    struct BatchHeader {
+        uint8_t format;                 // READINGS_BATCH
+        uint8_t count;                  // Samples that follow
+        uint16_t intervalSec;           // Spacing between samples
+        uint16_t cycleAwakeMs;          // Previous wake, boot included
+        uint16_t cycleAvgMicroAmps;     // Previous wake + sleep (modelled, saturating)
+    } __attribute__((packed));
+    
+    constexpr size_t MAX_BATCH_SAMPLES = (MAX_STATUS_DATA_LEN - sizeof(BatchHeader)) / sizeof(BatchSample);
+}
+
+#endif // PROTOCOL_COMMANDS_H
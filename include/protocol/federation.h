@@ -0,0 +1,127 @@
+#ifndef PROTOCOL_FEDERATION_H
+#define PROTOCOL_FEDERATION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "protocol/messages.h"
+
+// ============================================================================
+// HUB FEDERATION - hub to hub over the LAN (UDP)
+// ============================================================================
+// Each hub owns the devices in its own ESP-NOW range and tells the other
+// hubs of the same group about them:
+//
+//   HELLO    every FEDERATION_HELLO_INTERVAL_MS, broadcast + listed peers
+//   DELTA    device records changed since the last DELTA (broadcast), or
+//            since a peer's SYNC.since (unicast reply)
+//   SYNC     "I have your devices up to version X of boot B"
+//   COMMAND  run a command on a device the receiver owns
+//   RESULT   answer to COMMAND
+//
+// Versions are the owner's AquariumManager state versions, so a DELTA is
+// the same "changed since" query as /api/changes. A receiver applies a
+// DELTA only if it continues what it already has (fromVersion <= its
+// version, same bootId); anything else is answered with SYNC. HELLO
+// carries the last published version so a lost DELTA is noticed within
+// one HELLO interval.
+//
+// The group is a CRC-32 of FEDERATION_GROUP so unrelated installations on
+// one LAN ignore each other. It is not authentication.
+// All fields are little-endian.
+// ============================================================================
+
+#define FEDERATION_DEFAULT_PORT 4210
+#define FEDERATION_PROTOCOL_VERSION 1
+#define FEDERATION_NAME_LEN 24
+#define FEDERATION_MAX_RECORDS 32               // Device records per DELTA
+#define FEDERATION_STATUS_REMOVED 0xFF          // Record is a removal
+
+enum class FederationType : uint8_t {
+    HELLO = 0x01,
+    DELTA = 0x02,
+    SYNC = 0x03,
+    COMMAND = 0x04,
+    RESULT = 0x05
+};
+
+struct FederationHeader {
+    uint8_t magic[2];              // 'A', 'F'
+    uint8_t version;               // FEDERATION_PROTOCOL_VERSION
+    FederationType type;
+    uint32_t group;                // CRC-32 of the group name
+    uint8_t hubId[6];              // Sender's radio MAC
+    uint16_t reserved;
+    uint32_t bootId;               // Sender's AquariumManager boot ID
+} __attribute__((packed));
+
+struct FederationHello {
+    FederationHeader header;
+    uint32_t publishedVersion;     // toVersion of the last DELTA broadcast
+    uint16_t httpPort;             // For links to the owning hub's UI
+    uint8_t deviceCount;
+    uint8_t reserved;
+    char name[FEDERATION_NAME_LEN];    // NUL-padded
+} __attribute__((packed));
+
+// One device as seen by its owning hub
+struct FederationDeviceRecord {
+    uint8_t mac[6];
+    uint8_t type;                  // NodeType
+    uint8_t status;                // Device::Status, or FEDERATION_STATUS_REMOVED
+    uint8_t tankId;
+    uint8_t health;
+    uint16_t reserved;
+    uint32_t version;              // Owner's state version of this change
+    char name[FEDERATION_NAME_LEN];
+} __attribute__((packed));
+
+#define FEDERATION_DELTA_FULL 0x01      // Replaces everything known about the sender
+
+struct FederationDelta {
+    FederationHeader header;
+    uint32_t fromVersion;          // Receiver must have this version (unless FULL)
+    uint32_t toVersion;            // Receiver has this version after applying
+    uint8_t flags;
+    uint8_t count;                 // Records that follow
+    uint16_t reserved;
+} __attribute__((packed));
+
+struct FederationSync {
+    FederationHeader header;
+    uint32_t knownBootId;          // 0 = nothing known
+    uint32_t since;
+} __attribute__((packed));
+
+struct FederationCommand {
+    FederationHeader header;
+    uint16_t ticket;               // Echoed in RESULT
+    uint8_t mac[6];
+    uint8_t commandLen;
+    uint8_t reserved;
+    uint8_t commandData[MAX_COMMAND_DATA_LEN];     // protocol/commands.h payload
+} __attribute__((packed));
+
+enum class FederationResult : uint8_t {
+    SENT = 0x00,                   // Handed to ESP-NOW by the owner
+    NOT_FOUND = 0x01,              // Receiver does not own the device
+    OFFLINE = 0x02,
+    SEND_FAILED = 0x03
+};
+
+struct FederationCommandResult {
+    FederationHeader header;
+    uint16_t ticket;
+    FederationResult result;
+    uint8_t commandId;             // Transaction ID used towards the node
+} __attribute__((packed));
+
+constexpr size_t FEDERATION_MAX_FRAME =
+    sizeof(FederationDelta) + FEDERATION_MAX_RECORDS * sizeof(FederationDeviceRecord);
+
+static_assert(FEDERATION_MAX_FRAME <= 1472, "DELTA must fit one UDP datagram");
+
+inline size_t federationDeltaSize(uint8_t count) {
+    return sizeof(FederationDelta) + count * sizeof(FederationDeviceRecord);
+}
+
+#endif // PROTOCOL_FEDERATION_H
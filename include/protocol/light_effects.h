@@ -0,0 +1,79 @@
+#ifndef PROTOCOL_LIGHT_EFFECTS_H
+#define PROTOCOL_LIGHT_EFFECTS_H
+
+#include <stdint.h>
+
+// ============================================================================
+// LIGHTING EFFECTS - shared between hub and lighting node
+// ============================================================================
+// Effects are generated on the lighting node at 50 Hz and layered on top of
+// the base (photoperiod) levels. The hub only sends parameters once:
+//
+//   commandData[0]  = LightCommands::CMD_EFFECT_START
+//   commandData[1..] = EffectParams
+//
+//   commandData[0]  = LightCommands::CMD_EFFECT_STOP
+//   commandData[1]  = EffectType to stop (NONE = all)
+//
+// All fields are little-endian. Effects with the same seed and parameters
+// render identically on every node, so several fixtures over one tank can
+// share a cloud pattern.
+// ============================================================================
+
+namespace LightEffects {
+
+// Effect generators (one active layer per type)
+enum class EffectType : uint8_t {
+    NONE = 0x00,
+    CLOUDS = 0x01,      // Seeded value noise dimming (passing clouds)
+    STORM = 0x02,       // Darkened sky with random lightning bursts
+    MOONLIGHT = 0x03    // Phase-scaled night glow with slow shimmer
+};
+
+// Channel mask bits (match node PWM channel order)
+constexpr uint8_t CHANNEL_WHITE = 0x01;
+constexpr uint8_t CHANNEL_BLUE = 0x02;
+constexpr uint8_t CHANNEL_RED = 0x04;
+constexpr uint8_t CHANNEL_ALL = 0x07;
+
+// CLOUDS arguments
+struct CloudArgs {
+    uint8_t coverage;   // Fraction of sky covered (0-255)
+    uint8_t depth;      // Dimming under a full cloud (0-255 = 0-100%)
+    uint8_t speed;      // Noise cells per minute (1-255)
+    uint8_t reserved;
+} __attribute__((packed));
+
+// STORM arguments
+struct StormArgs {
+    uint8_t darkness;   // Constant dimming while storm is active (0-255)
+    uint8_t flashRate;  // Mean lightning bursts per minute (0-255)
+    uint8_t flashLevel; // Peak level added during a flash (0-255)
+    uint8_t maxBurst;   // Max flashes per burst (1-8)
+} __attribute__((packed));
+
+// MOONLIGHT arguments
+struct MoonArgs {
+    uint8_t phase;          // Lunar phase (0 = new, 128 = full, 255 = new)
+    uint8_t level;          // Level at full moon (0-255)
+    uint8_t shimmerPeriod;  // Shimmer period in seconds (0 = steady)
+    uint8_t shimmerDepth;   // Shimmer amplitude (0-255 of level)
+} __attribute__((packed));
+
+// CMD_EFFECT_START payload
+struct EffectParams {
+    EffectType type;        // Generator
+    uint8_t channelMask;    // CHANNEL_* bits the layer affects
+    uint32_t seed;          // Noise / PRNG seed
+    uint16_t durationSec;   // Auto-stop after this many seconds (0 = until stopped)
+    uint8_t args[4];        // CloudArgs / StormArgs / MoonArgs
+} __attribute__((packed));
+
+static_assert(sizeof(CloudArgs) == 4, "CloudArgs must fit EffectParams::args");
+static_assert(sizeof(StormArgs) == 4, "StormArgs must fit EffectParams::args");
+static_assert(sizeof(MoonArgs) == 4, "MoonArgs must fit EffectParams::args");
+static_assert(sizeof(EffectParams) + 1 <= 32, "EffectParams must fit in commandData");
+
+}
+
+#endif // PROTOCOL_LIGHT_EFFECTS_H
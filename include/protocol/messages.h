@@ -2,11 +2,31 @@
 #define PROTOCOL_MESSAGES_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 // ESP-NOW configuration
 #define ESPNOW_CHANNEL 6
 #define MAX_TANK_ID 255
 #define MAX_NODE_NAME_LEN 16
+#define MAX_COMMAND_DATA_LEN 32
+#define MAX_STATUS_DATA_LEN 32
+
+// Beacon / power save
+#define BEACON_SLOT_COUNT 64                        // Node slots (ACK assignedNodeId), 0 = none
+#define BEACON_BITMAP_LEN (BEACON_SLOT_COUNT / 8)
+#define DEFAULT_BEACON_INTERVAL_MS 1000
+#define NODE_CAP_POWER_SAVE 0x01                    // AnnounceMessage::capabilities: radio sleeps between beacons
+#define NODE_CAP_LONG_RANGE 0x02                    // AnnounceMessage::capabilities: receives ESP32 LR frames
+
+// Protocol negotiation (see ProtocolInfo)
+// Version 1 is the current wire format: the 6-byte MessageHeader (16-bit
+// timestamp) and length-prefixed COMMAND/STATUS payloads. Version 0 senders
+// use the same frames but did not negotiate. Firmware from before the
+// header shrank to 6 bytes is not wire-compatible with either and must be
+// reflashed; no version number identifies it.
+#define PROTOCOL_VERSION 1                          // 0 = sender predates negotiation
+#define PROTO_FEAT_FRAGMENTS 0x01                   // Reassembles multi-frame COMMANDs
+#define PROTO_FEAT_LARGE_COMMAND 0x02               // Accepts COMMAND payloads over MAX_COMMAND_DATA_LEN
 
 // Message types for ESP-NOW communication
 enum class MessageType : uint8_t {
@@ -16,7 +36,9 @@ enum class MessageType : uint8_t {
     COMMAND = 0x04,     // Hub sends command to node
     STATUS = 0x05,      // Node sends status to hub
     HEARTBEAT = 0x06,   // Periodic alive signal
-    UNMAP = 0x07        // Hub unmaps a device (reset to discovery mode)
+    UNMAP = 0x07,       // Hub unmaps a device (reset to discovery mode)
+    BEACON = 0x08,      // Hub broadcast: liveness, time, pending downlink
+    REPLICATE = 0x09    // Hub to hub: state files copied to a standby hub
 };
 
 // Node types in the system
@@ -38,26 +60,46 @@ struct MessageHeader {
     MessageType type;
     uint8_t tankId;
     NodeType nodeType;
-    uint32_t timestamp;  // millis() when sent
+    uint16_t timestamp;  // Low 16 bits of sender millis() (relative, wraps every ~65 s)
     uint8_t sequenceNum; // For tracking message order
 } __attribute__((packed));
 
+// Protocol a node offers in its ANNOUNCE and the hub agrees to in its ACK.
+// Nodes that predate negotiation send zeros here (version 0): the hub keeps
+// them on single 32-byte COMMAND frames and plain ACKs. For version >= 1
+// the hub records min(version), the common features and maxCommandData per
+// peer, sends the agreed set back as an ACK tail, and picks the transfer
+// mode for every command from it.
+struct ProtocolInfo {
+    uint8_t version;               // PROTOCOL_VERSION of the sender
+    uint8_t features;              // PROTO_FEAT_* bits
+    uint8_t maxCommandData;        // Largest COMMAND payload per frame (>= MAX_COMMAND_DATA_LEN)
+} __attribute__((packed));
+
 // ANNOUNCE message - sent by nodes on boot (discovery phase)
 // Node does NOT know tankId or name yet - hub will provision via CONFIG
 struct AnnounceMessage {
     MessageHeader header;          // tankId = 0 (unmapped), nodeType = device type
     uint8_t firmwareVersion;
     uint8_t capabilities;          // Bitfield for node capabilities
-    uint8_t reserved[16];          // Reserved for future use
+    ProtocolInfo protocol;         // Offered protocol (was reserved, zero from older nodes)
+    uint8_t reserved[13];          // Reserved for future use
 } __attribute__((packed));
 
 // ACK message - hub response to ANNOUNCE
 struct AckMessage {
     MessageHeader header;
-    uint8_t assignedNodeId;  // Hub-assigned unique ID
+    uint8_t assignedNodeId;  // Hub-assigned beacon slot (1..BEACON_SLOT_COUNT-1, 0 = none)
     bool accepted;           // Whether node is accepted into network
 } __attribute__((packed));
 
+// ACK with the agreed protocol. Sent only to nodes that offered version >= 1;
+// older nodes reject ACKs of any other length than sizeof(AckMessage).
+struct AckProtocolMessage {
+    AckMessage ack;
+    ProtocolInfo protocol;   // Agreed: min version, common features
+} __attribute__((packed));
+
 // CONFIG message - hub sends configuration to node (provisioning)
 struct ConfigMessage {
     MessageHeader header;          // tankId = assigned tank
@@ -71,7 +113,8 @@ struct CommandMessage {
     uint8_t commandId;
     uint8_t commandSeqID;          // sequenceID for commands, incase larger command needs to be sent to nodes, then this increases by 1 for each sub messages
     bool finalCommand;             // True if final message sequence, else False if there are subsequent messages to be followed
-    uint8_t commandData[32];       // Generic command payload
+    uint8_t commandLen;            // Used bytes of commandData
+    uint8_t commandData[MAX_COMMAND_DATA_LEN];  // Generic command payload (only commandLen bytes sent)
 } __attribute__((packed));
 
 // STATUS message - node to hub
@@ -79,7 +122,8 @@ struct StatusMessage {
     MessageHeader header;
     uint8_t commandId; // CommandID to be used by Hub for ack
     uint8_t statusCode;
-    uint8_t statusData[32];  // Generic status payload
+    uint8_t statusLen;       // Used bytes of statusData
+    uint8_t statusData[MAX_STATUS_DATA_LEN];  // Generic status payload (only statusLen bytes sent)
 } __attribute__((packed));
 
 // HEARTBEAT message - bidirectional
@@ -89,6 +133,24 @@ struct HeartbeatMessage {
     uint16_t uptimeMinutes;
 } __attribute__((packed));
 
+// Optional HEARTBEAT tail - command timing since the previous heartbeat.
+// Receivers that only know HeartbeatMessage read the prefix and ignore it.
+struct HeartbeatDiagnostics {
+    uint16_t commandsHandled;  // Commands executed in the interval
+    uint16_t handlerAvgUs;     // Mean handleCommand() time (saturating)
+    uint16_t handlerMaxUs;     // Slowest handleCommand() (saturating)
+    uint16_t latencyAvgUs;     // Mean RX callback -> handler start
+    uint16_t latencyMaxUs;     // Worst RX callback -> handler start
+    uint8_t rxDropped;         // Frames lost to a full receive ring (saturating)
+    uint8_t reserved;
+} __attribute__((packed));
+
+// HEARTBEAT with diagnostics (sent by NodeBase nodes)
+struct HeartbeatDiagMessage {
+    HeartbeatMessage heartbeat;
+    HeartbeatDiagnostics diagnostics;
+} __attribute__((packed));
+
 // UNMAP message - hub to node (reset device to discovery mode)
 struct UnmapMessage {
     MessageHeader header;
@@ -96,13 +158,129 @@ struct UnmapMessage {
     uint8_t reserved[8];  // Reserved for future use
 } __attribute__((packed));
 
+// Node confirms a CONFIG or UNMAP with a STATUS whose commandId echoes the
+// frame's header.sequenceNum (hub transaction token) and whose statusCode
+// says which frame it applied. The hub commits provisioning only after
+// this arrives. Frames with sequenceNum 0 (rename, move) are not confirmed.
+constexpr uint8_t STATUS_CONFIG_APPLIED = 0xC0;
+constexpr uint8_t STATUS_UNMAP_APPLIED = 0xC1;
+
+// BEACON message - hub broadcast every intervalMs
+// Nodes treat it as hub liveness. A power-save node wakes for each beacon
+// and stays awake only if its slot bit is set; it then sends any frame
+// (normally a HEARTBEAT) and the hub releases the frames it was holding.
+struct BeaconMessage {
+    MessageHeader header;          // tankId = 0 (all tanks)
+    uint32_t epoch;                // Unix time (s), 0 = hub clock not set
+    uint16_t intervalMs;           // Time until the next beacon
+    uint16_t hubSession;           // Changes on hub restart (slots are reassigned)
+    uint16_t configGeneration;     // Low 16 bits of the hub state version
+    uint8_t channel;               // ESP-NOW channel
+    uint8_t pendingSlots[BEACON_BITMAP_LEN];  // Bit n = downlink queued for slot n
+} __attribute__((packed));
+
+// Optional BEACON tail - logical hub identity for standby failover.
+// hubId is the MAC of the hub the nodes were provisioned by; a standby that
+// takes over beacons with the same hubId and a higher generation, and nodes
+// move to its MAC. Receivers that only know BeaconMessage ignore it.
+struct BeaconIdentity {
+    uint8_t hubId[6];              // Logical hub (first primary's MAC)
+    uint16_t hubGeneration;        // Bumped on every takeover
+} __attribute__((packed));
+
+// BEACON with identity (sent by hubs)
+struct BeaconIdentMessage {
+    BeaconMessage beacon;
+    BeaconIdentity identity;
+} __attribute__((packed));
+
+inline bool beaconSlotPending(const BeaconMessage& beacon, uint8_t slot) {
+    return slot > 0 && slot < BEACON_SLOT_COUNT &&
+           (beacon.pendingSlots[slot >> 3] & (1 << (slot & 7))) != 0;
+}
+
+inline void beaconSetSlotPending(BeaconMessage& beacon, uint8_t slot) {
+    if (slot > 0 && slot < BEACON_SLOT_COUNT) {
+        beacon.pendingSlots[slot >> 3] |= (1 << (slot & 7));
+    }
+}
+
+// REPLICATE message - active hub to standby hub (and acknowledgements back)
+// A state file is streamed as consecutive chunks; the standby writes them
+// to a temporary file and renames it over its own copy once the whole file
+// has arrived and its CRC matches. header.sequenceNum is 0: ordering is by
+// offset, and beacons from the same hub must not look like duplicates.
+#define REPLICATION_CHUNK_LEN 200
+
+enum class ReplicationOp : uint8_t {
+    CHUNK = 0x01,       // Active -> standby: file bytes at offset
+    ACK = 0x02,         // Standby -> active: file applied (crc identifies it)
+    NACK = 0x03         // Standby -> active: resend from offset
+};
+
+struct ReplicationMessage {
+    MessageHeader header;          // tankId = 0, nodeType = HUB
+    ReplicationOp op;
+    uint8_t fileIndex;             // Position in the replicated file list
+    uint32_t totalLen;             // Whole file size
+    uint32_t crc;                  // CRC-32 of the whole file
+    uint32_t offset;               // CHUNK: first byte; NACK: next expected byte
+    uint8_t dataLen;               // CHUNK only
+    uint8_t data[REPLICATION_CHUNK_LEN];
+} __attribute__((packed));
+
+constexpr size_t REPLICATION_HEADER_LEN = sizeof(ReplicationMessage) - REPLICATION_CHUNK_LEN;
+
+// ============================================================================
+// VARIABLE-LENGTH FRAMES
+// ============================================================================
+// COMMAND and STATUS carry a length byte and are transmitted without the
+// unused tail of their payload array, e.g. "lights off" is 11 bytes on air
+// instead of 43. Senders pass *FrameSize(msg) to esp_now_send(); receivers
+// must accept a frame only if its length matches exactly, then copy it into
+// a zeroed struct before reading the payload.
+// ============================================================================
+
+constexpr size_t COMMAND_HEADER_SIZE = sizeof(CommandMessage) - MAX_COMMAND_DATA_LEN;
+constexpr size_t STATUS_HEADER_SIZE = sizeof(StatusMessage) - MAX_STATUS_DATA_LEN;
+
+// COMMAND payload of a full ESP-NOW frame, for peers that agreed to
+// PROTO_FEAT_LARGE_COMMAND (the payload then runs past commandData)
+constexpr size_t MAX_COMMAND_FRAME_DATA_LEN = 250 - COMMAND_HEADER_SIZE;
+
+inline size_t commandFrameSize(const CommandMessage& msg) {
+    return COMMAND_HEADER_SIZE + msg.commandLen;
+}
+
+inline size_t statusFrameSize(const StatusMessage& msg) {
+    return STATUS_HEADER_SIZE + msg.statusLen;
+}
+
+inline bool isValidCommandFrame(const uint8_t* data, size_t len, size_t maxData = MAX_COMMAND_DATA_LEN) {
+    if (len < COMMAND_HEADER_SIZE) return false;
+    uint8_t used = ((const CommandMessage*)data)->commandLen;
+    return used <= maxData && len == COMMAND_HEADER_SIZE + used;
+}
+
+inline bool isValidStatusFrame(const uint8_t* data, size_t len) {
+    if (len < STATUS_HEADER_SIZE) return false;
+    uint8_t used = ((const StatusMessage*)data)->statusLen;
+    return used <= MAX_STATUS_DATA_LEN && len == STATUS_HEADER_SIZE + used;
+}
+
 // Maximum message size check (ESP-NOW limit is 250 bytes)
 static_assert(sizeof(AnnounceMessage) <= 250, "AnnounceMessage too large for ESP-NOW");
+// ProtocolInfo was carved out of the ANNOUNCE reserved bytes; new fields
+// must come out of reserved[] too, not grow the body
+static_assert(sizeof(AnnounceMessage) == sizeof(MessageHeader) + 18, "AnnounceMessage body must stay 18 bytes (fields come out of reserved[])");
 static_assert(sizeof(AckMessage) <= 250, "AckMessage too large for ESP-NOW");
+static_assert(sizeof(AckProtocolMessage) <= 250, "AckProtocolMessage too large for ESP-NOW");
 static_assert(sizeof(ConfigMessage) <= 250, "ConfigMessage too large for ESP-NOW");
 static_assert(sizeof(CommandMessage) <= 250, "CommandMessage too large for ESP-NOW");
 static_assert(sizeof(StatusMessage) <= 250, "StatusMessage too large for ESP-NOW");
 static_assert(sizeof(HeartbeatMessage) <= 250, "HeartbeatMessage too large for ESP-NOW");
+static_assert(sizeof(HeartbeatDiagMessage) <= 250, "HeartbeatDiagMessage too large for ESP-NOW");
 static_assert(sizeof(UnmapMessage) <= 250, "UnmapMessage too large for ESP-NOW");
+static_assert(sizeof(BeaconMessage) <= 250, "BeaconMessage too large for ESP-NOW");
 
 #endif // PROTOCOL_MESSAGES_H
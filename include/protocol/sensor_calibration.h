@@ -0,0 +1,202 @@
+#ifndef PROTOCOL_SENSOR_CALIBRATION_H
+#define PROTOCOL_SENSOR_CALIBRATION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "protocol/commands.h"
+
+// ============================================================================
+// SENSOR CALIBRATION - shared between hub and water quality node
+// ============================================================================
+// The hub compiles 2-5 buffer/standard readings per probe into a piecewise
+// linear table and pushes it with SensorProtocol::SET_CALIBRATION:
+//
+//   commandData[0]   = SET_CALIBRATION
+//   commandData[1..] = Table header + count Points (unused points not sent)
+//
+// The node converts raw ADC counts with lookup() + compensate(): integer
+// maths only, so the ESP8266 never touches soft-float for a reading.
+//
+//   value = v[i] + (raw - r[i]) * (v[i+1] - v[i]) / (r[i+1] - r[i])
+//
+// Outside the calibrated span the end segments are extrapolated. All
+// fields are little-endian. compile() uses floats and is only called on
+// the hub.
+// ============================================================================
+
+namespace SensorCalibration {
+
+enum class Probe : uint8_t {
+    PH = 0x00,      // value = pH x100
+    TDS = 0x01      // value = ppm
+};
+
+constexpr uint8_t MIN_POINTS = 2;
+constexpr uint8_t MAX_POINTS = 5;
+
+// Temperature compensation defaults (Table::tempParam)
+constexpr int16_t PH_ISOPOTENTIAL_X100 = 700;   // Nernst slope pivots around pH 7.00
+constexpr int16_t TDS_ALPHA_PER_10K = 200;      // Conductivity +2.0 % per C
+
+struct Point {
+    uint16_t raw;           // ADC counts
+    uint16_t value;         // pH x100 or ppm at refTemp
+} __attribute__((packed));
+
+struct Table {
+    Probe probe;
+    uint8_t count;          // Points in use (MIN_POINTS..MAX_POINTS)
+    int16_t refTempX100;    // Water temperature during calibration (C x100)
+    int16_t tempParam;      // PH: isopotential pH x100, TDS: alpha per 10k per C
+    Point points[MAX_POINTS];  // Strictly ascending raw
+} __attribute__((packed));
+
+constexpr size_t TABLE_HEADER_SIZE = sizeof(Table) - sizeof(Point) * MAX_POINTS;
+
+static_assert(1 + sizeof(Table) <= MAX_COMMAND_DATA_LEN, "Table must fit in commandData");
+
+inline size_t tableSize(uint8_t count) {
+    return TABLE_HEADER_SIZE + sizeof(Point) * count;
+}
+
+inline bool isValid(const Table& table) {
+    if (table.probe != Probe::PH && table.probe != Probe::TDS) return false;
+    if (table.count < MIN_POINTS || table.count > MAX_POINTS) return false;
+    for (uint8_t i = 1; i < table.count; i++) {
+        if (table.points[i].raw <= table.points[i - 1].raw) return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Wire format
+// ----------------------------------------------------------------------------
+
+inline size_t encode(uint8_t* out, const Table& table) {
+    out[0] = SensorProtocol::SET_CALIBRATION;
+    memcpy(out + 1, &table, tableSize(table.count));
+    return 1 + tableSize(table.count);
+}
+
+inline bool decode(const uint8_t* data, size_t len, Table& table) {
+    if (len < 1 + TABLE_HEADER_SIZE || data[0] != SensorProtocol::SET_CALIBRATION) {
+        return false;
+    }
+    memset(&table, 0, sizeof(table));
+    memcpy(&table, data + 1, TABLE_HEADER_SIZE);
+    if (table.count < MIN_POINTS || table.count > MAX_POINTS ||
+        len != 1 + tableSize(table.count)) {
+        return false;
+    }
+    memcpy(&table, data + 1, tableSize(table.count));
+    return isValid(table);
+}
+
+// ----------------------------------------------------------------------------
+// Conversion (node side, integer only)
+// ----------------------------------------------------------------------------
+
+// Round-half-away-from-zero integer division
+inline int32_t divRound(int64_t num, int64_t den) {
+    if (den < 0) { num = -num; den = -den; }
+    return (int32_t)(num >= 0 ? (num + den / 2) / den : (num - den / 2) / den);
+}
+
+// Raw counts -> value at the calibration temperature
+inline int32_t lookup(const Table& table, uint16_t raw) {
+    uint8_t i = 0;
+    while (i + 2 < table.count && raw > table.points[i + 1].raw) {
+        i++;
+    }
+    const Point& a = table.points[i];
+    const Point& b = table.points[i + 1];
+    return (int32_t)a.value + divRound((int64_t)((int32_t)raw - a.raw) * ((int32_t)b.value - a.value),
+                                       (int32_t)b.raw - a.raw);
+}
+
+// Value at refTemp -> value at the measured temperature
+inline int32_t compensate(const Table& table, int32_t value, int16_t tempX100) {
+    if (table.probe == Probe::PH) {
+        // Electrode slope scales with absolute temperature (centi-kelvin)
+        int32_t refK = (int32_t)table.refTempX100 + 27315;
+        int32_t nowK = (int32_t)tempX100 + 27315;
+        if (nowK <= 0) return value;
+        return table.tempParam + divRound((int64_t)(value - table.tempParam) * refK, nowK);
+    }
+
+    // Conductivity rises ~alpha per C; report it normalised to refTemp
+    int32_t denom = 10000 + divRound((int64_t)table.tempParam * (tempX100 - table.refTempX100), 100);
+    if (denom <= 0) return value;
+    return divRound((int64_t)value * 10000, denom);
+}
+
+inline uint16_t convert(const Table& table, uint16_t raw, int16_t tempX100) {
+    int32_t value = compensate(table, lookup(table, raw), tempX100);
+    return value < 0 ? 0 : (value > 0xFFFF ? 0xFFFF : (uint16_t)value);
+}
+
+// Single-point trim: shift the whole table so raw reads as knownValue
+inline void applyOffset(Table& table, uint16_t raw, uint16_t knownValue) {
+    int32_t delta = (int32_t)knownValue - lookup(table, raw);
+    for (uint8_t i = 0; i < table.count; i++) {
+        int32_t value = (int32_t)table.points[i].value + delta;
+        table.points[i].value = value < 0 ? 0 : (value > 0xFFFF ? 0xFFFF : (uint16_t)value);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Compilation (hub side)
+// ----------------------------------------------------------------------------
+
+struct CalPoint {
+    float reference;        // Buffer pH or standard ppm
+    uint16_t raw;           // ADC counts the node reported in it
+};
+
+/**
+ * @brief Build a Table from buffer readings
+ * @return false on <2 or >5 points, repeated raw values, a non-monotonic
+ *         response, or a reference out of range
+ */
+inline bool compile(Probe probe, const CalPoint* points, uint8_t count, float refTempC, Table& out) {
+    if (count < MIN_POINTS || count > MAX_POINTS) return false;
+
+    CalPoint sorted[MAX_POINTS];
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1].raw > points[i].raw) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = points[i];
+    }
+
+    float scale = (probe == Probe::PH) ? 100.0f : 1.0f;
+    memset(&out, 0, sizeof(out));
+    out.probe = probe;
+    out.count = count;
+    out.refTempX100 = (int16_t)(refTempC * 100.0f + (refTempC < 0 ? -0.5f : 0.5f));
+    out.tempParam = (probe == Probe::PH) ? PH_ISOPOTENTIAL_X100 : TDS_ALPHA_PER_10K;
+
+    int8_t direction = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        float value = sorted[i].reference * scale + 0.5f;
+        if (value < 0.0f || value > 65535.0f) return false;
+        out.points[i].raw = sorted[i].raw;
+        out.points[i].value = (uint16_t)value;
+
+        if (i > 0) {
+            // pH probes usually fall with rising counts; either way, stay monotonic
+            int8_t step = out.points[i].value > out.points[i - 1].value ? 1 :
+                          (out.points[i].value < out.points[i - 1].value ? -1 : 0);
+            if (step == 0 || (direction != 0 && step != direction)) return false;
+            direction = step;
+        }
+    }
+    return isValid(out);
+}
+
+}
+
+#endif // PROTOCOL_SENSOR_CALIBRATION_H
@@ -0,0 +1,477 @@
+#include "ESPNowLink.h"
+
+// ============================================================================
+// STATIC MEMBERS
+// ============================================================================
+
+static ESPNowLink* s_link = nullptr;
+
+#ifdef ESP32
+QueueHandle_t ESPNowLink::s_txResultQueue = nullptr;
+
+// RSSI of the ESP-NOW frame the WiFi task is delivering. The promiscuous
+// callback sees each frame just before onReceiveStatic(), in the same task.
+static uint8_t s_rssiMac[6] = {0};
+static int8_t s_rssi = 0;
+#endif
+
+// ============================================================================
+// CONSTRUCTOR / DESTRUCTOR
+// ============================================================================
+
+ESPNowLink::ESPNowLink()
+    : _initialized(false)
+    , _channel(6)
+    , _currentCommandId(0)
+#ifdef ESP32
+    , _rxQueue(nullptr)
+#endif
+    , _commandCallback(nullptr)
+    , _statusCallback(nullptr)
+    , _heartbeatCallback(nullptr)
+    , _heartbeatDiagCallback(nullptr)
+    , _ackCallback(nullptr)
+    , _announceCallback(nullptr)
+    , _configCallback(nullptr)
+    , _unmapCallback(nullptr)
+    , _beaconCallback(nullptr)
+    , _beaconIdentityCallback(nullptr)
+    , _replicationCallback(nullptr)
+{
+    s_link = this;
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+ESPNowLink::~ESPNowLink() {
+#ifdef ESP32
+    if (_rxQueue) {
+        vQueueDelete(_rxQueue);
+    }
+#endif
+}
+
+// ============================================================================
+// INITIALIZATION
+// ============================================================================
+
+bool ESPNowLink::initRadio(uint8_t channel, bool isHub) {
+    _channel = channel;
+
+    // CRITICAL: Set WiFi mode before ESP-NOW init
+    // ESP-NOW requires WiFi to be in STA or AP_STA mode
+    // Hub: WiFi should already be initialized by WiFiManager (WIFI_STA or WIFI_AP_STA)
+    // Nodes: Need to explicitly set WIFI_STA mode
+    if (!isHub) {
+        WiFi.mode(WIFI_STA);
+        WiFi.disconnect();  // Disconnect from any AP
+        Serial.println("[OK] WiFi mode set to STA");
+    } else {
+        // Hub: Verify WiFi is already initialized
+#ifdef ESP32
+        wifi_mode_t currentMode = WiFi.getMode();
+        Serial.printf("[OK] WiFi already initialized (mode: %s)\n",
+                     currentMode == WIFI_STA ? "STA" :
+                     currentMode == WIFI_AP ? "AP" :
+                     currentMode == WIFI_AP_STA ? "AP_STA" : "OFF");
+#else
+        Serial.println("[OK] WiFi already initialized");
+#endif
+    }
+
+    // Create RX queue
+#ifdef ESP32
+    _rxQueue = xQueueCreate(ESPNOW_RX_QUEUE_SIZE, sizeof(RxQueueEntry));
+    if (!_rxQueue) {
+        Serial.println("[ERR] Failed to create RX queue");
+        return false;
+    }
+    Serial.printf("[OK] RX Queue created (%d entries)\n", ESPNOW_RX_QUEUE_SIZE);
+#else
+    Serial.printf("[OK] RX Queue initialized (ESP8266 std::queue)\n");
+#endif
+
+    // Set WiFi channel
+#ifdef ESP8266
+    wifi_set_channel(_channel);
+#else
+    esp_wifi_set_channel(_channel, WIFI_SECOND_CHAN_NONE);
+#endif
+    Serial.printf("[OK] WiFi Channel: %d\n", _channel);
+
+    // Initialize ESP-NOW
+#ifdef ESP8266
+    if (esp_now_init() != 0) {
+#else
+    if (esp_now_init() != ESP_OK) {
+#endif
+        Serial.println("[ERR] ESP-NOW init failed");
+        return false;
+    }
+    Serial.println("[OK] ESP-NOW initialized");
+
+    // Register callbacks
+#ifdef ESP8266
+    esp_now_set_self_role(ESP_NOW_ROLE_COMBO);
+    esp_now_register_recv_cb(onReceiveStatic);
+    esp_now_register_send_cb(onSendStatic);
+#else
+    esp_now_register_recv_cb(onReceiveStatic);
+    esp_now_register_send_cb(onSendStatic);
+#endif
+    Serial.println("[OK] Callbacks registered");
+
+    _initialized = true;
+    return true;
+}
+
+bool ESPNowLink::addRadioPeer(const uint8_t* mac, bool& added) {
+    added = false;
+    if (!_initialized) return false;
+
+    // Check if peer already exists to avoid errors
+#ifdef ESP8266
+    // ESP8266: Check if peer exists by attempting to add (returns -1 if exists)
+    int result = esp_now_add_peer((uint8_t*)mac, ESP_NOW_ROLE_COMBO, _channel, NULL, 0);
+    if (result == -1) {
+        // Peer already exists - this is fine, not an error
+        return true;
+    }
+    if (result != 0) {
+        Serial.printf("[ERR] Failed to add peer %02X:%02X:...\n", mac[0], mac[1]);
+        return false;
+    }
+#else
+    // ESP32: Check if peer exists
+    if (esp_now_is_peer_exist(mac)) {
+        // Peer already exists - this is fine, not an error
+        return true;
+    }
+
+    esp_now_peer_info_t peerInfo = {};
+    memcpy(peerInfo.peer_addr, mac, 6);
+    peerInfo.channel = _channel;
+    peerInfo.encrypt = false;
+
+    esp_err_t result = esp_now_add_peer(&peerInfo);
+    if (result != ESP_OK) {
+        Serial.printf("[ERR] Failed to add peer %02X:%02X:... (error %d)\n", mac[0], mac[1], result);
+        return false;
+    }
+#endif
+
+    Serial.printf("[OK] Added peer %02X:%02X:%02X:%02X:%02X:%02X\n",
+                  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    added = true;
+    return true;
+}
+
+bool ESPNowLink::removeRadioPeer(const uint8_t* mac) {
+    if (!_initialized) return false;
+
+#ifdef ESP8266
+    if (esp_now_del_peer((uint8_t*)mac) != 0) {
+#else
+    if (esp_now_del_peer(mac) != ESP_OK) {
+#endif
+        return false;
+    }
+
+    Serial.printf("  Removed peer %02X:%02X:...\n", mac[0], mac[1]);
+    return true;
+}
+
+// ============================================================================
+// SENDING
+// ============================================================================
+
+bool ESPNowLink::send(const uint8_t* mac, const uint8_t* data, size_t len) {
+    if (!_initialized) {
+        Serial.println("[ERR] ESPNowManager not initialized");
+        return false;
+    }
+
+    if (len > ESPNOW_MAX_DATA_LEN) {
+        Serial.printf("[ERR] Message too large: %d bytes (max %d)\n", len, ESPNOW_MAX_DATA_LEN);
+        return false;
+    }
+
+    return transmit(mac, data, len);
+}
+
+bool ESPNowLink::transmit(const uint8_t* mac, const uint8_t* data, size_t len) {
+#ifdef ESP8266
+    int result = esp_now_send((uint8_t*)mac, (uint8_t*)data, len);
+    bool success = (result == 0);
+#else
+    esp_err_t result = esp_now_send(mac, data, len);
+    bool success = (result == ESP_OK);
+#endif
+
+    if (success) {
+        _stats.messagesSent++;
+    } else {
+        _stats.sendFailures++;
+        Serial.printf("[ERR] Send failed: %d\n", result);
+    }
+
+    return success;
+}
+
+// ============================================================================
+// RECEIVING (COMMON)
+// ============================================================================
+
+bool ESPNowLink::nextFrame(RxQueueEntry& entry) {
+#ifdef ESP32
+    return xQueueReceive(_rxQueue, &entry, 0) == pdTRUE;
+#else
+    // ESP8266: Process all queued messages
+    if (_rxQueue.empty()) {
+        return false;
+    }
+    entry = _rxQueue.front();
+    _rxQueue.pop();
+    return true;
+#endif
+}
+
+void ESPNowLink::dispatchFrame(const uint8_t* mac, const uint8_t* data, int len) {
+    const MessageHeader* header = (const MessageHeader*)data;
+
+    // Route based on message type
+    switch (header->type) {
+        case MessageType::STATUS:
+            if (isValidStatusFrame(data, len)) {
+                StatusMessage status = {};
+                memcpy(&status, data, len);
+                if (_statusCallback) {
+                    _statusCallback(mac, status);
+                }
+            } else {
+                Serial.printf("[ERR] STATUS length %d invalid\n", len);
+            }
+            break;
+
+        case MessageType::HEARTBEAT:
+            if (len >= sizeof(HeartbeatMessage) && _heartbeatCallback) {
+                _heartbeatCallback(mac, *(HeartbeatMessage*)data);
+            }
+            if (len >= sizeof(HeartbeatDiagMessage) && _heartbeatDiagCallback) {
+                _heartbeatDiagCallback(mac, ((HeartbeatDiagMessage*)data)->diagnostics);
+            }
+            break;
+
+        case MessageType::ANNOUNCE:
+            if (len >= sizeof(AnnounceMessage)) {
+                const AnnounceMessage& announce = *(const AnnounceMessage*)data;
+                Serial.printf("[ANNOUNCE] Received from %02X:%02X:%02X:%02X:%02X:%02X\n",
+                             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+                Serial.printf("           Type: %d, FW: v%d, Capabilities: 0x%02X, Protocol: v%d\n",
+                             (int)announce.header.nodeType, announce.firmwareVersion, announce.capabilities,
+                             announce.protocol.version);
+
+                if (_announceCallback) {
+                    _announceCallback(mac, announce);
+                } else {
+                    Serial.println("[WARN]  No ANNOUNCE callback registered!");
+                }
+            }
+            break;
+
+        case MessageType::ACK:
+            // Node receives ACK from hub
+            if (len >= sizeof(AckMessage)) {
+                const AckMessage* ack = (const AckMessage*)data;
+                if (_ackCallback) {
+                    _ackCallback(mac, *ack);
+                }
+            }
+            break;
+
+        case MessageType::CONFIG:
+            // Node receives CONFIG from hub (provisioning)
+            if (len >= sizeof(ConfigMessage)) {
+                const ConfigMessage* config = (const ConfigMessage*)data;
+                if (_configCallback) {
+                    _configCallback(mac, *config);
+                }
+            }
+            break;
+
+        case MessageType::BEACON:
+            // Node receives periodic hub beacon
+            if (len >= sizeof(BeaconMessage)) {
+                BeaconMessage beacon;
+                memcpy(&beacon, data, sizeof(beacon));
+                if (_beaconCallback) {
+                    _beaconCallback(mac, beacon);
+                }
+            }
+            if (len >= sizeof(BeaconIdentMessage) && _beaconIdentityCallback) {
+                BeaconIdentity identity;
+                memcpy(&identity, data + sizeof(BeaconMessage), sizeof(identity));
+                _beaconIdentityCallback(mac, identity);
+            }
+            break;
+
+        case MessageType::REPLICATE:
+            // Standby hub receives state, active hub receives ACK/NACK
+            if (len >= REPLICATION_HEADER_LEN && _replicationCallback) {
+                _replicationCallback(mac, data, len);
+            }
+            break;
+
+        case MessageType::UNMAP:
+            // Node receives UNMAP from hub (reset to discovery mode)
+            if (len >= sizeof(UnmapMessage)) {
+                const UnmapMessage* unmap = (const UnmapMessage*)data;
+                if (_unmapCallback) {
+                    _unmapCallback(mac, *unmap);
+                }
+            }
+            break;
+
+        default:
+            Serial.printf("[WARN]  Unknown message type: 0x%02X\n", (uint8_t)header->type);
+            break;
+    }
+}
+
+void ESPNowLink::onCommandReceived(void (*callback)(const uint8_t* mac, const uint8_t* data, size_t len)) {
+    _commandCallback = callback;
+}
+
+void ESPNowLink::onStatusReceived(void (*callback)(const uint8_t* mac, const StatusMessage& status)) {
+    _statusCallback = callback;
+}
+
+void ESPNowLink::onHeartbeatReceived(void (*callback)(const uint8_t* mac, const HeartbeatMessage& heartbeat)) {
+    _heartbeatCallback = callback;
+}
+
+void ESPNowLink::onHeartbeatDiagnostics(void (*callback)(const uint8_t* mac, const HeartbeatDiagnostics& diagnostics)) {
+    _heartbeatDiagCallback = callback;
+}
+
+void ESPNowLink::onAnnounceReceived(void (*callback)(const uint8_t* mac, const AnnounceMessage& announce)) {
+    _announceCallback = callback;
+}
+
+void ESPNowLink::onAckReceived(void (*callback)(const uint8_t* mac, const AckMessage& ack)) {
+    _ackCallback = callback;
+}
+
+void ESPNowLink::onConfigReceived(void (*callback)(const uint8_t* mac, const ConfigMessage& config)) {
+    _configCallback = callback;
+}
+
+void ESPNowLink::onUnmapReceived(void (*callback)(const uint8_t* mac, const UnmapMessage& unmap)) {
+    _unmapCallback = callback;
+}
+
+void ESPNowLink::onBeaconReceived(void (*callback)(const uint8_t* mac, const BeaconMessage& beacon)) {
+    _beaconCallback = callback;
+}
+
+void ESPNowLink::onBeaconIdentity(void (*callback)(const uint8_t* mac, const BeaconIdentity& identity)) {
+    _beaconIdentityCallback = callback;
+}
+
+void ESPNowLink::onReplicationReceived(void (*callback)(const uint8_t* mac, const uint8_t* data, size_t len)) {
+    _replicationCallback = callback;
+}
+
+// ============================================================================
+// DIAGNOSTICS
+// ============================================================================
+
+void ESPNowLink::printStatistics() const {
+    printCounters();
+    Serial.println("-----------------------------------------");
+}
+
+void ESPNowLink::printCounters() const {
+    Serial.println("-----------------------------------------");
+    Serial.println("[STATS] ESPNowManager Statistics");
+    Serial.println("-----------------------------------------");
+    Serial.printf("[TX] Messages Sent:        %u\n", _stats.messagesSent);
+    Serial.printf("[RX] Messages Received:    %u\n", _stats.messagesReceived);
+    Serial.printf("[ERR] Send Failures:        %u\n", _stats.sendFailures);
+    Serial.printf("[RST] Retries:              %u\n", _stats.retries);
+    Serial.printf(" Fragments Sent:       %u\n", _stats.fragmentsSent);
+    Serial.printf(" Fragments Received:   %u\n", _stats.fragmentsReceived);
+    Serial.printf("  Reassembly Timeouts:  %u\n", _stats.reassemblyTimeouts);
+    Serial.printf(" Duplicates Ignored:   %u\n", _stats.duplicatesIgnored);
+}
+
+// ============================================================================
+// INTERNAL HELPERS
+// ============================================================================
+
+uint64_t ESPNowLink::macToKey(const uint8_t* mac) {
+    uint64_t key = 0;
+    for (int i = 0; i < 6; i++) {
+        key |= ((uint64_t)mac[i]) << (i * 8);
+    }
+    return key;
+}
+
+#ifdef ESP8266
+void ESPNowLink::onReceiveStatic(uint8_t* mac, uint8_t* data, uint8_t len) {
+#else
+void ESPNowLink::onReceiveStatic(const uint8_t* mac, const uint8_t* data, int len) {
+#endif
+    if (!s_link || !s_link->_initialized) return;
+
+    // Debug: Log every received message
+    Serial.printf("[RX] Got %d bytes from %02X:%02X:%02X:%02X:%02X:%02X\n",
+                 len, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+    // Queue message for processing in main loop (ISR-safe)
+    RxQueueEntry entry;
+    memcpy(entry.mac, mac, 6);
+    memcpy(entry.data, data, len);
+    entry.len = len;
+
+#ifdef ESP32
+    entry.rssi = memcmp(s_rssiMac, mac, 6) == 0 ? s_rssi : 0;
+
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    xQueueSendFromISR(s_link->_rxQueue, &entry, &xHigherPriorityTaskWoken);
+
+    if (xHigherPriorityTaskWoken) {
+        portYIELD_FROM_ISR();
+    }
+#else
+    // ESP8266: Direct queue (not ISR-safe but no FreeRTOS)
+    entry.rssi = 0;
+    s_link->_rxQueue.push(entry);
+#endif
+}
+
+#ifdef ESP8266
+void ESPNowLink::onSendStatic(uint8_t* mac, uint8_t status) {
+    // Track send status if needed
+}
+#else
+void ESPNowLink::onSendStatic(const uint8_t* mac, esp_now_send_status_t status) {
+    // Broadcasts are never ACKed, so only unicast results say anything
+    if (!s_txResultQueue || (mac[0] & 0x01)) return;
+
+    TxResultEntry result;
+    memcpy(result.mac, mac, 6);
+    result.delivered = (status == ESP_NOW_SEND_SUCCESS);
+    xQueueSend(s_txResultQueue, &result, 0);  // Full: drop, the EWMA copes
+}
+
+void ESPNowLink::onPromiscuousStatic(void* buf, wifi_promiscuous_pkt_type_t type) {
+    if (type != WIFI_PKT_MGMT) return;
+
+    // Action frame (0xD0), vendor-specific category (127): ESP-NOW
+    const wifi_promiscuous_pkt_t* pkt = (const wifi_promiscuous_pkt_t*)buf;
+    if (pkt->rx_ctrl.sig_len < 25 || pkt->payload[0] != 0xD0 || pkt->payload[24] != 127) return;
+
+    memcpy(s_rssiMac, pkt->payload + 10, 6);  // Transmitter address
+    s_rssi = pkt->rx_ctrl.rssi;
+}
+#endif
@@ -0,0 +1,278 @@
+#ifndef ESPNOW_LINK_H
+#define ESPNOW_LINK_H
+
+#include <Arduino.h>
+#ifdef ESP8266
+    #include <ESP8266WiFi.h>
+    #include <espnow.h>
+#else
+    #include <WiFi.h>
+    #include <esp_now.h>
+    #include <esp_wifi.h>
+#endif
+#include "protocol/messages.h"
+#include <queue>
+
+// ============================================================================
+// CONSTANTS
+// ============================================================================
+
+#define ESPNOW_MAX_DATA_LEN 250
+#define ESPNOW_FRAGMENT_SIZE 32  // Size of commandData in CommandMessage
+#define ESPNOW_MAX_MESSAGE_SIZE 512  // Maximum size for large messages
+#define ESPNOW_REASSEMBLY_TIMEOUT_MS 1500
+#define ESPNOW_MAX_RETRIES 3
+#define ESPNOW_RETRY_BASE_DELAY_MS 100
+#define ESPNOW_RX_QUEUE_SIZE 10
+#define ESPNOW_PS_QUEUE_MAX 16           // Frames held for sleeping peers (all peers)
+#define ESPNOW_PS_QUEUE_TTL_MS 10000     // Held frames expire after this
+#define ESPNOW_PS_AWAKE_WINDOW_MS 50     // Peer treated as awake after it transmits
+#define ESPNOW_TX_RESULT_QUEUE_SIZE 16   // Send results awaiting the rate controller
+
+// ============================================================================
+// STRUCTURES
+// ============================================================================
+
+/**
+ * @brief Message queue entry for RX processing
+ */
+struct RxQueueEntry {
+    uint8_t mac[6];
+    uint8_t data[ESPNOW_MAX_DATA_LEN];
+    int len;
+    int8_t rssi;              // dBm, 0 = unknown
+};
+
+/**
+ * @brief Delivery result of one unicast send (send callback to main loop)
+ */
+struct TxResultEntry {
+    uint8_t mac[6];
+    bool delivered;           // MAC-layer ACK received
+};
+
+// ============================================================================
+// ESPNOW LINK (SHARED BY ALL ROLES)
+// ============================================================================
+
+/**
+ * @brief Radio, RX queue, callbacks and statistics every role needs
+ *
+ * The role policies (ESPNowRoles.h) derive from this and add their own
+ * state; ESPNowManagerT<Role> (ESPNowManager.h) ties them together. Nothing
+ * here branches on the role.
+ */
+class ESPNowLink {
+public:
+    ESPNowLink(const ESPNowLink&) = delete;
+    ESPNowLink& operator=(const ESPNowLink&) = delete;
+
+    // ========================================================================
+    // SENDING
+    // ========================================================================
+
+    /**
+     * @brief Send small message (single frame)
+     * @param mac Destination MAC address
+     * @param data Message data
+     * @param len Message length
+     * @return true if sent successfully
+     */
+    bool send(const uint8_t* mac, const uint8_t* data, size_t len);
+
+    // ========================================================================
+    // RECEIVING (COMMON)
+    // ========================================================================
+
+    /**
+     * @brief Set callback for received complete commands
+     * @param callback Function to call when command reassembly complete
+     */
+    void onCommandReceived(void (*callback)(const uint8_t* mac, const uint8_t* data, size_t len));
+
+    /**
+     * @brief Transaction ID of the command being delivered
+     * Valid inside the command callback; echo it in the STATUS reply
+     */
+    uint8_t getCurrentCommandId() const { return _currentCommandId; }
+
+    /**
+     * @brief Set callback for received status messages
+     * @param callback Function to call when status received
+     */
+    void onStatusReceived(void (*callback)(const uint8_t* mac, const StatusMessage& status));
+
+    /**
+     * @brief Set callback for received heartbeat messages
+     * @param callback Function to call when heartbeat received
+     */
+    void onHeartbeatReceived(void (*callback)(const uint8_t* mac, const HeartbeatMessage& heartbeat));
+
+    /**
+     * @brief Set callback for heartbeat diagnostics
+     *
+     * Called after the heartbeat callback when the frame carries a
+     * HeartbeatDiagnostics tail (HeartbeatDiagMessage).
+     * @param callback Function to call when diagnostics received
+     */
+    void onHeartbeatDiagnostics(void (*callback)(const uint8_t* mac, const HeartbeatDiagnostics& diagnostics));
+
+    /**
+     * @brief Set callback for received announce messages
+     * @param callback Function to call when announce received
+     */
+    void onAnnounceReceived(void (*callback)(const uint8_t* mac, const AnnounceMessage& announce));
+
+    /**
+     * @brief Set callback for received ACK messages
+     * @param callback Function to call when ACK received
+     */
+    void onAckReceived(void (*callback)(const uint8_t* mac, const AckMessage& ack));
+
+    /**
+     * @brief Set callback for received CONFIG messages
+     * @param callback Function to call when CONFIG received
+     */
+    void onConfigReceived(void (*callback)(const uint8_t* mac, const ConfigMessage& config));
+
+    /**
+     * @brief Set callback for received UNMAP messages
+     * @param callback Function to call when UNMAP received
+     */
+    void onUnmapReceived(void (*callback)(const uint8_t* mac, const UnmapMessage& unmap));
+
+    /**
+     * @brief Set callback for received BEACON messages
+     * @param callback Function to call when a beacon is received
+     */
+    void onBeaconReceived(void (*callback)(const uint8_t* mac, const BeaconMessage& beacon));
+
+    /**
+     * @brief Set callback for beacon identity
+     *
+     * Called after the beacon callback when the frame carries a
+     * BeaconIdentity tail (BeaconIdentMessage).
+     * @param callback Function to call when identity received
+     */
+    void onBeaconIdentity(void (*callback)(const uint8_t* mac, const BeaconIdentity& identity));
+
+    /**
+     * @brief Set callback for REPLICATE frames (hub to hub)
+     * @param callback Function to call with the raw frame
+     */
+    void onReplicationReceived(void (*callback)(const uint8_t* mac, const uint8_t* data, size_t len));
+
+    // ========================================================================
+    // DIAGNOSTICS
+    // ========================================================================
+
+    /**
+     * @brief Get statistics
+     */
+    struct Statistics {
+        uint32_t messagesSent;
+        uint32_t messagesReceived;
+        uint32_t sendFailures;
+        uint32_t retries;
+        uint32_t fragmentsSent;
+        uint32_t fragmentsReceived;
+        uint32_t reassemblyTimeouts;
+        uint32_t duplicatesIgnored;
+        uint32_t beaconsSent;
+        uint32_t framesHeld;          // Sends deferred for power-save peers
+        uint32_t framesExpired;       // Held frames dropped (TTL or queue full)
+        uint32_t sendsNotAcked;       // Unicast sends the peer did not ACK
+        uint32_t rateChanges;         // Per-peer PHY rate changes
+    };
+
+    Statistics getStatistics() const { return _stats; }
+    void resetStatistics() { _stats = {}; }
+    void printStatistics() const;
+
+protected:
+    ESPNowLink();
+    ~ESPNowLink();
+
+    bool _initialized;
+    uint8_t _channel;
+    uint8_t _currentCommandId;      // Command passed to _commandCallback
+
+    // Message queue (for ISR-safe processing)
+#ifdef ESP32
+    QueueHandle_t _rxQueue;
+    static QueueHandle_t s_txResultQueue;   // Created by a role that wants send results
+#else
+    std::queue<RxQueueEntry> _rxQueue;  // ESP8266 doesn't have FreeRTOS queues
+#endif
+
+    // Callbacks
+    void (*_commandCallback)(const uint8_t* mac, const uint8_t* data, size_t len);
+    void (*_statusCallback)(const uint8_t* mac, const StatusMessage& status);
+    void (*_heartbeatCallback)(const uint8_t* mac, const HeartbeatMessage& heartbeat);
+    void (*_heartbeatDiagCallback)(const uint8_t* mac, const HeartbeatDiagnostics& diagnostics);
+    void (*_ackCallback)(const uint8_t* mac, const AckMessage& ack);
+    void (*_announceCallback)(const uint8_t* mac, const AnnounceMessage& announce);
+    void (*_configCallback)(const uint8_t* mac, const ConfigMessage& config);
+    void (*_unmapCallback)(const uint8_t* mac, const UnmapMessage& unmap);
+    void (*_beaconCallback)(const uint8_t* mac, const BeaconMessage& beacon);
+    void (*_beaconIdentityCallback)(const uint8_t* mac, const BeaconIdentity& identity);
+    void (*_replicationCallback)(const uint8_t* mac, const uint8_t* data, size_t len);
+
+    // Statistics
+    Statistics _stats;
+
+    /**
+     * @brief WiFi mode, channel, ESP-NOW init and callbacks
+     * @param isHub Hub keeps the WiFi mode WiFiManager set up
+     */
+    bool initRadio(uint8_t channel, bool isHub);
+
+    /**
+     * @brief Register a peer with the ESP-NOW driver (existing peers are fine)
+     * @param added Set when the peer was not registered before
+     */
+    bool addRadioPeer(const uint8_t* mac, bool& added);
+
+    bool removeRadioPeer(const uint8_t* mac);
+
+    /**
+     * @brief Hand one frame to esp_now_send() and update statistics
+     */
+    bool transmit(const uint8_t* mac, const uint8_t* data, size_t len);
+
+    /**
+     * @brief Take the next received frame off the RX queue
+     */
+    bool nextFrame(RxQueueEntry& entry);
+
+    /**
+     * @brief Validate a frame and pass it to its callback (not COMMAND,
+     *        which the role handles)
+     */
+    void dispatchFrame(const uint8_t* mac, const uint8_t* data, int len);
+
+    void printCounters() const;
+
+    /**
+     * @brief Convert MAC address to uint64_t key
+     */
+    static uint64_t macToKey(const uint8_t* mac);
+
+    /**
+     * @brief ESP-NOW receive callback (static, forwards to instance)
+     */
+#ifdef ESP8266
+    static void onReceiveStatic(uint8_t* mac, uint8_t* data, uint8_t len);
+    static void onSendStatic(uint8_t* mac, uint8_t status);
+#else
+    static void onReceiveStatic(const uint8_t* mac, const uint8_t* data, int len);
+    static void onSendStatic(const uint8_t* mac, esp_now_send_status_t status);
+
+    /**
+     * @brief Promiscuous callback: RSSI of the ESP-NOW frame being received
+     */
+    static void onPromiscuousStatic(void* buf, wifi_promiscuous_pkt_type_t type);
+#endif
+};
+
+#endif // ESPNOW_LINK_H
@@ -0,0 +1,458 @@
+#ifndef ESPNOW_ROLES_H
+#define ESPNOW_ROLES_H
+
+#include "ESPNowLink.h"
+#include "RateController.h"
+#include <map>
+#include <vector>
+
+// ============================================================================
+// ROLE POLICIES
+// ============================================================================
+// ESPNowManagerT<Role> derives from one of these. Each role holds only the
+// state it uses and supplies the hooks the manager calls on every frame:
+//
+//   IS_HUB                       Hub keeps the WiFi mode set up by WiFiManager
+//   peerAdded(mac) / peerRemoved(mac)
+//   pollRole()                   Start of every processQueue()
+//   frameRssi(mac, rssi)         Frame from mac arrived with this RSSI
+//   acceptFrame(mac, data, len)  false drops the frame (duplicates)
+//   handleCommand(mac, cmd, payload)
+//                                Validated COMMAND frame; payload holds
+//                                cmd.commandLen bytes (may exceed commandData)
+//   protocolOffer()              ProtocolInfo this role supports
+//
+// The hooks are resolved at compile time, so a node build contains no peer
+// table, retry queue or rate controller and the hub no reassembly buffer.
+
+// ============================================================================
+// STRUCTURES
+// ============================================================================
+
+/**
+ * @brief Reassembly context for multi-part messages (node-side)
+ */
+struct ReassemblyContext {
+    bool active;
+    uint8_t commandId;        // Command ID being reassembled
+    uint8_t expectedSeqID;    // Next expected sequence ID
+    uint32_t startTime;       // When reassembly started
+    uint8_t buffer[ESPNOW_MAX_MESSAGE_SIZE];
+    size_t offset;            // Current buffer offset
+    uint8_t senderMac[6];     // MAC of sender
+};
+
+/**
+ * @brief TX retry context (hub-side)
+ */
+struct RetryContext {
+    uint8_t destMac[6];
+    uint8_t data[ESPNOW_MAX_DATA_LEN];
+    size_t len;
+    uint8_t attemptsRemaining;
+    uint32_t nextRetryTime;
+    bool active;
+};
+
+/**
+ * @brief Frame held for a power-save peer (hub-side)
+ */
+struct HeldFrame {
+    uint8_t destMac[6];
+    uint8_t data[ESPNOW_MAX_DATA_LEN];
+    size_t len;
+    uint32_t queuedAt;
+};
+
+/**
+ * @brief Peer status tracking
+ */
+struct PeerStatus {
+    uint8_t mac[6];
+    bool online;
+    uint32_t lastHeartbeat;
+    uint8_t lastSeqReceived;  // For duplicate detection
+    uint8_t slot;             // Beacon slot (0 = none)
+    bool powerSave;           // Radio sleeps between beacons
+    uint32_t awakeUntil;      // millis() until which sends go straight out
+    bool longRange;           // Peer receives LR frames (and hub LR enabled)
+    ProtocolInfo protocol;    // Agreed in ANNOUNCE/ACK (version 0 = legacy)
+    RateController::State rate;
+};
+
+/**
+ * @brief Radio link to a peer as seen by the rate controller (hub-side)
+ */
+struct PeerLinkInfo {
+    uint16_t rateKbps;        // Current ESP-NOW PHY rate
+    bool longRange;           // Rate is an LR rate
+    int8_t rssi;              // dBm, 0 = unknown
+    uint8_t deliveryPercent;  // Delivered sends (EWMA)
+    uint16_t rateChanges;
+};
+
+// ============================================================================
+// HUB ROLE
+// ============================================================================
+
+/**
+ * @brief Hub: tracks peers, retries, power-save queue, beacons, PHY rates
+ */
+class HubRole : public ESPNowLink {
+public:
+    static constexpr bool IS_HUB = true;
+    static const char* roleName() { return "HUB"; }
+    static ProtocolInfo protocolOffer() {
+        ProtocolInfo offer = {PROTOCOL_VERSION, PROTO_FEAT_FRAGMENTS | PROTO_FEAT_LARGE_COMMAND,
+                              (uint8_t)MAX_COMMAND_FRAME_DATA_LEN};
+        return offer;
+    }
+
+    // ========================================================================
+    // SENDING (HUB-SIDE)
+    // ========================================================================
+
+    /**
+     * @brief Send small message (single frame)
+     * @param mac Destination MAC address
+     * @param data Message data
+     * @param len Message length
+     * @param checkOnline If true, check peer is online before sending
+     * @return true if sent successfully
+     */
+    bool send(const uint8_t* mac, const uint8_t* data, size_t len, bool checkOnline = false);
+
+    /**
+     * @brief Send large message with automatic fragmentation
+     * @param mac Destination MAC address
+     * @param commandId Unique command ID
+     * @param data Large data buffer
+     * @param len Data length (up to ESPNOW_MAX_MESSAGE_SIZE)
+     * @param checkOnline If true, check peer is online before sending
+     * @return true if all fragments sent successfully
+     */
+    bool sendFragmented(const uint8_t* mac, uint8_t commandId,
+                       const uint8_t* data, size_t len, bool checkOnline = false);
+
+    /**
+     * @brief Send a command in the best transfer mode the peer agreed to
+     *
+     * One frame if len fits the peer's maxCommandData (32 bytes for
+     * peers without PROTO_FEAT_LARGE_COMMAND), otherwise fragments of
+     * that size if the peer reassembles.
+     * @param tankId Tank the command is for (header.tankId)
+     * @param commandId Transaction ID the node echoes in its STATUS
+     * @return false if sending failed or the command is too large for the peer
+     */
+    bool sendCommand(const uint8_t* mac, uint8_t tankId, uint8_t commandId,
+                     const uint8_t* data, size_t len, bool checkOnline = false);
+
+    /**
+     * @brief Longest command sendCommand() can deliver to a peer
+     */
+    size_t getMaxCommandLen(const uint8_t* mac) const;
+
+    /**
+     * @brief Send with automatic retry on failure
+     * @param mac Destination MAC address
+     * @param data Message data
+     * @param len Message length
+     * @param maxRetries Maximum retry attempts
+     * @return true if sent successfully (possibly after retries)
+     */
+    bool sendWithRetry(const uint8_t* mac, const uint8_t* data, size_t len, uint8_t maxRetries = ESPNOW_MAX_RETRIES);
+
+    // ========================================================================
+    // BEACON & POWER SAVE (HUB-SIDE)
+    // ========================================================================
+    // send() to a power-save peer that is not known to be awake holds the
+    // frame instead. The peer's slot bit is set in every beacon until it
+    // transmits, at which point the held frames are sent in order.
+
+    /**
+     * @brief Get or assign the beacon slot for a peer
+     * @param mac Peer MAC address
+     * @return Slot (1..BEACON_SLOT_COUNT-1), 0 if all slots are taken
+     */
+    uint8_t assignSlot(const uint8_t* mac);
+
+    /**
+     * @brief Mark a peer as power-save (from ANNOUNCE capabilities)
+     */
+    void setPeerPowerSave(const uint8_t* mac, bool powerSave);
+
+    /**
+     * @brief Broadcast a beacon with the current pending-slot bitmap
+     * @param epoch Unix time (0 if unknown)
+     * @param configGeneration Hub configuration generation
+     * @param hubSession Identifier that changes on hub restart
+     * @param intervalMs Time until the next beacon
+     * @return true if sent
+     */
+    bool sendBeacon(uint32_t epoch, uint16_t configGeneration, uint16_t hubSession, uint16_t intervalMs);
+
+    /**
+     * @brief Append a BeaconIdentity tail to every beacon from now on
+     * @param hubId Logical hub identity (MAC the nodes were provisioned by)
+     * @param generation Takeover generation
+     */
+    void setBeaconIdentity(const uint8_t* hubId, uint16_t generation);
+
+    /**
+     * @brief Number of frames held for sleeping peers
+     */
+    size_t getHeldFrameCount() const { return _heldFrames.size(); }
+
+    // ========================================================================
+    // PROTOCOL NEGOTIATION (HUB-SIDE)
+    // ========================================================================
+
+    /**
+     * @brief Record the protocol agreed with a peer from its ANNOUNCE offer
+     * @return Agreed protocol (version 0 for nodes that predate negotiation)
+     */
+    ProtocolInfo negotiateProtocol(const uint8_t* mac, const ProtocolInfo& offered);
+
+    /**
+     * @brief Protocol agreed with a peer
+     * @return false if the peer is not tracked
+     */
+    bool getPeerProtocol(const uint8_t* mac, ProtocolInfo& protocol) const;
+
+    /**
+     * @brief Append the agreed protocol to an ACK for peers that negotiated
+     * @param frame ACK with frame.ack filled in
+     * @return Bytes of frame to send
+     */
+    size_t completeAck(const uint8_t* mac, AckProtocolMessage& frame) const;
+
+    // ========================================================================
+    // RATE ADAPTATION (HUB-SIDE, ESP32)
+    // ========================================================================
+    // Each peer gets its own PHY rate from a RateController fed with the
+    // delivery result of every unicast send and the RSSI of every frame
+    // received from it. Peers start at 1 Mbps, the ESP-NOW default.
+
+    /**
+     * @brief Start adapting the PHY rate per peer (call after begin())
+     * @param longRange Also use the LR rates for peers that announce
+     *        NODE_CAP_LONG_RANGE (adds LR to the station protocols)
+     * @return false on ESP8266 or if the radio rejected the setup
+     */
+    bool enableRateAdaptation(bool longRange);
+
+    bool isRateAdaptationEnabled() const { return _rateAdaptation; }
+
+    /**
+     * @brief Mark a peer as able to receive LR frames (from ANNOUNCE capabilities)
+     */
+    void setPeerLongRange(const uint8_t* mac, bool longRange);
+
+    /**
+     * @brief Current rate, RSSI and delivery of a peer
+     * @return false if the peer is not tracked
+     */
+    bool getPeerLink(const uint8_t* mac, PeerLinkInfo& info) const;
+
+    // ========================================================================
+    // PEER STATUS (HUB-SIDE)
+    // ========================================================================
+
+    /**
+     * @brief Update peer status (online/offline)
+     * @param mac Peer MAC address
+     * @param online True if online
+     */
+    void setPeerOnline(const uint8_t* mac, bool online);
+
+    /**
+     * @brief Check if peer is online
+     * @param mac Peer MAC address
+     * @return true if peer is online
+     */
+    bool isPeerOnline(const uint8_t* mac) const;
+
+    /**
+     * @brief Update peer heartbeat timestamp
+     * @param mac Peer MAC address
+     */
+    void updatePeerHeartbeat(const uint8_t* mac);
+
+    /**
+     * @brief Check all peers for heartbeat timeout
+     * @param timeoutMs Timeout in milliseconds
+     * @return Number of peers marked offline
+     */
+    int checkPeerTimeouts(uint32_t timeoutMs);
+
+    // ========================================================================
+    // DIAGNOSTICS
+    // ========================================================================
+
+    void printStatistics() const;
+
+protected:
+    HubRole();
+    ~HubRole();
+
+    // Role hooks (see top of file)
+    void peerAdded(const uint8_t* mac);
+    void peerRemoved(const uint8_t* mac);
+    void pollRole();
+    void frameRssi(const uint8_t* mac, int8_t rssi);
+    bool acceptFrame(const uint8_t* mac, const uint8_t* data, int len);
+    void handleCommand(const uint8_t* mac, const CommandMessage& cmd, const uint8_t* payload);
+
+private:
+    // Peer tracking
+    std::map<uint64_t, PeerStatus> _peers;  // Key: MAC as uint64_t
+
+    // Retry contexts
+    std::vector<RetryContext> _retryQueue;
+
+    // Frames held for power-save peers, oldest first
+    std::vector<HeldFrame> _heldFrames;
+    uint8_t _beaconSequence;
+    BeaconIdentity _beaconIdentity;
+    bool _hasBeaconIdentity;
+
+    // Rate adaptation
+    bool _rateAdaptation;
+    bool _longRange;                // LR enabled on this radio
+#ifdef ESP32
+    RateController::Rate _interfaceRate;    // Rate set with esp_wifi_config_espnow_rate()
+#endif
+
+    /**
+     * @brief COMMAND payload bytes per frame for a peer
+     */
+    size_t commandFrameData(const uint8_t* mac) const;
+
+    /**
+     * @brief Split a command into COMMAND frames of fragmentSize payload
+     */
+    bool sendFragments(const uint8_t* mac, uint8_t tankId, uint8_t commandId,
+                       const uint8_t* data, size_t len, size_t fragmentSize);
+
+    /**
+     * @brief Check if message is duplicate
+     * @return true if duplicate (should be ignored)
+     */
+    bool isDuplicate(const uint8_t* mac, uint8_t sequenceNum);
+
+    /**
+     * @brief Process retry queue
+     */
+    void processRetries();
+
+    /**
+     * @brief Add message to retry queue
+     */
+    void addToRetryQueue(const uint8_t* mac, const uint8_t* data, size_t len);
+
+    /**
+     * @brief Hold a frame for a sleeping peer (drops the oldest when full)
+     */
+    void holdFrame(const uint8_t* mac, const uint8_t* data, size_t len);
+
+    /**
+     * @brief Peer transmitted: mark it awake and send its held frames
+     */
+    void releaseHeldFrames(const uint8_t* mac);
+
+    /**
+     * @brief Drop held frames older than ESPNOW_PS_QUEUE_TTL_MS
+     */
+    void expireHeldFrames();
+
+    /**
+     * @brief Feed queued send results to the rate controllers
+     */
+    void processTxResults();
+
+    /**
+     * @brief Feed the RSSI of a received frame to the peer's rate controller
+     */
+    void updatePeerRssi(const uint8_t* mac, int8_t rssi);
+
+    /**
+     * @brief Configure the radio for a peer's current rate
+     */
+    void applyPeerRate(const PeerStatus& peer);
+
+    /**
+     * @brief Without per-peer rates (IDF < 5.1): run the interface at the
+     *        slowest tracked peer's rate
+     */
+    void applyInterfaceRate();
+};
+
+// ============================================================================
+// NODE ROLE
+// ============================================================================
+
+/**
+ * @brief End device: reassembles fragmented commands, tracks no peers
+ */
+class NodeRole : public ESPNowLink {
+public:
+    static constexpr bool IS_HUB = false;
+    static const char* roleName() { return "NODE"; }
+    static ProtocolInfo protocolOffer() {
+        ProtocolInfo offer = {PROTOCOL_VERSION, PROTO_FEAT_FRAGMENTS | PROTO_FEAT_LARGE_COMMAND,
+                              (uint8_t)MAX_COMMAND_FRAME_DATA_LEN};
+        return offer;
+    }
+
+protected:
+    NodeRole();
+
+    // Role hooks (see top of file)
+    void peerAdded(const uint8_t*) {}
+    void peerRemoved(const uint8_t*) {}
+    void pollRole();
+    void frameRssi(const uint8_t*, int8_t) {}
+    bool acceptFrame(const uint8_t*, const uint8_t*, int) { return true; }  // Duplicates handled by hub
+    void handleCommand(const uint8_t* mac, const CommandMessage& cmd, const uint8_t* payload);
+
+private:
+    ReassemblyContext _reassembly;
+
+    /**
+     * @brief Reset reassembly context
+     */
+    void resetReassembly();
+};
+
+// ============================================================================
+// REPEATER ROLE
+// ============================================================================
+
+/**
+ * @brief Relay: forwards frames, never reassembles
+ *
+ * Commands addressed to the repeater itself are small; fragmented ones
+ * are dropped instead of carrying the 512-byte reassembly buffer.
+ */
+class RepeaterRole : public ESPNowLink {
+public:
+    static constexpr bool IS_HUB = false;
+    static const char* roleName() { return "REPEATER"; }
+    static ProtocolInfo protocolOffer() {
+        ProtocolInfo offer = {PROTOCOL_VERSION, 0, MAX_COMMAND_DATA_LEN};
+        return offer;
+    }
+
+protected:
+    RepeaterRole() {}
+
+    // Role hooks (see top of file)
+    void peerAdded(const uint8_t*) {}
+    void peerRemoved(const uint8_t*) {}
+    void pollRole() {}
+    void frameRssi(const uint8_t*, int8_t) {}
+    bool acceptFrame(const uint8_t*, const uint8_t*, int) { return true; }
+    void handleCommand(const uint8_t* mac, const CommandMessage& cmd, const uint8_t* payload);
+};
+
+#endif // ESPNOW_ROLES_H
@@ -0,0 +1,827 @@
+#include "ESPNowRoles.h"
+
+#ifdef HUB_BUILD  // Only the role this build uses is compiled
+
+// Per-peer ESP-NOW rates (esp_now_set_peer_rate_config) need ESP-IDF 5.1;
+// older cores set one rate for the interface. The version macros are only
+// tested once esp_idf_version.h has defined them.
+#ifdef ESP32
+#include <esp_idf_version.h>
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+#define HUB_PER_PEER_RATE 1
+#endif
+#endif
+
+// ============================================================================
+// CONSTRUCTOR / DESTRUCTOR
+// ============================================================================
+
+HubRole::HubRole()
+    : _beaconSequence(0)
+    , _hasBeaconIdentity(false)
+    , _rateAdaptation(false)
+    , _longRange(false)
+#ifdef ESP32
+    , _interfaceRate(RateController::Rate::B_1M)
+#endif
+{
+    memset(&_beaconIdentity, 0, sizeof(_beaconIdentity));
+}
+
+HubRole::~HubRole() {
+#ifdef ESP32
+    if (s_txResultQueue) {
+        vQueueDelete(s_txResultQueue);
+        s_txResultQueue = nullptr;
+    }
+#endif
+}
+
+// ============================================================================
+// ROLE HOOKS
+// ============================================================================
+
+void HubRole::peerAdded(const uint8_t* mac) {
+    PeerStatus& peer = _peers[macToKey(mac)];
+    memcpy(peer.mac, mac, 6);
+    peer.online = true;
+    peer.lastHeartbeat = millis();
+    peer.lastSeqReceived = 0;
+    memset(&peer.protocol, 0, sizeof(peer.protocol));  // Legacy until it announces
+    RateController::reset(peer.rate, false, peer.lastHeartbeat);
+    applyPeerRate(peer);
+}
+
+void HubRole::peerRemoved(const uint8_t* mac) {
+    _peers.erase(macToKey(mac));
+    applyInterfaceRate();
+
+    for (size_t i = 0; i < _heldFrames.size();) {
+        if (memcmp(_heldFrames[i].destMac, mac, 6) == 0) {
+            _heldFrames.erase(_heldFrames.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+void HubRole::pollRole() {
+    processRetries();
+
+    // Send results for the rate controllers
+    if (_rateAdaptation) {
+        processTxResults();
+    }
+}
+
+void HubRole::frameRssi(const uint8_t* mac, int8_t rssi) {
+    if (_rateAdaptation && rssi != 0) {
+        updatePeerRssi(mac, rssi);
+    }
+}
+
+bool HubRole::acceptFrame(const uint8_t* mac, const uint8_t* data, int len) {
+    const MessageHeader* header = (const MessageHeader*)data;
+
+    // Check for duplicate (sequence number validation)
+    if (isDuplicate(mac, header->sequenceNum)) {
+        _stats.duplicatesIgnored++;
+        Serial.printf(" Duplicate message ignored (seq %d)\n", header->sequenceNum);
+        return false;
+    }
+
+    // Any frame from a peer means its radio is on
+    releaseHeldFrames(mac);
+
+    if (header->type == MessageType::HEARTBEAT && len >= sizeof(HeartbeatMessage)) {
+        updatePeerHeartbeat(mac);
+    }
+    return true;
+}
+
+void HubRole::handleCommand(const uint8_t*, const CommandMessage&, const uint8_t*) {
+    // Commands are for nodes only
+    Serial.println("[WARN]  Hub received COMMAND (unexpected)");
+}
+
+// ============================================================================
+// SENDING (HUB-SIDE)
+// ============================================================================
+
+bool HubRole::send(const uint8_t* mac, const uint8_t* data, size_t len, bool checkOnline) {
+    if (!_initialized) {
+        Serial.println("[ERR] ESPNowManager not initialized");
+        return false;
+    }
+
+    if (len > ESPNOW_MAX_DATA_LEN) {
+        Serial.printf("[ERR] Message too large: %d bytes (max %d)\n", len, ESPNOW_MAX_DATA_LEN);
+        return false;
+    }
+
+    // Check if peer is online
+    if (checkOnline && !isPeerOnline(mac)) {
+        Serial.println("[WARN]  Peer offline, message not sent");
+        return false;
+    }
+
+    // Power-save peer between beacons: hold until it transmits
+    auto it = _peers.find(macToKey(mac));
+    if (it != _peers.end() && it->second.powerSave &&
+        (int32_t)(millis() - it->second.awakeUntil) >= 0) {
+        holdFrame(mac, data, len);
+        return true;
+    }
+
+    return transmit(mac, data, len);
+}
+
+bool HubRole::sendFragmented(const uint8_t* mac, uint8_t commandId,
+                             const uint8_t* data, size_t len, bool checkOnline) {
+    if (!_initialized) return false;
+
+    // Check if peer is online
+    if (checkOnline && !isPeerOnline(mac)) {
+        Serial.println("[WARN]  Peer offline, fragmented message not sent");
+        return false;
+    }
+
+    return sendFragments(mac, 0, commandId, data, len, commandFrameData(mac));
+}
+
+bool HubRole::sendCommand(const uint8_t* mac, uint8_t tankId, uint8_t commandId,
+                          const uint8_t* data, size_t len, bool checkOnline) {
+    if (!_initialized) return false;
+
+    // Check if peer is online
+    if (checkOnline && !isPeerOnline(mac)) {
+        Serial.println("[WARN]  Peer offline, command not sent");
+        return false;
+    }
+
+    size_t frameData = commandFrameData(mac);
+    if (len > frameData) {
+        auto it = _peers.find(macToKey(mac));
+        if (it == _peers.end() || !(it->second.protocol.features & PROTO_FEAT_FRAGMENTS)) {
+            Serial.printf("[ERR] Command of %d bytes exceeds what the peer accepts (%d)\n", len, frameData);
+            return false;
+        }
+        return sendFragments(mac, tankId, commandId, data, len, frameData);
+    }
+
+    // Whole command in one frame, only the used payload goes on air
+    uint8_t frame[ESPNOW_MAX_DATA_LEN];
+    CommandMessage& cmd = *(CommandMessage*)frame;
+    cmd.header.type = MessageType::COMMAND;
+    cmd.header.tankId = tankId;
+    cmd.header.nodeType = NodeType::HUB;
+    cmd.header.timestamp = millis();
+    cmd.header.sequenceNum = 0;  // ESPNowManager handles sequence tracking
+    cmd.commandId = commandId;
+    cmd.commandSeqID = 0;
+    cmd.finalCommand = true;
+    cmd.commandLen = len;
+    memcpy(frame + COMMAND_HEADER_SIZE, data, len);
+
+    return send(mac, frame, COMMAND_HEADER_SIZE + len, false);
+}
+
+size_t HubRole::getMaxCommandLen(const uint8_t* mac) const {
+    auto it = _peers.find(macToKey(mac));
+    if (it != _peers.end() && (it->second.protocol.features & PROTO_FEAT_FRAGMENTS)) {
+        return ESPNOW_MAX_MESSAGE_SIZE;
+    }
+    return commandFrameData(mac);
+}
+
+size_t HubRole::commandFrameData(const uint8_t* mac) const {
+    auto it = _peers.find(macToKey(mac));
+    if (it == _peers.end() || !(it->second.protocol.features & PROTO_FEAT_LARGE_COMMAND)) {
+        return MAX_COMMAND_DATA_LEN;
+    }
+    return it->second.protocol.maxCommandData;
+}
+
+bool HubRole::sendFragments(const uint8_t* mac, uint8_t tankId, uint8_t commandId,
+                            const uint8_t* data, size_t len, size_t fragmentSize) {
+    if (len > ESPNOW_MAX_MESSAGE_SIZE) {
+        Serial.printf("[ERR] Message too large: %d bytes (max %d)\n", len, ESPNOW_MAX_MESSAGE_SIZE);
+        return false;
+    }
+
+    Serial.printf(" Fragmenting message: %d bytes into %d-byte chunks\n",
+                  len, fragmentSize);
+
+    size_t offset = 0;
+    uint8_t seqID = 0;
+
+    while (offset < len) {
+        size_t remainingBytes = len - offset;
+        size_t chunkSize = (remainingBytes < fragmentSize) ? remainingBytes : fragmentSize;
+        bool isFinal = (offset + chunkSize >= len);
+
+        // Build command message (payload may run past commandData, see
+        // PROTO_FEAT_LARGE_COMMAND)
+        uint8_t frame[ESPNOW_MAX_DATA_LEN];
+        CommandMessage& cmd = *(CommandMessage*)frame;
+        cmd.header.type = MessageType::COMMAND;
+        cmd.header.tankId = tankId;
+        cmd.header.nodeType = NodeType::HUB;
+        cmd.header.timestamp = millis();
+        cmd.header.sequenceNum = 0;  // Will be set by send callback
+
+        cmd.commandId = commandId;
+        cmd.commandSeqID = seqID;
+        cmd.finalCommand = isFinal;
+
+        // Copy fragment data
+        memcpy(frame + COMMAND_HEADER_SIZE, data + offset, chunkSize);
+        cmd.commandLen = chunkSize;
+
+        // Send fragment (final fragment goes out short)
+        if (!send(mac, frame, COMMAND_HEADER_SIZE + chunkSize, false)) {
+            Serial.printf("[ERR] Failed to send fragment %d\n", seqID);
+            return false;
+        }
+
+        _stats.fragmentsSent++;
+
+        Serial.printf("  [TX] Sent fragment %d/%d (%d bytes)%s\n",
+                      seqID + 1,
+                      (len + fragmentSize - 1) / fragmentSize,
+                      chunkSize,
+                      isFinal ? " [FINAL]" : "");
+
+        offset += chunkSize;
+        seqID++;
+
+        // Small delay between fragments to avoid overwhelming receiver
+        delay(10);
+    }
+
+    Serial.printf("[OK] Sent %d fragments successfully\n", seqID);
+    return true;
+}
+
+bool HubRole::sendWithRetry(const uint8_t* mac, const uint8_t* data, size_t len, uint8_t maxRetries) {
+    if (!_initialized) return false;
+
+    for (uint8_t attempt = 0; attempt <= maxRetries; attempt++) {
+        if (attempt > 0) {
+            _stats.retries++;
+            uint32_t delayMs = ESPNOW_RETRY_BASE_DELAY_MS * (1 << (attempt - 1));  // Exponential backoff
+            Serial.printf("[RST] Retry %d/%d (delay %dms)\n", attempt, maxRetries, delayMs);
+            delay(delayMs);
+        }
+
+        if (send(mac, data, len, false)) {
+            if (attempt > 0) {
+                Serial.printf("[OK] Sent successfully after %d retries\n", attempt);
+            }
+            return true;
+        }
+    }
+
+    Serial.printf("[ERR] Failed after %d retries\n", maxRetries);
+    return false;
+}
+
+void HubRole::processRetries() {
+    // Process pending retries (hub only)
+    if (_retryQueue.empty()) return;
+
+    uint32_t now = millis();
+
+    for (auto it = _retryQueue.begin(); it != _retryQueue.end(); ) {
+        RetryContext& ctx = *it;
+
+        if (!ctx.active) {
+            it = _retryQueue.erase(it);
+            continue;
+        }
+
+        // Check if retry time reached
+        if (now >= ctx.nextRetryTime) {
+            if (ctx.attemptsRemaining > 0) {
+                // Retry send
+                if (send(ctx.destMac, ctx.data, ctx.len, false)) {
+                    // Success - remove from retry queue
+                    Serial.printf("[OK] Retry successful for %02X:%02X:...\n", 
+                                 ctx.destMac[0], ctx.destMac[1]);
+                    it = _retryQueue.erase(it);
+                    continue;
+                } else {
+                    // Failed - schedule next retry
+                    ctx.attemptsRemaining--;
+                    _stats.retries++;
+
+                    uint8_t attemptNum = ESPNOW_MAX_RETRIES - ctx.attemptsRemaining;
+                    uint32_t delayMs = ESPNOW_RETRY_BASE_DELAY_MS * (1 << attemptNum);
+                    ctx.nextRetryTime = now + delayMs;
+
+                    Serial.printf("[RST] Retry %d/%d scheduled in %dms\n", 
+                                 attemptNum, ESPNOW_MAX_RETRIES, delayMs);
+                }
+            } else {
+                // No more retries - give up
+                Serial.printf("[ERR] Retry failed after %d attempts\n", ESPNOW_MAX_RETRIES);
+                it = _retryQueue.erase(it);
+                continue;
+            }
+        }
+
+        ++it;
+    }
+}
+
+void HubRole::addToRetryQueue(const uint8_t* mac, const uint8_t* data, size_t len) {
+    if (len > ESPNOW_MAX_DATA_LEN) return;
+
+    RetryContext ctx;
+    memcpy(ctx.destMac, mac, 6);
+    memcpy(ctx.data, data, len);
+    ctx.len = len;
+    ctx.attemptsRemaining = ESPNOW_MAX_RETRIES;
+    ctx.nextRetryTime = millis() + ESPNOW_RETRY_BASE_DELAY_MS;
+    ctx.active = true;
+
+    _retryQueue.push_back(ctx);
+    Serial.println(" Message added to retry queue");
+}
+
+// ============================================================================
+// BEACON & POWER SAVE (HUB-SIDE)
+// ============================================================================
+
+uint8_t HubRole::assignSlot(const uint8_t* mac) {
+    PeerStatus& peer = _peers[macToKey(mac)];
+    if (peer.slot != 0) {
+        return peer.slot;
+    }
+    memcpy(peer.mac, mac, 6);
+
+    // Lowest free slot keeps the beacon bitmap dense
+    bool used[BEACON_SLOT_COUNT] = {false};
+    for (const auto& pair : _peers) {
+        used[pair.second.slot] = true;
+    }
+    for (uint8_t slot = 1; slot < BEACON_SLOT_COUNT; slot++) {
+        if (!used[slot]) {
+            peer.slot = slot;
+            return slot;
+        }
+    }
+
+    Serial.println("[WARN]  No free beacon slot");
+    return 0;
+}
+
+void HubRole::setPeerPowerSave(const uint8_t* mac, bool powerSave) {
+    auto it = _peers.find(macToKey(mac));
+    if (it == _peers.end()) return;
+
+    it->second.powerSave = powerSave;
+
+    // Just announced, so it is listening right now
+    it->second.awakeUntil = millis() + ESPNOW_PS_AWAKE_WINDOW_MS;
+    if (!powerSave) {
+        releaseHeldFrames(mac);
+    }
+}
+
+bool HubRole::sendBeacon(uint32_t epoch, uint16_t configGeneration, uint16_t hubSession, uint16_t intervalMs) {
+    if (!_initialized) return false;
+
+    expireHeldFrames();
+
+    BeaconIdentMessage frame = {};
+    BeaconMessage& beacon = frame.beacon;
+    beacon.header.type = MessageType::BEACON;
+    beacon.header.tankId = 0;
+    beacon.header.nodeType = NodeType::HUB;
+    beacon.header.timestamp = millis();
+    beacon.header.sequenceNum = _beaconSequence++;
+    beacon.epoch = epoch;
+    beacon.intervalMs = intervalMs;
+    beacon.hubSession = hubSession;
+    beacon.configGeneration = configGeneration;
+    beacon.channel = _channel;
+
+    for (const HeldFrame& held : _heldFrames) {
+        auto it = _peers.find(macToKey(held.destMac));
+        if (it != _peers.end()) {
+            beaconSetSlotPending(beacon, it->second.slot);
+        }
+    }
+
+    size_t len = sizeof(BeaconMessage);
+    if (_hasBeaconIdentity) {
+        frame.identity = _beaconIdentity;
+        len = sizeof(frame);
+    }
+
+    uint8_t broadcastMac[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    bool success = transmit(broadcastMac, (uint8_t*)&frame, len);
+    if (success) {
+        _stats.beaconsSent++;
+    }
+    return success;
+}
+
+void HubRole::setBeaconIdentity(const uint8_t* hubId, uint16_t generation) {
+    memcpy(_beaconIdentity.hubId, hubId, 6);
+    _beaconIdentity.hubGeneration = generation;
+    _hasBeaconIdentity = true;
+}
+
+void HubRole::holdFrame(const uint8_t* mac, const uint8_t* data, size_t len) {
+    if (_heldFrames.size() >= ESPNOW_PS_QUEUE_MAX) {
+        _heldFrames.erase(_heldFrames.begin());
+        _stats.framesExpired++;
+        Serial.println("[WARN]  Power-save queue full, dropped oldest frame");
+    }
+
+    HeldFrame frame;
+    memcpy(frame.destMac, mac, 6);
+    memcpy(frame.data, data, len);
+    frame.len = len;
+    frame.queuedAt = millis();
+    _heldFrames.push_back(frame);
+    _stats.framesHeld++;
+}
+
+void HubRole::releaseHeldFrames(const uint8_t* mac) {
+    auto peer = _peers.find(macToKey(mac));
+    if (peer != _peers.end()) {
+        peer->second.awakeUntil = millis() + ESPNOW_PS_AWAKE_WINDOW_MS;
+    }
+
+    for (size_t i = 0; i < _heldFrames.size();) {
+        if (memcmp(_heldFrames[i].destMac, mac, 6) == 0) {
+            transmit(_heldFrames[i].destMac, _heldFrames[i].data, _heldFrames[i].len);
+            _heldFrames.erase(_heldFrames.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+void HubRole::expireHeldFrames() {
+    uint32_t now = millis();
+
+    for (size_t i = 0; i < _heldFrames.size();) {
+        if (now - _heldFrames[i].queuedAt > ESPNOW_PS_QUEUE_TTL_MS) {
+            _heldFrames.erase(_heldFrames.begin() + i);
+            _stats.framesExpired++;
+        } else {
+            i++;
+        }
+    }
+}
+
+// ============================================================================
+// PROTOCOL NEGOTIATION (HUB-SIDE)
+// ============================================================================
+
+ProtocolInfo HubRole::negotiateProtocol(const uint8_t* mac, const ProtocolInfo& offered) {
+    ProtocolInfo agreed = {};
+    agreed.maxCommandData = MAX_COMMAND_DATA_LEN;
+
+    // Version 0: node predates negotiation, the reserved bytes were zero
+    if (offered.version != 0) {
+        ProtocolInfo own = protocolOffer();
+        agreed.version = offered.version < own.version ? offered.version : own.version;
+        agreed.features = offered.features & own.features;
+
+        if (agreed.features & PROTO_FEAT_LARGE_COMMAND) {
+            uint8_t limit = offered.maxCommandData < own.maxCommandData ? offered.maxCommandData : own.maxCommandData;
+            if (limit > MAX_COMMAND_DATA_LEN) {
+                agreed.maxCommandData = limit;
+            } else {
+                agreed.features &= ~PROTO_FEAT_LARGE_COMMAND;
+            }
+        }
+    }
+
+    auto it = _peers.find(macToKey(mac));
+    if (it != _peers.end()) {
+        if (memcmp(&it->second.protocol, &agreed, sizeof(agreed)) != 0) {
+            Serial.printf("[PROTO] %02X:%02X:%02X:%02X:%02X:%02X v%d, features 0x%02X, %d-byte commands\n",
+                          mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
+                          agreed.version, agreed.features, agreed.maxCommandData);
+        }
+        it->second.protocol = agreed;
+    }
+    return agreed;
+}
+
+bool HubRole::getPeerProtocol(const uint8_t* mac, ProtocolInfo& protocol) const {
+    auto it = _peers.find(macToKey(mac));
+    if (it == _peers.end()) return false;
+
+    protocol = it->second.protocol;
+    return true;
+}
+
+size_t HubRole::completeAck(const uint8_t* mac, AckProtocolMessage& frame) const {
+    auto it = _peers.find(macToKey(mac));
+    if (it == _peers.end() || it->second.protocol.version == 0) {
+        return sizeof(AckMessage);  // Older nodes reject longer ACKs
+    }
+
+    frame.protocol = it->second.protocol;
+    return sizeof(AckProtocolMessage);
+}
+
+// ============================================================================
+// RATE ADAPTATION (HUB-SIDE)
+// ============================================================================
+// Arduino-ESP32 2.x (IDF 4.4) has one ESP-NOW rate per interface, so the
+// interface runs at the slowest rate any tracked peer needs; peers still
+// get their own controller and move up together once all of them can.
+// IDF 5.1 added per-peer rates and is used when available.
+
+#ifdef ESP32
+static wifi_phy_rate_t phyRate(RateController::Rate rate) {
+    switch (rate) {
+        case RateController::Rate::LR_250K: return WIFI_PHY_RATE_LORA_250K;
+        case RateController::Rate::LR_500K: return WIFI_PHY_RATE_LORA_500K;
+        case RateController::Rate::B_2M:    return WIFI_PHY_RATE_2M_L;
+        case RateController::Rate::G_6M:    return WIFI_PHY_RATE_6M;
+        case RateController::Rate::G_12M:   return WIFI_PHY_RATE_12M;
+        case RateController::Rate::G_24M:   return WIFI_PHY_RATE_24M;
+        case RateController::Rate::G_54M:   return WIFI_PHY_RATE_54M;
+        default:                            return WIFI_PHY_RATE_1M_L;
+    }
+}
+#endif
+
+bool HubRole::enableRateAdaptation(bool longRange) {
+    if (!_initialized) return false;
+    if (_rateAdaptation) return true;
+
+#ifdef ESP32
+    s_txResultQueue = xQueueCreate(ESPNOW_TX_RESULT_QUEUE_SIZE, sizeof(TxResultEntry));
+    if (!s_txResultQueue) {
+        Serial.println("[ERR] Failed to create TX result queue");
+        return false;
+    }
+
+    if (longRange) {
+        uint8_t protocols = 0;
+        esp_wifi_get_protocol(WIFI_IF_STA, &protocols);
+        // 11b/g/n stay enabled, so the router connection is unaffected
+        if (esp_wifi_set_protocol(WIFI_IF_STA, protocols | WIFI_PROTOCOL_LR) == ESP_OK) {
+            _longRange = true;
+        } else {
+            Serial.println("[WARN] Long-range mode not available, using 11b/g rates only");
+        }
+    }
+
+    // Management frames only: ESP-NOW frames are vendor-specific action frames
+    wifi_promiscuous_filter_t filter = {};
+    filter.filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT;
+    esp_wifi_set_promiscuous_filter(&filter);
+    esp_wifi_set_promiscuous_rx_cb(onPromiscuousStatic);
+    if (esp_wifi_set_promiscuous(true) != ESP_OK) {
+        Serial.println("[WARN] No RSSI from peers, adapting on delivery only");
+    }
+
+    uint32_t now = millis();
+    for (auto& pair : _peers) {
+        RateController::reset(pair.second.rate, pair.second.longRange && _longRange, now);
+    }
+    _interfaceRate = RateController::Rate::B_1M;
+    _rateAdaptation = true;
+
+    Serial.printf("[OK] Rate adaptation enabled (LR %s)\n", _longRange ? "on" : "off");
+    return true;
+#else
+    (void)longRange;
+    return false;
+#endif
+}
+
+void HubRole::setPeerLongRange(const uint8_t* mac, bool longRange) {
+    auto it = _peers.find(macToKey(mac));
+    if (it == _peers.end()) return;
+
+    it->second.longRange = longRange;
+    if (_rateAdaptation &&
+        RateController::setLongRange(it->second.rate, longRange && _longRange, millis())) {
+        _stats.rateChanges++;
+        applyPeerRate(it->second);
+    }
+}
+
+bool HubRole::getPeerLink(const uint8_t* mac, PeerLinkInfo& info) const {
+    auto it = _peers.find(macToKey(mac));
+    if (it == _peers.end()) return false;
+
+    const RateController::State& rate = it->second.rate;
+    info.rateKbps = RateController::kbps(rate.rate);
+    info.longRange = RateController::isLongRange(rate.rate);
+    info.rssi = rate.rssiKnown ? (int8_t)(rate.rssi16 / 16) : 0;
+    info.deliveryPercent = (uint8_t)((rate.delivery * 100 + RateController::DELIVERY_ONE / 2) /
+                                     RateController::DELIVERY_ONE);
+    info.rateChanges = rate.changes;
+    return true;
+}
+
+void HubRole::processTxResults() {
+#ifdef ESP32
+    uint32_t now = millis();
+    TxResultEntry result;
+    while (xQueueReceive(s_txResultQueue, &result, 0) == pdTRUE) {
+        if (!result.delivered) {
+            _stats.sendsNotAcked++;
+        }
+
+        auto it = _peers.find(macToKey(result.mac));
+        if (it == _peers.end()) continue;
+
+        PeerStatus& peer = it->second;
+        if (RateController::onTxResult(peer.rate, result.delivered, now)) {
+            _stats.rateChanges++;
+            Serial.printf("[RATE] %02X:%02X:%02X:%02X:%02X:%02X -> %u kbps (delivery %u%%)\n",
+                          peer.mac[0], peer.mac[1], peer.mac[2], peer.mac[3], peer.mac[4], peer.mac[5],
+                          RateController::kbps(peer.rate.rate),
+                          (unsigned)(peer.rate.delivery * 100 / RateController::DELIVERY_ONE));
+            applyPeerRate(peer);
+        }
+    }
+#endif
+}
+
+void HubRole::updatePeerRssi(const uint8_t* mac, int8_t rssi) {
+    auto it = _peers.find(macToKey(mac));
+    if (it == _peers.end()) return;
+
+    PeerStatus& peer = it->second;
+    if (RateController::onRssi(peer.rate, rssi, millis())) {
+        _stats.rateChanges++;
+        Serial.printf("[RATE] %02X:%02X:%02X:%02X:%02X:%02X -> %u kbps (RSSI %d dBm)\n",
+                      peer.mac[0], peer.mac[1], peer.mac[2], peer.mac[3], peer.mac[4], peer.mac[5],
+                      RateController::kbps(peer.rate.rate), peer.rate.rssi16 / 16);
+        applyPeerRate(peer);
+    }
+}
+
+void HubRole::applyPeerRate(const PeerStatus& peer) {
+    if (!_rateAdaptation) return;
+
+#ifdef HUB_PER_PEER_RATE
+    esp_now_rate_config_t rateConfig = {};
+    rateConfig.phymode = RateController::isLongRange(peer.rate.rate) ? WIFI_PHY_MODE_LR :
+                         peer.rate.rate <= RateController::Rate::B_2M ? WIFI_PHY_MODE_11B : WIFI_PHY_MODE_11G;
+    rateConfig.rate = phyRate(peer.rate.rate);
+    esp_err_t result = esp_now_set_peer_rate_config(peer.mac, &rateConfig);
+    if (result != ESP_OK) {
+        Serial.printf("[ERR] Failed to set ESP-NOW rate (error %d)\n", result);
+    }
+#else
+    (void)peer;
+    applyInterfaceRate();
+#endif
+}
+
+void HubRole::applyInterfaceRate() {
+#if defined(ESP32) && !defined(HUB_PER_PEER_RATE)
+    if (!_rateAdaptation) return;
+
+    bool any = false;
+    RateController::Rate slowest = RateController::Rate::G_54M;
+    for (const auto& pair : _peers) {
+        if ((pair.second.mac[0] & 0x01) == 0 && pair.second.rate.rate <= slowest) {
+            slowest = pair.second.rate.rate;
+            any = true;
+        }
+    }
+    if (!any) {
+        slowest = RateController::Rate::B_1M;  // Broadcast only: ESP-NOW default
+    }
+    if (slowest == _interfaceRate) return;
+
+    esp_err_t result = esp_wifi_config_espnow_rate(WIFI_IF_STA, phyRate(slowest));
+    if (result == ESP_OK) {
+        _interfaceRate = slowest;
+    } else {
+        Serial.printf("[ERR] Failed to set ESP-NOW rate (error %d)\n", result);
+    }
+#endif
+}
+
+// ============================================================================
+// PEER STATUS (HUB-SIDE)
+// ============================================================================
+
+void HubRole::setPeerOnline(const uint8_t* mac, bool online) {
+    uint64_t key = macToKey(mac);
+    auto it = _peers.find(key);
+
+    if (it != _peers.end()) {
+        bool wasOnline = it->second.online;
+        it->second.online = online;
+
+        if (online && !wasOnline) {
+            Serial.printf("[OK] Peer %02X:%02X:... is now ONLINE\n", mac[0], mac[1]);
+        } else if (!online && wasOnline) {
+            Serial.printf("[WARN]  Peer %02X:%02X:... is now OFFLINE\n", mac[0], mac[1]);
+        }
+    }
+}
+
+bool HubRole::isPeerOnline(const uint8_t* mac) const {
+    uint64_t key = macToKey(mac);
+    auto it = _peers.find(key);
+
+    return (it != _peers.end()) && it->second.online;
+}
+
+void HubRole::updatePeerHeartbeat(const uint8_t* mac) {
+    uint64_t key = macToKey(mac);
+    auto it = _peers.find(key);
+
+    if (it != _peers.end()) {
+        it->second.lastHeartbeat = millis();
+
+        // Mark online if was offline
+        if (!it->second.online) {
+            setPeerOnline(mac, true);
+        }
+    }
+}
+
+int HubRole::checkPeerTimeouts(uint32_t timeoutMs) {
+    int offlineCount = 0;
+    uint32_t now = millis();
+
+    for (auto& pair : _peers) {
+        PeerStatus& peer = pair.second;
+
+        if (peer.online && (now - peer.lastHeartbeat > timeoutMs)) {
+            setPeerOnline(peer.mac, false);
+            offlineCount++;
+        }
+    }
+
+    return offlineCount;
+}
+
+bool HubRole::isDuplicate(const uint8_t* mac, uint8_t sequenceNum) {
+    uint64_t key = macToKey(mac);
+    auto it = _peers.find(key);
+
+    if (it == _peers.end()) {
+        return false;  // Unknown peer, not a duplicate
+    }
+
+    PeerStatus& peer = it->second;
+
+    // Check if this is the same sequence as last received
+    bool isDup = (sequenceNum == peer.lastSeqReceived && sequenceNum != 0);
+
+    // Update last received sequence
+    peer.lastSeqReceived = sequenceNum;
+
+    return isDup;
+}
+
+// ============================================================================
+// DIAGNOSTICS
+// ============================================================================
+
+void HubRole::printStatistics() const {
+    printCounters();
+
+    Serial.println("-----------------------------------------");
+    Serial.printf(" Tracked Peers:        %d\n", _peers.size());
+
+    int onlineCount = 0;
+    for (const auto& pair : _peers) {
+        if (pair.second.online) onlineCount++;
+    }
+    Serial.printf("   - Online:             %d\n", onlineCount);
+    Serial.printf("   - Offline:            %d\n", _peers.size() - onlineCount);
+    Serial.printf(" Beacons Sent:         %u\n", _stats.beaconsSent);
+    Serial.printf(" Frames Held/Expired:  %u / %u (%u queued)\n",
+                  _stats.framesHeld, _stats.framesExpired, (unsigned)_heldFrames.size());
+    Serial.printf(" Sends Not ACKed:      %u\n", _stats.sendsNotAcked);
+
+    if (_rateAdaptation) {
+        Serial.printf(" Rate Changes:         %u\n", _stats.rateChanges);
+        for (const auto& pair : _peers) {
+            const PeerStatus& peer = pair.second;
+            if (peer.mac[0] & 0x01) continue;
+            Serial.printf("   - %02X:%02X:%02X:%02X:%02X:%02X  %5u kbps  RSSI %4d  delivery %3u%%\n",
+                          peer.mac[0], peer.mac[1], peer.mac[2], peer.mac[3], peer.mac[4], peer.mac[5],
+                          RateController::kbps(peer.rate.rate),
+                          peer.rate.rssiKnown ? peer.rate.rssi16 / 16 : 0,
+                          (unsigned)(peer.rate.delivery * 100 / RateController::DELIVERY_ONE));
+        }
+    }
+
+    Serial.println("-----------------------------------------");
+}
+
+#endif // HUB_BUILD
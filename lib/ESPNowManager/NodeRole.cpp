@@ -0,0 +1,123 @@
+#include "ESPNowRoles.h"
+
+#ifndef HUB_BUILD  // Only the role this build uses is compiled
+
+// ============================================================================
+// NODE ROLE
+// ============================================================================
+
+NodeRole::NodeRole() {
+    memset(&_reassembly, 0, sizeof(_reassembly));
+}
+
+void NodeRole::pollRole() {
+    // Check reassembly timeout
+    if (_reassembly.active && (millis() - _reassembly.startTime > ESPNOW_REASSEMBLY_TIMEOUT_MS)) {
+        Serial.println("  Reassembly timeout");
+        _stats.reassemblyTimeouts++;
+        resetReassembly();
+    }
+}
+
+void NodeRole::handleCommand(const uint8_t* mac, const CommandMessage& cmd, const uint8_t* payload) {
+    _stats.fragmentsReceived++;
+
+    // Check if this is a fragmented message
+    if (cmd.commandSeqID == 0 && cmd.finalCommand) {
+        // Single-frame command - process immediately
+        if (_commandCallback) {
+            _currentCommandId = cmd.commandId;
+            _commandCallback(mac, payload, cmd.commandLen);
+        }
+        return;
+    }
+
+    // Multi-frame command - reassemble
+
+    // Check timeout on active reassembly
+    if (_reassembly.active && (millis() - _reassembly.startTime > ESPNOW_REASSEMBLY_TIMEOUT_MS)) {
+        Serial.println("  Reassembly timeout, dropping partial message");
+        _stats.reassemblyTimeouts++;
+        resetReassembly();
+    }
+
+    // Start new reassembly
+    if (!_reassembly.active) {
+        if (cmd.commandSeqID != 0) {
+            Serial.println("[WARN]  Fragment doesn't start at 0, ignoring");
+            return;
+        }
+
+        Serial.printf(" Starting reassembly for command %d\n", cmd.commandId);
+        _reassembly.active = true;
+        _reassembly.commandId = cmd.commandId;
+        _reassembly.expectedSeqID = 0;
+        _reassembly.startTime = millis();
+        _reassembly.offset = 0;
+        memcpy(_reassembly.senderMac, mac, 6);
+    }
+
+    // Validate sequence
+    if (cmd.commandId != _reassembly.commandId) {
+        Serial.println("[WARN]  Command ID mismatch, dropping reassembly");
+        resetReassembly();
+        return;
+    }
+
+    if (cmd.commandSeqID != _reassembly.expectedSeqID) {
+        Serial.printf("[WARN]  Sequence mismatch: expected %d, got %d\n",
+                     _reassembly.expectedSeqID, cmd.commandSeqID);
+        resetReassembly();
+        return;
+    }
+
+    // Append fragment
+    if (_reassembly.offset + cmd.commandLen > ESPNOW_MAX_MESSAGE_SIZE) {
+        Serial.println("[ERR] Reassembly buffer overflow");
+        resetReassembly();
+        return;
+    }
+
+    memcpy(_reassembly.buffer + _reassembly.offset, payload, cmd.commandLen);
+    _reassembly.offset += cmd.commandLen;
+    _reassembly.expectedSeqID++;
+
+    Serial.printf("   Fragment %d appended (%d bytes total)\n",
+                 cmd.commandSeqID, _reassembly.offset);
+
+    // Check if complete
+    if (cmd.finalCommand) {
+        Serial.printf("[OK] Reassembly complete: %d bytes\n", _reassembly.offset);
+
+        if (_commandCallback) {
+            _currentCommandId = _reassembly.commandId;
+            _commandCallback(_reassembly.senderMac, _reassembly.buffer, _reassembly.offset);
+        }
+
+        resetReassembly();
+    }
+}
+
+void NodeRole::resetReassembly() {
+    memset(&_reassembly, 0, sizeof(_reassembly));
+}
+
+// ============================================================================
+// REPEATER ROLE
+// ============================================================================
+
+void RepeaterRole::handleCommand(const uint8_t* mac, const CommandMessage& cmd, const uint8_t* payload) {
+    _stats.fragmentsReceived++;
+
+    if (cmd.commandSeqID != 0 || !cmd.finalCommand) {
+        Serial.println("[WARN]  Fragmented command dropped (repeater does not reassemble)");
+        return;
+    }
+
+    if (_commandCallback) {
+        _currentCommandId = cmd.commandId;
+        _commandCallback(mac, payload, cmd.commandLen);
+    }
+}
+
+#endif // !HUB_BUILD
@@ -0,0 +1,229 @@
+#ifndef ESPNOW_RATE_CONTROLLER_H
+#define ESPNOW_RATE_CONTROLLER_H
+
+#include <stdint.h>
+
+/**
+ * @brief Per-peer ESP-NOW PHY rate selection
+ *
+ * Pure decision logic: no radio, no clock of its own, so it can be driven
+ * from a simulation on the host. ESPNowManager keeps one State per peer,
+ * feeds it the delivery result of every unicast send (MAC-layer ACK from
+ * the send callback) and the RSSI of every frame received from the peer,
+ * and applies the rate whenever a call returns true.
+ *
+ * Rates form a ladder, most robust first. A peer starts at 1 Mbps (the
+ * ESP-NOW default) and
+ *  - steps down when delivery falls below STEP_DOWN_DELIVERY, after
+ *    FAIL_STREAK failures in a row, or when RSSI drops HYSTERESIS_DB below
+ *    what its current rate needs;
+ *  - steps up one rung when delivery has stayed above STEP_UP_DELIVERY
+ *    for DWELL_MS and (if RSSI is known) the next rate's minimum is met.
+ * A rate that failed shortly after a step up is not tried again for a
+ * backoff period that doubles on each such failure, so a marginal link
+ * does not oscillate. The long-range rungs are used only for peers that
+ * announced NODE_CAP_LONG_RANGE and only when the hub enabled LR.
+ */
+class RateController {
+public:
+    enum class Rate : uint8_t {
+        LR_250K = 0,
+        LR_500K,
+        B_1M,               // ESP-NOW default
+        B_2M,
+        G_6M,
+        G_12M,
+        G_24M,
+        G_54M,
+        COUNT
+    };
+
+    static constexpr uint16_t DELIVERY_ONE = 1024;          // EWMA scale (100 %)
+    static constexpr uint16_t STEP_UP_DELIVERY = 973;       // 95 %
+    static constexpr uint16_t STEP_DOWN_DELIVERY = 717;     // 70 %
+    static constexpr uint8_t MIN_SAMPLES = 10;              // Sends at a rate before delivery is judged
+    static constexpr uint8_t FAIL_STREAK = 4;               // Consecutive failures step down at once
+    static constexpr uint32_t DWELL_MS = 10000;             // Time at a rate before stepping up
+    static constexpr uint32_t PROBE_MS = 30000;             // Failure within this after a step up backs off
+    static constexpr uint32_t BACKOFF_MS = 30000;           // First step-up block
+    static constexpr uint32_t MAX_BACKOFF_MS = 480000;
+    static constexpr int8_t HYSTERESIS_DB = 6;
+    static constexpr uint32_t RSSI_STALE_MS = 120000;       // Ignore RSSI older than this
+
+    struct State {
+        Rate rate;
+        bool longRange;             // Peer can receive LR frames
+        uint16_t delivery;          // EWMA of delivered sends, DELIVERY_ONE = all
+        int16_t rssi16;             // EWMA RSSI in 1/16 dBm
+        bool rssiKnown;
+        uint32_t rssiMs;            // Last RSSI sample
+        uint16_t samples;           // Sends since the last change
+        uint8_t failStreak;
+        uint32_t changedMs;
+        bool steppedUp;             // Last change was a step up
+        Rate blockedRate;           // Not stepped up to before blockedUntil
+        uint32_t blockedUntil;
+        uint32_t backoffMs;
+        uint16_t changes;           // Rate changes since reset()
+    };
+
+    /**
+     * @brief Start a peer at 1 Mbps with no history
+     */
+    static void reset(State& state, bool longRange, uint32_t now) {
+        state.rate = Rate::B_1M;
+        state.longRange = longRange;
+        state.rssi16 = 0;
+        state.rssiKnown = false;
+        state.rssiMs = 0;
+        state.blockedRate = Rate::COUNT;
+        state.blockedUntil = 0;
+        state.backoffMs = BACKOFF_MS;
+        state.changes = 0;
+        _enter(state, Rate::B_1M, false, now);
+    }
+
+    /**
+     * @brief Peer capability changed (ANNOUNCE)
+     * @return true if the rate changed (peer left LR)
+     */
+    static bool setLongRange(State& state, bool longRange, uint32_t now) {
+        state.longRange = longRange;
+        if (!longRange && state.rate < Rate::B_1M) {
+            _change(state, Rate::B_1M, now);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Frame received from the peer
+     * @return true if the rate changed
+     */
+    static bool onRssi(State& state, int8_t rssi, uint32_t now) {
+        if (!state.rssiKnown || now - state.rssiMs >= RSSI_STALE_MS) {
+            state.rssi16 = rssi * 16;
+            state.rssiKnown = true;
+        } else {
+            state.rssi16 += (rssi * 16 - state.rssi16) / 4;
+        }
+        state.rssiMs = now;
+
+        Rate floor = _lowest(state);
+        if (state.rate > floor && rssiBelow(state, minRssi(state.rate) - HYSTERESIS_DB, now)) {
+            _change(state, _prev(state.rate), now);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Result of one unicast send to the peer
+     * @return true if the rate changed
+     */
+    static bool onTxResult(State& state, bool delivered, uint32_t now) {
+        state.delivery = (uint16_t)(state.delivery +
+            ((delivered ? (int32_t)DELIVERY_ONE : 0) - (int32_t)state.delivery) / 8);
+        if (state.samples < 0xFFFF) {
+            state.samples++;
+        }
+        state.failStreak = delivered ? 0 : (uint8_t)(state.failStreak < 0xFF ? state.failStreak + 1 : 0xFF);
+
+        bool failing = state.failStreak >= FAIL_STREAK ||
+                       (state.samples >= MIN_SAMPLES && state.delivery < STEP_DOWN_DELIVERY);
+        if (failing) {
+            if (state.rate <= _lowest(state)) {
+                return false;   // Nothing more robust left
+            }
+            if (state.steppedUp && now - state.changedMs < PROBE_MS) {
+                // The step up did not hold: keep away from this rate for a while
+                state.blockedRate = state.rate;
+                state.blockedUntil = now + state.backoffMs;
+                state.backoffMs = state.backoffMs >= MAX_BACKOFF_MS / 2 ? MAX_BACKOFF_MS : state.backoffMs * 2;
+            }
+            _change(state, _prev(state.rate), now);
+            return true;
+        }
+
+        if (state.steppedUp && now - state.changedMs >= PROBE_MS) {
+            state.backoffMs = BACKOFF_MS;   // The last step up held
+        }
+
+        if (state.rate < _highest() && state.samples >= MIN_SAMPLES &&
+            state.delivery >= STEP_UP_DELIVERY && now - state.changedMs >= DWELL_MS) {
+            Rate next = _next(state.rate);
+            if (next == state.blockedRate && (int32_t)(now - state.blockedUntil) < 0) {
+                return false;
+            }
+            if (state.rssiKnown && now - state.rssiMs < RSSI_STALE_MS &&
+                state.rssi16 < minRssi(next) * 16) {
+                return false;   // Delivery is fine but the signal would not carry the next rate
+            }
+            _change(state, next, now);
+            state.steppedUp = true;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Weakest RSSI (dBm) at which a rate is stepped up to
+     */
+    static int8_t minRssi(Rate rate) {
+        switch (rate) {
+            case Rate::LR_500K: return -96;
+            case Rate::B_1M:    return -92;
+            case Rate::B_2M:    return -84;
+            case Rate::G_6M:    return -80;
+            case Rate::G_12M:   return -76;
+            case Rate::G_24M:   return -70;
+            case Rate::G_54M:   return -62;
+            default:            return -128;
+        }
+    }
+
+    static bool rssiBelow(const State& state, int threshold, uint32_t now) {
+        return state.rssiKnown && now - state.rssiMs < RSSI_STALE_MS && state.rssi16 < threshold * 16;
+    }
+
+    static bool isLongRange(Rate rate) { return rate < Rate::B_1M; }
+
+    /**
+     * @brief Rate in kbit/s (for logs and JSON)
+     */
+    static uint16_t kbps(Rate rate) {
+        switch (rate) {
+            case Rate::LR_250K: return 250;
+            case Rate::LR_500K: return 500;
+            case Rate::B_1M:    return 1000;
+            case Rate::B_2M:    return 2000;
+            case Rate::G_6M:    return 6000;
+            case Rate::G_12M:   return 12000;
+            case Rate::G_24M:   return 24000;
+            case Rate::G_54M:   return 54000;
+            default:            return 0;
+        }
+    }
+
+private:
+    static Rate _lowest(const State& state) { return state.longRange ? Rate::LR_250K : Rate::B_1M; }
+    static Rate _highest() { return Rate::G_54M; }
+    static Rate _next(Rate rate) { return (Rate)((uint8_t)rate + 1); }
+    static Rate _prev(Rate rate) { return (Rate)((uint8_t)rate - 1); }
+
+    static void _change(State& state, Rate rate, uint32_t now) {
+        _enter(state, rate, false, now);
+        state.changes++;
+    }
+
+    static void _enter(State& state, Rate rate, bool steppedUp, uint32_t now) {
+        state.rate = rate;
+        state.delivery = DELIVERY_ONE;
+        state.samples = 0;
+        state.failStreak = 0;
+        state.changedMs = now;
+        state.steppedUp = steppedUp;
+    }
+};
+
+#endif // ESPNOW_RATE_CONTROLLER_H
@@ -11,6 +11,158 @@
 // - updateHardware()
 // ============================================================================
 
+// ============================================================================
+// Receive Ring and Command Timing
+// ============================================================================
+// The ESP-NOW receive callback runs in the WiFi task. It only copies the
+// frame into this single-producer/single-consumer ring; parsing, logging,
+// handleCommand() and esp_now_send() all happen later in nodeLoop().
+// ============================================================================
+
+struct RxFrame {
+    uint8_t mac[6];
+    uint8_t len;
+    uint32_t rxMicros;              // micros() in the receive callback
+    uint8_t data[RX_FRAME_MAX];
+};
+
+static RxFrame rxRing[RX_RING_SLOTS];
+static volatile uint8_t rxHead = 0;     // Written only by the callback
+static volatile uint8_t rxTail = 0;     // Written only by nodeLoop()
+static volatile uint8_t rxDropped = 0;  // Ring-full drops since last heartbeat
+
+// Command timing since the last heartbeat
+static uint16_t cmdCount = 0;
+static uint32_t cmdHandlerTotalUs = 0;
+static uint32_t cmdHandlerMaxUs = 0;
+static uint32_t cmdLatencyTotalUs = 0;
+static uint32_t cmdLatencyMaxUs = 0;
+
+// ============================================================================
+// Beacon State and Radio Duty Cycle
+// ============================================================================
+
+static uint8_t nodeSlot = 0;                // From ACK assignedNodeId
+static bool beaconSeen = false;             // Beacon since the last ACK
+static uint32_t lastBeaconMs = 0;
+static uint16_t beaconIntervalMs = 0;
+static uint16_t hubSession = 0;
+static uint16_t hubConfigGeneration = 0;
+static uint32_t beaconEpoch = 0;            // Epoch carried by the last beacon
+static uint8_t hubId[6] = {0};              // Logical hub identity (BeaconIdentity)
+static uint16_t hubGeneration = 0;          // 0 = hub sent no identity yet
+static uint32_t radioHoldUntil = 0;         // Radio stays on until this millis()
+static bool radioAsleep = false;
+
+static void radioWake() {
+    if (!radioAsleep) return;
+    #ifdef ESP8266
+        WiFi.forceSleepWake();
+        delay(1);
+        wifi_set_channel(ESPNOW_CHANNEL);
+    #else
+        esp_wifi_start();
+        esp_wifi_set_channel(ESPNOW_CHANNEL, WIFI_SECOND_CHAN_NONE);
+    #endif
+    radioAsleep = false;
+}
+
+#ifdef NODE_POWER_SAVE
+static void radioSleep() {
+    if (radioAsleep) return;
+    #ifdef ESP8266
+        WiFi.forceSleepBegin();
+    #else
+        esp_wifi_stop();
+    #endif
+    radioAsleep = true;
+}
+#endif
+
+// Sends awaiting onDataSent(), and consecutive failed unicast sends
+static volatile uint8_t txPending = 0;
+static volatile uint8_t txFailures = 0;
+static uint32_t lastTxMs = 0;
+
+// Keep the radio on for replies to a frame we are about to send
+static void holdRadio() {
+    radioWake();
+    lastTxMs = millis();
+    radioHoldUntil = lastTxMs + PS_AWAKE_HOLD_MS;
+    txPending++;
+}
+
+uint32_t getHubEpoch() {
+    if (!beaconSeen || beaconEpoch == 0) return 0;
+    return beaconEpoch + (millis() - lastBeaconMs) / 1000;
+}
+
+uint16_t getHubConfigGeneration() {
+    return hubConfigGeneration;
+}
+
+static uint16_t saturate16(uint32_t value) {
+    return value > 0xFFFF ? 0xFFFF : (uint16_t)value;
+}
+
+#ifdef NODE_DEEP_SLEEP
+// ============================================================================
+// Deep Sleep State (RTC Memory)
+// ============================================================================
+// Everything needed to talk to the hub again without an ANNOUNCE/ACK round
+// trip. Written just before deep sleep, validated by magic + CRC on wake, so
+// a power-on (garbage RTC memory) falls back to normal discovery.
+// ============================================================================
+
+struct NodeRtcState {
+    uint32_t magic;
+    uint32_t epoch;                 // Hub epoch at the expected wake time
+    uint32_t wakeCount;
+    uint32_t lastAwakeMs;           // Previous wake, including boot
+    uint32_t lastSleepMs;
+    uint16_t hubSession;
+    uint16_t configGeneration;
+    uint16_t beaconIntervalMs;
+    uint8_t hubMac[6];
+    uint8_t channel;
+    uint8_t slot;
+    uint8_t sequence;
+    uint8_t txFailures;
+    uint8_t hubId[6];
+    uint16_t hubGeneration;
+    uint8_t userData[RTC_USER_DATA_LEN];
+    uint32_t crc;                   // CRC-32 of every byte before this field
+};
+
+static_assert(sizeof(NodeRtcState) % 4 == 0, "RTC user memory is written in 4-byte blocks");
+
+const uint32_t RTC_STATE_MAGIC = 0x4E525443;   // "NRTC"
+
+#ifdef ESP8266
+static NodeRtcState rtcState;
+#else
+RTC_DATA_ATTR static NodeRtcState rtcState;
+#endif
+
+static bool beaconCheckDue = false;         // This wake must hear a beacon
+static bool beaconThisWake = false;
+
+static uint32_t crc32(const uint8_t* data, size_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t rtcStateCrc() {
+    return crc32((const uint8_t*)&rtcState, offsetof(NodeRtcState, crc));
+}
+#endif
+
 // ============================================================================
 // ESP-NOW Communication Functions
 // ============================================================================
@@ -22,12 +174,24 @@ void sendAnnounce() {
     msg.header.nodeType = NODE_TYPE;
     msg.header.timestamp = millis();
     msg.header.sequenceNum = messageSequence++;
-    strncpy(msg.nodeName, NODE_NAME, MAX_NODE_NAME_LEN);
     msg.firmwareVersion = FIRMWARE_VERSION;
-    msg.capabilities = 0;
+    #ifdef NODE_POWER_SAVE
+        msg.capabilities = NODE_CAP_POWER_SAVE;
+    #else
+        msg.capabilities = 0;
+    #endif
+    #ifdef ESP32
+        msg.capabilities |= NODE_CAP_LONG_RANGE;    // LR enabled in setupESPNow()
+    #endif
+    
+    // Single-frame commands only: handlers read the CommandMessage in place
+    msg.protocol.version = PROTOCOL_VERSION;
+    msg.protocol.features = 0;
+    msg.protocol.maxCommandData = MAX_COMMAND_DATA_LEN;
     
     uint8_t broadcastAddress[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
     
+    holdRadio();
     #ifdef ESP8266
         esp_now_send(broadcastAddress, (uint8_t*)&msg, sizeof(msg));
     #else
@@ -40,15 +204,33 @@ void sendAnnounce() {
 void sendHeartbeat() {
     if (!hubDiscovered) return;
     
-    HeartbeatMessage msg = {};
-    msg.header.type = MessageType::HEARTBEAT;
-    msg.header.tankId = NODE_TANK_ID;
-    msg.header.nodeType = NODE_TYPE;
-    msg.header.timestamp = millis();
-    msg.header.sequenceNum = messageSequence++;
-    msg.health = 100;
-    msg.uptimeMinutes = millis() / 60000;
+    HeartbeatDiagMessage msg = {};
+    msg.heartbeat.header.type = MessageType::HEARTBEAT;
+    msg.heartbeat.header.tankId = NODE_TANK_ID;
+    msg.heartbeat.header.nodeType = NODE_TYPE;
+    msg.heartbeat.header.timestamp = millis();
+    msg.heartbeat.header.sequenceNum = messageSequence++;
+    msg.heartbeat.health = 100;
+    msg.heartbeat.uptimeMinutes = millis() / 60000;
+    
+    // Report and reset command timing for this interval
+    msg.diagnostics.commandsHandled = cmdCount;
+    if (cmdCount > 0) {
+        msg.diagnostics.handlerAvgUs = saturate16(cmdHandlerTotalUs / cmdCount);
+        msg.diagnostics.latencyAvgUs = saturate16(cmdLatencyTotalUs / cmdCount);
+    }
+    msg.diagnostics.handlerMaxUs = saturate16(cmdHandlerMaxUs);
+    msg.diagnostics.latencyMaxUs = saturate16(cmdLatencyMaxUs);
+    msg.diagnostics.rxDropped = rxDropped;
     
+    cmdCount = 0;
+    cmdHandlerTotalUs = 0;
+    cmdHandlerMaxUs = 0;
+    cmdLatencyTotalUs = 0;
+    cmdLatencyMaxUs = 0;
+    rxDropped = 0;  // Advisory: a drop racing this reset may go uncounted
+    
+    holdRadio();
     #ifdef ESP8266
         esp_now_send(hubMacAddress, (uint8_t*)&msg, sizeof(msg));
     #else
@@ -73,14 +255,17 @@ void sendStatus(uint8_t commandId, uint8_t statusCode, const uint8_t* data, size
     
     // Copy status data (up to 32 bytes)
     if (data != nullptr && dataLen > 0) {
-        size_t copyLen = (dataLen > 32) ? 32 : dataLen;
+        size_t copyLen = (dataLen > MAX_STATUS_DATA_LEN) ? MAX_STATUS_DATA_LEN : dataLen;
         memcpy(msg.statusData, data, copyLen);
+        msg.statusLen = copyLen;
     }
     
+    // Only the used part of statusData goes on air
+    holdRadio();
     #ifdef ESP8266
-        esp_now_send(hubMacAddress, (uint8_t*)&msg, sizeof(msg));
+        esp_now_send(hubMacAddress, (uint8_t*)&msg, statusFrameSize(msg));
     #else
-        esp_now_send(hubMacAddress, (uint8_t*)&msg, sizeof(msg));
+        esp_now_send(hubMacAddress, (uint8_t*)&msg, statusFrameSize(msg));
     #endif
     
     Serial.printf("[TX] STATUS sent (cmdId=%d, status=%d)\n", commandId, statusCode);
@@ -95,18 +280,80 @@ void onDataReceived(uint8_t* mac, uint8_t* data, uint8_t len) {
 #else
 void onDataReceived(const uint8_t* mac, const uint8_t* data, int len) {
 #endif
-    if (len < sizeof(MessageHeader)) {
-        Serial.println("ERROR: Received message too small");
+    // WiFi task context: copy and return - no Serial, no esp_now_send()
+    uint32_t rxMicros = micros();
+    
+    if (len < (int)sizeof(MessageHeader) || len > RX_FRAME_MAX) {
+        return;  // Malformed; not worth a ring slot
+    }
+    
+    uint8_t head = rxHead;
+    uint8_t next = (head + 1) & (RX_RING_SLOTS - 1);
+    if (next == rxTail) {
+        if (rxDropped < 255) {
+            rxDropped++;
+        }
         return;
     }
+    
+    RxFrame& frame = rxRing[head];
+    memcpy(frame.mac, mac, 6);
+    frame.len = (uint8_t)len;
+    frame.rxMicros = rxMicros;
+    memcpy(frame.data, data, len);
+    
+    __sync_synchronize();  // Publish the slot before the index
+    rxHead = next;
+}
+
+// A standby hub that took over beacons our hub identity from its own MAC at
+// a higher generation. Move to it; its new session makes us re-announce.
+static bool followFailoverHub(const uint8_t* mac, const uint8_t* data, uint8_t len) {
+    if (hubGeneration == 0 || len < sizeof(BeaconIdentMessage)) {
+        return false;
+    }
+    BeaconIdentMessage msg;
+    memcpy(&msg, data, sizeof(msg));
+    if (memcmp(msg.identity.hubId, hubId, 6) != 0 ||
+        (int16_t)(msg.identity.hubGeneration - hubGeneration) <= 0) {
+        return false;  // Another installation, or a stale hub
+    }
+    
+    #ifdef ESP8266
+        esp_now_del_peer(hubMacAddress);
+        memcpy(hubMacAddress, mac, 6);
+        esp_now_add_peer(hubMacAddress, ESP_NOW_ROLE_COMBO, ESPNOW_CHANNEL, NULL, 0);
+    #else
+        esp_now_del_peer(hubMacAddress);
+        memcpy(hubMacAddress, mac, 6);
+        esp_now_peer_info_t peerInfo = {};
+        memcpy(peerInfo.peer_addr, hubMacAddress, 6);
+        peerInfo.channel = ESPNOW_CHANNEL;
+        peerInfo.encrypt = false;
+        esp_now_add_peer(&peerInfo);
+    #endif
+    
+    Serial.printf("[WARN] Hub failover: generation %u -> %u, following %02X:%02X:%02X:%02X:%02X:%02X\n",
+                  hubGeneration, msg.identity.hubGeneration,
+                  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    hubGeneration = msg.identity.hubGeneration;
+    return true;
+}
 
-    MessageHeader* header = (MessageHeader*)data;
+// Handle one received frame (main loop context)
+static void processFrame(const RxFrame& frame) {
+    const uint8_t* mac = frame.mac;
+    const uint8_t* data = frame.data;
+    uint8_t len = frame.len;
+    
+    const MessageHeader* header = (const MessageHeader*)data;
     
     Serial.printf("RX from %02X:%02X:%02X:%02X:%02X:%02X - Type: %d\n",
                   mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
                   (int)header->type);
 
-    if (hubDiscovered && memcmp(mac, hubMacAddress, 6) != 0) {
+    if (hubDiscovered && memcmp(mac, hubMacAddress, 6) != 0 &&
+        !(header->type == MessageType::BEACON && followFailoverHub(mac, data, len))) {
         Serial.println("  Ignoring message from unknown sender");
         return;
     }
@@ -115,14 +362,21 @@ void onDataReceived(const uint8_t* mac, const uint8_t* data, int len) {
 
     switch (header->type) {
         case MessageType::ACK: {
-            if (len != sizeof(AckMessage)) {
+            // Hubs that negotiated our protocol append the agreed ProtocolInfo
+            if (len != sizeof(AckMessage) && len < (int)sizeof(AckProtocolMessage)) {
                 Serial.println("ERROR: Invalid ACK message size");
                 return;
             }
-            AckMessage* msg = (AckMessage*)data;
+            const AckMessage* msg = (const AckMessage*)data;
+            if (len >= (int)sizeof(AckProtocolMessage)) {
+                const ProtocolInfo& agreed = ((const AckProtocolMessage*)data)->protocol;
+                Serial.printf("[OK] Hub protocol v%d (features 0x%02X)\n", agreed.version, agreed.features);
+            }
             
             if (msg->accepted && currentState == NodeState::WAITING_FOR_ACK) {
                 Serial.printf("[OK] ACK received - Assigned Node ID: %d\n", msg->assignedNodeId);
+                nodeSlot = msg->assignedNodeId;
+                beaconSeen = false;
                 
                 if (!hubDiscovered) {
                     memcpy(hubMacAddress, mac, 6);
@@ -147,7 +401,7 @@ void onDataReceived(const uint8_t* mac, const uint8_t* data, int len) {
         }
         
         case MessageType::COMMAND: {
-            if (len != sizeof(CommandMessage)) {
+            if (!isValidCommandFrame(data, len)) {
                 Serial.println("ERROR: Invalid COMMAND message size");
                 return;
             }
@@ -157,24 +411,117 @@ void onDataReceived(const uint8_t* mac, const uint8_t* data, int len) {
                 return;
             }
             
-            CommandMessage* msg = (CommandMessage*)data;
+            // Zero the unsent tail so handlers never see stale bytes
+            CommandMessage command = {};
+            memcpy(&command, data, len);
+            const CommandMessage* msg = &command;
             Serial.printf("  Command ID: %d, SeqID: %d, Final: %s\n",
                          msg->commandId, msg->commandSeqID, 
                          msg->finalCommand ? "YES" : "NO");
             
+            uint32_t startUs = micros();
+            uint32_t latencyUs = startUs - frame.rxMicros;
+            
             handleCommand(msg);  // Call node-specific implementation
             
+            uint32_t handlerUs = micros() - startUs;
+            cmdCount++;
+            cmdHandlerTotalUs += handlerUs;
+            cmdLatencyTotalUs += latencyUs;
+            if (handlerUs > cmdHandlerMaxUs) cmdHandlerMaxUs = handlerUs;
+            if (latencyUs > cmdLatencyMaxUs) cmdLatencyMaxUs = latencyUs;
+            Serial.printf("  Handled in %lu us (RX latency %lu us)\n",
+                         (unsigned long)handlerUs, (unsigned long)latencyUs);
+            
             // Send acknowledgment STATUS message
             uint8_t ackData[1] = {1};  // Simple ACK
             sendStatus(msg->commandId, 0, ackData, 1);  // statusCode 0 = success
             break;
         }
         
+        case MessageType::CONFIG: {
+            if (len < sizeof(MessageHeader) || !hubDiscovered) {
+                return;
+            }
+            // Tank and role are fixed in firmware; confirm so the hub commits.
+            // Idempotent: a retried CONFIG is confirmed again.
+            char name[MAX_NODE_NAME_LEN] = {};
+            if (len >= sizeof(ConfigMessage)) {
+                memcpy(name, ((const ConfigMessage*)data)->deviceName, MAX_NODE_NAME_LEN - 1);
+            }
+            Serial.printf("  CONFIG: name '%s', tank %d\n", name, header->tankId);
+            if (header->sequenceNum != 0) {
+                sendStatus(header->sequenceNum, STATUS_CONFIG_APPLIED, nullptr, 0);
+            }
+            break;
+        }
+        
+        case MessageType::UNMAP: {
+            if (!hubDiscovered) {
+                return;
+            }
+            // Confirm first, then rejoin as an unmapped device
+            Serial.println("[WARN] UNMAP received - re-announcing");
+            if (header->sequenceNum != 0) {
+                sendStatus(header->sequenceNum, STATUS_UNMAP_APPLIED, nullptr, 0);
+            }
+            nodeSlot = 0;
+            beaconSeen = false;
+            currentState = NodeState::ANNOUNCING;
+            break;
+        }
+        
         case MessageType::HEARTBEAT: {
             Serial.println("  Hub heartbeat received");
             break;
         }
         
+        case MessageType::BEACON: {
+            if (len < sizeof(BeaconMessage) || !hubDiscovered) {
+                return;  // Beacons only matter once we have a hub
+            }
+            BeaconMessage beacon;
+            memcpy(&beacon, data, sizeof(beacon));
+            
+            if (len >= sizeof(BeaconIdentMessage)) {
+                BeaconIdentMessage ident;
+                memcpy(&ident, data, sizeof(ident));
+                memcpy(hubId, ident.identity.hubId, 6);
+                hubGeneration = ident.identity.hubGeneration;
+            }
+            
+            if (beaconSeen && beacon.hubSession != hubSession) {
+                // Hub restarted: our slot is stale, announce again
+                Serial.println("[WARN] Hub session changed - re-announcing");
+                beaconSeen = false;
+                nodeSlot = 0;
+                currentState = NodeState::ANNOUNCING;
+                break;
+            }
+            
+            if (beaconSeen && beacon.configGeneration != hubConfigGeneration) {
+                Serial.printf("  Hub config generation %u -> %u\n",
+                              hubConfigGeneration, beacon.configGeneration);
+            }
+            
+            beaconSeen = true;
+            lastBeaconMs = millis();
+            #ifdef NODE_DEEP_SLEEP
+                beaconThisWake = true;
+            #endif
+            beaconIntervalMs = beacon.intervalMs;
+            hubSession = beacon.hubSession;
+            hubConfigGeneration = beacon.configGeneration;
+            beaconEpoch = beacon.epoch;
+            
+            if (beaconSlotPending(beacon, nodeSlot) && currentState == NodeState::CONNECTED) {
+                // Hub is holding frames for us; any TX releases them
+                Serial.println("  Beacon: downlink pending - polling hub");
+                sendHeartbeat();
+            }
+            break;
+        }
+        
         default:
             Serial.printf("  Unknown message type: %d\n", (int)header->type);
             break;
@@ -183,12 +530,16 @@ void onDataReceived(const uint8_t* mac, const uint8_t* data, int len) {
 
 #ifdef ESP8266
 void onDataSent(uint8_t* mac, uint8_t status) {
+    if (txPending > 0) txPending--;
+    txFailures = (status == 0) ? 0 : (txFailures < 255 ? txFailures + 1 : 255);
     Serial.printf("TX to %02X:%02X:%02X:%02X:%02X:%02X - %s\n",
                   mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
                   status == 0 ? "OK" : "FAIL");
 }
 #else
 void onDataSent(const uint8_t* mac, esp_now_send_status_t status) {
+    if (txPending > 0) txPending--;
+    txFailures = (status == ESP_NOW_SEND_SUCCESS) ? 0 : (txFailures < 255 ? txFailures + 1 : 255);
     Serial.printf("TX to %02X:%02X:%02X:%02X:%02X:%02X - %s\n",
                   mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
                   status == ESP_NOW_SEND_SUCCESS ? "OK" : "FAIL");
@@ -210,6 +561,9 @@ void setupESPNow() {
         wifi_set_channel(ESPNOW_CHANNEL);
     #else
         esp_wifi_set_channel(ESPNOW_CHANNEL, WIFI_SECOND_CHAN_NONE);
+        // Receive the hub's LR frames too when it runs us at a long-range rate
+        esp_wifi_set_protocol(WIFI_IF_STA, WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G |
+                                           WIFI_PROTOCOL_11N | WIFI_PROTOCOL_LR);
     #endif
     Serial.printf("WiFi Channel: %d\n", ESPNOW_CHANNEL);
     
@@ -233,13 +587,48 @@ void setupESPNow() {
     #endif
 }
 
+// Drain the receive ring (main loop context)
+static void processReceived() {
+    while (rxTail != rxHead) {
+        __sync_synchronize();  // Read the slot after seeing the index
+        uint8_t tail = rxTail;
+        processFrame(rxRing[tail]);
+        rxTail = (tail + 1) & (RX_RING_SLOTS - 1);
+    }
+}
+
+#ifdef NODE_POWER_SAVE
+// Radio on around each expected beacon and while a hold is active
+static void updateRadioPower(uint32_t now) {
+    bool awake = !beaconSeen || beaconIntervalMs == 0 ||
+                 (int32_t)(radioHoldUntil - now) > 0 ||
+                 now - lastBeaconMs > (uint32_t)beaconIntervalMs * BEACON_MISS_LIMIT;
+    
+    if (!awake) {
+        // Phase within the beacon period; beacons drift, so listen on both sides
+        uint32_t phase = (now - lastBeaconMs) % beaconIntervalMs;
+        awake = phase >= beaconIntervalMs - BEACON_GUARD_MS || 
+                (now - lastBeaconMs >= beaconIntervalMs && phase < BEACON_LISTEN_MS);
+    }
+    
+    if (awake) {
+        radioWake();
+    } else if (rxTail == rxHead) {
+        radioSleep();
+    }
+}
+#endif
+
 void nodeLoop() {
+    processReceived();
+    
     uint32_t now = millis();
     
     switch (currentState) {
         case NodeState::ANNOUNCING:
         case NodeState::WAITING_FOR_ACK:
             if (now - lastHeartbeatSent > ANNOUNCE_INTERVAL_MS) {
+                radioWake();
                 sendAnnounce();
                 lastHeartbeatSent = now;
                 currentState = NodeState::WAITING_FOR_ACK;
@@ -253,9 +642,15 @@ void nodeLoop() {
             
             if (now - lastHeartbeatReceived > CONNECTION_TIMEOUT_MS) {
                 Serial.println("[WARN] Connection timeout - hub not responding");
+                radioWake();
                 enterFailSafeMode();  // Call node-specific fail-safe
                 currentState = NodeState::LOST_CONNECTION;
+                break;
             }
+            
+            #ifdef NODE_POWER_SAVE
+                updateRadioPower(now);
+            #endif
             break;
             
         case NodeState::LOST_CONNECTION:
@@ -271,3 +666,150 @@ void nodeLoop() {
             break;
     }
 }
+
+#ifdef NODE_DEEP_SLEEP
+// ============================================================================
+// Deep Sleep
+// ============================================================================
+
+static bool loadRtcState() {
+    #ifdef ESP8266
+        if (!ESP.rtcUserMemoryRead(0, (uint32_t*)&rtcState, sizeof(rtcState))) {
+            return false;
+        }
+    #endif
+    return rtcState.magic == RTC_STATE_MAGIC && rtcState.crc == rtcStateCrc();
+}
+
+static void saveRtcState() {
+    rtcState.magic = RTC_STATE_MAGIC;
+    rtcState.crc = rtcStateCrc();
+    #ifdef ESP8266
+        ESP.rtcUserMemoryWrite(0, (uint32_t*)&rtcState, sizeof(rtcState));
+    #endif
+}
+
+bool restoreRtcState() {
+    if (!loadRtcState()) {
+        memset(&rtcState, 0, sizeof(rtcState));
+        Serial.println("[WARN] No valid RTC state - full discovery");
+        return false;
+    }
+    
+    rtcState.wakeCount++;
+    txFailures = rtcState.txFailures;
+    
+    if (rtcState.slot == 0 || rtcState.channel != ESPNOW_CHANNEL ||
+        txFailures >= DEEP_SLEEP_TX_FAIL_LIMIT) {
+        // Keep the node's own RTC data, drop the hub session
+        Serial.printf("[WARN] RTC hub session unusable (slot %u, ch %u, %u failed sends)\n",
+                      rtcState.slot, rtcState.channel, txFailures);
+        rtcState.slot = 0;
+        txFailures = 0;
+        return false;
+    }
+    
+    memcpy(hubMacAddress, rtcState.hubMac, 6);
+    #ifdef ESP8266
+        esp_now_add_peer(hubMacAddress, ESP_NOW_ROLE_COMBO, ESPNOW_CHANNEL, NULL, 0);
+    #else
+        esp_now_peer_info_t peerInfo = {};
+        memcpy(peerInfo.peer_addr, hubMacAddress, 6);
+        peerInfo.channel = ESPNOW_CHANNEL;
+        peerInfo.encrypt = false;
+        esp_now_add_peer(&peerInfo);
+    #endif
+    hubDiscovered = true;
+    messageSequence = rtcState.sequence;
+    
+    // Resume as if the last beacon arrived at boot; a session change in a
+    // later beacon still sends the node back to ANNOUNCING
+    nodeSlot = rtcState.slot;
+    beaconSeen = true;
+    lastBeaconMs = millis();
+    beaconIntervalMs = rtcState.beaconIntervalMs;
+    hubSession = rtcState.hubSession;
+    memcpy(hubId, rtcState.hubId, 6);
+    hubGeneration = rtcState.hubGeneration;
+    hubConfigGeneration = rtcState.configGeneration;
+    beaconEpoch = rtcState.epoch;
+    beaconCheckDue = beaconIntervalMs > 0 && rtcState.wakeCount % DEEP_SLEEP_BEACON_CHECK == 0;
+    
+    lastHeartbeatReceived = millis();
+    lastHeartbeatSent = millis();
+    currentState = NodeState::CONNECTED;
+    
+    Serial.printf("[OK] Hub session resumed from RTC (slot %u, wake %lu)\n",
+                  nodeSlot, (unsigned long)rtcState.wakeCount);
+    return true;
+}
+
+uint8_t* rtcUserData() {
+    return rtcState.userData;
+}
+
+bool deepSleepReady() {
+    if (currentState != NodeState::CONNECTED || txPending > 0 || rxTail != rxHead) {
+        return false;
+    }
+    
+    uint32_t now = millis();
+    if (now - lastTxMs < DEEP_SLEEP_RX_WINDOW_MS) {
+        return false;  // Hub releases held frames when we transmit
+    }
+    
+    if (beaconCheckDue && !beaconThisWake) {
+        return now > (uint32_t)beaconIntervalMs + BEACON_LISTEN_MS;
+    }
+    return true;
+}
+
+void enterDeepSleep(uint32_t sleepMs) {
+    uint32_t awakeMs = millis() + DEEP_SLEEP_BOOT_MS;
+    
+    if (currentState == NodeState::CONNECTED && hubDiscovered) {
+        memcpy(rtcState.hubMac, hubMacAddress, 6);
+        rtcState.channel = ESPNOW_CHANNEL;
+        rtcState.slot = nodeSlot;
+        rtcState.hubSession = hubSession;
+        memcpy(rtcState.hubId, hubId, 6);
+        rtcState.hubGeneration = hubGeneration;
+        rtcState.configGeneration = hubConfigGeneration;
+        rtcState.beaconIntervalMs = beaconIntervalMs;
+        uint32_t epoch = getHubEpoch();
+        rtcState.epoch = epoch ? epoch + (sleepMs + DEEP_SLEEP_BOOT_MS) / 1000 : 0;
+    } else {
+        rtcState.slot = 0;  // Not joined: discover again on the next wake
+    }
+    rtcState.sequence = messageSequence;
+    rtcState.txFailures = txFailures;
+    rtcState.lastAwakeMs = awakeMs;
+    rtcState.lastSleepMs = sleepMs;
+    saveRtcState();
+    
+    Serial.printf("[OK] Deep sleep for %lu ms (awake %lu ms)\n",
+                  (unsigned long)sleepMs, (unsigned long)awakeMs);
+    Serial.flush();
+    
+    #ifdef ESP8266
+        ESP.deepSleep((uint64_t)sleepMs * 1000, WAKE_RF_DEFAULT);
+    #else
+        esp_sleep_enable_timer_wakeup((uint64_t)sleepMs * 1000);
+        esp_deep_sleep_start();
+    #endif
+}
+
+uint32_t getLastCycleAwakeMs() {
+    return rtcState.lastAwakeMs;
+}
+
+uint32_t getLastCycleAvgMicroAmps() {
+    uint64_t totalMs = (uint64_t)rtcState.lastAwakeMs + rtcState.lastSleepMs;
+    if (totalMs == 0) {
+        return 0;
+    }
+    uint64_t charge = (uint64_t)rtcState.lastAwakeMs * CYCLE_AWAKE_UA +
+                      (uint64_t)rtcState.lastSleepMs * CYCLE_SLEEP_UA;
+    return (uint32_t)(charge / totalMs);
+}
+#endif
@@ -41,6 +41,33 @@ const uint32_t ANNOUNCE_INTERVAL_MS = 5000;
 const uint32_t HEARTBEAT_INTERVAL_MS = 30000;
 const uint32_t CONNECTION_TIMEOUT_MS = 90000;
 
+// Beacons: any hub beacon counts as hub liveness. Built with
+// -DNODE_POWER_SAVE, the radio is off between beacons unless the node's
+// slot bit is set or it is sending.
+const uint32_t BEACON_GUARD_MS = 20;        // Wake this early for the next beacon
+const uint32_t BEACON_LISTEN_MS = 30;       // Listen this long for a late beacon
+const uint32_t PS_AWAKE_HOLD_MS = 150;      // Stay up after TX / pending bit
+const uint8_t BEACON_MISS_LIMIT = 5;        // Missed beacons before staying awake
+
+// Deep sleep (-DNODE_DEEP_SLEEP): hub MAC, channel, slot, sequence and hub
+// session are kept in CRC-checked RTC memory, so a timer wake resumes in
+// CONNECTED and transmits without an ANNOUNCE/ACK round trip. On ESP8266
+// GPIO16 must be wired to RST.
+#ifdef NODE_DEEP_SLEEP
+const uint8_t RTC_USER_DATA_LEN = 64;           // Node-owned bytes kept across sleep
+const uint32_t DEEP_SLEEP_BOOT_MS = 120;        // ROM boot + RF init, not seen by millis()
+const uint32_t DEEP_SLEEP_RX_WINDOW_MS = 25;    // Listen after the last TX for held frames
+const uint16_t DEEP_SLEEP_BEACON_CHECK = 20;    // Every Nth wake, confirm the hub session
+const uint8_t DEEP_SLEEP_TX_FAIL_LIMIT = 3;     // Failed sends before full re-discovery
+const uint32_t CYCLE_AWAKE_UA = 75000;          // Modelled current, radio on (uA)
+const uint32_t CYCLE_SLEEP_UA = 25;             // Modelled current, deep sleep (uA)
+#endif
+
+// Receive ring: frames are copied here in the ESP-NOW callback and
+// handled (including handleCommand() and the STATUS reply) in nodeLoop()
+const uint8_t RX_RING_SLOTS = 8;        // Must be a power of two
+const uint8_t RX_FRAME_MAX = 250;       // ESP-NOW payload limit
+
 // Functions that must be implemented by each specific node
 void setupHardware();           // Initialize hardware-specific pins/peripherals
 void enterFailSafeMode();       // Put hardware in safe state
@@ -52,7 +79,18 @@ void sendAnnounce();
 void sendHeartbeat();
 void sendStatus(uint8_t commandId, uint8_t statusCode, const uint8_t* data, size_t dataLen);
 void setupESPNow();
-void nodeLoop();
+void nodeLoop();                // Drains the receive ring, then runs the state machine
+uint32_t getHubEpoch();         // Unix time from the last beacon (0 = unknown)
+uint16_t getHubConfigGeneration();
+
+#ifdef NODE_DEEP_SLEEP
+bool restoreRtcState();         // Call after setupESPNow(); true = hub session resumed
+uint8_t* rtcUserData();         // RTC_USER_DATA_LEN bytes saved with the node state
+bool deepSleepReady();          // Connected, sends done, RX window and beacon check over
+void enterDeepSleep(uint32_t sleepMs);  // Saves RTC state; does not return
+uint32_t getLastCycleAwakeMs();         // Previous wake, including boot
+uint32_t getLastCycleAvgMicroAmps();    // Previous wake + sleep, modelled from time awake
+#endif
 
 #ifdef ESP8266
 void onDataReceived(uint8_t* mac, uint8_t* data, uint8_t len);
@@ -0,0 +1,391 @@
+#include "api/ApiRouter.h"
+
+// ============================================================================
+// PARAMS
+// ============================================================================
+
+const ApiRouter::Params::Value* ApiRouter::Params::_find(const char* name) const {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (strcmp(_values[i].name, name) == 0) {
+            return &_values[i];
+        }
+    }
+    return nullptr;
+}
+
+uint32_t ApiRouter::Params::getUint(const char* name) const {
+    const Value* value = _find(name);
+    return (value && value->type == ParamType::UINT) ? value->number : 0;
+}
+
+const uint8_t* ApiRouter::Params::getMac(const char* name) const {
+    const Value* value = _find(name);
+    return (value && value->type == ParamType::MAC) ? value->mac : nullptr;
+}
+
+String ApiRouter::Params::getString(const char* name) const {
+    String out;
+    const Value* value = _find(name);
+    if (value) {
+        out.reserve(value->length);
+        for (uint8_t i = 0; i < value->length; i++) {
+            out += value->text[i];
+        }
+    }
+    return out;
+}
+
+// ============================================================================
+// REGISTRATION
+// ============================================================================
+
+ApiRouter::ApiRouter(const char* prefix)
+    : _prefix(prefix) {
+    _addNode();
+}
+
+uint16_t ApiRouter::_addNode() {
+    Node node;
+    node.paramChild = -1;
+    node.paramType = ParamType::NONE;
+    _nodes.push_back(node);
+    return _nodes.size() - 1;
+}
+
+bool ApiRouter::on(const char* pattern, WebRequestMethodComposite methods, RequestHandler onRequest,
+                   BodyHandler onBody) {
+    uint16_t node = 0;
+    uint8_t depth = 0;
+    uint8_t paramCount = 0;
+    const char* cursor = pattern;
+
+    while (*cursor == '/') {
+        const char* start = cursor + 1;
+        const char* end = start;
+        while (*end && *end != '/') {
+            end++;
+        }
+        cursor = end;
+        size_t length = end - start;
+        if (length == 0) {
+            break;      // Trailing slash
+        }
+        if (++depth > MAX_DEPTH) {
+            Serial.printf("[ERR] Route %s: more than %d segments\n", pattern, MAX_DEPTH);
+            return false;
+        }
+
+        if (start[0] == '{' && end[-1] == '}') {
+            // {name} or {name:type}
+            String spec;
+            for (const char* c = start + 1; c < end - 1; c++) {
+                spec += *c;
+            }
+            int colon = spec.indexOf(':');
+            String name = colon < 0 ? spec : spec.substring(0, colon);
+            String typeName = colon < 0 ? String("str") : spec.substring(colon + 1);
+            ParamType type = typeName == "uint" ? ParamType::UINT :
+                             typeName == "mac" ? ParamType::MAC :
+                             typeName == "str" ? ParamType::STRING : ParamType::NONE;
+            if (name.length() == 0 || type == ParamType::NONE || ++paramCount > MAX_PARAMS) {
+                Serial.printf("[ERR] Route %s: bad parameter {%s}\n", pattern, spec.c_str());
+                return false;
+            }
+
+            if (_nodes[node].paramChild < 0) {
+                uint16_t child = _addNode();
+                _nodes[node].paramChild = child;
+                _nodes[node].paramType = type;
+                _nodes[node].paramName = name;
+            } else if (_nodes[node].paramType != type || _nodes[node].paramName != name) {
+                // One parameter per position keeps matching unambiguous
+                Serial.printf("[ERR] Route %s: {%s} conflicts with {%s}\n",
+                              pattern, spec.c_str(), _nodes[node].paramName.c_str());
+                return false;
+            }
+            node = _nodes[node].paramChild;
+            continue;
+        }
+
+        String literal;
+        for (const char* c = start; c < end; c++) {
+            literal += *c;
+        }
+
+        // Keep literals sorted for the binary search in _walk()
+        std::vector<Edge>& edges = _nodes[node].literals;
+        size_t pos = 0;
+        while (pos < edges.size() && strcmp(edges[pos].literal.c_str(), literal.c_str()) < 0) {
+            pos++;
+        }
+        if (pos < edges.size() && edges[pos].literal == literal) {
+            node = edges[pos].node;
+            continue;
+        }
+
+        uint16_t child = _addNode();
+        Edge edge;
+        edge.literal = literal;
+        edge.node = child;
+        _nodes[node].literals.insert(_nodes[node].literals.begin() + pos, edge);
+        node = child;
+    }
+
+    for (uint16_t index : _nodes[node].routes) {
+        if (_routes[index].methods & methods) {
+            Serial.printf("[ERR] Route %s registered twice\n", pattern);
+            return false;
+        }
+    }
+
+    Route route;
+    route.methods = methods;
+    route.onRequest = onRequest;
+    route.onBody = onBody;
+    _routes.push_back(route);
+    _nodes[node].routes.push_back(_routes.size() - 1);
+    return true;
+}
+
+// ============================================================================
+// MATCHING
+// ============================================================================
+
+int ApiRouter::match(const char* path, size_t length, WebRequestMethodComposite method,
+                     Params& params, WebRequestMethodComposite& allowed) const {
+    params._count = 0;
+    allowed = 0;
+
+    int16_t node = -1;
+    if (!_walk(0, path, length, 0, params, node)) {
+        return -1;
+    }
+
+    for (uint16_t index : _nodes[node].routes) {
+        allowed |= _routes[index].methods;
+        if (_routes[index].methods & method) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+bool ApiRouter::_walk(uint16_t node, const char* path, size_t length, size_t pos, Params& params,
+                      int16_t& found) const {
+    const Node& current = _nodes[node];
+
+    if (pos >= length) {
+        if (current.routes.empty()) {
+            return false;
+        }
+        found = node;
+        return true;
+    }
+    if (path[pos] != '/') {
+        return false;
+    }
+
+    size_t start = pos + 1;
+    size_t end = start;
+    while (end < length && path[end] != '/') {
+        end++;
+    }
+    size_t segment = end - start;
+    if (segment == 0) {
+        // Trailing slash is the same resource; empty inner segments never match
+        return end == length && _walk(node, path, length, length, params, found);
+    }
+
+    // Literal children first
+    size_t low = 0;
+    size_t high = current.literals.size();
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        const String& literal = current.literals[mid].literal;
+        int cmp = strncmp(literal.c_str(), path + start, segment);
+        if (cmp == 0 && literal.length() > segment) {
+            cmp = 1;
+        }
+        if (cmp == 0) {
+            if (_walk(current.literals[mid].node, path, length, end, params, found)) {
+                return true;
+            }
+            break;
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    // Then the typed parameter, backing out if the rest of the path fails
+    if (current.paramChild >= 0 && params._count < MAX_PARAMS) {
+        Params::Value& value = params._values[params._count];
+        if (_parseParam(current.paramType, path + start, segment, value)) {
+            value.name = current.paramName.c_str();
+            params._count++;
+            if (_walk(current.paramChild, path, length, end, params, found)) {
+                return true;
+            }
+            params._count--;
+        }
+    }
+
+    return false;
+}
+
+bool ApiRouter::_parseParam(ParamType type, const char* text, size_t length, Params::Value& value) {
+    if (length == 0 || length > 255) {
+        return false;
+    }
+    value.type = type;
+    value.text = text;
+    value.length = length;
+    value.number = 0;
+
+    switch (type) {
+        case ParamType::UINT: {
+            if (length > 10) {
+                return false;
+            }
+            uint64_t number = 0;
+            for (size_t i = 0; i < length; i++) {
+                if (text[i] < '0' || text[i] > '9') {
+                    return false;
+                }
+                number = number * 10 + (text[i] - '0');
+            }
+            if (number > 0xFFFFFFFFull) {
+                return false;
+            }
+            value.number = (uint32_t)number;
+            return true;
+        }
+
+        case ParamType::MAC:
+            if (length != 17) {
+                return false;
+            }
+            for (uint8_t i = 0; i < 6; i++) {
+                uint8_t byte = 0;
+                for (uint8_t j = 0; j < 2; j++) {
+                    char c = text[i * 3 + j];
+                    uint8_t nibble;
+                    if (c >= '0' && c <= '9') nibble = c - '0';
+                    else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+                    else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+                    else return false;
+                    byte = (byte << 4) | nibble;
+                }
+                if (i < 5 && text[i * 3 + 2] != ':') {
+                    return false;
+                }
+                value.mac[i] = byte;
+            }
+            return true;
+
+        case ParamType::STRING:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// ============================================================================
+// ASYNC WEB HANDLER
+// ============================================================================
+
+bool ApiRouter::_inNamespace(AsyncWebServerRequest* request, const char*& path, size_t& length) const {
+    const String& url = request->url();
+    size_t prefixLength = _prefix.length();
+    if (url.length() < prefixLength || strncmp(url.c_str(), _prefix.c_str(), prefixLength) != 0) {
+        return false;
+    }
+    if (url.length() > prefixLength && url[prefixLength] != '/') {
+        return false;   // e.g. /apix
+    }
+    path = url.c_str() + prefixLength;
+    length = url.length() - prefixLength;
+    return true;
+}
+
+int ApiRouter::_resolve(AsyncWebServerRequest* request, Params& params,
+                        WebRequestMethodComposite& allowed) const {
+    const char* path;
+    size_t length;
+    if (!_inNamespace(request, path, length)) {
+        allowed = 0;
+        return -1;
+    }
+    return match(path, length, request->method(), params, allowed);
+}
+
+bool ApiRouter::canHandle(AsyncWebServerRequest* request) {
+    const char* path;
+    size_t length;
+    if (!_inNamespace(request, path, length)) {
+        return false;
+    }
+
+    // Handlers read Accept / If-None-Match; keep every header
+    request->addInterestingHeader("ANY");
+    return true;
+}
+
+void ApiRouter::handleRequest(AsyncWebServerRequest* request) {
+    Params params;
+    WebRequestMethodComposite allowed;
+    int route = _resolve(request, params, allowed);
+
+    if (route < 0) {
+        if (allowed) {
+            AsyncWebServerResponse* response = request->beginResponse(
+                405, "application/json", "{\"success\":false,\"error\":\"Method not allowed\"}");
+            response->addHeader("Allow", _allowHeader(allowed));
+            request->send(response);
+        } else {
+            request->send(404, "application/json", "{\"success\":false,\"error\":\"Not found\"}");
+        }
+        return;
+    }
+
+    if (_routes[route].onRequest) {
+        _routes[route].onRequest(request, params);
+    }
+}
+
+void ApiRouter::handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                           size_t index, size_t total) {
+    // Re-matched per chunk: a trie walk is cheaper than per-request state,
+    // and _tempObject belongs to the body handlers
+    Params params;
+    WebRequestMethodComposite allowed;
+    int route = _resolve(request, params, allowed);
+
+    if (route >= 0 && _routes[route].onBody) {
+        _routes[route].onBody(request, params, data, len, index, total);
+    }
+}
+
+String ApiRouter::_allowHeader(WebRequestMethodComposite methods) {
+    static const struct {
+        WebRequestMethodComposite method;
+        const char* name;
+    } names[] = {
+        {HTTP_GET, "GET"}, {HTTP_POST, "POST"}, {HTTP_PUT, "PUT"}, {HTTP_PATCH, "PATCH"},
+        {HTTP_DELETE, "DELETE"}, {HTTP_HEAD, "HEAD"}, {HTTP_OPTIONS, "OPTIONS"}
+    };
+
+    String header;
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (methods & names[i].method) {
+            if (header.length() > 0) {
+                header += ", ";
+            }
+            header += names[i].name;
+        }
+    }
+    return header;
+}
@@ -0,0 +1,91 @@
+#include "api/PayloadEncoder.h"
+
+namespace PayloadEncoder {
+
+Format fromName(const String& name) {
+    String lower = name;
+    lower.toLowerCase();
+    if (lower == "msgpack" || lower == "messagepack" || lower == MIME_MSGPACK) {
+        return Format::MSGPACK;
+    }
+    return Format::JSON;
+}
+
+const char* name(Format format) {
+    return format == Format::MSGPACK ? "msgpack" : "json";
+}
+
+const char* contentType(Format format) {
+    return format == Format::MSGPACK ? MIME_MSGPACK : MIME_JSON;
+}
+
+Format negotiate(AsyncWebServerRequest* request) {
+    // Explicit query override is handy for curl and debugging
+    if (request->hasParam("format")) {
+        return fromName(request->getParam("format")->value());
+    }
+
+    if (request->hasHeader("Accept")) {
+        const String& accept = request->getHeader("Accept")->value();
+        // Also accept the unregistered x- variant some clients still send
+        if (accept.indexOf("application/msgpack") >= 0 ||
+            accept.indexOf("application/x-msgpack") >= 0) {
+            return Format::MSGPACK;
+        }
+    }
+
+    return Format::JSON;
+}
+
+size_t measure(JsonVariantConst src, Format format) {
+    return format == Format::MSGPACK ? measureMsgPack(src) : measureJson(src);
+}
+
+size_t encode(JsonVariantConst src, Format format, std::vector<uint8_t>& out) {
+    size_t len = measure(src, format);
+    out.resize(len);
+    if (len == 0) {
+        return 0;
+    }
+
+    // measureJson() excludes the terminator serializeJson() wants to write
+    if (format == Format::MSGPACK) {
+        return serializeMsgPack(src, out.data(), len);
+    }
+    out.resize(len + 1);
+    size_t written = serializeJson(src, (char*)out.data(), len + 1);
+    out.resize(written);
+    return written;
+}
+
+void send(AsyncWebServerRequest* request, int code, JsonVariantConst src, Format format) {
+    send(request, code, src, format, String());
+}
+
+void send(AsyncWebServerRequest* request, int code, JsonVariantConst src, Format format,
+          const String& etag) {
+    // Stream response copies into its own buffer, so the document may be
+    // freed as soon as we return
+    AsyncResponseStream* response = request->beginResponseStream(contentType(format));
+    response->setCode(code);
+    response->addHeader("Vary", "Accept");
+    if (etag.length() > 0) {
+        // Browsers must revalidate, which costs a 304 when unchanged
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", "no-cache");
+    }
+
+    if (format == Format::MSGPACK) {
+        serializeMsgPack(src, *response);
+    } else {
+        serializeJson(src, *response);
+    }
+
+    request->send(response);
+}
+
+void send(AsyncWebServerRequest* request, int code, JsonVariantConst src) {
+    send(request, code, src, negotiate(request));
+}
+
+}
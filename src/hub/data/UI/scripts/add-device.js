@@ -274,6 +274,17 @@ function addDeviceManually() {
         body: JSON.stringify(provisionData)
     })
     .then(response => response.json())
+    .then(data => {
+        if (!data.success) {
+            return data;
+        }
+        // Hub commits only after the node confirms
+        showNotification('Waiting for device to confirm...', 'info');
+        return waitForProvisioning(data).then(transaction => ({
+            success: transaction.state === 'COMMITTED',
+            error: transaction.error
+        }));
+    })
     .then(data => {
         if (data.success) {
             showNotification('Device provisioned successfully!', 'success');
@@ -32,11 +32,16 @@ function initWebSocket() {
     addActivityLog(`Connecting to hub...`, 'info');
     
     ws = new WebSocket(wsUrl);
+    ws.binaryType = 'arraybuffer';
     
     ws.onopen = () => {
         addActivityLog('Connected to hub', 'success');
         updateConnectionStatus(true);
         clearInterval(reconnectInterval);
+        reconnectInterval = null;
+        
+        // Ask for compact binary telemetry (hub replies with HELLO)
+        sendCommand({ type: 'HELLO', encoding: 'msgpack' });
         
         // Request initial data
         sendCommand({ type: 'GET_NODES', tankId: currentTankId });
@@ -62,7 +67,10 @@ function initWebSocket() {
     
     ws.onmessage = (event) => {
         try {
-            const data = JSON.parse(event.data);
+            // Binary frames are MessagePack, text frames are JSON
+            const data = (event.data instanceof ArrayBuffer)
+                ? MsgPack.decode(event.data)
+                : JSON.parse(event.data);
             handleMessage(data);
         } catch (e) {
             addActivityLog(`Failed to parse message: ${e}`, 'error');
@@ -91,6 +99,31 @@ function handleMessage(data) {
         case 'ERROR':
             logMessage(`Error: ${data.message}`, 'error');
             break;
+        case 'HELLO':
+            console.log(`[INFO] Telemetry encoding: ${data.encoding}`);
+            break;
+        // Hub telemetry events ({type, ts, data})
+        case 'deviceDiscovered':
+            addActivityLog(`New device discovered: ${data.data.name}`, 'info');
+            break;
+        case 'deviceOnline':
+            addActivityLog(`${data.data.name} is online`, 'success');
+            break;
+        case 'deviceOffline':
+            addActivityLog(`${data.data.name} went offline`, 'error');
+            break;
+        case 'deviceStatus':
+            // High-rate; dashboard counters refresh from the 5 s poll
+            break;
+        case 'temperatureAlert':
+            addActivityLog(`Temperature alert: ${data.data.name}`, 'warning');
+            break;
+        case 'phAlert':
+            addActivityLog(`pH alert: ${data.data.name}`, 'warning');
+            break;
+        case 'emergencyShutdown':
+            addActivityLog(`EMERGENCY SHUTDOWN: ${data.data.reason}`, 'error');
+            break;
         default:
             logMessage(`Unknown message type: ${data.type}`, 'warning');
     }
@@ -121,7 +154,6 @@ function updateConnectionStatus(connected) {
             statusText.textContent = 'System Offline';
         }
     }
-}   }
 }
 
 // Update hub uptime display
@@ -357,14 +389,33 @@ function logMessage(message, type = 'info') {
     addActivityLog(message, type);
 }
 
+// Poll a provisioning transaction (202 from provision/unmap) until it settles.
+// Resolves with the final transaction; state is COMMITTED on success.
+function waitForProvisioning(accepted, intervalMs = 500) {
+    return new Promise((resolve, reject) => {
+        function poll() {
+            fetch(accepted.poll)
+                .then(response => response.json())
+                .then(transaction => {
+                    if (transaction.state === 'PENDING') {
+                        setTimeout(poll, intervalMs);
+                    } else {
+                        resolve(transaction);
+                    }
+                })
+                .catch(reject);
+        }
+        poll();
+    });
+}
+
 // ============================================================================
 // DASHBOARD API INTEGRATION
 // ============================================================================
 
 function updateSystemStats() {
     // Fetch aquarium count
-    fetch('/api/aquariums')
-        .then(response => response.json())
+    fetchApi('/api/aquariums')
         .then(data => {
             const count = (data.aquariums && data.aquariums.length) || 0;
             const elem = document.getElementById('aquarium-count');
@@ -373,8 +424,7 @@ function updateSystemStats() {
         .catch(error => console.error('Error fetching aquariums:', error));
     
     // Fetch device count
-    fetch('/api/devices')
-        .then(response => response.json())
+    fetchApi('/api/devices')
         .then(data => {
             const count = (data.devices && data.devices.length) || 0;
             const elem = document.getElementById('device-count');
@@ -383,8 +433,7 @@ function updateSystemStats() {
         .catch(error => console.error('Error fetching devices:', error));
     
     // Update memory status
-    fetch('/api/status')
-        .then(response => response.json())
+    fetchApi('/api/status')
         .then(data => {
             const elem = document.getElementById('memory-status');
             if (elem && data.memory) {
@@ -427,8 +476,7 @@ function updateSystemStats() {
 // Load dashboard data from backend
 function loadDashboardData() {
     // Load aquariums
-    fetch('/api/aquariums')
-        .then(response => response.json())
+    fetchApi('/api/aquariums')
         .then(data => {
             if (data.aquariums && Array.isArray(data.aquariums)) {
                 const totalAquariums = data.aquariums.length;
@@ -445,8 +493,7 @@ function loadDashboardData() {
         .catch(error => console.error('Error loading aquariums:', error));
     
     // Load devices
-    fetch('/api/devices')
-        .then(response => response.json())
+    fetchApi('/api/devices')
         .then(data => {
             if (data.devices && Array.isArray(data.devices)) {
                 const totalDevices = data.devices.length;
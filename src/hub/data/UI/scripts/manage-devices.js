@@ -24,6 +24,7 @@ function loadDevices() {
                 filteredDevices = [...allDevices];
                 updateStatistics();
                 renderDevices();
+                loadRemoteDevices();
             }
         })
         .catch(error => {
@@ -36,6 +37,22 @@ function loadDevices() {
         });
 }
 
+// Devices owned by the other hubs of a federation (read-only here)
+function loadRemoteDevices() {
+    fetch('/api/federation/devices')
+        .then(response => response.json())
+        .then(data => {
+            const remote = (data.devices || []).filter(device => device.local === false);
+            if (remote.length === 0) {
+                return;
+            }
+            allDevices = allDevices.filter(device => !device.hub).concat(remote);
+            updateStatistics();
+            filterDevices();
+        })
+        .catch(error => console.error('Error loading federation devices:', error));
+}
+
 function loadTankFilter() {
     // Load from backend API
     fetch('/api/aquariums')
@@ -148,6 +165,11 @@ function renderDevices() {
                         <div style="color: var(--color-text-secondary); font-size: 0.875rem;">
                             <strong>Type:</strong> ${getDeviceTypeName(device.type)}
                         </div>
+                        ${device.hub ? `
+                            <div style="color: var(--color-text-secondary); font-size: 0.875rem;">
+                                <strong>Hub:</strong> <a href="http://${device.hubAddress}/">${device.hub}</a>${device.hubOnline ? '' : ' (unreachable)'}
+                            </div>
+                        ` : ''}
                     </div>
                     
                     ${device.schedules && device.schedules.length > 0 ? `
@@ -156,6 +178,7 @@ function renderDevices() {
                         </div>
                     ` : ''}
                 </div>
+                ${device.hub ? '' : `
                 <div class="card-footer" style="display: flex; gap: 0.5rem;">
                     <button class="btn btn-primary" style="flex: 1;" onclick="viewDevice('${device.mac}')">
                         🔌 Control
@@ -167,6 +190,7 @@ function renderDevices() {
                         🗑️ Unmap
                     </button>
                 </div>
+                `}
             </div>
         `;
     }).join('');
@@ -319,6 +343,15 @@ function unmapDevice(mac, name) {
         body: JSON.stringify({ mac: mac })
     })
     .then(response => response.json())
+    .then(data => {
+        if (!data.success) {
+            return data;
+        }
+        return waitForProvisioning(data).then(transaction => ({
+            success: transaction.state === 'COMMITTED',
+            error: transaction.error
+        }));
+    })
     .then(data => {
         if (data.success) {
             showNotification(`Device "${name}" unmapped successfully!`, 'success');
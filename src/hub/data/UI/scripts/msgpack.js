@@ -0,0 +1,126 @@
+// Aquarium Management System - MessagePack decoder
+// Decodes binary telemetry from the hub (WebSocket frames and REST responses
+// requested with Accept: application/msgpack). Decode-only: the hub never
+// expects MessagePack from the browser.
+
+const MsgPack = (() => {
+    const textDecoder = new TextDecoder('utf-8');
+
+    function decode(input) {
+        const bytes = input instanceof Uint8Array ? input : new Uint8Array(input);
+        const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+        let pos = 0;
+
+        function str(len) {
+            const value = textDecoder.decode(bytes.subarray(pos, pos + len));
+            pos += len;
+            return value;
+        }
+
+        function bin(len) {
+            const value = bytes.slice(pos, pos + len);
+            pos += len;
+            return value;
+        }
+
+        function array(len) {
+            const value = new Array(len);
+            for (let i = 0; i < len; i++) value[i] = read();
+            return value;
+        }
+
+        function map(len) {
+            const value = {};
+            for (let i = 0; i < len; i++) {
+                const key = read();
+                value[key] = read();
+            }
+            return value;
+        }
+
+        function u8() { return view.getUint8(pos++); }
+        function u16() { const v = view.getUint16(pos); pos += 2; return v; }
+        function u32() { const v = view.getUint32(pos); pos += 4; return v; }
+
+        function read() {
+            const type = u8();
+
+            // Fixed-size formats
+            if (type <= 0x7f) return type;                       // positive fixint
+            if (type >= 0xe0) return type - 0x100;               // negative fixint
+            if ((type & 0xf0) === 0x80) return map(type & 0x0f); // fixmap
+            if ((type & 0xf0) === 0x90) return array(type & 0x0f); // fixarray
+            if ((type & 0xe0) === 0xa0) return str(type & 0x1f); // fixstr
+
+            let value;
+            switch (type) {
+                case 0xc0: return null;
+                case 0xc2: return false;
+                case 0xc3: return true;
+                case 0xc4: return bin(u8());
+                case 0xc5: return bin(u16());
+                case 0xc6: return bin(u32());
+                case 0xca: value = view.getFloat32(pos); pos += 4; return value;
+                case 0xcb: value = view.getFloat64(pos); pos += 8; return value;
+                case 0xcc: return u8();
+                case 0xcd: return u16();
+                case 0xce: return u32();
+                case 0xcf: value = Number(view.getBigUint64(pos)); pos += 8; return value;
+                case 0xd0: value = view.getInt8(pos); pos += 1; return value;
+                case 0xd1: value = view.getInt16(pos); pos += 2; return value;
+                case 0xd2: value = view.getInt32(pos); pos += 4; return value;
+                case 0xd3: value = Number(view.getBigInt64(pos)); pos += 8; return value;
+                case 0xd9: return str(u8());
+                case 0xda: return str(u16());
+                case 0xdb: return str(u32());
+                case 0xdc: return array(u16());
+                case 0xdd: return array(u32());
+                case 0xde: return map(u16());
+                case 0xdf: return map(u32());
+                default:
+                    throw new Error(`Unsupported MessagePack type 0x${type.toString(16)}`);
+            }
+        }
+
+        return read();
+    }
+
+    return { decode };
+})();
+
+// Last response per URL for conditional GET (url -> { etag, data })
+const apiCache = new Map();
+
+// Fetch a hub API endpoint preferring MessagePack, falling back to JSON
+// when the response is not binary (older firmware or static files).
+// GETs send If-None-Match; a 304 returns the previously decoded data
+// without transferring or parsing the body again.
+function fetchApi(url, options = {}) {
+    const isGet = !options.method || options.method.toUpperCase() === 'GET';
+    const cached = isGet ? apiCache.get(url) : null;
+
+    const headers = Object.assign({ 'Accept': 'application/msgpack, application/json;q=0.5' },
+                                  options.headers || {});
+    if (cached) headers['If-None-Match'] = cached.etag;
+
+    // The hub's ETag handles caching; keep the browser cache out of it
+    return fetch(url, Object.assign({}, options, { headers, cache: 'no-store' }))
+        .then(response => {
+            if (response.status === 304 && cached) {
+                return cached.data;
+            }
+
+            const type = response.headers.get('Content-Type') || '';
+            const body = type.includes('msgpack')
+                ? response.arrayBuffer().then(buffer => MsgPack.decode(buffer))
+                : response.json();
+
+            return body.then(data => {
+                const etag = response.headers.get('ETag');
+                if (isGet && etag && response.ok) {
+                    apiCache.set(url, { etag, data });
+                }
+                return data;
+            });
+        });
+}
@@ -25,11 +25,26 @@
 #include <esp_now.h>
 #include <ArduinoJson.h>
 #include "protocol/messages.h"
+#include "protocol/commands.h"
 #include "models/Aquarium.h"
 #include "managers/AquariumManager.h"
 #include <HTTPClient.h>
 #include "Constant.h"
 #include "ESPNowManager.h"
+#include "api/PayloadEncoder.h"
+#include "api/ApiRouter.h"
+#include "managers/DeviceConfigStore.h"
+#include "managers/ProvisioningManager.h"
+#include "managers/CalibrationStore.h"
+#include "managers/AnalyticsManager.h"
+#include "managers/EventJournal.h"
+#include "managers/ScheduleJournal.h"
+#include "managers/ScheduleTimeline.h"
+#include "managers/TaskExecutor.h"
+#include "managers/FailoverManager.h"
+#include "managers/FederationManager.h"
+#include <map>
+#include <memory>
 
 // ============================================================================
 // CONFIGURATION & CONSTANTS
@@ -39,6 +54,7 @@
 struct HubConfig {
     bool heartbeatEnabled;
     uint32_t heartbeatIntervalSec;
+    uint16_t beaconIntervalMs;
     bool aggressiveMemoryManagement;
     uint32_t heapWarningThresholdKB;
     uint32_t psramWarningThresholdKB;
@@ -48,9 +64,17 @@ struct HubConfig {
     String mdnsHostname;
     uint8_t espnowChannel;
     uint8_t espnowMaxPeers;
+    bool espnowRateAdaptation;  // Per-peer PHY rate
+    bool espnowLongRange;       // Allow LR rates for capable nodes
     bool debugSerial;
     bool debugESPNOW;
     bool debugWebSocket;
+    String hubPartner;          // Partner hub MAC for hot standby (empty = single hub)
+    bool hubStandby;            // Preferred role in the pair
+    String federationGroup;     // LAN federation group (empty = off)
+    String federationName;      // Shown on the other hubs (default: mDNS name)
+    uint16_t federationPort;
+    String federationPeers;     // ip[:port],... besides broadcast
 };
 
 HubConfig config;
@@ -61,15 +85,36 @@ TaskHandle_t watchdogTaskHandle = NULL;
 // ESPNowManager callbacks declared here
 void onAnnounceReceived(const uint8_t* mac, const AnnounceMessage& msg);
 void onHeartbeatReceived(const uint8_t* mac, const HeartbeatMessage& msg);
+void onHeartbeatDiagnostics(const uint8_t* mac, const HeartbeatDiagnostics& diagnostics);
 void onStatusReceived(const uint8_t* mac, const StatusMessage& msg);
 void onCommandReceived(const uint8_t* mac, const uint8_t* data, size_t len);
+void onBeaconIdentity(const uint8_t* mac, const BeaconIdentity& identity);
+void onReplicationReceived(const uint8_t* mac, const uint8_t* data, size_t len);
 
 // Web server
 AsyncWebServer server(80);
 
+// REST API: every /api route, matched by one path trie
+ApiRouter api("/api");
+
+// WebSocket telemetry endpoint (ws://<hub>/ws)
+AsyncWebSocket ws("/ws");
+
+// Per-client telemetry encoding (client ID -> format)
+// Written from the AsyncTCP task, read from loop() and the watchdog task
+std::map<uint32_t, PayloadEncoder::Format> wsClientFormats;
+SemaphoreHandle_t wsClientsMutex = NULL;
+
 // WiFiManager
 WiFiManager wifiManager;
 
+// Largest JSON body a single-resource endpoint accepts
+constexpr size_t MAX_REQUEST_BODY_BYTES = 4096;
+
+// Batch device endpoint limits
+constexpr size_t MAX_BATCH_OPERATIONS = 32;
+constexpr size_t MAX_BATCH_BODY_BYTES = 8192;
+
 // ============================================================================
 // CONFIGURATION LOADER
 // ============================================================================
@@ -78,6 +123,7 @@ void loadConfiguration() {
     // Set defaults
     config.heartbeatEnabled = true;
     config.heartbeatIntervalSec = 30;
+    config.beaconIntervalMs = DEFAULT_BEACON_INTERVAL_MS;
     config.aggressiveMemoryManagement = true;
     config.heapWarningThresholdKB = 50;
     config.psramWarningThresholdKB = 100;
@@ -87,9 +133,17 @@ void loadConfiguration() {
     config.mdnsHostname = "ams";
     config.espnowChannel = 6;
     config.espnowMaxPeers = 20;
+    config.espnowRateAdaptation = true;
+    config.espnowLongRange = false;
     config.debugSerial = true;
     config.debugESPNOW = false;
     config.debugWebSocket = false;
+    config.hubPartner = "";
+    config.hubStandby = false;
+    config.federationGroup = "";
+    config.federationName = "";
+    config.federationPort = FEDERATION_DEFAULT_PORT;
+    config.federationPeers = "";
     
     // Load from file
     if (!LittleFS.exists("/config/hub_config.txt")) {
@@ -130,6 +184,9 @@ void loadConfiguration() {
             config.heartbeatEnabled = (value == "true");
         } else if (key == "HEARTBEAT_INTERVAL_SEC") {
             config.heartbeatIntervalSec = value.toInt();
+        } else if (key == "BEACON_INTERVAL_MS") {
+            long interval = value.toInt();
+            config.beaconIntervalMs = interval < 100 ? 100 : (interval > 10000 ? 10000 : interval);
         } else if (key == "AGGRESSIVE_MEMORY_MANAGEMENT") {
             config.aggressiveMemoryManagement = (value == "true");
         } else if (key == "HEAP_WARNING_THRESHOLD_KB") {
@@ -148,12 +205,28 @@ void loadConfiguration() {
             config.espnowChannel = value.toInt();
         } else if (key == "ESPNOW_MAX_PEERS") {
             config.espnowMaxPeers = value.toInt();
+        } else if (key == "ESPNOW_RATE_ADAPTATION") {
+            config.espnowRateAdaptation = (value == "true");
+        } else if (key == "ESPNOW_LONG_RANGE") {
+            config.espnowLongRange = (value == "true");
         } else if (key == "DEBUG_SERIAL") {
             config.debugSerial = (value == "true");
         } else if (key == "DEBUG_ESPNOW") {
             config.debugESPNOW = (value == "true");
         } else if (key == "DEBUG_WEBSOCKET") {
             config.debugWebSocket = (value == "true");
+        } else if (key == "HUB_PARTNER") {
+            config.hubPartner = value;
+        } else if (key == "HUB_ROLE") {
+            config.hubStandby = (value == "standby");
+        } else if (key == "FEDERATION_GROUP") {
+            config.federationGroup = value;
+        } else if (key == "FEDERATION_NAME") {
+            config.federationName = value;
+        } else if (key == "FEDERATION_PORT") {
+            config.federationPort = value.toInt();
+        } else if (key == "FEDERATION_PEERS") {
+            config.federationPeers = value;
         }
     }
     
@@ -163,9 +236,21 @@ void loadConfiguration() {
     Serial.printf("   - Heartbeat: %s (%ds)\n", 
                   config.heartbeatEnabled ? "ON" : "OFF", 
                   config.heartbeatIntervalSec);
+    Serial.printf("   - Beacon: every %ums\n", config.beaconIntervalMs);
     Serial.printf("   - Memory Management: %s\n", 
                   config.aggressiveMemoryManagement ? "AGGRESSIVE" : "NORMAL");
     Serial.printf("   - mDNS: %s.local\n", config.mdnsHostname.c_str());
+    if (config.hubPartner.length() > 0) {
+        Serial.printf("   - Failover: %s, partner %s\n",
+                      config.hubStandby ? "standby" : "primary", config.hubPartner.c_str());
+    }
+    if (config.federationName.length() == 0) {
+        config.federationName = config.mdnsHostname;
+    }
+    if (config.federationGroup.length() > 0) {
+        Serial.printf("   - Federation: group %s as %s (UDP %u)\n",
+                      config.federationGroup.c_str(), config.federationName.c_str(), config.federationPort);
+    }
 }
 
 // ============================================================================
@@ -224,23 +309,19 @@ void watchdogTask(void* parameter) {
     
     unsigned long lastMemoryCheck = 0;
     unsigned long lastHealthCheck = 0;
-    unsigned long lastWaterCheck = 0;
     
     while (true) {
         unsigned long now = millis();
         
         // Device health monitoring (every 5 seconds)
+        // Stays here rather than on an executor worker: the fail-safe must
+        // not wait behind a flash write, and this task outranks the workers.
+        // Offline alerts are broadcast from a worker.
         if (now - lastHealthCheck >= 5000) {
             lastHealthCheck = now;
             AquariumManager::getInstance().checkDeviceHealth();
         }
         
-        // Water parameter monitoring (every 10 seconds)
-        if (now - lastWaterCheck >= 10000) {
-            lastWaterCheck = now;
-            AquariumManager::getInstance().checkWaterParameters();
-        }
-        
         // Memory monitoring (every 30 seconds)
         if (config.heartbeatEnabled && (now - lastMemoryCheck >= config.heartbeatIntervalSec * 1000)) {
             lastMemoryCheck = now;
@@ -447,10 +528,12 @@ bool loadAquariumsFromFile() {
 }
 
 /**
- * @brief Save aquariums to JSON file
- * @return true if saved successfully
+ * @brief Serialize all aquariums as stored in aquariums.json
+ *
+ * Reads live Aquarium objects, so it runs in the caller's context; only
+ * the resulting text is handed to the executor.
  */
-bool saveAquariumsToFile() {
+String serializeAquariums() {
     JsonDocument doc;
     JsonArray aquariums = doc["aquariums"].to<JsonArray>();
     
@@ -496,24 +579,82 @@ bool saveAquariumsToFile() {
         obj["updatedAt"] = millis();
     }
     
-    // Write to file
-    File file = LittleFS.open("/config/aquariums.json", "w");
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
+
+/**
+ * @brief Write serialized aquariums to aquariums.json
+ * 
+ * Written to a .tmp file and renamed over the old one, so a reset
+ * mid-write leaves the previous file intact.
+ * @return true if saved successfully
+ */
+bool writeAquariumsFile(const String& json) {
+    File file = LittleFS.open("/config/aquariums.json.tmp", "w");
     if (!file) {
-        Serial.println(" Failed to open aquariums.json for writing");
+        Serial.println(" Failed to open aquariums.json.tmp for writing");
         return false;
     }
     
-    if (serializeJson(doc, file) == 0) {
+    size_t written = file.print(json);
+    file.close();
+    
+    if (written != json.length() || !LittleFS.rename("/config/aquariums.json.tmp", "/config/aquariums.json")) {
         Serial.println(" Failed to write aquariums.json");
-        file.close();
+        LittleFS.remove("/config/aquariums.json.tmp");
         return false;
     }
     
-    file.close();
     Serial.println(" Aquariums saved to file");
     return true;
 }
 
+/**
+ * @brief Save aquariums to JSON file
+ * @return true if saved successfully
+ */
+bool saveAquariumsToFile() {
+    return writeAquariumsFile(serializeAquariums());
+}
+
+// Coalescing keys for recurring background jobs (TaskExecutor::submit)
+enum ExecutorKey : uint8_t {
+    KEY_SAVE_AQUARIUMS = 1,
+    KEY_ANALYTICS = 2,
+    KEY_JOURNAL_FLUSH = 3,
+    KEY_WATER_CHECK = 4
+};
+
+static std::shared_ptr<String> pendingAquariumsJson;   // Latest unsaved snapshot
+static portMUX_TYPE pendingAquariumsMux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Snapshot aquariums now, write the file on a background worker
+ *
+ * A burst of edits queues one write; the job takes whichever snapshot is
+ * newest when it runs. KEY_SAVE_AQUARIUMS keeps writes from overlapping:
+ * an edit made during a write runs the job once more after it, so the
+ * file always ends on the latest state.
+ */
+void queueAquariumsSave() {
+    std::shared_ptr<String> snapshot = std::make_shared<String>(serializeAquariums());
+    portENTER_CRITICAL(&pendingAquariumsMux);
+    pendingAquariumsJson.swap(snapshot);
+    portEXIT_CRITICAL(&pendingAquariumsMux);
+    
+    TaskExecutor::getInstance().submit([](const TaskExecutor::JobContext& context) {
+        std::shared_ptr<String> json;
+        portENTER_CRITICAL(&pendingAquariumsMux);
+        json.swap(pendingAquariumsJson);
+        portEXIT_CRITICAL(&pendingAquariumsMux);
+        if (json) {
+            writeAquariumsFile(*json);
+        }
+    }, TaskExecutor::Priority::NORMAL, 0, KEY_SAVE_AQUARIUMS);
+}
+
 /**
  * @brief Get next available aquarium ID
  * @return Next ID (1-255)
@@ -553,40 +694,486 @@ uint8_t getNextAquariumId() {
     return maxId + 1;
 }
 
+// ============================================================================
+// WEBSOCKET TELEMETRY
+// ============================================================================
+
+/**
+ * @brief Send an already-encoded payload to one client
+ * 
+ * MessagePack goes out as a binary frame, JSON as a text frame, so the
+ * browser can tell them apart without a header.
+ */
+void sendEncodedToClient(AsyncWebSocketClient* client, PayloadEncoder::Format format,
+                         const std::vector<uint8_t>& payload) {
+    if (format == PayloadEncoder::Format::MSGPACK) {
+        client->binary(payload.data(), payload.size());
+    } else {
+        client->text((const char*)payload.data(), payload.size());
+    }
+}
+
+/**
+ * @brief Send a document to one client in its negotiated format
+ */
+void sendDocumentToClient(AsyncWebSocketClient* client, PayloadEncoder::Format format,
+                          JsonVariantConst doc) {
+    std::vector<uint8_t> payload;
+    PayloadEncoder::encode(doc, format, payload);
+    sendEncodedToClient(client, format, payload);
+}
+
+/**
+ * @brief Reply to HELLO with the encodings the hub supports
+ */
+void sendHello(AsyncWebSocketClient* client, PayloadEncoder::Format format) {
+    JsonDocument doc;
+    doc["type"] = "HELLO";
+    doc["encoding"] = PayloadEncoder::name(format);
+    JsonArray encodings = doc["encodings"].to<JsonArray>();
+    encodings.add("json");
+    encodings.add("msgpack");
+    sendDocumentToClient(client, format, doc.as<JsonVariantConst>());
+}
+
+/**
+ * @brief Handle a control frame from a dashboard client
+ * 
+ * Clients select their telemetry encoding with
+ * {"type":"HELLO","encoding":"msgpack"}. Control frames are always JSON
+ * text; only hub -> client telemetry switches to binary.
+ */
+void handleWebSocketMessage(AsyncWebSocketClient* client, uint8_t* data, size_t len) {
+    JsonDocument doc;
+    if (deserializeJson(doc, (const char*)data, len)) {
+        return;
+    }
+    
+    String type = doc["type"] | "";
+    
+    if (type == "HELLO") {
+        PayloadEncoder::Format format = PayloadEncoder::fromName(doc["encoding"] | "json");
+        
+        xSemaphoreTake(wsClientsMutex, portMAX_DELAY);
+        wsClientFormats[client->id()] = format;
+        xSemaphoreGive(wsClientsMutex);
+        
+        sendHello(client, format);
+        
+        if (config.debugWebSocket) {
+            Serial.printf("[WS] Client #%u encoding: %s\n", client->id(), PayloadEncoder::name(format));
+        }
+    } else if (config.debugWebSocket) {
+        Serial.printf("[WS] Client #%u sent unhandled '%s'\n", client->id(), type.c_str());
+    }
+}
+
+void onWebSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client,
+                      AwsEventType type, void* arg, uint8_t* data, size_t len) {
+    switch (type) {
+        case WS_EVT_CONNECT:
+            xSemaphoreTake(wsClientsMutex, portMAX_DELAY);
+            wsClientFormats[client->id()] = PayloadEncoder::Format::JSON;
+            xSemaphoreGive(wsClientsMutex);
+            
+            if (config.debugWebSocket) {
+                Serial.printf("[WS] Client #%u connected from %s\n",
+                              client->id(), client->remoteIP().toString().c_str());
+            }
+            break;
+            
+        case WS_EVT_DISCONNECT:
+            xSemaphoreTake(wsClientsMutex, portMAX_DELAY);
+            wsClientFormats.erase(client->id());
+            xSemaphoreGive(wsClientsMutex);
+            
+            if (config.debugWebSocket) {
+                Serial.printf("[WS] Client #%u disconnected\n", client->id());
+            }
+            break;
+            
+        case WS_EVT_DATA: {
+            // Control frames are tiny; ignore anything fragmented
+            AwsFrameInfo* info = (AwsFrameInfo*)arg;
+            if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT) {
+                handleWebSocketMessage(client, data, len);
+            }
+            break;
+        }
+        
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief AquariumManager telemetry sink
+ * 
+ * Wraps the event in {"type", "ts", "data"} and encodes it at most once
+ * per format, however many clients are connected. Clients whose send
+ * queue is full are skipped rather than buffered without bound.
+ */
+void broadcastTelemetry(const String& event, JsonVariantConst data) {
+    if (ws.count() == 0) {
+        return;
+    }
+    
+    JsonDocument envelope;
+    envelope["type"] = event;
+    envelope["ts"] = millis() / 1000;
+    envelope["data"] = data;
+    
+    // Snapshot client list so encoding happens outside the lock
+    std::vector<std::pair<uint32_t, PayloadEncoder::Format>> clients;
+    xSemaphoreTake(wsClientsMutex, portMAX_DELAY);
+    clients.assign(wsClientFormats.begin(), wsClientFormats.end());
+    xSemaphoreGive(wsClientsMutex);
+    
+    std::vector<uint8_t> encoded[2];
+    bool ready[2] = {false, false};
+    
+    for (const auto& entry : clients) {
+        AsyncWebSocketClient* client = ws.client(entry.first);
+        if (!client || !client->canSend()) {
+            continue;
+        }
+        
+        uint8_t slot = (uint8_t)entry.second;
+        if (!ready[slot]) {
+            PayloadEncoder::encode(envelope.as<JsonVariantConst>(), entry.second, encoded[slot]);
+            ready[slot] = true;
+        }
+        
+        sendEncodedToClient(client, entry.second, encoded[slot]);
+    }
+}
+
+/**
+ * @brief Entity tag for a collection in a given encoding
+ * 
+ * Includes the boot ID so versions restarting at 0 after a reboot never
+ * match a tag cached before it.
+ */
+String collectionETag(AquariumManager::Collection collection, PayloadEncoder::Format format) {
+    AquariumManager& manager = AquariumManager::getInstance();
+    char etag[40];
+    snprintf(etag, sizeof(etag), "\"%08x-%u-%s\"",
+             (unsigned)manager.getBootId(),
+             (unsigned)manager.getCollectionVersion(collection),
+             PayloadEncoder::name(format));
+    return String(etag);
+}
+
+/**
+ * @brief Answer 304 if the client already holds the current collection
+ * @param etag Current entity tag
+ * @return true if a 304 was sent and the handler should stop
+ */
+bool sendIfNotModified(AsyncWebServerRequest* request, const String& etag) {
+    if (!request->hasHeader("If-None-Match")) {
+        return false;
+    }
+    
+    const String& presented = request->getHeader("If-None-Match")->value();
+    if (presented != etag && presented != "*") {
+        return false;
+    }
+    
+    AsyncWebServerResponse* response = request->beginResponse(304);
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+    return true;
+}
+
+/**
+ * @brief Serve a /config JSON file in the negotiated format
+ * 
+ * JSON is streamed straight from flash; MessagePack requires a parse and
+ * re-encode, which is still cheaper for the client on slow links.
+ */
+void sendConfigFile(AsyncWebServerRequest* request, const char* path, const char* emptyJson,
+                    AquariumManager::Collection collection) {
+    PayloadEncoder::Format format = PayloadEncoder::negotiate(request);
+    String etag = collectionETag(collection, format);
+    
+    if (sendIfNotModified(request, etag)) {
+        return;
+    }
+    
+    if (!LittleFS.exists(path)) {
+        JsonDocument doc;
+        deserializeJson(doc, emptyJson);
+        PayloadEncoder::send(request, 200, doc.as<JsonVariantConst>(), format, etag);
+        return;
+    }
+    
+    if (format == PayloadEncoder::Format::JSON) {
+        AsyncWebServerResponse* response = request->beginResponse(LittleFS, path, PayloadEncoder::MIME_JSON);
+        response->addHeader("Vary", "Accept");
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
+        return;
+    }
+    
+    File file = LittleFS.open(path, "r");
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+    
+    if (error) {
+        request->send(500, "text/plain", "Corrupt data file");
+        return;
+    }
+    
+    PayloadEncoder::send(request, 200, doc.as<JsonVariantConst>(), format, etag);
+}
+
+/**
+ * @brief Accumulate a (possibly chunked) request body
+ * 
+ * AsyncWebServer delivers large bodies in several onBody calls. The
+ * buffer lives in request->_tempObject, which the server frees with the
+ * request. Content-Length comes from the client, so bodies over maxTotal
+ * are answered with 413 before anything is allocated.
+ * @return true once the complete body is available
+ */
+bool collectRequestBody(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                        size_t index, size_t total,
+                        size_t maxTotal = MAX_REQUEST_BODY_BYTES) {
+    if (total > maxTotal) {
+        if (index == 0) {
+            request->send(413, "application/json", "{\"success\":false,\"error\":\"Body too large\"}");
+        }
+        return false;
+    }
+    
+    if (index == 0) {
+        request->_tempObject = malloc(total + 1);
+    }
+    
+    char* buffer = (char*)request->_tempObject;
+    if (!buffer) {
+        if (index + len == total) {
+            request->send(507, "text/plain", "Out of memory");
+        }
+        return false;
+    }
+    
+    memcpy(buffer + index, data, len);
+    
+    if (index + len < total) {
+        return false;
+    }
+    
+    buffer[total] = '\0';
+    return true;
+}
+
+/**
+ * @brief Map a DeviceConfigStore error to an HTTP error response
+ */
+void sendDeviceOpError(AsyncWebServerRequest* request, DeviceConfigStore::Error error) {
+    int code = 400;
+    switch (error) {
+        case DeviceConfigStore::Error::NOT_FOUND: code = 404; break;
+        case DeviceConfigStore::Error::SEND_FAILED: code = 500; break;
+        case DeviceConfigStore::Error::BUSY: code = 409; break;
+        case DeviceConfigStore::Error::TOO_MANY: code = 503; break;
+        default: break;
+    }
+    
+    JsonDocument doc;
+    doc["success"] = false;
+    doc["error"] = DeviceConfigStore::errorString(error);
+    PayloadEncoder::send(request, code, doc.as<JsonVariantConst>(), PayloadEncoder::Format::JSON);
+}
+
+/**
+ * @brief 202 for a started provisioning transaction, with where to poll it
+ */
+void sendProvisioningAccepted(AsyncWebServerRequest* request, uint32_t id) {
+    JsonDocument doc;
+    doc["success"] = true;
+    doc["transactionId"] = id;
+    doc["state"] = ProvisioningManager::stateString(ProvisioningManager::State::PENDING);
+    doc["poll"] = String("/api/provisioning/") + id;
+    PayloadEncoder::send(request, 202, doc.as<JsonVariantConst>(), PayloadEncoder::Format::JSON);
+}
+
+/**
+ * @brief Provisioning completion: push the outcome to dashboards
+ */
+void notifyProvisioning(const ProvisioningManager::Transaction& transaction) {
+    JsonDocument doc;
+    ProvisioningManager::toJson(transaction, doc.to<JsonObject>());
+    broadcastTelemetry("provisioning", doc.as<JsonVariantConst>());
+}
+
+/**
+ * @brief Last readings a tank received, without asking its sensors
+ */
+void cachedReadingsToJson(const Aquarium* aquarium, JsonObject out) {
+    out["temperature"] = aquarium->getCurrentTemperature();
+    out["ph"] = aquarium->getCurrentPh();
+    out["tds"] = aquarium->getCurrentTds();
+    out["lastUpdate"] = aquarium->getLastSensorUpdate();
+    if (aquarium->getLastSensorUpdate() != 0) {
+        out["ageMs"] = millis() - aquarium->getLastSensorUpdate();
+    }
+}
+
 // ============================================================================
 // WEB SERVER SETUP
 // ============================================================================
 
+/**
+ * @brief Post the "web UI is up" message to the ntfy.sh topic in hub_config.txt
+ */
+void sendStartupNotification() {
+    // Load topic from config file
+    String ntfyTopic = "";
+    File configFile = LittleFS.open("/config/hub_config.txt", "r");
+    if (configFile) {
+        while (configFile.available()) {
+            String line = configFile.readStringUntil('\n');
+            line.trim();
+            if (line.startsWith("NTFY_TOPIC=")) {
+                ntfyTopic = line.substring(String("NTFY_TOPIC=").length());
+                ntfyTopic.trim();
+                break;
+            }
+        }
+        configFile.close();
+    }
+    if (ntfyTopic.length() > 0) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), NTFY_MSG_WEBSERVER_UP, WiFi.localIP().toString().c_str());
+        String url = "https://ntfy.sh/" + ntfyTopic;
+        HTTPClient http;
+        http.begin(url);
+        http.addHeader("Title", "AMS Hub WebUI");
+        int httpCode = http.POST(msg);
+        if (httpCode > 0) {
+            Serial.printf("[ntfy] Notification sent: %s\n", msg);
+        } else {
+            Serial.printf("[ntfy] Notification failed: %d\n", httpCode);
+        }
+        http.end();
+    } else {
+        Serial.println("[ntfy] NTFY_TOPIC not set in config, notification not sent.");
+    }
+}
+
 void setupWebServer() {
     Serial.println(" Starting web server...");
     
+    // WebSocket telemetry (registered before static files so /ws is not
+    // looked up on the filesystem)
+    wsClientsMutex = xSemaphoreCreateMutex();
+    ws.onEvent(onWebSocketEvent);
+    server.addHandler(&ws);
+    AquariumManager::getInstance().setWebSocketCallback(broadcastTelemetry);
+    
+    // REST API ahead of the static handlers, so /api requests never probe
+    // LittleFS; routes are added to the router below
+    server.addHandler(&api);
+    
     // Serve static files from LittleFS
     server.serveStatic("/", LittleFS, "/UI/").setDefaultFile("index.html");
     
     // Serve config directory (read-only)
     server.serveStatic("/config", LittleFS, "/config/");
     
-    // API endpoints (placeholder for future)
-    server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request){
-        String json = "{";
-        json += "\"uptime\":" + String(millis() / 1000) + ",";
-        json += "\"heap_free\":" + String(ESP.getFreeHeap()) + ",";
-        json += "\"psram_free\":" + String(ESP.getFreePsram()) + ",";
-        json += "\"wifi_rssi\":" + String(WiFi.RSSI());
-        json += "}";
-        request->send(200, "application/json", json);
+    // ===== System API Endpoints =====
+    api.on("/status", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        JsonDocument doc;
+        doc["uptime"] = millis() / 1000;
+        doc["heap_free"] = ESP.getFreeHeap();
+        doc["psram_free"] = ESP.getFreePsram();
+        doc["wifi_rssi"] = WiFi.RSSI();
+        doc["ws_clients"] = ws.count();
+        
+        TaskExecutor::Stats exec = TaskExecutor::getInstance().getStats();
+        JsonObject executor = doc["executor"].to<JsonObject>();
+        executor["workers"] = exec.workers;
+        executor["submitted"] = exec.submitted;
+        executor["coalesced"] = exec.coalesced;
+        executor["rejected"] = exec.rejected;
+        executor["executed"] = exec.executed;
+        executor["stolen"] = exec.stolen;
+        executor["late"] = exec.late;
+        executor["queued"] = exec.queued;
+        JsonArray utilization = executor["utilizationPct"].to<JsonArray>();
+        for (uint8_t i = 0; i < exec.workers; i++) {
+            utilization.add(exec.utilizationPct[i]);
+        }
+        executor["avgLatencyUs"] = exec.avgLatencyUs;
+        executor["maxLatencyUs"] = exec.maxLatencyUs;
+        executor["windowMs"] = exec.windowMs;
+        
+        FailoverManager::getInstance().toJson(doc["failover"].to<JsonObject>());
+        PayloadEncoder::send(request, 200, doc.as<JsonVariantConst>());
     });
     
-    server.on("/api/reboot", HTTP_POST, [](AsyncWebServerRequest *request){
+    api.on("/reboot", HTTP_POST, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
         request->send(200, "text/plain", "Rebooting...");
         delay(1000);
         ESP.restart();
     });
     
+    // GET change feed: /api/changes?since=<version>&bootId=<id>
+    // Returns only entities modified after <version>; see changesToJson()
+    api.on("/changes", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        uint32_t since = 0;
+        uint32_t bootId = 0;
+        if (request->hasParam("since")) {
+            since = strtoul(request->getParam("since")->value().c_str(), NULL, 10);
+        }
+        if (request->hasParam("bootId")) {
+            bootId = strtoul(request->getParam("bootId")->value().c_str(), NULL, 10);
+        }
+        
+        JsonDocument doc;
+        AquariumManager::getInstance().changesToJson(since, bootId, doc.to<JsonObject>());
+        PayloadEncoder::send(request, 200, doc.as<JsonVariantConst>());
+    });
+    
+    // GET schedule preview with conflict / redundancy analysis
+    api.on("/timeline", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        uint32_t from = (uint32_t)time(nullptr);
+        if (request->hasParam("from")) {
+            from = strtoul(request->getParam("from")->value().c_str(), NULL, 10);
+        }
+        uint32_t to = from + ScheduleTimeline::DEFAULT_SPAN_SEC;
+        if (request->hasParam("to")) {
+            to = strtoul(request->getParam("to")->value().c_str(), NULL, 10);
+        }
+        
+        if (to <= from || to - from > ScheduleTimeline::MAX_SPAN_SEC) {
+            request->send(400, "application/json",
+                          "{\"error\":\"'to' must be after 'from' and within 7 days\"}");
+            return;
+        }
+        
+        JsonDocument doc;
+        ScheduleTimeline::getInstance().toJson(from, to, doc.to<JsonObject>());
+        PayloadEncoder::send(request, 200, doc.as<JsonVariantConst>());
+    });
+    
     // ===== Aquarium API Endpoints =====
     
     // GET all aquariums
-    server.on("/api/aquariums", HTTP_GET, [](AsyncWebServerRequest *request){
+    api.on("/aquariums", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        PayloadEncoder::Format format = PayloadEncoder::negotiate(request);
+        String etag = collectionETag(AquariumManager::Collection::AQUARIUMS, format);
+        
+        // Idle dashboards poll this; skip rebuilding an unchanged list
+        if (sendIfNotModified(request, etag)) {
+            return;
+        }
+        
         JsonDocument doc;
         JsonArray aquariums = doc["aquariums"].to<JsonArray>();
         
@@ -623,14 +1210,12 @@ void setupWebServer() {
             currentReadings["tds"] = aquarium->getCurrentTds();
         }
         
-        String response;
-        serializeJson(doc, response);
-        request->send(200, "application/json", response);
+        PayloadEncoder::send(request, 200, doc.as<JsonVariantConst>(), format, etag);
     });
     
     // POST create new aquarium
-    server.on("/api/aquariums", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
-        [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
+    api.on("/aquariums", HTTP_POST, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){},
+        [](AsyncWebServerRequest *request, const ApiRouter::Params& params, uint8_t *data, size_t len, size_t index, size_t total){
         
         // Parse JSON body
         JsonDocument doc;
@@ -687,11 +1272,10 @@ void setupWebServer() {
             request->send(500, "text/plain", "Failed to add aquarium to manager");
             return;
         }
+        EventJournal::getInstance().logConfig(EventJournal::Config::AQUARIUM_ADDED, newId);
         
-        // Save to file
-        if (!saveAquariumsToFile()) {
-            Serial.println("  Warning: Failed to save aquariums to file");
-        }
+        // Save to file (background; failures are logged by the writer)
+        queueAquariumsSave();
         
         // Return success with ID
         JsonDocument responseDoc;
@@ -707,11 +1291,10 @@ void setupWebServer() {
     });
     
     // GET single aquarium
-    server.on("^\\/api\\/aquariums\\/([0-9]+)$", HTTP_GET, [](AsyncWebServerRequest *request){
-        String idStr = request->pathArg(0);
-        uint8_t id = idStr.toInt();
+    api.on("/aquariums/{id:uint}", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        uint32_t id = params.getUint("id");
         
-        Aquarium* aquarium = AquariumManager::getInstance().getAquarium(id);
+        Aquarium* aquarium = (id <= 255) ? AquariumManager::getInstance().getAquarium(id) : nullptr;
         if (!aquarium) {
             request->send(404, "text/plain", "Aquarium not found");
             return;
@@ -748,293 +1331,505 @@ void setupWebServer() {
         currentReadings["tds"] = aquarium->getCurrentTds();
         currentReadings["lastUpdate"] = aquarium->getLastSensorUpdate();
         
-        String response;
-        serializeJson(doc, response);
-        request->send(200, "application/json", response);
+        PayloadEncoder::send(request, 200, doc.as<JsonVariantConst>());
     });
     
     // DELETE aquarium
-    server.on("^\\/api\\/aquariums\\/([0-9]+)$", HTTP_DELETE, [](AsyncWebServerRequest *request){
-        String idStr = request->pathArg(0);
-        uint8_t id = idStr.toInt();
+    api.on("/aquariums/{id:uint}", HTTP_DELETE, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        uint32_t id = params.getUint("id");
         
-        if (!AquariumManager::getInstance().removeAquarium(id)) {
+        if (id > 255 || !AquariumManager::getInstance().removeAquarium(id)) {
             request->send(404, "text/plain", "Aquarium not found");
             return;
         }
+        EventJournal::getInstance().logConfig(EventJournal::Config::AQUARIUM_REMOVED, id);
         
         // Save to file
-        saveAquariumsToFile();
+        queueAquariumsSave();
         
         request->send(200, "text/plain", "Aquarium deleted successfully");
-        Serial.printf(" Deleted aquarium ID: %d\\n", id);
+        Serial.printf(" Deleted aquarium ID: %u\\n", id);
     });
     
-    // GET unmapped devices
-    server.on("/api/unmapped-devices", HTTP_GET, [](AsyncWebServerRequest *request){
-        File file = LittleFS.open("/config/unmapped-devices.json", "r");
-        if (!file) {
-            // Return empty list if file doesn't exist
-            request->send(200, "application/json", "{\"unmappedDevices\":[]}");
+    // GET tank readings (id 0 = every tank)
+    // Cached by default; ?fresh=1 asks every sensor now and answers when all
+    // have replied or ?timeoutMs= (default 2000) passes. Concurrent fresh
+    // requests for the same tank share one round of requests.
+    api.on("/tanks/{id:uint}/readings", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        AquariumManager& manager = AquariumManager::getInstance();
+        uint32_t id = params.getUint("id");
+        
+        Aquarium* aquarium = (id != 0 && id <= 255) ? manager.getAquarium(id) : nullptr;
+        if (id != 0 && !aquarium) {
+            request->send(404, "text/plain", "Aquarium not found");
             return;
         }
         
-        String jsonData = file.readString();
-        file.close();
-        
-        request->send(200, "application/json", jsonData);
-    });
-    
-    // GET all devices
-    server.on("/api/devices", HTTP_GET, [](AsyncWebServerRequest *request){
-        File file = LittleFS.open("/config/devices.json", "r");
-        if (!file) {
-            // Return empty list if file doesn't exist
-            request->send(200, "application/json", "{\"devices\":[]}");
+        bool fresh = request->hasParam("fresh") && request->getParam("fresh")->value() == "1";
+        if (!fresh) {
+            JsonDocument doc;
+            doc["tankId"] = id;
+            doc["fresh"] = false;
+            if (aquarium) {
+                cachedReadingsToJson(aquarium, doc["readings"].to<JsonObject>());
+            } else {
+                JsonArray tanks = doc["tanks"].to<JsonArray>();
+                for (Aquarium* each : manager.getAllAquariums()) {
+                    JsonObject tank = tanks.add<JsonObject>();
+                    tank["tankId"] = each->getId();
+                    cachedReadingsToJson(each, tank["readings"].to<JsonObject>());
+                }
+            }
+            PayloadEncoder::send(request, 200, doc.as<JsonVariantConst>());
             return;
         }
         
-        String jsonData = file.readString();
-        file.close();
+        uint32_t timeoutMs = AquariumManager::GATHER_DEFAULT_TIMEOUT_MS;
+        if (request->hasParam("timeoutMs")) {
+            timeoutMs = strtoul(request->getParam("timeoutMs")->value().c_str(), nullptr, 10);
+        }
         
-        request->send(200, "application/json", jsonData);
+        // Held open until the gather completes (the filler is re-polled by the server)
+        std::shared_ptr<AquariumManager::ReadingGather> gather = manager.gatherReadings(id, timeoutMs);
+        std::shared_ptr<String> body = std::make_shared<String>();
+        request->send(request->beginChunkedResponse(PayloadEncoder::MIME_JSON,
+            [gather, body](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                if (!gather->isComplete()) {
+                    return RESPONSE_TRY_AGAIN;
+                }
+                if (body->length() == 0) {
+                    JsonDocument doc;
+                    gather->toJson(doc.to<JsonObject>());
+                    serializeJson(doc, *body);
+                }
+                if (index >= body->length()) {
+                    return 0;
+                }
+                size_t len = body->length() - index;
+                if (len > maxLen) {
+                    len = maxLen;
+                }
+                memcpy(buffer, body->c_str() + index, len);
+                return len;
+            }));
+    });
+    
+    // GET unmapped devices
+    api.on("/unmapped-devices", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        sendConfigFile(request, "/config/unmapped-devices.json", "{\"unmappedDevices\":[]}",
+                       AquariumManager::Collection::UNMAPPED);
+    });
+    
+    // GET all devices
+    api.on("/devices", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        sendConfigFile(request, "/config/devices.json", "{\"devices\":[]}",
+                       AquariumManager::Collection::DEVICES);
     });
     
     // POST provision device
-    server.on("/api/provision-device", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
-        [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
+    api.on("/provision-device", HTTP_POST, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){},
+        [](AsyncWebServerRequest *request, const ApiRouter::Params& params, uint8_t *data, size_t len, size_t index, size_t total){
         if (index == 0) {
             Serial.println(" Received provision-device request");
         }
         
-        if (index + len == total) {
-            // Parse JSON
-            DynamicJsonDocument doc(1024);
-            DeserializationError error = deserializeJson(doc, data, len);
-            
-            if (error) {
-                Serial.printf(" JSON parse error: %s\n", error.c_str());
-                request->send(400, "application/json", "{\"success\":false,\"error\":\"Invalid JSON\"}");
-                return;
-            }
-            
-            // Extract device info
-            String macStr = doc["mac"].as<String>();
-            String deviceName = doc["name"].as<String>();
-            uint8_t tankId = doc["tankId"];
-            
-            Serial.printf(" Provisioning device: %s -> %s (Tank %d)\n",
-                         macStr.c_str(), deviceName.c_str(), tankId);
-            
-            // Convert MAC string to bytes
-            uint8_t mac[6];
-            if (sscanf(macStr.c_str(), "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
-                      &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]) != 6) {
-                request->send(400, "application/json", "{\"success\":false,\"error\":\"Invalid MAC address\"}");
-                return;
-            }
-            
-            // Load unmapped devices
-            File unmappedFile = LittleFS.open("/config/unmapped-devices.json", "r");
-            if (!unmappedFile) {
-                request->send(404, "application/json", "{\"success\":false,\"error\":\"Unmapped devices file not found\"}");
-                return;
-            }
-            
-            DynamicJsonDocument unmappedDoc(4096);
-            deserializeJson(unmappedDoc, unmappedFile);
-            unmappedFile.close();
-            
-            // Find device in unmapped list
-            JsonArray unmappedDevices = unmappedDoc["unmappedDevices"];
-            int foundIndex = -1;
-            JsonObject foundDevice;
-            
-            for (size_t i = 0; i < unmappedDevices.size(); i++) {
-                if (unmappedDevices[i]["mac"].as<String>() == macStr) {
-                    foundIndex = i;
-                    foundDevice = unmappedDevices[i];
-                    break;
-                }
-            }
-            
-            if (foundIndex == -1) {
-                request->send(404, "application/json", "{\"success\":false,\"error\":\"Device not found in unmapped list\"}");
-                return;
-            }
-            
-            // Send CONFIG message to node
-            ConfigMessage configMsg = {};
-            configMsg.header.type = MessageType::CONFIG;
-            configMsg.header.tankId = tankId;
-            configMsg.header.nodeType = NodeType::HUB;
-            configMsg.header.timestamp = millis();
-            configMsg.header.sequenceNum = 0;
-            strncpy(configMsg.deviceName, deviceName.c_str(), MAX_NODE_NAME_LEN - 1);
-            
-            bool sent = ESPNowManager::getInstance().send(mac, (uint8_t*)&configMsg, sizeof(configMsg));
-            
-            if (!sent) {
-                Serial.println(" Failed to send CONFIG message");
-                request->send(500, "application/json", "{\"success\":false,\"error\":\"Failed to send CONFIG to device\"}");
-                return;
-            }
-            
-            Serial.println(" CONFIG message sent to device");
-            
-            // Remove from unmapped devices
-            unmappedDevices.remove(foundIndex);
-            
-            // Save updated unmapped devices
-            unmappedFile = LittleFS.open("/config/unmapped-devices.json", "w");
-            serializeJson(unmappedDoc, unmappedFile);
-            unmappedFile.close();
-            
-            // Add to devices.json
-            File devicesFile = LittleFS.open("/config/devices.json", "r");
-            DynamicJsonDocument devicesDoc(8192);
-            if (devicesFile) {
-                deserializeJson(devicesDoc, devicesFile);
-                devicesFile.close();
-            }
-            
-            JsonArray devices = devicesDoc["devices"];
-            JsonObject newDevice = devices.createNestedObject();
-            newDevice["mac"] = macStr;
-            newDevice["type"] = foundDevice["type"];
-            newDevice["name"] = deviceName;
-            newDevice["tankId"] = tankId;
-            newDevice["firmwareVersion"] = foundDevice["firmwareVersion"];
-            newDevice["enabled"] = true;
-            newDevice["status"] = "PROVISIONING";
-            
-            devicesFile = LittleFS.open("/config/devices.json", "w");
-            serializeJson(devicesDoc, devicesFile);
-            devicesFile.close();
-            
-            Serial.printf(" Device provisioned: %s\n", deviceName.c_str());
-            
-            // Send success response
-            String response = "{\"success\":true,\"device\":{";
-            response += "\"mac\":\"" + macStr + "\",";
-            response += "\"name\":\"" + deviceName + "\",";
-            response += "\"tankId\":" + String(tankId) + ",";
-            response += "\"status\":\"PROVISIONED\"";
-            response += "}}";
-            
-            request->send(200, "application/json", response);
+        if (!collectRequestBody(request, data, len, index, total)) {
+            return;
+        }
+        
+        JsonDocument doc;
+        DeserializationError error = deserializeJson(doc, (const char*)request->_tempObject, total);
+        
+        if (error) {
+            Serial.printf(" JSON parse error: %s\n", error.c_str());
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"Invalid JSON\"}");
+            return;
+        }
+        
+        // Extract device info
+        String macStr = doc["mac"].as<String>();
+        String deviceName = doc["name"].as<String>();
+        uint8_t tankId = doc["tankId"];
+        
+        Serial.printf(" Provisioning device: %s -> %s (Tank %d)\n",
+                     macStr.c_str(), deviceName.c_str(), tankId);
+        
+        // Committed only once the node confirms; poll the returned transaction
+        DeviceConfigStore::Error opError;
+        uint32_t id = ProvisioningManager::getInstance().beginProvision(
+            macStr, deviceName, tankId, opError, notifyProvisioning);
+        if (id == 0) {
+            sendDeviceOpError(request, opError);
+            return;
         }
+        
+        sendProvisioningAccepted(request, id);
     });
     
     // POST unmap device
-    server.on("/api/unmap-device", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
-        [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
+    api.on("/unmap-device", HTTP_POST, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){},
+        [](AsyncWebServerRequest *request, const ApiRouter::Params& params, uint8_t *data, size_t len, size_t index, size_t total){
         if (index == 0) {
             Serial.println(" Received unmap-device request");
         }
         
-        if (index + len == total) {
-            // Parse JSON
-            DynamicJsonDocument doc(512);
-            DeserializationError error = deserializeJson(doc, data, len);
+        if (!collectRequestBody(request, data, len, index, total)) {
+            return;
+        }
+        
+        JsonDocument doc;
+        DeserializationError error = deserializeJson(doc, (const char*)request->_tempObject, total);
+        
+        if (error) {
+            Serial.printf(" JSON parse error: %s\n", error.c_str());
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"Invalid JSON\"}");
+            return;
+        }
+        
+        String macStr = doc["mac"].as<String>();
+        Serial.printf(" Unmapping device: %s\n", macStr.c_str());
+        
+        DeviceConfigStore::Error opError;
+        uint32_t id = ProvisioningManager::getInstance().beginUnmap(macStr, opError, notifyProvisioning);
+        if (id == 0) {
+            sendDeviceOpError(request, opError);
+            return;
+        }
+        
+        sendProvisioningAccepted(request, id);
+    });
+    
+    // GET provisioning transactions (all, or one by ID)
+    api.on("/provisioning", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        JsonDocument doc;
+        ProvisioningManager::getInstance().toJson(doc["transactions"].to<JsonArray>());
+        PayloadEncoder::send(request, 200, doc.as<JsonVariantConst>());
+    });
+    
+    api.on("/provisioning/{id:uint}", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        ProvisioningManager::Transaction transaction;
+        if (!ProvisioningManager::getInstance().get(params.getUint("id"), transaction)) {
+            request->send(404, "application/json", "{\"success\":false,\"error\":\"Unknown or expired transaction\"}");
+            return;
+        }
+        
+        JsonDocument doc;
+        ProvisioningManager::toJson(transaction, doc.to<JsonObject>());
+        PayloadEncoder::send(request, 200, doc.as<JsonVariantConst>());
+    });
+    
+    // POST batch of device operations (provision/unmap/rename/move)
+    // Body: {"operations":[{"op":"provision","mac":"..","name":"..","tankId":1}, ...]}
+    // Provision and unmap start one confirmed transaction each; renames and
+    // moves are applied to one store load and written once.
+    api.on("/devices/batch", HTTP_POST, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){},
+        [](AsyncWebServerRequest *request, const ApiRouter::Params& params, uint8_t *data, size_t len, size_t index, size_t total){
+        if (!collectRequestBody(request, data, len, index, total, MAX_BATCH_BODY_BYTES)) {
+            return;
+        }
+        
+        JsonDocument doc;
+        DeserializationError error = deserializeJson(doc, (const char*)request->_tempObject, total);
+        JsonArray operations = doc["operations"];
+        
+        if (error || operations.isNull()) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"Expected {operations:[...]}\"}");
+            return;
+        }
+        
+        if (operations.size() > MAX_BATCH_OPERATIONS) {
+            request->send(413, "application/json", "{\"success\":false,\"error\":\"Too many operations\"}");
+            return;
+        }
+        
+        Serial.printf(" Batch device request: %u operations\n", operations.size());
+        
+        DeviceConfigStore store;
+        store.load();
+        ProvisioningManager& provisioning = ProvisioningManager::getInstance();
+        
+        JsonDocument responseDoc;
+        JsonArray results = responseDoc["results"].to<JsonArray>();
+        JsonArray transactions = responseDoc["transactions"].to<JsonArray>();
+        uint16_t applied = 0;       // Direct edits
+        uint16_t started = 0;       // Transactions
+        
+        for (size_t i = 0; i < operations.size(); i++) {
+            JsonObject op = operations[i];
+            String type = op["op"] | "";
+            String macStr = op["mac"] | "";
             
-            if (error) {
-                Serial.printf(" JSON parse error: %s\n", error.c_str());
-                request->send(400, "application/json", "{\"success\":false,\"error\":\"Invalid JSON\"}");
-                return;
-            }
+            JsonObject item = results.add<JsonObject>();
+            item["index"] = i;
+            item["op"] = type;
+            item["mac"] = macStr;
             
-            // Extract device MAC
-            String macStr = doc["mac"].as<String>();
-            Serial.printf(" Unmapping device: %s\n", macStr.c_str());
+            // Same path as /provision-device and /unmap-device: committed
+            // only once the node confirms, one open transaction per MAC
+            if (type == "provision" || type == "unmap") {
+                DeviceConfigStore::Error opError;
+                uint32_t id = type == "provision"
+                    ? provisioning.beginProvision(macStr, op["name"] | "", op["tankId"] | 0,
+                                                  opError, notifyProvisioning, &store)
+                    : provisioning.beginUnmap(macStr, opError, notifyProvisioning, &store);
+                item["success"] = id != 0;
+                if (id != 0) {
+                    item["transactionId"] = id;
+                    item["state"] = ProvisioningManager::stateString(ProvisioningManager::State::PENDING);
+                    transactions.add(id);
+                    started++;
+                } else {
+                    item["error"] = DeviceConfigStore::errorString(opError);
+                }
+                continue;
+            }
             
-            // Convert MAC string to bytes
+            DeviceConfigStore::Result result;
+            bool knownOp = type == "rename" || type == "move";
             uint8_t mac[6];
-            if (sscanf(macStr.c_str(), "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
-                      &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]) != 6) {
-                request->send(400, "application/json", "{\"success\":false,\"error\":\"Invalid MAC address\"}");
-                return;
+            if (!knownOp) {
+                result.error = DeviceConfigStore::Error::INVALID_ARGUMENT;
+            } else if (DeviceConfigStore::parseMac(macStr, mac) && provisioning.isPending(mac)) {
+                result.error = DeviceConfigStore::Error::BUSY;
+            } else if (type == "rename") {
+                result = store.rename(macStr, op["name"] | "");
+            } else {
+                result = store.move(macStr, op["tankId"] | 0);
             }
             
-            // Load devices.json
-            File devicesFile = LittleFS.open("/config/devices.json", "r");
-            if (!devicesFile) {
-                request->send(404, "application/json", "{\"success\":false,\"error\":\"Devices file not found\"}");
-                return;
+            item["success"] = result.ok();
+            if (result.ok()) {
+                item["status"] = result.status;
+                item["frameSent"] = result.frameSent;
+                applied++;
+            } else {
+                item["error"] = knownOp ? DeviceConfigStore::errorString(result.error) : "Unknown operation";
             }
-            
-            DynamicJsonDocument devicesDoc(8192);
-            deserializeJson(devicesDoc, devicesFile);
-            devicesFile.close();
-            
-            // Find and remove device
-            JsonArray devices = devicesDoc["devices"];
-            int foundIndex = -1;
-            JsonObject foundDevice;
-            
-            for (size_t i = 0; i < devices.size(); i++) {
-                if (devices[i]["mac"].as<String>() == macStr) {
-                    foundIndex = i;
-                    foundDevice = devices[i];
-                    break;
+        }
+        
+        // Single write per file for the direct edits
+        bool persisted = applied == 0 || store.commit();
+        uint16_t accepted = applied + started;
+        
+        responseDoc["success"] = persisted && accepted == operations.size();
+        responseDoc["applied"] = applied;
+        responseDoc["pending"] = started;
+        responseDoc["failed"] = operations.size() - accepted;
+        responseDoc["persisted"] = persisted;
+        
+        Serial.printf(" Batch complete: %u applied, %u pending, %u failed\n",
+                      applied, started, operations.size() - accepted);
+        
+        int code = !persisted ? 500 :
+                   accepted != operations.size() ? 207 :
+                   started > 0 ? 202 : 200;
+        PayloadEncoder::send(request, code, responseDoc.as<JsonVariantConst>());
+    });
+    
+    // GET federation: this hub and the other hubs of its group
+    api.on("/federation", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        JsonDocument doc;
+        FederationManager::getInstance().toJson(doc.to<JsonObject>());
+        PayloadEncoder::send(request, 200, doc.as<JsonVariantConst>());
+    });
+    
+    // GET every device of the federation; remote ones carry "hub" and "local": false
+    api.on("/federation/devices", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        JsonDocument doc;
+        JsonArray devices = doc["devices"].to<JsonArray>();
+        for (Device* device : AquariumManager::getInstance().getAllDevices()) {
+            JsonObject obj = devices.add<JsonObject>();
+            device->toJsonObject(obj);
+            obj["hub"] = config.federationName;
+            obj["local"] = true;
+        }
+        FederationManager::getInstance().remoteDevicesToJson(devices);
+        PayloadEncoder::send(request, 200, doc.as<JsonVariantConst>());
+    });
+    
+    // POST a command to any device of the federation
+    // Body: {"data":[opcode, args...]} (protocol/commands.h encoding)
+    // Answered once the local send or the owning hub's RESULT is in
+    api.on("/devices/{mac:mac}/command", HTTP_POST, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){},
+        [](AsyncWebServerRequest *request, const ApiRouter::Params& params, uint8_t *data, size_t len, size_t index, size_t total){
+        if (!collectRequestBody(request, data, len, index, total)) {
+            return;
+        }
+        
+        if (!FailoverManager::getInstance().isActive()) {
+            request->send(503, "application/json", "{\"success\":false,\"error\":\"Standby hub\"}");
+            return;
+        }
+        
+        JsonDocument doc;
+        DeserializationError error = deserializeJson(doc, (const char*)request->_tempObject, total);
+        JsonArray bytes = doc["data"];
+        if (error || bytes.isNull() || bytes.size() == 0 || bytes.size() > MAX_COMMAND_DATA_LEN) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"Expected {data:[1-32 bytes]}\"}");
+            return;
+        }
+        
+        uint8_t command[MAX_COMMAND_DATA_LEN];
+        for (size_t i = 0; i < bytes.size(); i++) {
+            command[i] = bytes[i].as<uint8_t>();
+        }
+        
+        std::shared_ptr<FederationManager::RoutedCommand> routed =
+            FederationManager::getInstance().routeCommand(params.getMac("mac"), command, bytes.size());
+        std::shared_ptr<String> body = std::make_shared<String>();
+        request->send(request->beginChunkedResponse(PayloadEncoder::MIME_JSON,
+            [routed, body](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                if (!routed->isComplete()) {
+                    return RESPONSE_TRY_AGAIN;
+                }
+                if (body->length() == 0) {
+                    JsonDocument result;
+                    routed->toJson(result.to<JsonObject>());
+                    serializeJson(result, *body);
                 }
+                if (index >= body->length()) {
+                    return 0;
+                }
+                size_t len = body->length() - index;
+                if (len > maxLen) {
+                    len = maxLen;
+                }
+                memcpy(buffer, body->c_str() + index, len);
+                return len;
+            }));
+    });
+    
+    // GET sensor calibrations and history (?mac= for one node)
+    api.on("/sensors/calibration", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        String macStr = request->hasParam("mac") ? request->getParam("mac")->value() : String();
+        
+        CalibrationStore store;
+        store.load();
+        
+        JsonDocument doc;
+        store.toJson(doc["calibrations"].to<JsonArray>(), macStr);
+        PayloadEncoder::send(request, 200, doc.as<JsonVariantConst>());
+    });
+    
+    // POST multi-point calibration for one probe
+    // Body: {"mac":"..","probe":"ph","refTempC":25.0,
+    //        "points":[{"reference":4.01,"raw":702},{"reference":6.86,"raw":515}, ...]}
+    // raw is the ADC count the node reported (STATUS bytes 6-9) in each buffer.
+    api.on("/sensors/calibration", HTTP_POST, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){},
+        [](AsyncWebServerRequest *request, const ApiRouter::Params& params, uint8_t *data, size_t len, size_t index, size_t total){
+        if (!collectRequestBody(request, data, len, index, total)) {
+            return;
+        }
+        
+        JsonDocument doc;
+        DeserializationError error = deserializeJson(doc, (const char*)request->_tempObject, total);
+        
+        if (error) {
+            Serial.printf(" JSON parse error: %s\n", error.c_str());
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"Invalid JSON\"}");
+            return;
+        }
+        
+        CalibrationStore::Result result;
+        SensorCalibration::Probe probe;
+        JsonArray pointsJson = doc["points"].as<JsonArray>();
+        SensorCalibration::CalPoint points[SensorCalibration::MAX_POINTS];
+        uint8_t count = 0;
+        
+        if (!CalibrationStore::parseProbe(doc["probe"] | "", probe)) {
+            result.error = CalibrationStore::Error::INVALID_PROBE;
+        } else if (pointsJson.size() > SensorCalibration::MAX_POINTS) {
+            result.error = CalibrationStore::Error::INVALID_POINTS;
+        } else {
+            for (JsonObject point : pointsJson) {
+                points[count].reference = point["reference"] | -1.0f;
+                points[count].raw = point["raw"] | 0;
+                count++;
             }
-            
-            if (foundIndex == -1) {
-                request->send(404, "application/json", "{\"success\":false,\"error\":\"Device not found\"}");
+        }
+        
+        String macStr = doc["mac"].as<String>();
+        CalibrationStore store;
+        store.load();
+        if (result.ok()) {
+            result = store.apply(macStr, probe, points, count, doc["refTempC"] | 25.0f);
+        }
+        
+        JsonDocument responseDoc;
+        if (!result.ok()) {
+            responseDoc["success"] = false;
+            responseDoc["error"] = CalibrationStore::errorString(result.error);
+            int code = result.error == CalibrationStore::Error::SEND_FAILED ? 500 : 400;
+            PayloadEncoder::send(request, code, responseDoc.as<JsonVariantConst>(), PayloadEncoder::Format::JSON);
+            return;
+        }
+        
+        bool persisted = store.commit();
+        responseDoc["success"] = true;
+        responseDoc["persisted"] = persisted;
+        responseDoc["slope"] = result.slope;
+        responseDoc["offset"] = result.offset;
+        responseDoc["slopeDriftPct"] = result.slopeDriftPct;
+        responseDoc["offsetDrift"] = result.offsetDrift;
+        PayloadEncoder::send(request, 200, responseDoc.as<JsonVariantConst>(), PayloadEncoder::Format::JSON);
+    });
+    
+    // GET per-tank daily analytics (?tankId= for one tank, ?days= per tank)
+    api.on("/analytics", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        uint8_t tankId = request->hasParam("tankId") ? request->getParam("tankId")->value().toInt() : 0;
+        long days = request->hasParam("days") ? request->getParam("days")->value().toInt() :
+                                                AnalyticsManager::DEFAULT_DAYS;
+        if (days < 1 || days > AnalyticsManager::RING_CAPACITY) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"days out of range\"}");
+            return;
+        }
+        
+        JsonDocument doc;
+        AnalyticsManager::getInstance().toJson(doc.to<JsonObject>(), tankId, (uint16_t)days);
+        PayloadEncoder::send(request, 200, doc.as<JsonVariantConst>());
+    });
+    
+    // GET event journal (?from=&to= epoch, ?device=MAC, ?tankId=, ?type=, ?limit=)
+    // Streamed in chunks straight from flash, oldest first
+    api.on("/events", HTTP_GET, [](AsyncWebServerRequest *request, const ApiRouter::Params& params){
+        EventJournal::Filter filter;
+        if (request->hasParam("from")) {
+            filter.from = strtoul(request->getParam("from")->value().c_str(), nullptr, 10);
+        }
+        if (request->hasParam("to")) {
+            filter.to = strtoul(request->getParam("to")->value().c_str(), nullptr, 10);
+        }
+        if (request->hasParam("tankId")) {
+            filter.tankId = request->getParam("tankId")->value().toInt();
+        }
+        if (request->hasParam("device")) {
+            if (!DeviceConfigStore::parseMac(request->getParam("device")->value(), filter.mac)) {
+                request->send(400, "application/json", "{\"success\":false,\"error\":\"invalid device MAC\"}");
                 return;
             }
-            
-            // Send UNMAP message to node
-            UnmapMessage unmapMsg = {};
-            unmapMsg.header.type = MessageType::UNMAP;
-            unmapMsg.header.tankId = 0;  // Reset to unmapped
-            unmapMsg.header.nodeType = NodeType::HUB;
-            unmapMsg.header.timestamp = millis();
-            unmapMsg.header.sequenceNum = 0;
-            unmapMsg.reason = 1;  // User-initiated unmap
-            
-            bool sent = ESPNowManager::getInstance().send(mac, (uint8_t*)&unmapMsg, sizeof(unmapMsg));
-            
-            if (sent) {
-                Serial.println(" UNMAP message sent to device");
-            } else {
-                Serial.println(" Warning: Failed to send UNMAP message (device may be offline)");
-            }
-            
-            // Remove from devices.json
-            devices.remove(foundIndex);
-            
-            devicesFile = LittleFS.open("/config/devices.json", "w");
-            serializeJson(devicesDoc, devicesFile);
-            devicesFile.close();
-            
-            // Add back to unmapped devices
-            File unmappedFile = LittleFS.open("/config/unmapped-devices.json", "r");
-            DynamicJsonDocument unmappedDoc(4096);
-            if (unmappedFile) {
-                deserializeJson(unmappedDoc, unmappedFile);
-                unmappedFile.close();
+            filter.matchMac = true;
+        }
+        if (request->hasParam("type") &&
+            !EventJournal::parseType(request->getParam("type")->value(), filter.type)) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"unknown event type\"}");
+            return;
+        }
+        if (request->hasParam("limit")) {
+            long limit = request->getParam("limit")->value().toInt();
+            if (limit < 1 || limit > EventJournal::MAX_QUERY_LIMIT) {
+                request->send(400, "application/json", "{\"success\":false,\"error\":\"limit out of range\"}");
+                return;
             }
-            
-            JsonArray unmappedDevices = unmappedDoc["unmappedDevices"];
-            JsonObject newUnmapped = unmappedDevices.createNestedObject();
-            newUnmapped["mac"] = macStr;
-            newUnmapped["type"] = foundDevice["type"];
-            newUnmapped["firmwareVersion"] = foundDevice["firmwareVersion"];
-            newUnmapped["discoveredAt"] = millis();
-            newUnmapped["announceCount"] = 0;
-            
-            unmappedFile = LittleFS.open("/config/unmapped-devices.json", "w");
-            serializeJson(unmappedDoc, unmappedFile);
-            unmappedFile.close();
-            
-            Serial.printf(" Device unmapped: %s\n", macStr.c_str());
-            
-            // Send success response
-            String response = "{\"success\":true,\"message\":\"Device unmapped successfully\"}";
-            request->send(200, "application/json", response);
+            filter.limit = (uint16_t)limit;
         }
+        
+        // Queued records become visible to this query
+        EventJournal::getInstance().flush(true);
+        std::shared_ptr<EventJournal::Query> query = EventJournal::getInstance().query(filter);
+        request->send(request->beginChunkedResponse(PayloadEncoder::MIME_JSON,
+            [query](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                return query->read(buffer, maxLen);
+            }));
     });
     
     // 404 handler
@@ -1049,39 +1844,10 @@ void setupWebServer() {
     Serial.printf("   - Access: http://%s.local\n", config.mdnsHostname.c_str());
     Serial.printf("   - Or: http://%s\n", WiFi.localIP().toString().c_str());
 
-    // --- ntfy.sh notification ---
-    // Load topic from config file
-    String ntfyTopic = "";
-    File configFile = LittleFS.open("/config/hub_config.txt", "r");
-    if (configFile) {
-        while (configFile.available()) {
-            String line = configFile.readStringUntil('\n');
-            line.trim();
-            if (line.startsWith("NTFY_TOPIC=")) {
-                ntfyTopic = line.substring(String("NTFY_TOPIC=").length());
-                ntfyTopic.trim();
-                break;
-            }
-        }
-        configFile.close();
-    }
-    if (ntfyTopic.length() > 0) {
-        char msg[128];
-        snprintf(msg, sizeof(msg), NTFY_MSG_WEBSERVER_UP, WiFi.localIP().toString().c_str());
-        String url = "https://ntfy.sh/" + ntfyTopic;
-        HTTPClient http;
-        http.begin(url);
-        http.addHeader("Title", "AMS Hub WebUI");
-        int httpCode = http.POST(msg);
-        if (httpCode > 0) {
-            Serial.printf("[ntfy] Notification sent: %s\n", msg);
-        } else {
-            Serial.printf("[ntfy] Notification failed: %d\n", httpCode);
-        }
-        http.end();
-    } else {
-        Serial.println("[ntfy] NTFY_TOPIC not set in config, notification not sent.");
-    }
+    // ntfy.sh "UI is up" notification: a blocking HTTPS POST, so it runs on a worker
+    TaskExecutor::getInstance().submit([](const TaskExecutor::JobContext& context) {
+        sendStartupNotification();
+    }, TaskExecutor::Priority::BACKGROUND);
 }
 
 // ============================================================================
@@ -1089,6 +1855,11 @@ void setupWebServer() {
 // ============================================================================
 
 void onAnnounceReceived(const uint8_t* mac, const AnnounceMessage& msg) {
+    // Nodes belong to the active hub; a standby must not ACK them away
+    if (!FailoverManager::getInstance().isActive()) {
+        return;
+    }
+    
     if (config.debugESPNOW) {
         Serial.println("");
         Serial.printf("  ANNOUNCE from %02X:%02X:%02X:%02X:%02X:%02X\n",
@@ -1101,22 +1872,28 @@ void onAnnounceReceived(const uint8_t* mac, const AnnounceMessage& msg) {
         Serial.println("");
     }
     
+    // Add peer and agree on a protocol before AquariumManager ACKs it
+    ESPNowManager::getInstance().addPeer(mac);
+    ESPNowManager::getInstance().setPeerPowerSave(mac, (msg.capabilities & NODE_CAP_POWER_SAVE) != 0);
+    ESPNowManager::getInstance().setPeerLongRange(mac, (msg.capabilities & NODE_CAP_LONG_RANGE) != 0);
+    ESPNowManager::getInstance().negotiateProtocol(mac, msg.protocol);
+    
     // Forward to AquariumManager
     AquariumManager::getInstance().handleAnnounce(mac, msg);
     
-    // Add peer and send ACK
-    ESPNowManager::getInstance().addPeer(mac);
-    
-    AckMessage ack = {};
+    // Send ACK
+    AckProtocolMessage frame = {};
+    AckMessage& ack = frame.ack;
     ack.header.type = MessageType::ACK;
     ack.header.tankId = msg.header.tankId;
     ack.header.nodeType = NodeType::HUB;
     ack.header.timestamp = millis();
     ack.header.sequenceNum = 0;
-    ack.assignedNodeId = 1;  // Simple assignment for now
+    ack.assignedNodeId = ESPNowManager::getInstance().assignSlot(mac);  // Beacon slot
     ack.accepted = true;
     
-    ESPNowManager::getInstance().send(mac, (uint8_t*)&ack, sizeof(ack));
+    size_t ackLen = ESPNowManager::getInstance().completeAck(mac, frame);
+    ESPNowManager::getInstance().send(mac, (uint8_t*)&frame, ackLen);
     
     if (config.debugESPNOW) {
         Serial.printf(" ACK sent to device\n\n");
@@ -1138,6 +1915,18 @@ void onHeartbeatReceived(const uint8_t* mac, const HeartbeatMessage& msg) {
     AquariumManager::getInstance().handleHeartbeat(mac, msg);
 }
 
+void onHeartbeatDiagnostics(const uint8_t* mac, const HeartbeatDiagnostics& diagnostics) {
+    if (config.debugESPNOW) {
+        Serial.printf(" DIAG from %02X:%02X:%02X:%02X:%02X:%02X | "
+                      "Cmds: %u | Handler: avg %uus max %uus | Latency: avg %uus max %uus\n",
+                      mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
+                      diagnostics.commandsHandled, diagnostics.handlerAvgUs, diagnostics.handlerMaxUs,
+                      diagnostics.latencyAvgUs, diagnostics.latencyMaxUs);
+    }
+    
+    AquariumManager::getInstance().handleHeartbeatDiagnostics(mac, diagnostics);
+}
+
 void onStatusReceived(const uint8_t* mac, const StatusMessage& msg) {
     if (config.debugESPNOW) {
         Serial.println("");
@@ -1165,9 +1954,24 @@ void onStatusReceived(const uint8_t* mac, const StatusMessage& msg) {
             Serial.println();
         }
         
+        // Deep-sleeping sensor: batch header carries the node's cycle cost
+        if (msg.header.nodeType == NodeType::SENSOR &&
+            msg.statusLen >= sizeof(SensorProtocol::BatchHeader) &&
+            msg.statusData[0] == SensorProtocol::READINGS_BATCH) {
+            SensorProtocol::BatchHeader batch;
+            memcpy(&batch, msg.statusData, sizeof(batch));
+            Serial.printf(" Batch: %u samples @ %us | cycle %u ms awake, ~%u uA avg\n",
+                          batch.count, batch.intervalSec, batch.cycleAwakeMs, batch.cycleAvgMicroAmps);
+        }
+        
         Serial.println("");
     }
     
+    // CONFIG / UNMAP confirmations settle provisioning transactions
+    if (ProvisioningManager::getInstance().handleStatus(mac, msg)) {
+        return;
+    }
+    
     // Forward to AquariumManager
     AquariumManager::getInstance().handleStatus(mac, msg);
 }
@@ -1180,13 +1984,47 @@ void onCommandReceived(const uint8_t* mac, const uint8_t* data, size_t len) {
     }
 }
 
+void onBeaconIdentity(const uint8_t* mac, const BeaconIdentity& identity) {
+    FailoverManager::getInstance().handleBeaconIdentity(mac, identity);
+}
+
+void onReplicationReceived(const uint8_t* mac, const uint8_t* data, size_t len) {
+    FailoverManager::getInstance().handleReplication(mac, data, len);
+}
+
+/**
+ * @brief Standby became active: rebuild live state from the replicated files
+ *
+ * Devices attach (and restore their schedules) as the nodes re-announce
+ * to this hub's new session.
+ */
+void onFailoverTakeover() {
+    AquariumManager& manager = AquariumManager::getInstance();
+    
+    // The watchdog and executor walk these devices; hold them off until
+    // the replicated set has replaced the deleted one
+    manager.lockRegistry();
+    for (Aquarium* aquarium : manager.getAllAquariums()) {
+        manager.removeAquarium(aquarium->getId());
+    }
+    ScheduleJournal::getInstance().begin();
+    loadAquariumsFromFile();
+    manager.unlockRegistry();
+    manager.markChanged(AquariumManager::Collection::DEVICES);
+    manager.markChanged(AquariumManager::Collection::UNMAPPED);
+
+    JsonDocument doc;
+    FailoverManager::getInstance().toJson(doc.to<JsonObject>());
+    broadcastTelemetry("failover", doc.as<JsonVariantConst>());
+}
+
 void setupESPNow() {
     Serial.println("");
     Serial.println(" Initializing ESPNowManager...");
     Serial.println("");
     
     // Initialize ESPNowManager as hub
-    bool success = ESPNowManager::getInstance().begin(config.espnowChannel, true);
+    bool success = ESPNowManager::getInstance().begin(config.espnowChannel);
     
     if (!success) {
         Serial.println(" ESPNowManager initialization failed!");
@@ -1196,8 +2034,15 @@ void setupESPNow() {
     // Register callbacks
     ESPNowManager::getInstance().onAnnounceReceived(onAnnounceReceived);
     ESPNowManager::getInstance().onHeartbeatReceived(onHeartbeatReceived);
+    ESPNowManager::getInstance().onHeartbeatDiagnostics(onHeartbeatDiagnostics);
     ESPNowManager::getInstance().onStatusReceived(onStatusReceived);
     ESPNowManager::getInstance().onCommandReceived(onCommandReceived);
+    ESPNowManager::getInstance().onBeaconIdentity(onBeaconIdentity);
+    ESPNowManager::getInstance().onReplicationReceived(onReplicationReceived);
+    
+    if (config.espnowRateAdaptation) {
+        ESPNowManager::getInstance().enableRateAdaptation(config.espnowLongRange);
+    }
     
     Serial.println(" ESPNowManager ready");
     Serial.printf("   - Channel: %d\n", config.espnowChannel);
@@ -1251,6 +2096,19 @@ void setup() {
     // Initialize AquariumManager
     AquariumManager::getInstance().initialize();
     
+    // Per-tank daily usage counters (ring file on LittleFS)
+    AnalyticsManager::getInstance().begin();
+    
+    // Audit journal (segment files on LittleFS)
+    EventJournal::getInstance().begin();
+    EventJournal::getInstance().log(EventJournal::Type::BOOT);
+    
+    // Schedule firing state; must load before devices attach schedules
+    ScheduleJournal::getInstance().begin();
+    
+    // Background workers for housekeeping (one per core)
+    TaskExecutor::getInstance().begin();
+    
     // Setup web server
     setupWebServer();
     
@@ -1260,6 +2118,14 @@ void setup() {
     // Setup ESP-NOW (callbacks run on Core 0, processed in main loop)
     setupESPNow();
     
+    // Hot standby: decide active/standby, beacon identity for nodes
+    FailoverManager::getInstance().onTakeover(onFailoverTakeover);
+    FailoverManager::getInstance().begin(config.hubPartner, config.hubStandby, config.beaconIntervalMs);
+    
+    // LAN federation with the other hubs of the installation
+    FederationManager::getInstance().begin(config.federationGroup, config.federationName,
+                                           config.federationPort, config.federationPeers, 80);
+    
     // Start watchdog task on Core 1 (device health monitoring)
     xTaskCreatePinnedToCore(
         watchdogTask,            // Task function
@@ -1294,9 +2160,68 @@ void loop() {
     // Check for peer timeouts (60 second timeout)
     ESPNowManager::getInstance().checkPeerTimeouts(60000);
     
+    // Active/standby role and state replication to the partner hub
+    FailoverManager& failover = FailoverManager::getInstance();
+    failover.update();
+    
+    // Beacon: hub liveness, time and pending downlink for sleeping nodes
+    static unsigned long lastBeaconTime = 0;
+    if (failover.isActive() && millis() - lastBeaconTime >= config.beaconIntervalMs) {
+        lastBeaconTime = millis();
+        time_t now = time(nullptr);
+        AquariumManager& manager = AquariumManager::getInstance();
+        ESPNowManager::getInstance().sendBeacon(
+            now > 1600000000 ? (uint32_t)now : 0,           // 0 until NTP has set the clock
+            (uint16_t)manager.getStateVersion(),
+            (uint16_t)manager.getBootId(),
+            config.beaconIntervalMs);
+    }
+    
     // Update AquariumManager (schedule execution only)
     // Note: Health checks and water monitoring run on Core 1 watchdog task
-    AquariumManager::getInstance().updateSchedules();
+    // A standby must not journal firings it cannot send
+    if (failover.isActive()) {
+        AquariumManager::getInstance().updateSchedules();
+    }
+    
+    // Device deltas and forwarded commands with the other hubs (a standby
+    // owns no devices, the active partner speaks for the pair)
+    if (failover.isActive()) {
+        FederationManager::getInstance().update();
+    }
+    
+    // Send fresh-reading requests and answer completed gathers
+    AquariumManager::getInstance().updateReadingGathers();
+    
+    // Send, retry and time out provisioning transactions
+    ProvisioningManager::getInstance().update();
+    
+    // Accrue device usage, roll over days, checkpoint to flash (background)
+    static unsigned long lastAnalyticsSubmit = 0;
+    if (millis() - lastAnalyticsSubmit >= 1000) {
+        lastAnalyticsSubmit = millis();
+        TaskExecutor::getInstance().submit([](const TaskExecutor::JobContext& context) {
+            AnalyticsManager::getInstance().update();
+        }, TaskExecutor::Priority::BACKGROUND, 0, KEY_ANALYTICS);
+    }
+    
+    // Evaluate water parameter alerts (background)
+    static unsigned long lastWaterCheckSubmit = 0;
+    if (millis() - lastWaterCheckSubmit >= 10000) {
+        lastWaterCheckSubmit = millis();
+        TaskExecutor::getInstance().submit([](const TaskExecutor::JobContext& context) {
+            AquariumManager::getInstance().checkWaterParameters();
+        }, TaskExecutor::Priority::NORMAL, 10000, KEY_WATER_CHECK);
+    }
+    
+    // Append queued journal records to flash (background)
+    static unsigned long lastJournalSubmit = 0;
+    if (millis() - lastJournalSubmit >= 250) {
+        lastJournalSubmit = millis();
+        TaskExecutor::getInstance().submit([](const TaskExecutor::JobContext& context) {
+            EventJournal::getInstance().flush();
+        }, TaskExecutor::Priority::NORMAL, 0, KEY_JOURNAL_FLUSH);
+    }
     
     // Print WiFi channel status periodically
     static unsigned long lastChannelCheckTime = 0;
@@ -1331,9 +2256,17 @@ void loop() {
                       stats.sendFailures, stats.reassemblyTimeouts);
         Serial.printf("   Duplicates ignored: %u\n", stats.duplicatesIgnored);
         Serial.printf("   Retries: %u\n", stats.retries);
+        Serial.printf("   Not ACKed: %u / rate changes: %u\n", stats.sendsNotAcked, stats.rateChanges);
         Serial.println("\n");
     }
     
+    // Drop stale WebSocket clients (AsyncWebSocket keeps them until told)
+    static unsigned long lastWsCleanup = 0;
+    if (millis() - lastWsCleanup > 1000) {
+        lastWsCleanup = millis();
+        ws.cleanupClients();
+    }
+    
     // Small delay to prevent watchdog issues
     delay(10);
 }
@@ -0,0 +1,478 @@
+#include "managers/AnalyticsManager.h"
+#include "protocol/commands.h"
+#include <LittleFS.h>
+#include <time.h>
+
+AnalyticsManager& AnalyticsManager::getInstance() {
+    static AnalyticsManager instance;
+    return instance;
+}
+
+AnalyticsManager::AnalyticsManager()
+    : _mutex(xSemaphoreCreateMutex())
+    , _fileReady(false)
+    , _lastUpdateMs(0)
+    , _lastCheckpointMs(0) {
+    memset(&_header, 0, sizeof(_header));
+    memset(_tanks, 0, sizeof(_tanks));
+}
+
+// ============================================================================
+// LIFECYCLE
+// ============================================================================
+
+bool AnalyticsManager::begin() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    bool valid = false;
+    File file = LittleFS.open(ANALYTICS_FILE, "r");
+    if (file) {
+        valid = file.read((uint8_t*)&_header, sizeof(_header)) == sizeof(_header) &&
+                _header.magic == RING_MAGIC &&
+                _header.version == RING_VERSION &&
+                _header.capacity == RING_CAPACITY &&
+                _header.head < RING_CAPACITY &&
+                _header.count <= RING_CAPACITY &&
+                file.size() == sizeof(RingHeader) + (size_t)RING_CAPACITY * sizeof(DailyRecord);
+        file.close();
+    }
+
+    if (valid) {
+        _fileReady = true;
+        Serial.printf("[OK] Analytics: %u of %u tank-days stored\n", _header.count, RING_CAPACITY);
+    } else {
+        _fileReady = _createFile();
+        if (_fileReady) {
+            Serial.printf("[OK] Analytics: created %s (%u tank-days)\n", ANALYTICS_FILE, RING_CAPACITY);
+        } else {
+            Serial.printf("[ERR] Analytics: cannot create %s, counting in RAM only\n", ANALYTICS_FILE);
+        }
+    }
+
+    _lastCheckpointMs = millis();
+    xSemaphoreGive(_mutex);
+    return _fileReady;
+}
+
+void AnalyticsManager::update() {
+    uint32_t now = millis();
+    if (now - _lastUpdateMs < 1000) {
+        return;
+    }
+    _lastUpdateMs = now;
+
+    uint32_t today = _today();
+    bool checkpoint = now - _lastCheckpointMs >= CHECKPOINT_INTERVAL_MS;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < MAX_TANKS; i++) {
+        TankState& tank = _tanks[i];
+        if (!tank.used) {
+            continue;
+        }
+
+        _fold(tank, now);
+
+        if (today != 0 && tank.record.date != today) {
+            if (tank.record.date == 0) {
+                // Clock just set: everything so far happened today
+                tank.record.date = today;
+                _attachSlot(tank);
+            } else {
+                // Day changed: close yesterday, open today
+                _writeRecord(tank);
+                _startDay(tank, today);
+            }
+        }
+
+        if (checkpoint && tank.record.date != 0) {
+            _writeRecord(tank);
+        }
+    }
+    if (checkpoint) {
+        _lastCheckpointMs = now;
+    }
+    xSemaphoreGive(_mutex);
+}
+
+// ============================================================================
+// STATE TRANSITIONS
+// ============================================================================
+
+void AnalyticsManager::onCommand(uint8_t tankId, NodeType type, const uint8_t* data, size_t len) {
+    if (!data || len == 0 ||
+        (type != NodeType::LIGHT && type != NodeType::CO2 && type != NodeType::FISH_FEEDER)) {
+        return;
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    TankState* tank = _tankState(tankId, true);
+    if (!tank) {
+        xSemaphoreGive(_mutex);
+        return;
+    }
+
+    uint32_t now = millis();
+    _fold(*tank, now);
+
+    uint8_t level = 0;
+    uint8_t white, blue, red, portions;
+    uint16_t seconds;
+
+    switch (type) {
+        case NodeType::LIGHT:
+            // Effects animate levels on the node; they are not counted
+            if (LightProtocol::AllOff::decode(data, len)) {
+                memset(tank->light, 0, sizeof(tank->light));
+            } else if (LightProtocol::AllOn::decode(data, len, white, blue, red)) {
+                tank->light[0] = white;
+                tank->light[1] = blue;
+                tank->light[2] = red;
+            } else if (LightProtocol::WhiteOff::decode(data, len) || LightProtocol::WhiteOn::decode(data, len, level)) {
+                tank->light[0] = level;
+            } else if (LightProtocol::BlueOff::decode(data, len) || LightProtocol::BlueOn::decode(data, len, level)) {
+                tank->light[1] = level;
+            } else if (LightProtocol::RedOff::decode(data, len) || LightProtocol::RedOn::decode(data, len, level)) {
+                tank->light[2] = level;
+            }
+            break;
+
+        case NodeType::CO2:
+            if (CO2Protocol::Start::decode(data, len)) {
+                tank->co2On = true;
+                tank->co2UntilMs = 0;
+            } else if (CO2Protocol::Timed::decode(data, len, seconds)) {
+                tank->co2On = seconds > 0;
+                tank->co2UntilMs = now + seconds * 1000UL;
+                if (tank->co2UntilMs == 0) tank->co2UntilMs = 1;   // 0 means "until Stop"
+            } else if (CO2Protocol::Stop::decode(data, len) || CO2Protocol::EmergencyStop::decode(data, len)) {
+                tank->co2On = false;
+            }
+            break;
+
+        case NodeType::FISH_FEEDER:
+            if (FeederProtocol::Feed::decode(data, len, portions)) {
+                tank->record.portions += portions;
+                tank->record.feedings++;
+            }
+            break;
+
+        default:
+            break;
+    }
+    xSemaphoreGive(_mutex);
+}
+
+void AnalyticsManager::onHeaterStatus(uint8_t tankId, bool heating) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    TankState* tank = _tankState(tankId, true);
+    if (tank) {
+        uint32_t now = millis();
+        _fold(*tank, now);
+
+        // Only a reported off -> on counts; a heater seen for the first time does not
+        if (heating && tank->heaterKnown && !tank->heaterOn) {
+            tank->record.heaterCycles++;
+        }
+        tank->heaterKnown = true;
+        tank->heaterOn = heating;
+        tank->heaterStatusMs = now;
+    }
+    xSemaphoreGive(_mutex);
+}
+
+void AnalyticsManager::forgetTank(uint8_t tankId) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    TankState* tank = _tankState(tankId, false);
+    if (tank) {
+        _fold(*tank, millis());
+        if (tank->record.date != 0) {
+            _writeRecord(*tank);
+        }
+        tank->used = false;
+    }
+    xSemaphoreGive(_mutex);
+}
+
+/**
+ * @brief Accrue whole seconds since the last fold to the current state
+ */
+void AnalyticsManager::_fold(TankState& tank, uint32_t nowMs) {
+    uint32_t seconds = (nowMs - tank.lastFoldMs) / 1000;
+    if (seconds == 0) {
+        return;
+    }
+    uint32_t start = tank.lastFoldMs;
+    tank.lastFoldMs += seconds * 1000;
+
+    for (uint8_t c = 0; c < 3; c++) {
+        tank.record.lightLevelSec[c] += (uint32_t)tank.light[c] * seconds;
+    }
+
+    if (tank.co2On) {
+        uint32_t onSec = seconds;
+        if (tank.co2UntilMs != 0) {
+            int32_t remainingMs = (int32_t)(tank.co2UntilMs - start);
+            if (remainingMs <= (int32_t)(seconds * 1000)) {
+                onSec = remainingMs > 0 ? remainingMs / 1000 : 0;
+                tank.co2On = false;
+            }
+        }
+        tank.record.co2OnSec += onSec;
+    }
+
+    if (tank.heaterKnown) {
+        // A heater that stops reporting stops counting toward duty
+        uint32_t knownSec = seconds;
+        int32_t validMs = (int32_t)(tank.heaterStatusMs + HEATER_STATUS_VALID_MS - start);
+        if (validMs <= (int32_t)(seconds * 1000)) {
+            knownSec = validMs > 0 ? validMs / 1000 : 0;
+            tank.heaterKnown = false;
+        }
+        tank.record.heaterKnownSec += knownSec;
+        if (tank.heaterOn) {
+            tank.record.heaterOnSec += knownSec;
+        }
+    }
+}
+
+// ============================================================================
+// RING FILE
+// ============================================================================
+
+AnalyticsManager::TankState* AnalyticsManager::_tankState(uint8_t tankId, bool create) {
+    TankState* freeSlot = nullptr;
+    for (uint8_t i = 0; i < MAX_TANKS; i++) {
+        if (_tanks[i].used && _tanks[i].record.tankId == tankId) {
+            return &_tanks[i];
+        }
+        if (!_tanks[i].used && !freeSlot) {
+            freeSlot = &_tanks[i];
+        }
+    }
+
+    if (!create || tankId == 0) {
+        return nullptr;
+    }
+    if (!freeSlot) {
+        Serial.printf("[WARN] Analytics: more than %u tanks, tank %u not tracked\n", MAX_TANKS, tankId);
+        return nullptr;
+    }
+
+    memset(freeSlot, 0, sizeof(TankState));
+    freeSlot->used = true;
+    freeSlot->record.tankId = tankId;
+    freeSlot->lastFoldMs = millis();
+    _startDay(*freeSlot, _today());
+    return freeSlot;
+}
+
+void AnalyticsManager::_startDay(TankState& tank, uint32_t date) {
+    uint8_t tankId = tank.record.tankId;
+    memset(&tank.record, 0, sizeof(tank.record));
+    tank.record.tankId = tankId;
+    tank.record.date = date;
+    tank.slot = -1;
+
+    if (date != 0) {
+        _attachSlot(tank);
+    }
+}
+
+/**
+ * @brief Give a dated record its ring slot
+ *
+ * If the ring already holds this tank-day (hub rebooted today), its counts
+ * are merged in and the slot reused; otherwise the oldest slot is taken.
+ */
+void AnalyticsManager::_attachSlot(TankState& tank) {
+    if (!_fileReady || tank.slot >= 0 || tank.record.date == 0) {
+        return;
+    }
+
+    File file = LittleFS.open(ANALYTICS_FILE, "r");
+    if (file) {
+        DailyRecord stored;
+        for (uint16_t i = 0; i < _header.count; i++) {
+            uint16_t slot = (_header.head + RING_CAPACITY - 1 - i) % RING_CAPACITY;
+            if (!file.seek(sizeof(RingHeader) + (size_t)slot * sizeof(DailyRecord)) ||
+                file.read((uint8_t*)&stored, sizeof(stored)) != sizeof(stored)) {
+                break;
+            }
+            if (stored.tankId != tank.record.tankId || stored.date != tank.record.date) {
+                continue;
+            }
+
+            DailyRecord& record = tank.record;
+            record.heaterCycles += stored.heaterCycles;
+            for (uint8_t c = 0; c < 3; c++) {
+                record.lightLevelSec[c] += stored.lightLevelSec[c];
+            }
+            record.heaterOnSec += stored.heaterOnSec;
+            record.heaterKnownSec += stored.heaterKnownSec;
+            record.co2OnSec += stored.co2OnSec;
+            record.portions += stored.portions;
+            record.feedings += stored.feedings;
+            tank.slot = slot;
+            break;
+        }
+        file.close();
+    }
+
+    if (tank.slot < 0) {
+        tank.slot = _header.head;
+        _header.head = (_header.head + 1) % RING_CAPACITY;
+        if (_header.count < RING_CAPACITY) {
+            _header.count++;
+        }
+        _writeHeader();
+    }
+}
+
+bool AnalyticsManager::_writeRecord(TankState& tank) {
+    _attachSlot(tank);
+    if (!_fileReady || tank.slot < 0) {
+        return false;
+    }
+
+    File file = LittleFS.open(ANALYTICS_FILE, "r+");
+    if (!file) {
+        Serial.printf("[ERR] Analytics: cannot open %s\n", ANALYTICS_FILE);
+        return false;
+    }
+
+    bool ok = file.seek(sizeof(RingHeader) + (size_t)tank.slot * sizeof(DailyRecord)) &&
+              file.write((const uint8_t*)&tank.record, sizeof(DailyRecord)) == sizeof(DailyRecord);
+    file.close();
+
+    if (!ok) {
+        Serial.printf("[ERR] Analytics: failed to write tank %u day %u\n", tank.record.tankId, tank.record.date);
+    }
+    return ok;
+}
+
+bool AnalyticsManager::_writeHeader() {
+    File file = LittleFS.open(ANALYTICS_FILE, "r+");
+    if (!file) {
+        return false;
+    }
+    bool ok = file.write((const uint8_t*)&_header, sizeof(_header)) == sizeof(_header);
+    file.close();
+    return ok;
+}
+
+bool AnalyticsManager::_createFile() {
+    File file = LittleFS.open(ANALYTICS_FILE, "w");
+    if (!file) {
+        return false;
+    }
+
+    memset(&_header, 0, sizeof(_header));
+    _header.magic = RING_MAGIC;
+    _header.version = RING_VERSION;
+    _header.capacity = RING_CAPACITY;
+
+    bool ok = file.write((const uint8_t*)&_header, sizeof(_header)) == sizeof(_header);
+
+    DailyRecord empty;
+    memset(&empty, 0, sizeof(empty));
+    for (uint16_t i = 0; ok && i < RING_CAPACITY; i++) {
+        ok = file.write((const uint8_t*)&empty, sizeof(empty)) == sizeof(empty);
+    }
+    file.close();
+    return ok;
+}
+
+// ============================================================================
+// QUERY
+// ============================================================================
+
+void AnalyticsManager::toJson(JsonObject out, uint8_t tankId, uint16_t days) {
+    uint16_t emitted[256] = {0};   // Days returned per tank
+    uint32_t now = millis();
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    out["capacity"] = (int)RING_CAPACITY;
+    out["stored"] = _header.count;
+    out["persisted"] = _fileReady;
+    JsonArray list = out["days"].to<JsonArray>();
+
+    // Live records first: today, or undated until the clock is set
+    for (uint8_t i = 0; i < MAX_TANKS; i++) {
+        TankState& tank = _tanks[i];
+        if (!tank.used || (tankId != 0 && tank.record.tankId != tankId) || days == 0) {
+            continue;
+        }
+        _fold(tank, now);
+        _recordToJson(tank.record, true, list.add<JsonObject>());
+        emitted[tank.record.tankId]++;
+    }
+
+    File file = _fileReady ? LittleFS.open(ANALYTICS_FILE, "r") : File();
+    if (file) {
+        DailyRecord record;
+        for (uint16_t i = 0; i < _header.count; i++) {
+            uint16_t slot = (_header.head + RING_CAPACITY - 1 - i) % RING_CAPACITY;
+
+            bool live = false;
+            for (uint8_t t = 0; t < MAX_TANKS; t++) {
+                if (_tanks[t].used && _tanks[t].slot == (int16_t)slot) {
+                    live = true;
+                    break;
+                }
+            }
+            if (live) {
+                continue;
+            }
+
+            if (!file.seek(sizeof(RingHeader) + (size_t)slot * sizeof(DailyRecord)) ||
+                file.read((uint8_t*)&record, sizeof(record)) != sizeof(record)) {
+                break;
+            }
+            if (record.tankId == 0 || (tankId != 0 && record.tankId != tankId) ||
+                emitted[record.tankId] >= days) {
+                continue;
+            }
+            _recordToJson(record, false, list.add<JsonObject>());
+            emitted[record.tankId]++;
+        }
+        file.close();
+    }
+
+    xSemaphoreGive(_mutex);
+}
+
+void AnalyticsManager::_recordToJson(const DailyRecord& record, bool partial, JsonObject out) const {
+    out["tankId"] = record.tankId;
+    out["date"] = record.date;
+    out["partial"] = partial;
+
+    // Hours at full power per channel
+    JsonObject light = out["light"].to<JsonObject>();
+    light["whiteHours"] = record.lightLevelSec[0] / (255.0f * 3600.0f);
+    light["blueHours"] = record.lightLevelSec[1] / (255.0f * 3600.0f);
+    light["redHours"] = record.lightLevelSec[2] / (255.0f * 3600.0f);
+
+    JsonObject heater = out["heater"].to<JsonObject>();
+    heater["onHours"] = record.heaterOnSec / 3600.0f;
+    heater["observedHours"] = record.heaterKnownSec / 3600.0f;
+    if (record.heaterKnownSec > 0) {
+        heater["dutyPct"] = record.heaterOnSec * 100.0f / record.heaterKnownSec;
+    }
+    heater["cycles"] = record.heaterCycles;
+
+    out["co2Hours"] = record.co2OnSec / 3600.0f;
+    out["portions"] = record.portions;
+    out["feedings"] = record.feedings;
+}
+
+uint32_t AnalyticsManager::_today() {
+    time_t now = time(nullptr);
+    if (now < 1600000000) {
+        return 0;
+    }
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    return (uint32_t)(timeinfo.tm_year + 1900) * 10000 + (timeinfo.tm_mon + 1) * 100 + timeinfo.tm_mday;
+}
@@ -1,7 +1,15 @@
 #include "managers/AquariumManager.h"
+#include "managers/AnalyticsManager.h"
+#include "managers/EventJournal.h"
+#include "managers/ScheduleJournal.h"
+#include "managers/TaskExecutor.h"
+#include "models/devices/SensorDevice.h"
+#include "protocol/commands.h"
 #include <esp_now.h>
+#include "ESPNowManager.h"
 #include <LittleFS.h>
 #include <ArduinoJson.h>
+#include <algorithm>
 
 // ============================================================================
 // SINGLETON INSTANCE
@@ -19,11 +27,22 @@ AquariumManager& AquariumManager::getInstance() {
 AquariumManager::AquariumManager() 
     : _startTime(0),
       _lastScheduleCheck(0),
+      _lastScheduleSecond(0),
       _lastHealthCheck(0),
       _lastWaterCheck(0),
-      _wsCallback(nullptr) {
+      _wsCallback(nullptr),
+      _registryMutex(xSemaphoreCreateRecursiveMutex()),
+      _gatherMutex(xSemaphoreCreateMutex()),
+      _stateVersion(0),
+      _bootId(0),
+      _tombstoneFloor(0) {
     // Initialize statistics
     _stats = Statistics();
+    
+    for (size_t i = 0; i < (size_t)Collection::COUNT; i++) {
+        _collectionVersions[i] = 0;
+    }
+    _versionMux = portMUX_INITIALIZER_UNLOCKED;
 }
 
 AquariumManager::~AquariumManager() {
@@ -45,6 +64,9 @@ bool AquariumManager::initialize() {
     _lastHealthCheck = millis();
     _lastWaterCheck = millis();
     
+    // New boot ID so clients holding versions from before a reboot resync
+    _bootId = esp_random();
+    
     Serial.println(" AquariumManager initialized");
     return true;
 }
@@ -87,21 +109,27 @@ bool AquariumManager::addAquarium(Aquarium* aquarium) {
     
     uint8_t id = aquarium->getId();
     
+    lockRegistry();
     // Check for duplicate ID
     if (_aquariums.find(id) != _aquariums.end()) {
+        unlockRegistry();
         Serial.printf(" Aquarium with ID %d already exists\n", id);
         return false;
     }
     
     _aquariums[id] = aquarium;
+    touchAquarium(aquarium);
+    unlockRegistry();
     Serial.printf(" Added aquarium: %s (ID: %d)\n", 
                   aquarium->getName().c_str(), id);
     return true;
 }
 
 bool AquariumManager::removeAquarium(uint8_t id) {
+    lockRegistry();
     auto it = _aquariums.find(id);
     if (it == _aquariums.end()) {
+        unlockRegistry();
         Serial.printf(" Aquarium ID %d not found\n", id);
         return false;
     }
@@ -112,11 +140,17 @@ bool AquariumManager::removeAquarium(uint8_t id) {
     for (Device* device : devices) {
         uint64_t key = _macToKey(device->getMac());
         _globalDeviceRegistry.erase(key);
+        _addTombstone(Collection::DEVICES, key);
     }
     
     // Delete aquarium (and its devices)
     delete aquarium;
     _aquariums.erase(it);
+    _heaterReferences.erase(id);
+    _raisedAlerts.erase(id);
+    AnalyticsManager::getInstance().forgetTank(id);
+    _addTombstone(Collection::AQUARIUMS, id);
+    unlockRegistry();
     
     Serial.printf(" Removed aquarium ID: %d\n", id);
     return true;
@@ -154,8 +188,10 @@ void AquariumManager::handleAnnounce(const uint8_t* mac, const AnnounceMessage&
                   (int)msg.header.nodeType, msg.header.tankId, msg.firmwareVersion);
     
     // Check if device already registered
-    if (_globalDeviceRegistry.find(macKey) != _globalDeviceRegistry.end()) {
+    auto registered = _globalDeviceRegistry.find(macKey);
+    if (registered != _globalDeviceRegistry.end()) {
         Serial.println("   - Device already registered, sending ACK");
+        _applyProtocol(registered->second, mac);
         _sendAck(mac, msg.header.tankId, true);
         _stats.totalMessagesReceived++;
         return;
@@ -232,6 +268,7 @@ void AquariumManager::handleAnnounce(const uint8_t* mac, const AnnounceMessage&
             serializeJson(doc, file);
             file.close();
         }
+        markChanged(Collection::UNMAPPED);
         
         _sendAck(mac, 0, true);  // Still send ACK
         _stats.totalMessagesReceived++;
@@ -261,6 +298,7 @@ void AquariumManager::handleAnnounce(const uint8_t* mac, const AnnounceMessage&
     
     // Set tank ID and firmware version
     device->setFirmwareVersion(msg.firmwareVersion);
+    _applyProtocol(device, mac);
     
     // Add to aquarium
     if (!aquarium->addDevice(device)) {
@@ -273,20 +311,39 @@ void AquariumManager::handleAnnounce(const uint8_t* mac, const AnnounceMessage&
     }
     
     // Add to global registry
+    lockRegistry();
     _globalDeviceRegistry[macKey] = device;
+    unlockRegistry();
+    touchDevice(device);
+    touchAquarium(aquarium);
     
     // Send ACK
     _sendAck(mac, msg.header.tankId, true);
     
     // Broadcast update
     if (_wsCallback) {
-        _wsCallback("deviceDiscovered", device->toJson());
+        _broadcastDevice("deviceDiscovered", device);
     }
     
     Serial.printf("   -  Device registered successfully\n");
     _stats.totalMessagesReceived++;
 }
 
+void AquariumManager::handleHeartbeatDiagnostics(const uint8_t* mac, const HeartbeatDiagnostics& diagnostics) {
+    Device* device = getDevice(mac);
+    if (!device) {
+        return;
+    }
+    
+    // Not versioned: timing changes every interval and would defeat ETags
+    device->updateDiagnostics(diagnostics);
+    
+    if (diagnostics.rxDropped > 0) {
+        Serial.printf("[WARN] %s dropped %u frames (RX ring full)\n",
+                      device->getName().c_str(), diagnostics.rxDropped);
+    }
+}
+
 void AquariumManager::handleHeartbeat(const uint8_t* mac, const HeartbeatMessage& msg) {
     uint64_t macKey = _macToKey(mac);
     
@@ -297,14 +354,29 @@ void AquariumManager::handleHeartbeat(const uint8_t* mac, const HeartbeatMessage
     }
     
     Device* device = it->second;
+    uint8_t previousHealth = device->getHealth();
     device->updateHeartbeat(msg.health, msg.uptimeMinutes);
     
+    // Not versioned either: RSSI and delivery move with every frame
+    PeerLinkInfo link;
+    if (ESPNowManager::getInstance().isRateAdaptationEnabled() &&
+        ESPNowManager::getInstance().getPeerLink(mac, link)) {
+        device->updateLink(link.rateKbps, link.rssi, link.deliveryPercent);
+    }
+    
+    // Uptime ticks alone are not a change worth invalidating clients for
+    if (msg.health != previousHealth) {
+        touchDevice(device);
+    }
+    
     // Update status to online if it was offline
     if (device->getStatus() != Device::Status::ONLINE) {
         device->setStatus(Device::Status::ONLINE);
+        touchDevice(device);
+        EventJournal::getInstance().log(EventJournal::Type::DEVICE_ONLINE, device->getTankId(), mac);
         
         if (_wsCallback) {
-            _wsCallback("deviceOnline", device->toJson());
+            _broadcastDevice("deviceOnline", device);
         }
     }
     
@@ -322,15 +394,205 @@ void AquariumManager::handleStatus(const uint8_t* mac, const StatusMessage& msg)
     
     Device* device = it->second;
     device->handleStatus(msg);
+    touchDevice(device);
+    
+    if (device->getType() == NodeType::SENSOR) {
+        _collectFreshReading(device, msg);
+    }
+    
+    // Command outcomes only; periodic readings would flood the journal
+    if (msg.commandId != 0) {
+        uint8_t entry[EventJournal::DATA_LEN];
+        entry[0] = msg.commandId;
+        entry[1] = msg.statusCode;
+        size_t len = msg.statusLen > sizeof(entry) - 2 ? sizeof(entry) - 2 : msg.statusLen;
+        memcpy(entry + 2, msg.statusData, len);
+        EventJournal::getInstance().log(EventJournal::Type::STATUS, device->getTankId(), mac, entry, len + 2);
+    }
+    
+    if (device->getStatus() == Device::Status::OFFLINE) {
+        device->setStatus(Device::Status::ONLINE);
+        EventJournal::getInstance().log(EventJournal::Type::DEVICE_ONLINE, device->getTankId(), mac);
+        if (_wsCallback) {
+            _broadcastDevice("deviceOnline", device);
+        }
+    }
+    
+    // Status payloads may carry readings for the owning tank
+    Aquarium* aquarium = getAquarium(device->getTankId());
+    if (aquarium) {
+        if (device->getType() == NodeType::SENSOR) {
+            _ingestSensorReadings(aquarium, device, msg);
+            _pushHeaterReference(aquarium);
+        } else if (device->getType() == NodeType::HEATER) {
+            _ingestHeaterReadings(aquarium, device, msg);
+        }
+        touchAquarium(aquarium);
+    }
     
     // Broadcast update
     if (_wsCallback) {
-        _wsCallback("deviceStatus", device->toJson());
+        _broadcastDevice("deviceStatus", device);
     }
     
     _stats.totalMessagesReceived++;
 }
 
+/**
+ * @brief Feed sensor STATUS readings through the tank's stream monitors
+ * 
+ * Accepts the single-reading payload and deep-sleep READINGS_BATCH.
+ * Command acknowledgements (commandId != 0) carry no readings.
+ */
+void AquariumManager::_ingestSensorReadings(Aquarium* aquarium, const Device* device, const StatusMessage& msg) {
+    if (msg.commandId != 0) {
+        return;
+    }
+    
+    uint8_t before[3] = {
+        aquarium->getTemperatureMonitor().getFlags(),
+        aquarium->getPhMonitor().getFlags(),
+        aquarium->getTdsMonitor().getFlags()
+    };
+    uint32_t now = millis();
+    
+    if (msg.statusLen >= sizeof(SensorProtocol::BatchHeader) &&
+        msg.statusData[0] == SensorProtocol::READINGS_BATCH) {
+        SensorProtocol::BatchHeader header;
+        memcpy(&header, msg.statusData, sizeof(header));
+        
+        uint8_t count = header.count;
+        size_t available = (msg.statusLen - sizeof(header)) / sizeof(SensorProtocol::BatchSample);
+        if (count > available) {
+            count = available;
+        }
+        
+        // Oldest first; the newest sample was taken just before this STATUS
+        for (uint8_t i = 0; i < count; i++) {
+            SensorProtocol::BatchSample sample;
+            memcpy(&sample, msg.statusData + sizeof(header) + i * sizeof(sample), sizeof(sample));
+            uint32_t takenAt = now - (uint32_t)(count - 1 - i) * header.intervalSec * 1000;
+            
+            aquarium->updateTemperature(sample.tempX100 / 100.0f, takenAt, device->getMac());
+            aquarium->updatePh(sample.phX100 / 100.0f, takenAt);
+            aquarium->updateTds(sample.tdsPpm, takenAt);
+        }
+    } else if (msg.statusLen >= 6) {
+        // [pH_int, pH_frac, TDS_low, TDS_high, Temp_int, Temp_frac, raw counts...]
+        const uint8_t* d = msg.statusData;
+        aquarium->updatePh(d[0] + d[1] / 100.0f, now);
+        aquarium->updateTds((uint16_t)(d[2] | (d[3] << 8)), now);
+        aquarium->updateTemperature(d[4] + d[5] / 100.0f, now, device->getMac());
+    } else {
+        return;
+    }
+    
+    _reportProbeHealth(aquarium, device, "temperature", before[0], aquarium->getTemperatureMonitor().getFlags());
+    _reportProbeHealth(aquarium, device, "ph", before[1], aquarium->getPhMonitor().getFlags());
+    _reportProbeHealth(aquarium, device, "tds", before[2], aquarium->getTdsMonitor().getFlags());
+}
+
+/**
+ * @brief Log and broadcast a probe whose health flags changed
+ */
+void AquariumManager::_reportProbeHealth(const Aquarium* aquarium, const Device* device, const char* probe,
+                                         uint8_t previousFlags, uint8_t flags) {
+    if (flags == previousFlags) {
+        return;
+    }
+    
+    EventJournal::getInstance().logAlert(aquarium->getId(), EventJournal::Alert::PROBE, flags, flags != 0);
+    
+    if (flags != 0) {
+        Serial.printf("[WARN] Tank %d %s probe (%s): flags 0x%02X%s\n",
+                      aquarium->getId(), probe, device->getName().c_str(), flags,
+                      (flags & SensorStreamMonitor::SUSPECT_MASK) ? " - reading ignored" : "");
+    } else {
+        Serial.printf("[OK] Tank %d %s probe healthy again\n", aquarium->getId(), probe);
+    }
+    
+    if (_wsCallback) {
+        JsonDocument doc;
+        doc["tankId"] = aquarium->getId();
+        doc["mac"] = device->getMacString();
+        doc["probe"] = probe;
+        doc["suspect"] = (flags & SensorStreamMonitor::SUSPECT_MASK) != 0;
+        SensorStreamMonitor::flagsToJson(flags, doc["flags"].to<JsonArray>());
+        _wsCallback("probeHealth", doc.as<JsonVariantConst>());
+    }
+}
+
+/**
+ * @brief Fuse the heater's own probe from its periodic STATUS
+ * 
+ * The heater reports HeaterProtocol::Status; readings without
+ * STATUS_PROBE_OK (no sensor fitted or read failed) are skipped.
+ */
+void AquariumManager::_ingestHeaterReadings(Aquarium* aquarium, const Device* device, const StatusMessage& msg) {
+    if (msg.commandId != 0 || msg.statusLen != sizeof(HeaterProtocol::Status)) {
+        return;
+    }
+    
+    HeaterProtocol::Status status;
+    memcpy(&status, msg.statusData, sizeof(status));
+    AnalyticsManager::getInstance().onHeaterStatus(aquarium->getId(), (status.flags & HeaterProtocol::STATUS_HEATING) != 0);
+    
+    if (!(status.flags & HeaterProtocol::STATUS_PROBE_OK)) {
+        return;
+    }
+    
+    float probe = status.probeX100 / 100.0f;
+    TemperatureFusion::Result result = aquarium->updateHeaterTemperature(probe, device->getMac(), millis());
+    if (result == TemperatureFusion::Result::RESEEDED && aquarium->getTemperatureMonitor().getSampleCount() > 0) {
+        Serial.printf("[WARN] Tank %d temperature re-seeded from heater probe (%s): %.2fC\n",
+                      aquarium->getId(), device->getName().c_str(), probe);
+    }
+    
+    _pushHeaterReference(aquarium);
+}
+
+/**
+ * @brief Send the fused tank temperature to the tank's heaters
+ * 
+ * Heaters regulate on the reference until it expires, then fall back to
+ * their own probe. Sent every HEATER_REFERENCE_INTERVAL_MS, or sooner when
+ * the estimate moves; nothing is sent while the estimate is untrusted, so
+ * heaters fall back on their own.
+ */
+void AquariumManager::_pushHeaterReference(Aquarium* aquarium) {
+    if (!aquarium->hasTrustedTemperature()) {
+        return;
+    }
+    
+    float estimate = aquarium->getCurrentTemperature();
+    int16_t estimateX100 = (int16_t)(estimate * 100.0f + (estimate >= 0 ? 0.5f : -0.5f));
+    uint32_t now = millis();
+    
+    auto it = _heaterReferences.find(aquarium->getId());
+    if (it != _heaterReferences.end() &&
+        now - it->second.sentMs < HEATER_REFERENCE_INTERVAL_MS &&
+        abs(estimateX100 - it->second.sentX100) < HEATER_REFERENCE_STEP_X100) {
+        return;
+    }
+    
+    uint8_t commandData[HeaterProtocol::SetReference::SIZE];
+    size_t length = HeaterProtocol::SetReference::encode(commandData, estimateX100,
+                                                         (uint16_t)HEATER_REFERENCE_VALID_SEC);
+    
+    bool sent = false;
+    for (Device* heater : aquarium->getDevicesByType(NodeType::HEATER)) {
+        if (heater->isOnline() && heater->sendCommand(commandData, length)) {
+            sent = true;
+        }
+    }
+    
+    if (sent) {
+        HeaterReference& reference = _heaterReferences[aquarium->getId()];
+        reference.sentMs = now;
+        reference.sentX100 = estimateX100;
+    }
+}
+
 Device* AquariumManager::getDevice(const uint8_t* mac) {
     uint64_t macKey = _macToKey(mac);
     
@@ -357,17 +619,321 @@ size_t AquariumManager::getDeviceCount() const {
     return _globalDeviceRegistry.size();
 }
 
+// ============================================================================
+// FRESH READINGS (scatter/gather)
+// ============================================================================
+// Web handlers create or join a gather; the main loop sends the requests,
+// matches readings as they arrive and completes the gather. Nothing here
+// blocks the web server task.
+
+AquariumManager::ReadingGather::ReadingGather(uint8_t tankId, uint32_t timeoutMs)
+    : _tankId(tankId),
+      _startedMs(millis()),
+      _timeoutMs(timeoutMs),
+      _sentMs(0),
+      _elapsedMs(0),
+      _clients(1),
+      _complete(false) {
+}
+
+std::shared_ptr<AquariumManager::ReadingGather> AquariumManager::gatherReadings(uint8_t tankId, uint32_t timeoutMs) {
+    if (timeoutMs < GATHER_MIN_TIMEOUT_MS) {
+        timeoutMs = GATHER_MIN_TIMEOUT_MS;
+    } else if (timeoutMs > GATHER_MAX_TIMEOUT_MS) {
+        timeoutMs = GATHER_MAX_TIMEOUT_MS;
+    }
+    
+    xSemaphoreTake(_gatherMutex, portMAX_DELAY);
+    std::shared_ptr<ReadingGather>& gather = _gathers[tankId];
+    if (gather) {
+        gather->_clients++;
+    } else {
+        gather = std::make_shared<ReadingGather>(tankId, timeoutMs);
+    }
+    std::shared_ptr<ReadingGather> result = gather;
+    xSemaphoreGive(_gatherMutex);
+    
+    return result;
+}
+
+void AquariumManager::updateReadingGathers() {
+    uint32_t now = millis();
+    
+    xSemaphoreTake(_gatherMutex, portMAX_DELAY);
+    for (auto it = _gathers.begin(); it != _gathers.end(); ) {
+        ReadingGather& gather = *it->second;
+        if (gather._sentMs == 0) {
+            _scatterReadingRequests(gather, now);
+        }
+        
+        bool waiting = false;
+        for (const ReadingGather::Sensor& sensor : gather._sensors) {
+            if (sensor.outcome == ReadingGather::Outcome::WAITING) {
+                waiting = true;
+                break;
+            }
+        }
+        if (waiting && now - gather._startedMs < gather._timeoutMs) {
+            ++it;
+            continue;
+        }
+        
+        uint8_t fresh = 0;
+        for (ReadingGather::Sensor& sensor : gather._sensors) {
+            if (sensor.outcome == ReadingGather::Outcome::WAITING) {
+                sensor.outcome = ReadingGather::Outcome::TIMEOUT;
+            } else if (sensor.outcome == ReadingGather::Outcome::FRESH) {
+                fresh++;
+            }
+        }
+        gather._elapsedMs = now - gather._startedMs;
+        Serial.printf("[OK] Fresh readings for tank %u: %u/%u sensors in %u ms (%u clients)\n",
+                      gather._tankId, fresh, (unsigned)gather._sensors.size(), gather._elapsedMs, gather._clients);
+        
+        // Out of the map first: a later request starts a new round
+        std::shared_ptr<ReadingGather> done = it->second;
+        it = _gathers.erase(it);
+        done->_complete.store(true, std::memory_order_release);
+    }
+    xSemaphoreGive(_gatherMutex);
+}
+
+/**
+ * @brief Send REQUEST_READING to every sensor the gather covers
+ */
+void AquariumManager::_scatterReadingRequests(ReadingGather& gather, uint32_t now) {
+    std::vector<Device*> devices;
+    if (gather._tankId == 0) {
+        for (const auto& pair : _globalDeviceRegistry) {
+            if (pair.second->getType() == NodeType::SENSOR) {
+                devices.push_back(pair.second);
+            }
+        }
+    } else {
+        Aquarium* aquarium = getAquarium(gather._tankId);
+        if (aquarium) {
+            devices = aquarium->getDevicesByType(NodeType::SENSOR);
+        }
+    }
+    
+    gather._sentMs = now ? now : 1;
+    gather._sensors.reserve(devices.size());
+    for (Device* device : devices) {
+        ReadingGather::Sensor sensor;
+        memcpy(sensor.mac, device->getMac(), 6);
+        sensor.macStr = device->getMacString();
+        sensor.name = device->getName();
+        sensor.tankId = device->getTankId();
+        sensor.temperature = 0;
+        sensor.ph = 0;
+        sensor.tds = 0;
+        sensor.latencyMs = 0;
+        
+        // Offline sensors would only run the clock down to the deadline
+        if (!device->isOnline()) {
+            sensor.outcome = ReadingGather::Outcome::OFFLINE;
+        } else if (static_cast<SensorDevice*>(device)->requestReading()) {
+            sensor.outcome = ReadingGather::Outcome::WAITING;
+            sensor.match.expect(device->getLastCommandId());
+        } else {
+            sensor.outcome = ReadingGather::Outcome::SEND_FAILED;
+        }
+        gather._sensors.push_back(sensor);
+    }
+}
+
+/**
+ * @brief Hand a sensor STATUS to the gathers waiting on that sensor
+ * 
+ * Readings (commandId 0) and the REQUEST_READING acknowledgement both go
+ * to the sensor's ReadingMatcher, which accepts only the reading sent
+ * right before the ACK.
+ */
+void AquariumManager::_collectFreshReading(const Device* device, const StatusMessage& msg) {
+    xSemaphoreTake(_gatherMutex, portMAX_DELAY);
+    if (_gathers.empty()) {
+        xSemaphoreGive(_gatherMutex);
+        return;
+    }
+    
+    ReadingMatcher::Reading reading;
+    bool isReading = msg.commandId == 0 &&
+                     _decodeLatestReading(msg, reading.temperature, reading.ph, reading.tds);
+    if (isReading || msg.commandId != 0) {
+        uint32_t now = millis();
+        for (auto& pair : _gathers) {
+            ReadingGather& gather = *pair.second;
+            for (ReadingGather::Sensor& sensor : gather._sensors) {
+                if (sensor.outcome != ReadingGather::Outcome::WAITING ||
+                    memcmp(sensor.mac, device->getMac(), 6) != 0) {
+                    continue;
+                }
+                
+                bool answered = isReading
+                    ? sensor.match.onReading(msg.header.sequenceNum, reading)
+                    : sensor.match.onAck(msg.commandId, msg.header.sequenceNum);
+                if (answered) {
+                    const ReadingMatcher::Reading& answer = sensor.match.getReading();
+                    sensor.outcome = ReadingGather::Outcome::FRESH;
+                    sensor.temperature = answer.temperature;
+                    sensor.ph = answer.ph;
+                    sensor.tds = answer.tds;
+                    sensor.latencyMs = now - gather._sentMs;
+                }
+                break;
+            }
+        }
+    }
+    xSemaphoreGive(_gatherMutex);
+}
+
+/**
+ * @brief Newest reading in a sensor STATUS (single reading or batch)
+ */
+bool AquariumManager::_decodeLatestReading(const StatusMessage& msg, float& temperature, float& ph, uint16_t& tds) {
+    if (msg.statusLen >= sizeof(SensorProtocol::BatchHeader) &&
+        msg.statusData[0] == SensorProtocol::READINGS_BATCH) {
+        SensorProtocol::BatchHeader header;
+        memcpy(&header, msg.statusData, sizeof(header));
+        
+        size_t available = (msg.statusLen - sizeof(header)) / sizeof(SensorProtocol::BatchSample);
+        size_t count = header.count < available ? header.count : available;
+        if (count == 0) {
+            return false;
+        }
+        
+        SensorProtocol::BatchSample sample;
+        memcpy(&sample, msg.statusData + sizeof(header) + (count - 1) * sizeof(sample), sizeof(sample));
+        temperature = sample.tempX100 / 100.0f;
+        ph = sample.phX100 / 100.0f;
+        tds = sample.tdsPpm;
+        return true;
+    }
+    
+    if (msg.statusLen >= 6) {
+        const uint8_t* d = msg.statusData;
+        ph = d[0] + d[1] / 100.0f;
+        tds = (uint16_t)(d[2] | (d[3] << 8));
+        temperature = d[4] + d[5] / 100.0f;
+        return true;
+    }
+    return false;
+}
+
+void AquariumManager::ReadingGather::toJson(JsonObject out) const {
+    uint8_t fresh = 0;
+    for (const Sensor& sensor : _sensors) {
+        if (sensor.outcome == Outcome::FRESH) {
+            fresh++;
+        }
+    }
+    
+    out["tankId"] = _tankId;
+    out["fresh"] = true;
+    out["requested"] = _sensors.size();
+    out["replied"] = fresh;
+    out["complete"] = fresh == _sensors.size();
+    out["elapsedMs"] = _elapsedMs;
+    out["timeoutMs"] = _timeoutMs;
+    out["sharedBy"] = _clients;
+    
+    if (_tankId != 0) {
+        JsonObject readings = out["readings"].to<JsonObject>();
+        _averageTank(_tankId, readings);
+    } else {
+        // One consolidated entry per tank, in tank order
+        std::vector<uint8_t> tanks;
+        for (const Sensor& sensor : _sensors) {
+            if (std::find(tanks.begin(), tanks.end(), sensor.tankId) == tanks.end()) {
+                tanks.push_back(sensor.tankId);
+            }
+        }
+        std::sort(tanks.begin(), tanks.end());
+        
+        JsonArray tanksJson = out["tanks"].to<JsonArray>();
+        for (uint8_t tankId : tanks) {
+            JsonObject tank = tanksJson.add<JsonObject>();
+            tank["tankId"] = tankId;
+            _averageTank(tankId, tank["readings"].to<JsonObject>());
+        }
+    }
+    
+    JsonArray sensors = out["sensors"].to<JsonArray>();
+    for (const Sensor& sensor : _sensors) {
+        JsonObject entry = sensors.add<JsonObject>();
+        entry["mac"] = sensor.macStr;
+        entry["name"] = sensor.name;
+        entry["tankId"] = sensor.tankId;
+        entry["outcome"] = outcomeString(sensor.outcome);
+        if (sensor.outcome == Outcome::FRESH) {
+            entry["temperature"] = sensor.temperature;
+            entry["ph"] = sensor.ph;
+            entry["tds"] = sensor.tds;
+            entry["latencyMs"] = sensor.latencyMs;
+        }
+    }
+}
+
+/**
+ * @brief Average the fresh readings of one tank's sensors
+ * @return false (and null values) if none of them answered
+ */
+bool AquariumManager::ReadingGather::_averageTank(uint8_t tankId, JsonObject out) const {
+    float temperature = 0;
+    float ph = 0;
+    uint32_t tds = 0;
+    uint8_t count = 0;
+    
+    for (const Sensor& sensor : _sensors) {
+        if (sensor.tankId == tankId && sensor.outcome == Outcome::FRESH) {
+            temperature += sensor.temperature;
+            ph += sensor.ph;
+            tds += sensor.tds;
+            count++;
+        }
+    }
+    
+    out["sensors"] = count;
+    if (count == 0) {
+        out["temperature"] = nullptr;
+        out["ph"] = nullptr;
+        out["tds"] = nullptr;
+        return false;
+    }
+    out["temperature"] = temperature / count;
+    out["ph"] = ph / count;
+    out["tds"] = (uint16_t)((tds + count / 2) / count);
+    return true;
+}
+
+const char* AquariumManager::ReadingGather::outcomeString(Outcome outcome) {
+    switch (outcome) {
+        case Outcome::WAITING: return "waiting";
+        case Outcome::FRESH: return "fresh";
+        case Outcome::TIMEOUT: return "timeout";
+        case Outcome::OFFLINE: return "offline";
+        case Outcome::SEND_FAILED: return "send_failed";
+    }
+    return "unknown";
+}
+
 // ============================================================================
 // SCHEDULING
 // ============================================================================
 
 void AquariumManager::updateSchedules() {
-    uint32_t now = millis();
+    // Firings are keyed on wall-clock time; nothing is due until NTP sets it
+    time_t now = time(nullptr);
+    if (now < 1600000000 || (uint32_t)now == _lastScheduleSecond) {
+        return;
+    }
+    _lastScheduleSecond = (uint32_t)now;
     
     // Check all devices for due schedules
     for (auto& pair : _globalDeviceRegistry) {
         Device* device = pair.second;
         
+        // Firings missed while offline are left to each schedule's catch-up policy
         if (!device->isEnabled() || device->getStatus() != Device::Status::ONLINE) {
             continue;
         }
@@ -378,24 +944,39 @@ void AquariumManager::updateSchedules() {
             // Execute schedule
             const uint8_t* cmdData = schedule->getCommandData();
             size_t cmdLen = schedule->getCommandLength();
+            uint32_t firing = schedule->dueFiring(now);
             
-            if (cmdData && cmdLen > 0) {
+            if (cmdData && cmdLen > 0 && firing > 0) {
+                // Journal before sending: a crash in between skips the
+                // firing instead of repeating it after reboot
+                ScheduleJournal::getInstance().recordFiring(device->getMac(), schedule->getId(),
+                                                            firing, schedule->getExecutionCount() + 1);
+                schedule->markExecuted(firing);
                 device->sendCommand(cmdData, cmdLen);
-                schedule->markExecuted(now);
                 
-                Serial.printf(" Executed schedule: %s for device %s\n",
+                uint8_t entry[5];
+                uint32_t scheduleId = schedule->getId();
+                memcpy(entry, &scheduleId, sizeof(scheduleId));
+                entry[4] = cmdData[0];
+                EventJournal::getInstance().log(EventJournal::Type::SCHEDULE, device->getTankId(),
+                                                device->getMac(), entry, sizeof(entry));
+                
+                Serial.printf(" Executed schedule: %s for device %s (%lus late)\n",
                              schedule->getName().c_str(),
-                             device->getName().c_str());
+                             device->getName().c_str(),
+                             (unsigned long)((uint32_t)now - firing));
                 
                 _stats.totalCommands++;
             }
         }
     }
+    
+    ScheduleJournal::getInstance().update();
 }
 
 std::vector<Schedule*> AquariumManager::getDueSchedules() const {
     std::vector<Schedule*> result;
-    uint32_t now = millis();
+    uint32_t now = time(nullptr);
     
     for (const auto& pair : _globalDeviceRegistry) {
         Device* device = pair.second;
@@ -418,6 +999,7 @@ std::vector<Schedule*> AquariumManager::getDueSchedules() const {
 void AquariumManager::checkDeviceHealth() {
     uint32_t now = millis();
     
+    lockRegistry();
     for (auto& pair : _globalDeviceRegistry) {
         Device* device = pair.second;
         
@@ -429,59 +1011,87 @@ void AquariumManager::checkDeviceHealth() {
                 // Trigger fail-safe
                 device->triggerFailSafe();
                 device->setStatus(Device::Status::OFFLINE);
+                touchDevice(device);
+                EventJournal::getInstance().log(EventJournal::Type::DEVICE_OFFLINE,
+                                                device->getTankId(), device->getMac());
                 
                 // Broadcast alert
                 if (_wsCallback) {
-                    _wsCallback("deviceOffline", device->toJson());
+                    _alertDevice("deviceOffline", device);
                 }
                 
                 _stats.totalErrors++;
             }
         }
     }
+    unlockRegistry();
 }
 
 void AquariumManager::checkWaterParameters() {
+    lockRegistry();
     for (auto& pair : _aquariums) {
         Aquarium* aquarium = pair.second;
+        uint8_t& raised = _raisedAlerts[aquarium->getId()];
+        bool temperatureSafe = aquarium->isTemperatureSafe();
+        bool phSafe = aquarium->isPhSafe();
+        
+        if (temperatureSafe == ((raised & ALERT_TEMPERATURE) != 0)) {
+            EventJournal::getInstance().logAlert(aquarium->getId(), EventJournal::Alert::TEMPERATURE,
+                                                 aquarium->getCurrentTemperature(), !temperatureSafe);
+            raised ^= ALERT_TEMPERATURE;
+        }
+        if (phSafe == ((raised & ALERT_PH) != 0)) {
+            EventJournal::getInstance().logAlert(aquarium->getId(), EventJournal::Alert::PH,
+                                                 aquarium->getCurrentPh(), !phSafe);
+            raised ^= ALERT_PH;
+        }
         
         // Check temperature
-        if (!aquarium->isTemperatureSafe()) {
-            Serial.printf("  Aquarium %s temperature unsafe: %.1fC\n",
+        if (!temperatureSafe) {
+            Serial.printf("  Aquarium %s temperature unsafe: %.1fC%s\n",
                          aquarium->getName().c_str(),
-                         aquarium->getCurrentTemperature());
+                         aquarium->getCurrentTemperature(),
+                         aquarium->hasTrustedTemperature() ? "" : " (stale or suspect probe)");
             
             if (_wsCallback) {
-                _wsCallback("temperatureAlert", aquarium->toJson());
+                _alertAquarium("temperatureAlert", aquarium);
             }
         }
         
         // Check pH
-        if (!aquarium->isPhSafe()) {
-            Serial.printf("  Aquarium %s pH unsafe: %.2f\n",
+        if (!phSafe) {
+            Serial.printf("  Aquarium %s pH unsafe: %.2f%s\n",
                          aquarium->getName().c_str(),
-                         aquarium->getCurrentPh());
+                         aquarium->getCurrentPh(),
+                         aquarium->hasTrustedPh() ? "" : " (stale or suspect probe)");
             
             if (_wsCallback) {
-                _wsCallback("phAlert", aquarium->toJson());
+                _alertAquarium("phAlert", aquarium);
             }
         }
     }
+    unlockRegistry();
 }
 
 void AquariumManager::emergencyShutdown(const String& reason) {
     Serial.println(" EMERGENCY SHUTDOWN: " + reason);
+    EventJournal::getInstance().logAlert(0, EventJournal::Alert::EMERGENCY, 0.0f);
     
     // Trigger fail-safe on all devices
+    lockRegistry();
     for (auto& pair : _globalDeviceRegistry) {
         Device* device = pair.second;
         device->triggerFailSafe();
         device->setStatus(Device::Status::ERROR);
+        touchDevice(device);
     }
+    unlockRegistry();
     
     // Broadcast emergency
     if (_wsCallback) {
-        _wsCallback("emergencyShutdown", "{\"reason\":\"" + reason + "\"}");
+        JsonDocument doc;
+        doc["reason"] = reason;
+        _wsCallback("emergencyShutdown", doc.as<JsonVariantConst>());
     }
     
     _stats.totalErrors++;
@@ -537,20 +1147,196 @@ bool AquariumManager::fromJson(const String& json) {
     return false;
 }
 
+// ============================================================================
+// CHANGE TRACKING
+// ============================================================================
+
+uint32_t AquariumManager::getCollectionVersion(Collection collection) const {
+    portENTER_CRITICAL(&_versionMux);
+    uint32_t version = _collectionVersions[(size_t)collection];
+    portEXIT_CRITICAL(&_versionMux);
+    return version;
+}
+
+uint32_t AquariumManager::_bumpVersion(Collection collection) {
+    portENTER_CRITICAL(&_versionMux);
+    uint32_t version = ++_stateVersion;
+    _collectionVersions[(size_t)collection] = version;
+    portEXIT_CRITICAL(&_versionMux);
+    return version;
+}
+
+uint32_t AquariumManager::touchAquarium(Aquarium* aquarium) {
+    uint32_t version = _bumpVersion(Collection::AQUARIUMS);
+    aquarium->setVersion(version);
+    return version;
+}
+
+uint32_t AquariumManager::touchDevice(Device* device) {
+    uint32_t version = _bumpVersion(Collection::DEVICES);
+    device->setVersion(version);
+    return version;
+}
+
+uint32_t AquariumManager::markChanged(Collection collection) {
+    return _bumpVersion(collection);
+}
+
+void AquariumManager::_addTombstone(Collection collection, uint64_t key) {
+    uint32_t version = _bumpVersion(collection);
+    
+    portENTER_CRITICAL(&_versionMux);
+    if (_tombstones.size() >= MAX_TOMBSTONES) {
+        // Clients older than the dropped entry can no longer diff
+        _tombstoneFloor = _tombstones.front().version;
+        _tombstones.erase(_tombstones.begin());
+    }
+    Tombstone tombstone;
+    tombstone.collection = collection;
+    tombstone.key = key;
+    tombstone.version = version;
+    _tombstones.push_back(tombstone);
+    portEXIT_CRITICAL(&_versionMux);
+}
+
+void AquariumManager::changesToJson(uint32_t since, uint32_t bootId, JsonObject out) const {
+    out["bootId"] = _bootId;
+    out["version"] = _stateVersion;
+    
+    bool full = (bootId != _bootId) || (since < _tombstoneFloor) || (since > _stateVersion);
+    out["full"] = full;
+    if (full) {
+        // Client must refetch the list endpoints
+        return;
+    }
+    
+    JsonArray aquariums = out["aquariums"].to<JsonArray>();
+    for (const auto& pair : _aquariums) {
+        if (pair.second->getVersion() > since) {
+            pair.second->toJsonObject(aquariums.add<JsonObject>());
+        }
+    }
+    
+    JsonArray devices = out["devices"].to<JsonArray>();
+    for (const auto& pair : _globalDeviceRegistry) {
+        if (pair.second->getVersion() > since) {
+            pair.second->toJsonObject(devices.add<JsonObject>());
+        }
+    }
+    
+    JsonArray removed = out["removed"].to<JsonArray>();
+    portENTER_CRITICAL(&_versionMux);
+    std::vector<Tombstone> tombstones = _tombstones;
+    portEXIT_CRITICAL(&_versionMux);
+    
+    for (const Tombstone& tombstone : tombstones) {
+        if (tombstone.version <= since) {
+            continue;
+        }
+        JsonObject entry = removed.add<JsonObject>();
+        if (tombstone.collection == Collection::AQUARIUMS) {
+            entry["type"] = "aquarium";
+            entry["id"] = (uint8_t)tombstone.key;
+        } else {
+            // Key packs mac[i] into byte i (see _macToKey)
+            char macStr[18];
+            snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+                     (uint8_t)tombstone.key, (uint8_t)(tombstone.key >> 8),
+                     (uint8_t)(tombstone.key >> 16), (uint8_t)(tombstone.key >> 24),
+                     (uint8_t)(tombstone.key >> 32), (uint8_t)(tombstone.key >> 40));
+            entry["type"] = "device";
+            entry["mac"] = macStr;
+        }
+    }
+    
+    // File-backed lists have no per-entity versions; flag them instead
+    out["devicesChanged"] = getCollectionVersion(Collection::DEVICES) > since;
+    out["unmappedChanged"] = getCollectionVersion(Collection::UNMAPPED) > since;
+}
+
+bool AquariumManager::getRemovedDevices(uint32_t since, std::vector<RemovedDevice>& out) const {
+    portENTER_CRITICAL(&_versionMux);
+    std::vector<Tombstone> tombstones = _tombstones;
+    uint32_t floor = _tombstoneFloor;
+    portEXIT_CRITICAL(&_versionMux);
+    
+    if (since < floor) {
+        return false;
+    }
+    
+    for (const Tombstone& tombstone : tombstones) {
+        if (tombstone.collection != Collection::DEVICES || tombstone.version <= since) {
+            continue;
+        }
+        RemovedDevice removed;
+        for (uint8_t i = 0; i < 6; i++) {
+            removed.mac[i] = (uint8_t)(tombstone.key >> (8 * i));  // See _macToKey
+        }
+        removed.version = tombstone.version;
+        out.push_back(removed);
+    }
+    return true;
+}
+
 // ============================================================================
 // WEBSOCKET NOTIFICATIONS
 // ============================================================================
 
-void AquariumManager::broadcastUpdate(const String& event, const String& data) {
+void AquariumManager::broadcastUpdate(const String& event, JsonVariantConst data) {
     if (_wsCallback) {
         _wsCallback(event, data);
     }
 }
 
-void AquariumManager::setWebSocketCallback(void (*callback)(const String&, const String&)) {
+void AquariumManager::setWebSocketCallback(TelemetryCallback callback) {
     _wsCallback = callback;
 }
 
+void AquariumManager::_broadcastDevice(const String& event, const Device* device) {
+    if (!_wsCallback) {
+        return;
+    }
+    
+    JsonDocument doc;
+    device->toJsonObject(doc.to<JsonObject>());
+    _wsCallback(event, doc.as<JsonVariantConst>());
+}
+
+void AquariumManager::_broadcastAquarium(const String& event, const Aquarium* aquarium) {
+    if (!_wsCallback) {
+        return;
+    }
+    
+    JsonDocument doc;
+    aquarium->toJsonObject(doc.to<JsonObject>());
+    _wsCallback(event, doc.as<JsonVariantConst>());
+}
+
+void AquariumManager::_alertDevice(const String& event, const Device* device) {
+    std::shared_ptr<JsonDocument> doc = std::make_shared<JsonDocument>();
+    device->toJsonObject(doc->to<JsonObject>());
+    _dispatchAlert(event, doc);
+}
+
+void AquariumManager::_alertAquarium(const String& event, const Aquarium* aquarium) {
+    std::shared_ptr<JsonDocument> doc = std::make_shared<JsonDocument>();
+    aquarium->toJsonObject(doc->to<JsonObject>());
+    _dispatchAlert(event, doc);
+}
+
+void AquariumManager::_dispatchAlert(const String& event, std::shared_ptr<JsonDocument> doc) {
+    TelemetryCallback callback = _wsCallback;
+    if (!callback) {
+        return;
+    }
+    
+    // The check only snapshots state; encoding for and sending to every
+    // client happens on a worker
+    TaskExecutor::getInstance().submit([callback, event, doc](const TaskExecutor::JobContext& context) {
+        callback(event, doc->as<JsonVariantConst>());
+    }, TaskExecutor::Priority::URGENT);
+}
+
 // ============================================================================
 // STATISTICS
 // ============================================================================
@@ -606,17 +1392,31 @@ Device* AquariumManager::_createDevice(const uint8_t* mac, NodeType type, const
     return nullptr;
 }
 
+void AquariumManager::_applyProtocol(Device* device, const uint8_t* mac) {
+    // Negotiated by onAnnounceReceived() before the ANNOUNCE got here
+    ProtocolInfo protocol;
+    if (!ESPNowManager::getInstance().getPeerProtocol(mac, protocol)) {
+        return;
+    }
+    
+    if (device->setProtocol(protocol)) {
+        touchDevice(device);
+    }
+}
+
 void AquariumManager::_sendAck(const uint8_t* mac, uint8_t tankId, bool accepted) {
-    AckMessage ack;
+    AckProtocolMessage frame = {};
+    AckMessage& ack = frame.ack;
     ack.header.type = MessageType::ACK;
     ack.header.tankId = tankId;
     ack.header.nodeType = NodeType::HUB;
     ack.header.timestamp = millis();
     ack.header.sequenceNum = 0;
-    ack.assignedNodeId = 0;  // Not used for now
+    ack.assignedNodeId = accepted ? ESPNowManager::getInstance().assignSlot(mac) : 0;  // Beacon slot
     ack.accepted = accepted;
     
-    esp_err_t result = esp_now_send(mac, (uint8_t*)&ack, sizeof(ack));
+    size_t len = ESPNowManager::getInstance().completeAck(mac, frame);
+    esp_err_t result = esp_now_send(mac, (uint8_t*)&frame, len);
     
     if (result == ESP_OK) {
         Serial.println("   - ACK sent successfully");
@@ -0,0 +1,236 @@
+#include "managers/CalibrationStore.h"
+#include "managers/AquariumManager.h"
+#include "managers/DeviceConfigStore.h"
+#include "managers/EventJournal.h"
+#include "ESPNowManager.h"
+#include <LittleFS.h>
+#include <math.h>
+#include <time.h>
+
+CalibrationStore::CalibrationStore()
+    : _dirty(false) {
+}
+
+// ============================================================================
+// PERSISTENCE
+// ============================================================================
+
+bool CalibrationStore::load() {
+    File file = LittleFS.open(CALIBRATION_FILE, "r");
+    if (file) {
+        DeserializationError error = deserializeJson(_doc, file);
+        file.close();
+
+        if (error) {
+            Serial.printf("[WARN] %s unreadable (%s), starting empty\n", CALIBRATION_FILE, error.c_str());
+            _doc.clear();
+        }
+    }
+
+    if (!_doc["probes"].is<JsonArray>()) {
+        _doc["probes"].to<JsonArray>();
+    }
+    _dirty = false;
+    return true;
+}
+
+bool CalibrationStore::commit() {
+    if (!_dirty) {
+        return true;
+    }
+
+    String tmpPath = String(CALIBRATION_FILE) + ".tmp";
+    File file = LittleFS.open(tmpPath, "w");
+    if (!file) {
+        Serial.printf("[ERR] Cannot open %s for writing\n", tmpPath.c_str());
+        return false;
+    }
+
+    size_t written = serializeJson(_doc, file);
+    file.close();
+
+    if (written == 0 || !LittleFS.rename(tmpPath, CALIBRATION_FILE)) {
+        Serial.printf("[ERR] Failed to commit %s\n", CALIBRATION_FILE);
+        LittleFS.remove(tmpPath);
+        return false;
+    }
+
+    _dirty = false;
+    return true;
+}
+
+// ============================================================================
+// OPERATIONS
+// ============================================================================
+
+CalibrationStore::Result CalibrationStore::apply(const String& macStr, SensorCalibration::Probe probe,
+                                                 const SensorCalibration::CalPoint* points, uint8_t count,
+                                                 float refTempC) {
+    Result result;
+    uint8_t mac[6];
+
+    if (!DeviceConfigStore::parseMac(macStr, mac)) {
+        result.error = Error::INVALID_MAC;
+        return result;
+    }
+
+    SensorCalibration::Table table;
+    if (!SensorCalibration::compile(probe, points, count, refTempC, table)) {
+        result.error = Error::INVALID_POINTS;
+        return result;
+    }
+
+    if (!_sendTable(mac, table)) {
+        result.error = Error::SEND_FAILED;
+        return result;
+    }
+
+    _fitLine(points, count, result.slope, result.offset);
+
+    JsonObject entry = _findProbe(macStr, probe, true);
+    JsonArray history = entry["history"].as<JsonArray>();
+    if (history.isNull()) {
+        history = entry["history"].to<JsonArray>();
+    }
+    if (history.size() > 0) {
+        JsonObject previous = history[history.size() - 1];
+        float previousSlope = previous["slope"] | 0.0f;
+        if (previousSlope != 0.0f) {
+            result.slopeDriftPct = (result.slope - previousSlope) / fabsf(previousSlope) * 100.0f;
+        }
+        result.offsetDrift = result.offset - (previous["offset"] | 0.0f);
+    }
+
+    // Current table, as entered (the node holds the compiled copy)
+    JsonObject current = entry["current"].to<JsonObject>();
+    current["refTempC"] = refTempC;
+    JsonArray currentPoints = current["points"].to<JsonArray>();
+    for (uint8_t i = 0; i < count; i++) {
+        JsonObject point = currentPoints.add<JsonObject>();
+        point["reference"] = points[i].reference;
+        point["raw"] = points[i].raw;
+    }
+
+    time_t now = time(nullptr);
+    JsonObject record = history.add<JsonObject>();
+    record["epoch"] = now > 1600000000 ? (uint32_t)now : 0;
+    record["points"] = count;
+    record["refTempC"] = refTempC;
+    record["slope"] = result.slope;
+    record["offset"] = result.offset;
+    record["slopeDriftPct"] = result.slopeDriftPct;
+    record["offsetDrift"] = result.offsetDrift;
+
+    while (history.size() > MAX_HISTORY) {
+        history.remove(0);
+    }
+
+    _dirty = true;
+    Device* live = AquariumManager::getInstance().getDevice(mac);
+    EventJournal::getInstance().logConfig(EventJournal::Config::CALIBRATION, live ? live->getTankId() : 0, mac);
+    Serial.printf("[OK] %s %s calibrated: %u points, slope %.4f/1000 counts (%+.1f%%)\n",
+                  macStr.c_str(), probeName(probe), count, result.slope, result.slopeDriftPct);
+    return result;
+}
+
+void CalibrationStore::toJson(JsonArray out, const String& macStr) const {
+    for (JsonObjectConst entry : _doc["probes"].as<JsonArrayConst>()) {
+        if (macStr.length() == 0 || macStr.equalsIgnoreCase(entry["mac"].as<String>())) {
+            out.add(entry);
+        }
+    }
+}
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+const char* CalibrationStore::errorString(Error error) {
+    switch (error) {
+        case Error::INVALID_MAC: return "Invalid MAC address";
+        case Error::INVALID_PROBE: return "Probe must be 'ph' or 'tds'";
+        case Error::INVALID_POINTS: return "Need 2-5 points with distinct raw values and a monotonic response";
+        case Error::SEND_FAILED: return "Failed to send calibration to node";
+        default: return "OK";
+    }
+}
+
+const char* CalibrationStore::probeName(SensorCalibration::Probe probe) {
+    return probe == SensorCalibration::Probe::PH ? "ph" : "tds";
+}
+
+bool CalibrationStore::parseProbe(const String& name, SensorCalibration::Probe& probe) {
+    if (name.equalsIgnoreCase("ph")) {
+        probe = SensorCalibration::Probe::PH;
+        return true;
+    }
+    if (name.equalsIgnoreCase("tds")) {
+        probe = SensorCalibration::Probe::TDS;
+        return true;
+    }
+    return false;
+}
+
+JsonObject CalibrationStore::_findProbe(const String& macStr, SensorCalibration::Probe probe, bool create) {
+    JsonArray probes = _doc["probes"].as<JsonArray>();
+    for (JsonObject entry : probes) {
+        if (macStr.equalsIgnoreCase(entry["mac"].as<String>()) &&
+            strcmp(entry["probe"] | "", probeName(probe)) == 0) {
+            return entry;
+        }
+    }
+
+    if (!create) {
+        return JsonObject();
+    }
+    JsonObject entry = probes.add<JsonObject>();
+    entry["mac"] = macStr;
+    entry["probe"] = probeName(probe);
+    entry["history"].to<JsonArray>();
+    return entry;
+}
+
+bool CalibrationStore::_sendTable(const uint8_t* mac, const SensorCalibration::Table& table) {
+    uint8_t commandData[MAX_COMMAND_DATA_LEN];
+    size_t length = SensorCalibration::encode(commandData, table);
+
+    // Registered devices get a proper transaction ID
+    Device* device = AquariumManager::getInstance().getDevice(mac);
+    if (device) {
+        return device->sendCommand(commandData, length);
+    }
+
+    CommandMessage cmd = {};
+    cmd.header.type = MessageType::COMMAND;
+    cmd.header.nodeType = NodeType::HUB;
+    cmd.header.timestamp = millis();
+    cmd.commandId = 1;
+    cmd.finalCommand = true;
+    cmd.commandLen = length;
+    memcpy(cmd.commandData, commandData, length);
+
+    return ESPNowManager::getInstance().send(mac, (uint8_t*)&cmd, commandFrameSize(cmd));
+}
+
+// Least-squares line through the points (reference units per 1000 counts)
+void CalibrationStore::_fitLine(const SensorCalibration::CalPoint* points, uint8_t count,
+                                float& slope, float& offset) {
+    float meanRaw = 0, meanRef = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        meanRaw += points[i].raw;
+        meanRef += points[i].reference;
+    }
+    meanRaw /= count;
+    meanRef /= count;
+
+    float sxy = 0, sxx = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        float dx = points[i].raw - meanRaw;
+        sxy += dx * (points[i].reference - meanRef);
+        sxx += dx * dx;
+    }
+
+    float perCount = sxx > 0 ? sxy / sxx : 0;
+    slope = perCount * 1000.0f;
+    offset = meanRef - perCount * meanRaw;
+}
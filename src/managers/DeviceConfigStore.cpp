@@ -0,0 +1,345 @@
+#include "managers/DeviceConfigStore.h"
+#include "managers/AquariumManager.h"
+#include "managers/EventJournal.h"
+#include "ESPNowManager.h"
+#include <LittleFS.h>
+
+DeviceConfigStore::DeviceConfigStore()
+    : _devicesDirty(false)
+    , _unmappedDirty(false)
+    , _sendFrames(true)
+    , _locked(false) {
+}
+
+DeviceConfigStore::~DeviceConfigStore() {
+    if (_locked) {
+        xSemaphoreGive(_fileLock());
+    }
+}
+
+SemaphoreHandle_t DeviceConfigStore::_fileLock() {
+    static SemaphoreHandle_t lock = xSemaphoreCreateMutex();
+    return lock;
+}
+
+// ============================================================================
+// PERSISTENCE
+// ============================================================================
+
+bool DeviceConfigStore::load() {
+    if (!_locked) {
+        xSemaphoreTake(_fileLock(), portMAX_DELAY);
+        _locked = true;
+    }
+    
+    _devicesDoc.clear();
+    _unmappedDoc.clear();
+    _readFile(DEVICES_FILE, _devicesDoc);
+    _readFile(UNMAPPED_FILE, _unmappedDoc);
+
+    // Missing or empty files start with the expected structure
+    if (!_devicesDoc["devices"].is<JsonArray>()) {
+        _devicesDoc["devices"].to<JsonArray>();
+    }
+    if (!_unmappedDoc["unmappedDevices"].is<JsonArray>()) {
+        _unmappedDoc["unmappedDevices"].to<JsonArray>();
+    }
+    if (_unmappedDoc["metadata"].isNull()) {
+        _unmappedDoc["metadata"]["lastCleanup"] = 0;
+        _unmappedDoc["metadata"]["totalDiscovered"] = 0;
+        _unmappedDoc["metadata"]["autoCleanupAfterDays"] = 7;
+    }
+
+    _devicesDirty = false;
+    _unmappedDirty = false;
+    return true;
+}
+
+bool DeviceConfigStore::commit() {
+    bool ok = true;
+
+    if (_devicesDirty) {
+        ok &= _writeFile(DEVICES_FILE, _devicesDoc);
+        _devicesDirty = false;
+        AquariumManager::getInstance().markChanged(AquariumManager::Collection::DEVICES);
+    }
+    if (_unmappedDirty) {
+        ok &= _writeFile(UNMAPPED_FILE, _unmappedDoc);
+        _unmappedDirty = false;
+        AquariumManager::getInstance().markChanged(AquariumManager::Collection::UNMAPPED);
+    }
+
+    return ok;
+}
+
+bool DeviceConfigStore::_readFile(const char* path, JsonDocument& doc) {
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+
+    if (error) {
+        Serial.printf("[WARN] %s unreadable (%s), starting empty\n", path, error.c_str());
+        doc.clear();
+        return false;
+    }
+    return true;
+}
+
+bool DeviceConfigStore::_writeFile(const char* path, const JsonDocument& doc) {
+    String tmpPath = String(path) + ".tmp";
+
+    File file = LittleFS.open(tmpPath, "w");
+    if (!file) {
+        Serial.printf("[ERR] Cannot open %s for writing\n", tmpPath.c_str());
+        return false;
+    }
+
+    size_t written = serializeJson(doc, file);
+    file.close();
+
+    if (written == 0 || !LittleFS.rename(tmpPath, path)) {
+        Serial.printf("[ERR] Failed to commit %s\n", path);
+        LittleFS.remove(tmpPath);
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// OPERATIONS
+// ============================================================================
+
+DeviceConfigStore::Result DeviceConfigStore::provision(const String& macStr, const String& name, uint8_t tankId) {
+    Result result;
+    uint8_t mac[6];
+
+    if (!parseMac(macStr, mac)) {
+        result.error = Error::INVALID_MAC;
+        return result;
+    }
+    if (name.length() == 0 || tankId == 0) {
+        result.error = Error::INVALID_ARGUMENT;
+        return result;
+    }
+
+    JsonArray unmapped = _unmappedDoc["unmappedDevices"];
+    int index = _indexOf(unmapped, macStr);
+    if (index < 0) {
+        result.error = Error::NOT_FOUND;
+        return result;
+    }
+
+    // Node must receive its tank assignment, otherwise keep it unmapped
+    if (_sendFrames) {
+        if (!sendConfig(mac, name, tankId)) {
+            result.error = Error::SEND_FAILED;
+            return result;
+        }
+        result.frameSent = true;
+    }
+
+    JsonObject found = unmapped[index];
+    JsonObject device = _devicesDoc["devices"].as<JsonArray>().add<JsonObject>();
+    device["mac"] = macStr;
+    device["type"] = found["type"];
+    device["name"] = name;
+    device["tankId"] = tankId;
+    device["firmwareVersion"] = found["firmwareVersion"];
+    device["enabled"] = true;
+    device["status"] = "PROVISIONING";
+
+    unmapped.remove(index);
+
+    _devicesDirty = true;
+    _unmappedDirty = true;
+    EventJournal::getInstance().logConfig(EventJournal::Config::DEVICE_PROVISIONED, tankId, mac);
+    result.status = "PROVISIONED";
+    return result;
+}
+
+DeviceConfigStore::Result DeviceConfigStore::unmap(const String& macStr) {
+    Result result;
+    uint8_t mac[6];
+
+    if (!parseMac(macStr, mac)) {
+        result.error = Error::INVALID_MAC;
+        return result;
+    }
+
+    JsonArray devices = _devicesDoc["devices"];
+    int index = _indexOf(devices, macStr);
+    if (index < 0) {
+        result.error = Error::NOT_FOUND;
+        return result;
+    }
+
+    // Offline nodes are unmapped anyway; they re-announce as unmapped
+    // once they see their tank is gone
+    if (_sendFrames) {
+        result.frameSent = sendUnmap(mac);
+        if (!result.frameSent) {
+            Serial.printf("[WARN] UNMAP to %s not sent (device may be offline)\n", macStr.c_str());
+        }
+    }
+
+    JsonObject found = devices[index];
+    EventJournal::getInstance().logConfig(EventJournal::Config::DEVICE_UNMAPPED, found["tankId"] | 0, mac);
+    JsonObject entry = _unmappedDoc["unmappedDevices"].as<JsonArray>().add<JsonObject>();
+    entry["mac"] = macStr;
+    entry["type"] = found["type"];
+    entry["firmwareVersion"] = found["firmwareVersion"];
+    entry["discoveredAt"] = millis();
+    entry["announceCount"] = 0;
+
+    devices.remove(index);
+
+    _devicesDirty = true;
+    _unmappedDirty = true;
+    result.status = "UNMAPPED";
+    return result;
+}
+
+DeviceConfigStore::Result DeviceConfigStore::rename(const String& macStr, const String& name) {
+    Result result;
+    uint8_t mac[6];
+
+    if (!parseMac(macStr, mac)) {
+        result.error = Error::INVALID_MAC;
+        return result;
+    }
+    if (name.length() == 0) {
+        result.error = Error::INVALID_ARGUMENT;
+        return result;
+    }
+
+    JsonObject device = findDevice(macStr);
+    if (device.isNull()) {
+        result.error = Error::NOT_FOUND;
+        return result;
+    }
+
+    result.frameSent = sendConfig(mac, name, device["tankId"] | 0);
+
+    device["name"] = name;
+    _devicesDirty = true;
+
+    Device* live = AquariumManager::getInstance().getDevice(mac);
+    if (live) {
+        live->setName(name);
+    }
+
+    EventJournal::getInstance().logConfig(EventJournal::Config::DEVICE_RENAMED, device["tankId"] | 0, mac);
+    result.status = "RENAMED";
+    return result;
+}
+
+DeviceConfigStore::Result DeviceConfigStore::move(const String& macStr, uint8_t tankId) {
+    Result result;
+    uint8_t mac[6];
+
+    if (!parseMac(macStr, mac)) {
+        result.error = Error::INVALID_MAC;
+        return result;
+    }
+    if (tankId == 0) {
+        result.error = Error::INVALID_ARGUMENT;
+        return result;
+    }
+
+    JsonObject device = findDevice(macStr);
+    if (device.isNull()) {
+        result.error = Error::NOT_FOUND;
+        return result;
+    }
+
+    if (!sendConfig(mac, device["name"] | "", tankId)) {
+        result.error = Error::SEND_FAILED;
+        return result;
+    }
+    result.frameSent = true;
+
+    // Aquarium membership follows when the node re-announces on the new tank
+    device["tankId"] = tankId;
+    device["status"] = "PROVISIONING";
+    _devicesDirty = true;
+    EventJournal::getInstance().logConfig(EventJournal::Config::DEVICE_MOVED, tankId, mac);
+
+    result.status = "MOVED";
+    return result;
+}
+
+JsonObject DeviceConfigStore::findDevice(const String& macStr) {
+    JsonArray devices = _devicesDoc["devices"];
+    int index = _indexOf(devices, macStr);
+    if (index < 0) {
+        return JsonObject();
+    }
+    return devices[index];
+}
+
+bool DeviceConfigStore::isMapped(const String& macStr) {
+    return !findDevice(macStr).isNull();
+}
+
+bool DeviceConfigStore::isUnmapped(const String& macStr) {
+    return _indexOf(_unmappedDoc["unmappedDevices"], macStr) >= 0;
+}
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+const char* DeviceConfigStore::errorString(Error error) {
+    switch (error) {
+        case Error::NONE: return "OK";
+        case Error::INVALID_MAC: return "Invalid MAC address";
+        case Error::INVALID_ARGUMENT: return "Missing or invalid name/tankId";
+        case Error::NOT_FOUND: return "Device not found";
+        case Error::SEND_FAILED: return "Failed to send CONFIG to device";
+        case Error::BUSY: return "Another operation on this device is in progress";
+        case Error::TOO_MANY: return "Too many provisioning operations in progress";
+    }
+    return "Unknown error";
+}
+
+bool DeviceConfigStore::parseMac(const String& macStr, uint8_t* mac) {
+    return sscanf(macStr.c_str(), "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+                  &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]) == 6;
+}
+
+int DeviceConfigStore::_indexOf(JsonArray list, const String& macStr) const {
+    for (size_t i = 0; i < list.size(); i++) {
+        if (macStr.equalsIgnoreCase(list[i]["mac"].as<String>())) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+bool DeviceConfigStore::sendConfig(const uint8_t* mac, const String& name, uint8_t tankId, uint8_t token) {
+    ConfigMessage configMsg = {};
+    configMsg.header.type = MessageType::CONFIG;
+    configMsg.header.tankId = tankId;
+    configMsg.header.nodeType = NodeType::HUB;
+    configMsg.header.timestamp = millis();
+    configMsg.header.sequenceNum = token;
+    strncpy(configMsg.deviceName, name.c_str(), MAX_NODE_NAME_LEN - 1);
+
+    return ESPNowManager::getInstance().send(mac, (uint8_t*)&configMsg, sizeof(configMsg));
+}
+
+bool DeviceConfigStore::sendUnmap(const uint8_t* mac, uint8_t token) {
+    UnmapMessage unmapMsg = {};
+    unmapMsg.header.type = MessageType::UNMAP;
+    unmapMsg.header.tankId = 0;  // Reset to unmapped
+    unmapMsg.header.nodeType = NodeType::HUB;
+    unmapMsg.header.timestamp = millis();
+    unmapMsg.header.sequenceNum = token;
+    unmapMsg.reason = 1;  // User-initiated unmap
+
+    return ESPNowManager::getInstance().send(mac, (uint8_t*)&unmapMsg, sizeof(unmapMsg));
+}
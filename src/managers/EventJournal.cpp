@@ -0,0 +1,545 @@
+#include "managers/EventJournal.h"
+#include <LittleFS.h>
+#include <time.h>
+
+EventJournal& EventJournal::getInstance() {
+    static EventJournal instance;
+    return instance;
+}
+
+EventJournal::EventJournal()
+    : _fileMutex(xSemaphoreCreateMutex())
+    , _pendingHead(0)
+    , _pendingCount(0)
+    , _nextSeq(1)
+    , _dropped(0)
+    , _lastFlushMs(0)
+    , _ready(false)
+    , _active(0) {
+    _queueMux = portMUX_INITIALIZER_UNLOCKED;
+    memset(_index, 0, sizeof(_index));
+}
+
+// ============================================================================
+// LIFECYCLE
+// ============================================================================
+
+bool EventJournal::begin() {
+    xSemaphoreTake(_fileMutex, portMAX_DELAY);
+
+    LittleFS.mkdir("/journal");
+
+    // Newest segment (highest first sequence) is the one to append to
+    bool found = false;
+    bool tornTail = false;
+    for (uint8_t i = 0; i < SEGMENT_COUNT; i++) {
+        bool intact = _scanSegment(i);
+        if (!_index[i].valid) {
+            continue;
+        }
+        if (!found || _index[i].firstSeq > _index[_active].firstSeq) {
+            _active = i;
+            tornTail = !intact;
+            found = true;
+        }
+    }
+
+    if (found) {
+        _nextSeq = _index[_active].firstSeq + _index[_active].count;
+        // Appending after a torn record would hide everything behind it
+        if (tornTail || _index[_active].count >= SEGMENT_RECORDS) {
+            _ready = _startSegment((_active + 1) % SEGMENT_COUNT, _nextSeq);
+        } else {
+            _ready = true;
+        }
+    } else {
+        _nextSeq = 1;
+        _ready = _startSegment(0, _nextSeq);
+    }
+
+    if (_ready) {
+        uint32_t stored = 0;
+        for (uint8_t i = 0; i < SEGMENT_COUNT; i++) {
+            if (_index[i].valid) stored += _index[i].count;
+        }
+        Serial.printf("[OK] Event journal: %u records, next #%u (segment %u)\n",
+                      stored, _nextSeq, _active);
+    } else {
+        Serial.println("[ERR] Event journal unavailable, events are not recorded");
+    }
+
+    xSemaphoreGive(_fileMutex);
+    return _ready;
+}
+
+/**
+ * @brief Rebuild one segment's index entry
+ * @return false if the segment ends in a record that failed its check
+ */
+bool EventJournal::_scanSegment(uint8_t segment) {
+    SegmentIndex& index = _index[segment];
+    memset(&index, 0, sizeof(index));
+
+    char path[24];
+    _segmentPath(segment, path, sizeof(path));
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return true;
+    }
+
+    SegmentHeader header;
+    if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+        header.magic != SEGMENT_MAGIC || header.version != SEGMENT_VERSION || header.index != segment) {
+        file.close();
+        return true;
+    }
+
+    index.valid = true;
+    index.firstSeq = header.firstSeq;
+
+    Record record;
+    while (index.count < SEGMENT_RECORDS &&
+           file.read((uint8_t*)&record, sizeof(record)) == sizeof(record)) {
+        if (record.crc != _crc16((const uint8_t*)&record, sizeof(record) - sizeof(record.crc)) ||
+            record.seq != index.firstSeq + index.count) {
+            break;
+        }
+        uint32_t& blockMax = index.blockMaxTime[index.count / INDEX_STRIDE];
+        if (record.time > blockMax) {
+            blockMax = record.time;
+        }
+        index.count++;
+    }
+
+    bool intact = file.size() == sizeof(SegmentHeader) + (size_t)index.count * sizeof(Record);
+    file.close();
+    return intact;
+}
+
+bool EventJournal::_startSegment(uint8_t segment, uint32_t firstSeq) {
+    char path[24];
+    _segmentPath(segment, path, sizeof(path));
+
+    File file = LittleFS.open(path, "w");
+    if (!file) {
+        Serial.printf("[ERR] Cannot create %s\n", path);
+        _index[segment].valid = false;
+        return false;
+    }
+
+    SegmentHeader header;
+    header.magic = SEGMENT_MAGIC;
+    header.version = SEGMENT_VERSION;
+    header.index = segment;
+    header.firstSeq = firstSeq;
+    bool ok = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+    file.close();
+
+    SegmentIndex& index = _index[segment];
+    memset(&index, 0, sizeof(index));
+    index.valid = ok;
+    index.firstSeq = firstSeq;
+    _active = segment;
+    return ok;
+}
+
+// ============================================================================
+// APPEND
+// ============================================================================
+
+void EventJournal::log(Type type, uint8_t tankId, const uint8_t* mac, const uint8_t* data, size_t dataLen) {
+    Record record;
+    memset(&record, 0, sizeof(record));
+    time_t now = time(nullptr);
+    record.time = now > 1600000000 ? (uint32_t)now : 0;
+    record.uptimeSec = millis() / 1000;
+    record.type = type;
+    record.tankId = tankId;
+    if (mac) {
+        memcpy(record.mac, mac, 6);
+    }
+    if (data && dataLen > 0) {
+        record.dataLen = dataLen > DATA_LEN ? DATA_LEN : dataLen;
+        memcpy(record.data, data, record.dataLen);
+    }
+
+    // Sequence and CRC are assigned on flush, in write order
+    portENTER_CRITICAL(&_queueMux);
+    if (_pendingCount < PENDING_CAPACITY) {
+        _pending[(_pendingHead + _pendingCount) % PENDING_CAPACITY] = record;
+        _pendingCount++;
+    } else {
+        _dropped++;
+    }
+    portEXIT_CRITICAL(&_queueMux);
+}
+
+void EventJournal::logCommand(uint8_t tankId, const uint8_t* mac, uint8_t commandId,
+                              const uint8_t* command, size_t length, bool delivered) {
+    uint8_t data[DATA_LEN];
+    size_t len = 0;
+    if (delivered) {
+        data[len++] = commandId;
+    }
+    size_t copy = length > DATA_LEN - len ? DATA_LEN - len : length;
+    memcpy(data + len, command, copy);
+    len += copy;
+    log(delivered ? Type::COMMAND : Type::COMMAND_FAILED, tankId, mac, data, len);
+}
+
+void EventJournal::logAlert(uint8_t tankId, Alert alert, float value, bool raised) {
+    uint8_t data[1 + sizeof(float)];
+    data[0] = (uint8_t)alert;
+    memcpy(data + 1, &value, sizeof(float));
+    log(raised ? Type::ALERT : Type::ALERT_CLEARED, tankId, nullptr, data, raised ? sizeof(data) : 1);
+}
+
+void EventJournal::logConfig(Config change, uint8_t tankId, const uint8_t* mac) {
+    uint8_t data = (uint8_t)change;
+    log(Type::CONFIG, tankId, mac, &data, 1);
+}
+
+void EventJournal::flush(bool force) {
+    uint32_t now = millis();
+    if (!_ready || _pendingCount == 0 ||
+        (!force && _pendingCount < PENDING_CAPACITY / 4 && now - _lastFlushMs < FLUSH_INTERVAL_MS)) {
+        return;
+    }
+    _lastFlushMs = now;
+
+    Record batch[PENDING_CAPACITY];
+    uint8_t count = 0;
+    portENTER_CRITICAL(&_queueMux);
+    while (_pendingCount > 0) {
+        batch[count++] = _pending[_pendingHead];
+        _pendingHead = (_pendingHead + 1) % PENDING_CAPACITY;
+        _pendingCount--;
+    }
+    portEXIT_CRITICAL(&_queueMux);
+
+    xSemaphoreTake(_fileMutex, portMAX_DELAY);
+    uint8_t written = 0;
+    while (written < count) {
+        SegmentIndex& index = _index[_active];
+        if (index.count >= SEGMENT_RECORDS &&
+            !_startSegment((_active + 1) % SEGMENT_COUNT, _nextSeq)) {
+            break;
+        }
+
+        uint16_t space = SEGMENT_RECORDS - _index[_active].count;
+        uint8_t room = (uint16_t)(count - written) < space ? count - written : (uint8_t)space;
+        for (uint8_t i = written; i < written + room; i++) {
+            batch[i].seq = _nextSeq + (i - written);
+            batch[i].crc = _crc16((const uint8_t*)&batch[i], sizeof(Record) - sizeof(batch[i].crc));
+        }
+
+        char path[24];
+        _segmentPath(_active, path, sizeof(path));
+        File file = LittleFS.open(path, "a");
+        size_t bytes = room * sizeof(Record);
+        if (!file || file.write((const uint8_t*)&batch[written], bytes) != bytes) {
+            if (file) file.close();
+            // Partial write: the tail is torn; continue in a fresh segment
+            Serial.printf("[ERR] Event journal write failed (%s)\n", path);
+            _startSegment((_active + 1) % SEGMENT_COUNT, _nextSeq);
+            break;
+        }
+        file.close();
+
+        SegmentIndex& active = _index[_active];
+        for (uint8_t i = written; i < written + room; i++) {
+            uint32_t& blockMax = active.blockMaxTime[active.count / INDEX_STRIDE];
+            if (batch[i].time > blockMax) {
+                blockMax = batch[i].time;
+            }
+            active.count++;
+        }
+        _nextSeq += room;
+        written += room;
+    }
+    xSemaphoreGive(_fileMutex);
+
+    if (written < count) {
+        _dropped += count - written;
+    }
+}
+
+// ============================================================================
+// QUERY
+// ============================================================================
+
+std::shared_ptr<EventJournal::Query> EventJournal::query(const Filter& filter) {
+    return std::make_shared<Query>(*this, filter);
+}
+
+/**
+ * @brief Read up to max consecutive records starting at seq
+ *
+ * Skips records lost to rotation and index blocks whose newest record is
+ * older than minTime. Advances seq past the records returned.
+ * @return Records read; 0 = no more
+ */
+uint8_t EventJournal::_readBatch(uint32_t& seq, Record* out, uint8_t max, uint32_t minTime) {
+    xSemaphoreTake(_fileMutex, portMAX_DELAY);
+
+    uint8_t read = 0;
+    while (read == 0) {
+        // Segment holding seq, or the oldest one after it
+        int8_t segment = -1;
+        int8_t after = -1;
+        for (uint8_t i = 0; i < SEGMENT_COUNT; i++) {
+            const SegmentIndex& index = _index[i];
+            if (!index.valid || index.count == 0) continue;
+            if (seq >= index.firstSeq && seq < index.firstSeq + index.count) {
+                segment = i;
+                break;
+            }
+            if (index.firstSeq > seq && (after < 0 || index.firstSeq < _index[after].firstSeq)) {
+                after = i;
+            }
+        }
+        if (segment < 0) {
+            if (after < 0) break;
+            segment = after;
+            seq = _index[after].firstSeq;
+        }
+
+        const SegmentIndex& index = _index[segment];
+        uint16_t offset = seq - index.firstSeq;
+
+        // Whole block older than the query: jump to the next block
+        if (minTime > 0 && index.blockMaxTime[offset / INDEX_STRIDE] < minTime) {
+            seq = index.firstSeq + (offset / INDEX_STRIDE + 1) * INDEX_STRIDE;
+            if (seq > index.firstSeq + index.count) {
+                seq = index.firstSeq + index.count;
+            }
+            continue;
+        }
+
+        uint16_t blockEnd = (offset / INDEX_STRIDE + 1) * INDEX_STRIDE;
+        uint16_t available = (blockEnd < index.count ? blockEnd : index.count) - offset;
+        uint8_t want = available < max ? available : max;
+
+        char path[24];
+        _segmentPath(segment, path, sizeof(path));
+        File file = LittleFS.open(path, "r");
+        if (file && file.seek(sizeof(SegmentHeader) + (size_t)offset * sizeof(Record))) {
+            size_t bytes = file.read((uint8_t*)out, want * sizeof(Record));
+            read = bytes / sizeof(Record);
+        }
+        if (file) file.close();
+
+        if (read == 0) {
+            // Unreadable: skip the segment
+            seq = index.firstSeq + index.count;
+            continue;
+        }
+        seq += read;
+    }
+
+    xSemaphoreGive(_fileMutex);
+    return read;
+}
+
+EventJournal::Query::Query(EventJournal& journal, const Filter& filter)
+    : _journal(journal)
+    , _filter(filter)
+    , _nextSeq(0)
+    , _batchCount(0)
+    , _batchPos(0)
+    , _emitted(0)
+    , _stage(0)
+    , _truncated(false)
+    , _textPos(0) {
+}
+
+size_t EventJournal::Query::read(uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+        if (_textPos >= _text.length()) {
+            _text = "";
+            _textPos = 0;
+            if (!_nextText()) {
+                break;
+            }
+            continue;
+        }
+        size_t copy = _text.length() - _textPos;
+        if (copy > maxLen - written) {
+            copy = maxLen - written;
+        }
+        memcpy(buffer + written, _text.c_str() + _textPos, copy);
+        _textPos += copy;
+        written += copy;
+    }
+    return written;
+}
+
+/**
+ * @brief Produce the next piece of the response into _text
+ * @return false when the response is complete
+ */
+bool EventJournal::Query::_nextText() {
+    switch (_stage) {
+        case 0:
+            _text = "{\"events\":[";
+            _stage = 1;
+            return true;
+
+        case 1:
+            while (true) {
+                if (_emitted >= _filter.limit) {
+                    _truncated = true;
+                    _stage = 2;
+                    return _nextText();
+                }
+                if (_batchPos >= _batchCount) {
+                    _batchCount = _journal._readBatch(_nextSeq, _batch, BATCH, _filter.from);
+                    _batchPos = 0;
+                    if (_batchCount == 0) {
+                        _stage = 2;
+                        return _nextText();
+                    }
+                }
+
+                const Record& record = _batch[_batchPos++];
+                if ((_filter.from > 0 && record.time < _filter.from) ||
+                    (_filter.to > 0 && (record.time == 0 || record.time > _filter.to)) ||
+                    (_filter.matchMac && memcmp(record.mac, _filter.mac, 6) != 0) ||
+                    (_filter.tankId != 0 && record.tankId != _filter.tankId) ||
+                    (_filter.type != 0 && (uint8_t)record.type != _filter.type)) {
+                    continue;
+                }
+
+                if (_emitted > 0) {
+                    _text += ',';
+                }
+                _recordToJson(record, _text);
+                _emitted++;
+                return true;
+            }
+
+        case 2:
+            _text = _truncated ? "],\"truncated\":true}" : "],\"truncated\":false}";
+            _stage = 3;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// ============================================================================
+// FORMATTING
+// ============================================================================
+
+const char* EventJournal::typeName(Type type) {
+    switch (type) {
+        case Type::BOOT: return "boot";
+        case Type::COMMAND: return "command";
+        case Type::COMMAND_FAILED: return "commandFailed";
+        case Type::STATUS: return "status";
+        case Type::SCHEDULE: return "schedule";
+        case Type::ALERT: return "alert";
+        case Type::ALERT_CLEARED: return "alertCleared";
+        case Type::DEVICE_ONLINE: return "online";
+        case Type::DEVICE_OFFLINE: return "offline";
+        case Type::CONFIG: return "config";
+        default: return "unknown";
+    }
+}
+
+bool EventJournal::parseType(const String& name, uint8_t& type) {
+    for (uint8_t value = (uint8_t)Type::BOOT; value <= (uint8_t)Type::CONFIG; value++) {
+        if (name.equalsIgnoreCase(typeName((Type)value))) {
+            type = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+void EventJournal::_recordToJson(const Record& record, String& out) {
+    char line[256];
+    int len = snprintf(line, sizeof(line),
+                       "{\"seq\":%u,\"time\":%u,\"uptime\":%u,\"type\":\"%s\",\"tankId\":%u,"
+                       "\"mac\":\"%02X:%02X:%02X:%02X:%02X:%02X\",\"data\":\"",
+                       record.seq, record.time, record.uptimeSec, typeName(record.type), record.tankId,
+                       record.mac[0], record.mac[1], record.mac[2],
+                       record.mac[3], record.mac[4], record.mac[5]);
+    for (uint8_t i = 0; i < record.dataLen && i < DATA_LEN; i++) {
+        len += snprintf(line + len, sizeof(line) - len, "%02X", record.data[i]);
+    }
+    line[len++] = '"';
+
+    // Decoded fields for the common cases
+    const uint8_t* d = record.data;
+    switch (record.type) {
+        case Type::COMMAND:
+        case Type::STATUS:
+            if (record.dataLen >= 2) {
+                len += snprintf(line + len, sizeof(line) - len, ",\"commandId\":%u,\"%s\":%u",
+                                d[0], record.type == Type::COMMAND ? "opcode" : "statusCode", d[1]);
+            }
+            break;
+        case Type::COMMAND_FAILED:
+            if (record.dataLen >= 1) {
+                len += snprintf(line + len, sizeof(line) - len, ",\"opcode\":%u", d[0]);
+            }
+            break;
+        case Type::SCHEDULE:
+            if (record.dataLen >= 5) {
+                uint32_t scheduleId;
+                memcpy(&scheduleId, d, sizeof(scheduleId));
+                len += snprintf(line + len, sizeof(line) - len, ",\"scheduleId\":%u,\"opcode\":%u",
+                                scheduleId, d[4]);
+            }
+            break;
+        case Type::ALERT:
+        case Type::ALERT_CLEARED:
+            if (record.dataLen >= 1) {
+                static const char* alerts[] = {"", "temperature", "ph", "probe", "emergency"};
+                len += snprintf(line + len, sizeof(line) - len, ",\"alert\":\"%s\"",
+                                d[0] <= (uint8_t)Alert::EMERGENCY ? alerts[d[0]] : "");
+            }
+            if (record.dataLen >= 1 + sizeof(float)) {
+                float value;
+                memcpy(&value, d + 1, sizeof(value));
+                len += snprintf(line + len, sizeof(line) - len, ",\"value\":%.2f", value);
+            }
+            break;
+        case Type::CONFIG:
+            if (record.dataLen >= 1) {
+                static const char* changes[] = {"", "aquariumAdded", "aquariumRemoved", "deviceProvisioned",
+                                                "deviceUnmapped", "deviceRenamed", "deviceMoved", "calibration"};
+                len += snprintf(line + len, sizeof(line) - len, ",\"change\":\"%s\"",
+                                d[0] <= (uint8_t)Config::CALIBRATION ? changes[d[0]] : "");
+            }
+            break;
+        default:
+            break;
+    }
+
+    line[len++] = '}';
+    line[len] = '\0';
+    out += line;
+}
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+void EventJournal::_segmentPath(uint8_t segment, char* path, size_t size) {
+    snprintf(path, size, "/journal/seg%u.bin", segment);
+}
+
+uint16_t EventJournal::_crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
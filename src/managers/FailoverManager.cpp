@@ -0,0 +1,491 @@
+#include "managers/FailoverManager.h"
+#include "managers/DeviceConfigStore.h"
+#include "ESPNowManager.h"
+#include <LittleFS.h>
+
+const char* const FailoverManager::FILES[FailoverManager::FILE_COUNT] = {
+    "/config/aquariums.json",
+    "/config/devices.json",
+    "/config/unmapped-devices.json",
+    "/config/calibration.json",
+    "/config/schedules.jnl"
+};
+
+FailoverManager& FailoverManager::getInstance() {
+    static FailoverManager instance;
+    return instance;
+}
+
+FailoverManager::FailoverManager()
+    : _paired(false)
+    , _wasStandby(false)
+    , _lastSyncCheckMs(0)
+    , _takeoverCallback(nullptr)
+    , _filesApplied(0)
+    , _takeovers(0) {
+    memset(_ownMac, 0, sizeof(_ownMac));
+    memset(_partnerMac, 0, sizeof(_partnerMac));
+    memset(_outgoing, 0, sizeof(_outgoing));
+    memset(_incoming, 0, sizeof(_incoming));
+}
+
+// ============================================================================
+// ROLES
+// ============================================================================
+
+bool FailoverManager::begin(const String& partnerMac, bool preferStandby, uint16_t beaconIntervalMs) {
+    WiFi.macAddress(_ownMac);
+
+    FailoverPolicy::Identity identity;
+    if (!_loadIdentity(identity)) {
+        memset(&identity, 0, sizeof(identity));
+    }
+
+    bool valid = partnerMac.length() == 0 || DeviceConfigStore::parseMac(partnerMac, _partnerMac);
+    _paired = partnerMac.length() > 0 && valid && memcmp(_partnerMac, _ownMac, 6) != 0;
+
+    uint32_t listenMs = (uint32_t)beaconIntervalMs * LISTEN_BEACONS;
+    uint32_t takeoverMs = (uint32_t)beaconIntervalMs * TAKEOVER_BEACONS;
+    _policy.begin(_ownMac, preferStandby && _paired, identity, listenMs, takeoverMs, millis());
+
+    if (!_paired) {
+        // Single hub: active at once, still beacons its identity so a
+        // standby added later can take over without re-provisioning
+        _handleEvent(_policy.update(millis() + listenMs));
+        if (!valid) {
+            Serial.printf("[ERR] Invalid HUB_PARTNER '%s', running as single hub\n", partnerMac.c_str());
+        }
+        return valid;
+    }
+
+    // What is already on flash need not be sent again after a restart
+    for (uint8_t i = 0; i < FILE_COUNT; i++) {
+        _fileDigest(FILES[i], _incoming[i].appliedSize, _incoming[i].appliedCrc);
+    }
+
+    ESPNowManager::getInstance().addPeer(_partnerMac);
+    Serial.printf("[OK] Failover: paired with %s as preferred %s, listening %u ms\n",
+                  partnerMac.c_str(), preferStandby ? "standby" : "primary", listenMs);
+    return true;
+}
+
+void FailoverManager::update() {
+    uint32_t now = millis();
+    if (!_paired) {
+        return;
+    }
+
+    _handleEvent(_policy.update(now));
+
+    if (_policy.isActive()) {
+        if (now - _lastSyncCheckMs >= SYNC_CHECK_INTERVAL_MS) {
+            _lastSyncCheckMs = now;
+            _checkFiles(now);
+        }
+        for (uint8_t i = 0; i < FILE_COUNT; i++) {
+            _sendChunks(i, now);
+        }
+    }
+}
+
+void FailoverManager::handleBeaconIdentity(const uint8_t* mac, const BeaconIdentity& identity) {
+    if (!_paired || memcmp(mac, _partnerMac, 6) != 0) {
+        return;     // Only the configured partner counts
+    }
+    _handleEvent(_policy.onPeerBeacon(mac, identity.hubId, identity.hubGeneration, millis()));
+}
+
+void FailoverManager::_handleEvent(FailoverPolicy::Event event) {
+    if (_policy.takeDirty()) {
+        _saveIdentity();
+    }
+
+    const FailoverPolicy::Identity& identity = _policy.getIdentity();
+    switch (event) {
+        case FailoverPolicy::Event::BECAME_ACTIVE:
+            _applyIdentity();
+            memset(_outgoing, 0, sizeof(_outgoing));
+            if (_paired) {
+                Serial.printf("[OK] Failover: ACTIVE as %02X:%02X:%02X:%02X:%02X:%02X generation %u\n",
+                              identity.hubId[0], identity.hubId[1], identity.hubId[2],
+                              identity.hubId[3], identity.hubId[4], identity.hubId[5], identity.generation);
+            }
+            // Coming out of standby: live state must be rebuilt from the replicas
+            if (_wasStandby) {
+                _takeovers++;
+                if (_takeoverCallback) {
+                    _takeoverCallback();
+                }
+            }
+            break;
+
+        case FailoverPolicy::Event::BECAME_STANDBY:
+            _wasStandby = true;
+            Serial.println("[OK] Failover: STANDBY, receiving state from partner");
+            break;
+
+        case FailoverPolicy::Event::STEP_DOWN:
+            // Devices, slots and held frames belong to the partner now;
+            // a clean boot drops them and comes back as standby
+            Serial.printf("[WARN] Failover: partner active at generation %u, restarting as standby\n",
+                          identity.generation);
+            delay(100);
+            ESP.restart();
+            break;
+
+        default:
+            break;
+    }
+}
+
+void FailoverManager::_applyIdentity() {
+    const FailoverPolicy::Identity& identity = _policy.getIdentity();
+    ESPNowManager::getInstance().setBeaconIdentity(identity.hubId, identity.generation);
+}
+
+bool FailoverManager::_loadIdentity(FailoverPolicy::Identity& identity) {
+    File file = LittleFS.open(STATE_FILE, "r");
+    if (!file) {
+        return false;
+    }
+
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+    if (error || !DeviceConfigStore::parseMac(doc["hubId"] | "", identity.hubId)) {
+        Serial.printf("[WARN] %s unreadable, identity starts fresh\n", STATE_FILE);
+        return false;
+    }
+
+    identity.generation = doc["generation"] | 0;
+    identity.known = true;
+    return true;
+}
+
+void FailoverManager::_saveIdentity() {
+    const FailoverPolicy::Identity& identity = _policy.getIdentity();
+    char hubId[18];
+    snprintf(hubId, sizeof(hubId), "%02X:%02X:%02X:%02X:%02X:%02X",
+             identity.hubId[0], identity.hubId[1], identity.hubId[2],
+             identity.hubId[3], identity.hubId[4], identity.hubId[5]);
+
+    JsonDocument doc;
+    doc["hubId"] = hubId;
+    doc["generation"] = identity.generation;
+
+    String tmpPath = String(STATE_FILE) + ".tmp";
+    File file = LittleFS.open(tmpPath, "w");
+    if (!file) {
+        Serial.printf("[ERR] Cannot open %s for writing\n", tmpPath.c_str());
+        return;
+    }
+    size_t written = serializeJson(doc, file);
+    file.close();
+
+    if (written == 0 || !LittleFS.rename(tmpPath, STATE_FILE)) {
+        Serial.printf("[ERR] Failed to commit %s\n", STATE_FILE);
+        LittleFS.remove(tmpPath);
+    }
+}
+
+// ============================================================================
+// REPLICATION - ACTIVE SIDE
+// ============================================================================
+
+void FailoverManager::_checkFiles(uint32_t now) {
+    for (uint8_t i = 0; i < FILE_COUNT; i++) {
+        OutgoingFile& out = _outgoing[i];
+        if (out.sending || (int32_t)(now - out.nextCheckMs) < 0) {
+            continue;
+        }
+
+        uint32_t size;
+        uint32_t crc;
+        if (!_fileDigest(FILES[i], size, crc)) {
+            continue;   // Not created yet on this hub
+        }
+        if (out.acked && out.ackedSize == size && out.ackedCrc == crc) {
+            continue;
+        }
+
+        out.sending = true;
+        out.complete = false;
+        out.size = size;
+        out.crc = crc;
+        out.offset = 0;
+        out.lastActivityMs = now;
+    }
+}
+
+void FailoverManager::_sendChunks(uint8_t index, uint32_t now) {
+    OutgoingFile& out = _outgoing[index];
+    if (!out.sending) {
+        return;
+    }
+
+    // Everything sent: wait for the verdict, then back off and rescan
+    if (out.complete) {
+        if (now - out.lastActivityMs >= ACK_TIMEOUT_MS) {
+            out.sending = false;
+            out.retryDelayMs = out.retryDelayMs == 0 ? SYNC_CHECK_INTERVAL_MS
+                             : (out.retryDelayMs >= MAX_RETRY_DELAY_MS / 2 ? MAX_RETRY_DELAY_MS : out.retryDelayMs * 2);
+            out.nextCheckMs = now + out.retryDelayMs;
+        }
+        return;
+    }
+
+    File file = LittleFS.open(FILES[index], "r");
+    if (!file || (out.offset > 0 && !file.seek(out.offset))) {
+        if (file) {
+            file.close();
+        }
+        out.sending = false;
+        return;
+    }
+
+    ReplicationMessage msg = {};
+    msg.header.type = MessageType::REPLICATE;
+    msg.header.tankId = 0;
+    msg.header.nodeType = NodeType::HUB;
+    msg.header.sequenceNum = 0;
+    msg.op = ReplicationOp::CHUNK;
+    msg.fileIndex = index;
+    msg.totalLen = out.size;
+    msg.crc = out.crc;
+
+    // An empty file still needs one (empty) chunk to be applied
+    for (uint8_t n = 0; n < CHUNKS_PER_UPDATE && (out.offset < out.size || n == 0); n++) {
+        uint32_t remaining = out.size - out.offset;
+        size_t want = remaining > REPLICATION_CHUNK_LEN ? REPLICATION_CHUNK_LEN : remaining;
+        size_t got = want > 0 ? file.read(msg.data, want) : 0;
+        if (got != want) {
+            // File changed under us; the next scan sends the new version
+            out.sending = false;
+            break;
+        }
+
+        msg.header.timestamp = millis();
+        msg.offset = out.offset;
+        msg.dataLen = got;
+        if (!ESPNowManager::getInstance().send(_partnerMac, (uint8_t*)&msg, REPLICATION_HEADER_LEN + got)) {
+            break;  // Radio busy, resume from here next pass
+        }
+        out.offset += got;
+        out.lastActivityMs = now;
+        if (out.offset >= out.size) {
+            out.complete = true;
+            break;
+        }
+    }
+    file.close();
+}
+
+void FailoverManager::_handleAck(const ReplicationMessage& msg, uint32_t now) {
+    OutgoingFile& out = _outgoing[msg.fileIndex];
+    out.acked = true;
+    out.ackedSize = msg.totalLen;
+    out.ackedCrc = msg.crc;
+    out.retryDelayMs = 0;
+    out.nextCheckMs = now;
+    if (out.sending && out.size == msg.totalLen && out.crc == msg.crc) {
+        out.sending = false;
+    }
+}
+
+void FailoverManager::_handleNack(const ReplicationMessage& msg, uint32_t now) {
+    OutgoingFile& out = _outgoing[msg.fileIndex];
+    if (!out.sending || out.crc != msg.crc) {
+        return;     // About an older stream
+    }
+    if (msg.offset == 0 || msg.offset > out.size) {
+        out.sending = false;    // Restart from a fresh snapshot
+        out.nextCheckMs = now;
+        return;
+    }
+    out.offset = msg.offset;
+    out.complete = false;
+    out.lastActivityMs = now;
+}
+
+// ============================================================================
+// REPLICATION - STANDBY SIDE
+// ============================================================================
+
+void FailoverManager::handleReplication(const uint8_t* mac, const uint8_t* data, size_t len) {
+    if (!_paired || memcmp(mac, _partnerMac, 6) != 0) {
+        return;
+    }
+
+    ReplicationMessage msg = {};
+    memcpy(&msg, data, len < sizeof(msg) ? len : sizeof(msg));
+    if (msg.fileIndex >= FILE_COUNT) {
+        return;
+    }
+
+    uint32_t now = millis();
+    switch (msg.op) {
+        case ReplicationOp::CHUNK:
+            if (!_policy.isActive() && len >= REPLICATION_HEADER_LEN + msg.dataLen &&
+                msg.dataLen <= REPLICATION_CHUNK_LEN) {
+                _handleChunk(msg, now);
+            }
+            break;
+        case ReplicationOp::ACK:
+            _handleAck(msg, now);
+            break;
+        case ReplicationOp::NACK:
+            _handleNack(msg, now);
+            break;
+    }
+}
+
+void FailoverManager::_handleChunk(const ReplicationMessage& msg, uint32_t now) {
+    IncomingFile& in = _incoming[msg.fileIndex];
+    const char* path = FILES[msg.fileIndex];
+    String tmpPath = String(path) + ".repl";
+
+    if (msg.offset == 0) {
+        // Already have this version (e.g. the active hub restarted)
+        if (!in.receiving && in.appliedSize == msg.totalLen && in.appliedCrc == msg.crc &&
+            (in.appliedSize != 0 || in.appliedCrc != 0)) {
+            _reply(ReplicationOp::ACK, msg.fileIndex, msg.totalLen, msg.crc, 0);
+            return;
+        }
+        File file = LittleFS.open(tmpPath, "w");
+        if (!file) {
+            return;
+        }
+        file.close();
+        in.receiving = true;
+        in.size = msg.totalLen;
+        in.crc = msg.crc;
+        in.expected = 0;
+        in.runningCrc = 0xFFFFFFFF;
+    }
+
+    if (!in.receiving || in.size != msg.totalLen || in.crc != msg.crc || msg.offset != in.expected) {
+        // Lost or stale chunk: one NACK per gap, not one per frame
+        if (now - in.lastNackMs >= ACK_TIMEOUT_MS / 4) {
+            in.lastNackMs = now;
+            bool sameStream = in.receiving && in.size == msg.totalLen && in.crc == msg.crc;
+            _reply(ReplicationOp::NACK, msg.fileIndex, msg.totalLen, msg.crc, sameStream ? in.expected : 0);
+        }
+        return;
+    }
+
+    if (msg.dataLen > 0) {
+        File file = LittleFS.open(tmpPath, "a");
+        size_t written = file ? file.write(msg.data, msg.dataLen) : 0;
+        if (file) {
+            file.close();
+        }
+        if (written != msg.dataLen) {
+            in.receiving = false;
+            _reply(ReplicationOp::NACK, msg.fileIndex, msg.totalLen, msg.crc, 0);
+            return;
+        }
+        in.runningCrc = _crcUpdate(in.runningCrc, msg.data, msg.dataLen);
+        in.expected += msg.dataLen;
+    }
+
+    if (in.expected < in.size) {
+        return;
+    }
+
+    in.receiving = false;
+    if (~in.runningCrc != in.crc || !LittleFS.rename(tmpPath, path)) {
+        LittleFS.remove(tmpPath);
+        Serial.printf("[WARN] Replicated %s failed verification, requesting again\n", path);
+        _reply(ReplicationOp::NACK, msg.fileIndex, msg.totalLen, msg.crc, 0);
+        return;
+    }
+
+    in.appliedSize = in.size;
+    in.appliedCrc = in.crc;
+    _filesApplied++;
+    Serial.printf("[OK] Replicated %s (%u bytes)\n", path, in.size);
+    _reply(ReplicationOp::ACK, msg.fileIndex, in.size, in.crc, 0);
+}
+
+void FailoverManager::_reply(ReplicationOp op, uint8_t index, uint32_t size, uint32_t crc, uint32_t offset) {
+    ReplicationMessage msg = {};
+    msg.header.type = MessageType::REPLICATE;
+    msg.header.tankId = 0;
+    msg.header.nodeType = NodeType::HUB;
+    msg.header.timestamp = millis();
+    msg.header.sequenceNum = 0;
+    msg.op = op;
+    msg.fileIndex = index;
+    msg.totalLen = size;
+    msg.crc = crc;
+    msg.offset = offset;
+    ESPNowManager::getInstance().send(_partnerMac, (uint8_t*)&msg, REPLICATION_HEADER_LEN);
+}
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+bool FailoverManager::_fileDigest(const char* path, uint32_t& size, uint32_t& crc) {
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    uint8_t buffer[128];
+    uint32_t state = 0xFFFFFFFF;
+    size = 0;
+    size_t got;
+    while ((got = file.read(buffer, sizeof(buffer))) > 0) {
+        state = _crcUpdate(state, buffer, got);
+        size += got;
+    }
+    file.close();
+    crc = ~state;
+    return true;
+}
+
+uint32_t FailoverManager::_crcUpdate(uint32_t state, const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        state ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            state = (state >> 1) ^ (0xEDB88320 & (0 - (state & 1)));
+        }
+    }
+    return state;
+}
+
+void FailoverManager::toJson(JsonObject out) const {
+    const FailoverPolicy::Identity& identity = _policy.getIdentity();
+    char hubId[18];
+    snprintf(hubId, sizeof(hubId), "%02X:%02X:%02X:%02X:%02X:%02X",
+             identity.hubId[0], identity.hubId[1], identity.hubId[2],
+             identity.hubId[3], identity.hubId[4], identity.hubId[5]);
+
+    out["paired"] = _paired;
+    out["role"] = _paired ? FailoverPolicy::roleString(_policy.getRole()) : "ACTIVE";
+    out["hubId"] = hubId;
+    out["generation"] = identity.generation;
+    if (!_paired) {
+        return;
+    }
+
+    char partner[18];
+    snprintf(partner, sizeof(partner), "%02X:%02X:%02X:%02X:%02X:%02X",
+             _partnerMac[0], _partnerMac[1], _partnerMac[2], _partnerMac[3], _partnerMac[4], _partnerMac[5]);
+    out["partner"] = partner;
+    out["takeovers"] = _takeovers;
+
+    if (_policy.isActive()) {
+        uint8_t synced = 0;
+        for (uint8_t i = 0; i < FILE_COUNT; i++) {
+            if (_outgoing[i].acked && !_outgoing[i].sending) {
+                synced++;
+            }
+        }
+        out["filesSynced"] = synced;
+    } else {
+        out["lastPartnerBeaconMs"] = millis() - _policy.getLastPeerBeaconMs();
+        out["filesApplied"] = _filesApplied;
+    }
+}
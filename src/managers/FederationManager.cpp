@@ -0,0 +1,644 @@
+#include "managers/FederationManager.h"
+#include "managers/AquariumManager.h"
+#include <WiFi.h>
+
+FederationManager& FederationManager::getInstance() {
+    static FederationManager instance;
+    return instance;
+}
+
+FederationManager::FederationManager()
+    : _enabled(false)
+    , _rxQueue(NULL)
+    , _port(FEDERATION_DEFAULT_PORT)
+    , _httpPort(80)
+    , _staticPeerCount(0)
+    , _published(0)
+    , _lastHelloMs(0)
+    , _lastPublishMs(0)
+    , _nextTicket(1)
+    , _framesReceived(0)
+    , _framesDropped(0) {
+    _mutex = xSemaphoreCreateMutex();
+    memset(&_header, 0, sizeof(_header));
+    memset(_name, 0, sizeof(_name));
+}
+
+// ============================================================================
+// SETUP / LOOP
+// ============================================================================
+
+bool FederationManager::begin(const String& group, const String& name, uint16_t port,
+                              const String& peers, uint16_t httpPort) {
+    if (group.length() == 0) {
+        return false;
+    }
+
+    _port = port ? port : FEDERATION_DEFAULT_PORT;
+    _httpPort = httpPort;
+    strncpy(_name, name.c_str(), FEDERATION_NAME_LEN);
+
+    _header.magic[0] = 'A';
+    _header.magic[1] = 'F';
+    _header.version = FEDERATION_PROTOCOL_VERSION;
+    _header.group = _groupHash(group);
+    WiFi.macAddress(_header.hubId);
+
+    // Hubs outside this broadcast domain (or on one host, on other ports)
+    int start = 0;
+    while (start < (int)peers.length() && _staticPeerCount < MAX_STATIC_PEERS) {
+        int end = peers.indexOf(',', start);
+        if (end < 0) {
+            end = peers.length();
+        }
+        String entry = peers.substring(start, end);
+        entry.trim();
+        start = end + 1;
+        if (entry.length() == 0) {
+            continue;
+        }
+
+        StaticPeer& peer = _staticPeers[_staticPeerCount];
+        int colon = entry.indexOf(':');
+        peer.port = colon < 0 ? _port : (uint16_t)entry.substring(colon + 1).toInt();
+        String host = colon < 0 ? entry : entry.substring(0, colon);
+        if (!peer.ip.fromString(host.c_str()) || peer.port == 0) {
+            Serial.printf("[WARN] Federation: ignoring peer '%s'\n", entry.c_str());
+            continue;
+        }
+        _staticPeerCount++;
+    }
+
+    _rxQueue = xQueueCreate(RX_QUEUE_SIZE, sizeof(RxFrame));
+    if (!_rxQueue || !_udp.listen(_port)) {
+        Serial.printf("[ERR] Federation: cannot listen on UDP %u\n", _port);
+        return false;
+    }
+
+    _udp.onPacket([this](AsyncUDPPacket& packet) {
+        // AsyncUDP task: copy out and let loop() handle it
+        static RxFrame frame;
+        if (packet.length() < sizeof(FederationHeader) || packet.length() > FEDERATION_MAX_FRAME) {
+            return;
+        }
+        frame.ip = (uint32_t)packet.remoteIP();
+        frame.port = packet.remotePort();
+        frame.len = packet.length();
+        memcpy(frame.data, packet.data(), packet.length());
+        if (xQueueSend(_rxQueue, &frame, 0) != pdTRUE) {
+            _framesDropped++;
+        }
+    });
+
+    _enabled = true;
+    Serial.printf("[OK] Federation: '%s' in group '%s' on UDP %u (%u static peers)\n",
+                  _name, group.c_str(), _port, _staticPeerCount);
+    return true;
+}
+
+void FederationManager::update() {
+    uint32_t now = millis();
+
+    if (_enabled) {
+        static RxFrame frame;
+        while (xQueueReceive(_rxQueue, &frame, 0) == pdTRUE) {
+            _framesReceived++;
+            _handleFrame(frame, now);
+        }
+
+        if (now - _lastHelloMs >= HELLO_INTERVAL_MS) {
+            _lastHelloMs = now;
+            _sendHello();
+
+            xSemaphoreTake(_mutex, portMAX_DELAY);
+            _table.expire(now);
+            xSemaphoreGive(_mutex);
+        }
+
+        if (now - _lastPublishMs >= PUBLISH_INTERVAL_MS) {
+            _lastPublishMs = now;
+            _publish();
+        }
+    }
+
+    // Without federation this still sends commands to local devices
+    _runCommands(now);
+}
+
+// ============================================================================
+// RECEIVE
+// ============================================================================
+
+void FederationManager::_handleFrame(const RxFrame& frame, uint32_t now) {
+    FederationHeader header;
+    memcpy(&header, frame.data, sizeof(header));
+    if (header.magic[0] != 'A' || header.magic[1] != 'F' ||
+        header.version != FEDERATION_PROTOCOL_VERSION || header.group != _header.group ||
+        memcmp(header.hubId, _header.hubId, 6) == 0) {
+        return;     // Not ours, or our own broadcast
+    }
+
+    uint8_t index = 0;
+    FederationTable::Action action = FederationTable::Action::NONE;
+
+    switch (header.type) {
+        case FederationType::HELLO: {
+            if (frame.len < sizeof(FederationHello)) {
+                return;
+            }
+            FederationHello hello;
+            memcpy(&hello, frame.data, sizeof(hello));
+
+            xSemaphoreTake(_mutex, portMAX_DELAY);
+            action = _table.onHello(hello, frame.ip, frame.port, now, index);
+            if (action == FederationTable::Action::REQUEST_SYNC) {
+                _sendSync(_table.getPeer(index));
+            }
+            xSemaphoreGive(_mutex);
+            break;
+        }
+
+        case FederationType::DELTA: {
+            if (frame.len < sizeof(FederationDelta)) {
+                return;
+            }
+            FederationDelta delta;
+            memcpy(&delta, frame.data, sizeof(delta));
+            if (delta.count > FEDERATION_MAX_RECORDS || frame.len != federationDeltaSize(delta.count)) {
+                return;
+            }
+            static FederationDeviceRecord records[FEDERATION_MAX_RECORDS];
+            memcpy(records, frame.data + sizeof(delta), delta.count * sizeof(FederationDeviceRecord));
+
+            xSemaphoreTake(_mutex, portMAX_DELAY);
+            action = _table.onDelta(delta, records, frame.ip, frame.port, now, index);
+            if (action == FederationTable::Action::REQUEST_SYNC) {
+                _sendSync(_table.getPeer(index));
+            }
+            xSemaphoreGive(_mutex);
+            break;
+        }
+
+        case FederationType::SYNC: {
+            if (frame.len != sizeof(FederationSync)) {
+                return;
+            }
+            FederationSync sync;
+            memcpy(&sync, frame.data, sizeof(sync));
+            _handleSync(sync, frame.ip, frame.port);
+            break;
+        }
+
+        case FederationType::COMMAND: {
+            if (frame.len != sizeof(FederationCommand)) {
+                return;
+            }
+            FederationCommand command;
+            memcpy(&command, frame.data, sizeof(command));
+            _handleCommand(command, frame.ip, frame.port);
+            break;
+        }
+
+        case FederationType::RESULT: {
+            if (frame.len != sizeof(FederationCommandResult)) {
+                return;
+            }
+            FederationCommandResult result;
+            memcpy(&result, frame.data, sizeof(result));
+            _handleResult(result);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Answer a peer that is behind: incremental if possible, else FULL
+ */
+void FederationManager::_handleSync(const FederationSync& sync, uint32_t ip, uint16_t port) {
+    AquariumManager& manager = AquariumManager::getInstance();
+    uint32_t version = manager.getStateVersion();
+
+    bool full = sync.knownBootId != manager.getBootId() || (int32_t)(sync.since - version) > 0;
+    std::vector<FederationDeviceRecord> records;
+    if (!full && !_collectChanges(sync.since, false, records)) {
+        full = true;    // Removals already dropped
+        records.clear();
+    }
+    if (full) {
+        _collectChanges(0, true, records);
+    }
+
+    uint32_t to = version;
+    FederationTable::selectDelta(records, to);
+    _sendDelta(full ? 0 : sync.since, to, full, records, ip, port);
+}
+
+void FederationManager::_handleCommand(const FederationCommand& command, uint32_t ip, uint16_t port) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    bool known = _table.findPeer(command.header.hubId) >= 0;
+    xSemaphoreGive(_mutex);
+    if (!known || command.commandLen == 0 || command.commandLen > MAX_COMMAND_DATA_LEN) {
+        return;     // Only hubs that announced themselves may command
+    }
+
+    FederationCommandResult reply;
+    _fillHeader(reply.header, FederationType::RESULT);
+    reply.ticket = command.ticket;
+    reply.commandId = 0;
+
+    Device* device = AquariumManager::getInstance().getDevice(command.mac);
+    if (!device) {
+        reply.result = FederationResult::NOT_FOUND;
+    } else if (!device->isOnline()) {
+        reply.result = FederationResult::OFFLINE;
+    } else if (device->sendCommand(command.commandData, command.commandLen)) {
+        reply.result = FederationResult::SENT;
+        reply.commandId = device->getLastCommandId();
+    } else {
+        reply.result = FederationResult::SEND_FAILED;
+    }
+
+    Serial.printf("  Federation: forwarded command for %02X:%02X:%02X:%02X:%02X:%02X -> %u\n",
+                  command.mac[0], command.mac[1], command.mac[2],
+                  command.mac[3], command.mac[4], command.mac[5], (uint8_t)reply.result);
+    _sendTo((const uint8_t*)&reply, sizeof(reply), ip, port);
+}
+
+void FederationManager::_handleResult(const FederationCommandResult& result) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < _commands.size(); i++) {
+        RoutedCommand& command = *_commands[i];
+        if (command._ticket != result.ticket || memcmp(command._hubId, result.header.hubId, 6) != 0) {
+            continue;
+        }
+
+        RoutedCommand::Outcome outcome;
+        switch (result.result) {
+            case FederationResult::SENT: outcome = RoutedCommand::Outcome::SENT; break;
+            case FederationResult::NOT_FOUND: outcome = RoutedCommand::Outcome::NOT_FOUND; break;
+            case FederationResult::OFFLINE: outcome = RoutedCommand::Outcome::OFFLINE; break;
+            default: outcome = RoutedCommand::Outcome::SEND_FAILED; break;
+        }
+        command._finish(outcome, result.commandId);
+        _commands.erase(_commands.begin() + i);
+        break;
+    }
+    xSemaphoreGive(_mutex);
+}
+
+// ============================================================================
+// COMMAND ROUTING
+// ============================================================================
+
+FederationManager::RoutedCommand::RoutedCommand(const uint8_t* mac, const uint8_t* data, uint8_t len)
+    : _len(len)
+    , _ticket(0)
+    , _remote(false)
+    , _sentMs(0)
+    , _commandId(0)
+    , _outcome(Outcome::WAITING)
+    , _complete(false) {
+    memcpy(_mac, mac, 6);
+    memcpy(_data, data, len);
+    memset(_hubId, 0, sizeof(_hubId));
+}
+
+void FederationManager::RoutedCommand::_finish(Outcome outcome, uint8_t commandId) {
+    _outcome = outcome;
+    _commandId = commandId;
+    _complete.store(true, std::memory_order_release);
+}
+
+const char* FederationManager::RoutedCommand::outcomeString(Outcome outcome) {
+    switch (outcome) {
+        case Outcome::WAITING: return "waiting";
+        case Outcome::SENT: return "sent";
+        case Outcome::NOT_FOUND: return "not_found";
+        case Outcome::OFFLINE: return "offline";
+        case Outcome::SEND_FAILED: return "send_failed";
+        case Outcome::TIMEOUT: return "timeout";
+    }
+    return "unknown";
+}
+
+void FederationManager::RoutedCommand::toJson(JsonObject out) const {
+    char macStr[18];
+    snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+             _mac[0], _mac[1], _mac[2], _mac[3], _mac[4], _mac[5]);
+    out["mac"] = macStr;
+    out["success"] = _outcome == Outcome::SENT;
+    out["outcome"] = outcomeString(_outcome);
+    out["hub"] = _remote ? _hubName.c_str() : "local";
+    if (_outcome == Outcome::SENT) {
+        out["commandId"] = _commandId;
+    }
+}
+
+std::shared_ptr<FederationManager::RoutedCommand> FederationManager::routeCommand(
+        const uint8_t* mac, const uint8_t* data, uint8_t len) {
+    if (len > MAX_COMMAND_DATA_LEN) {
+        len = MAX_COMMAND_DATA_LEN;
+    }
+    std::shared_ptr<RoutedCommand> command = std::make_shared<RoutedCommand>(mac, data, len);
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _commands.push_back(command);
+    xSemaphoreGive(_mutex);
+    return command;
+}
+
+/**
+ * @brief Send new commands, time out forwarded ones (main loop)
+ */
+void FederationManager::_runCommands(uint32_t now) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < _commands.size(); ) {
+        RoutedCommand& command = *_commands[i];
+
+        if (command._ticket != 0) {
+            if (now - command._sentMs < COMMAND_TIMEOUT_MS) {
+                i++;
+                continue;
+            }
+            command._finish(RoutedCommand::Outcome::TIMEOUT, 0);
+            _commands.erase(_commands.begin() + i);
+            continue;
+        }
+
+        Device* device = AquariumManager::getInstance().getDevice(command._mac);
+        int owner = device ? -1 : _table.findOwner(command._mac, now);
+
+        if (device) {
+            if (!device->isOnline()) {
+                command._finish(RoutedCommand::Outcome::OFFLINE, 0);
+            } else if (device->sendCommand(command._data, command._len)) {
+                command._finish(RoutedCommand::Outcome::SENT, device->getLastCommandId());
+            } else {
+                command._finish(RoutedCommand::Outcome::SEND_FAILED, 0);
+            }
+        } else if (owner < 0) {
+            command._finish(RoutedCommand::Outcome::NOT_FOUND, 0);
+        } else if (!_table.isOnline(_table.getPeer(owner), now)) {
+            command._remote = true;
+            command._hubName = _table.getPeer(owner).name;
+            command._finish(RoutedCommand::Outcome::OFFLINE, 0);
+        } else {
+            const FederationTable::Peer& peer = _table.getPeer(owner);
+            FederationCommand frame;
+            _fillHeader(frame.header, FederationType::COMMAND);
+            command._ticket = _nextTicket++;
+            if (_nextTicket == 0) {
+                _nextTicket = 1;    // 0 = not forwarded
+            }
+            frame.ticket = command._ticket;
+            memcpy(frame.mac, command._mac, 6);
+            frame.commandLen = command._len;
+            frame.reserved = 0;
+            memset(frame.commandData, 0, sizeof(frame.commandData));
+            memcpy(frame.commandData, command._data, command._len);
+
+            command._remote = true;
+            memcpy(command._hubId, peer.hubId, 6);
+            command._hubName = peer.name;
+            command._sentMs = now;
+            _sendTo((const uint8_t*)&frame, sizeof(frame), peer.ip, peer.port);
+            i++;
+            continue;
+        }
+        _commands.erase(_commands.begin() + i);
+    }
+    xSemaphoreGive(_mutex);
+}
+
+// ============================================================================
+// PUBLISH
+// ============================================================================
+
+void FederationManager::_sendHello() {
+    AquariumManager& manager = AquariumManager::getInstance();
+    FederationHello hello;
+    _fillHeader(hello.header, FederationType::HELLO);
+    hello.publishedVersion = _published;
+    hello.httpPort = _httpPort;
+    size_t devices = manager.getDeviceCount();
+    hello.deviceCount = devices > 255 ? 255 : (uint8_t)devices;
+    hello.reserved = 0;
+    memcpy(hello.name, _name, FEDERATION_NAME_LEN);
+    _sendToAll((const uint8_t*)&hello, sizeof(hello));
+}
+
+/**
+ * @brief Broadcast device changes since the last DELTA
+ *
+ * Changes that touch no device (readings, aquariums) bump the state
+ * version too; they are not sent and _published stays put, so peers see
+ * no gap in fromVersion.
+ */
+void FederationManager::_publish() {
+    uint32_t version = AquariumManager::getInstance().getStateVersion();
+    if (version == _published) {
+        return;
+    }
+
+    std::vector<FederationDeviceRecord> records;
+    bool full = !_collectChanges(_published, false, records);
+    if (full) {
+        records.clear();
+        _collectChanges(0, true, records);
+    } else if (records.empty()) {
+        return;
+    }
+
+    uint32_t to = version;
+    FederationTable::selectDelta(records, to);
+    _sendDelta(full ? 0 : _published, to, full, records, 0, 0);
+    _published = to;
+}
+
+/**
+ * @brief Send one DELTA (ip 0 = broadcast and static peers)
+ */
+void FederationManager::_sendDelta(uint32_t from, uint32_t to, bool full,
+                                   const std::vector<FederationDeviceRecord>& records,
+                                   uint32_t ip, uint16_t port) {
+    static uint8_t buffer[FEDERATION_MAX_FRAME];
+    FederationDelta delta;
+    _fillHeader(delta.header, FederationType::DELTA);
+    delta.fromVersion = from;
+    delta.toVersion = to;
+    delta.flags = full ? FEDERATION_DELTA_FULL : 0;
+    delta.count = (uint8_t)records.size();
+    delta.reserved = 0;
+
+    memcpy(buffer, &delta, sizeof(delta));
+    memcpy(buffer + sizeof(delta), records.data(), records.size() * sizeof(FederationDeviceRecord));
+
+    size_t len = federationDeltaSize(delta.count);
+    if (ip == 0) {
+        _sendToAll(buffer, len);
+    } else {
+        _sendTo(buffer, len, ip, port);
+    }
+}
+
+/**
+ * @brief Device records changed after since (all devices if full)
+ * @return false if removals after since are no longer known
+ */
+bool FederationManager::_collectChanges(uint32_t since, bool full,
+                                        std::vector<FederationDeviceRecord>& records) {
+    AquariumManager& manager = AquariumManager::getInstance();
+    for (Device* device : manager.getAllDevices()) {
+        if (!full && device->getVersion() <= since) {
+            continue;
+        }
+        FederationDeviceRecord record;
+        memset(&record, 0, sizeof(record));
+        memcpy(record.mac, device->getMac(), 6);
+        record.type = (uint8_t)device->getType();
+        record.status = (uint8_t)device->getStatus();
+        record.tankId = device->getTankId();
+        record.health = device->getHealth();
+        record.version = device->getVersion();
+        strncpy(record.name, device->getName().c_str(), FEDERATION_NAME_LEN);
+        records.push_back(record);
+    }
+    if (full) {
+        return true;
+    }
+
+    std::vector<AquariumManager::RemovedDevice> removed;
+    if (!manager.getRemovedDevices(since, removed)) {
+        return false;
+    }
+    for (const AquariumManager::RemovedDevice& each : removed) {
+        FederationDeviceRecord record;
+        memset(&record, 0, sizeof(record));
+        memcpy(record.mac, each.mac, 6);
+        record.status = FEDERATION_STATUS_REMOVED;
+        record.version = each.version;
+        records.push_back(record);
+    }
+    return true;
+}
+
+void FederationManager::_sendSync(const FederationTable::Peer& peer) {
+    FederationSync sync;
+    _fillHeader(sync.header, FederationType::SYNC);
+    sync.knownBootId = peer.bootId;
+    sync.since = peer.version;
+    _sendTo((const uint8_t*)&sync, sizeof(sync), peer.ip, peer.port);
+}
+
+// ============================================================================
+// TRANSPORT
+// ============================================================================
+
+void FederationManager::_fillHeader(FederationHeader& header, FederationType type) {
+    header = _header;
+    header.type = type;
+    header.bootId = AquariumManager::getInstance().getBootId();
+}
+
+void FederationManager::_sendToAll(const uint8_t* data, size_t len) {
+    _udp.broadcastTo((uint8_t*)data, len, _port);
+    for (uint8_t i = 0; i < _staticPeerCount; i++) {
+        _udp.writeTo(data, len, _staticPeers[i].ip, _staticPeers[i].port);
+    }
+}
+
+void FederationManager::_sendTo(const uint8_t* data, size_t len, uint32_t ip, uint16_t port) {
+    _udp.writeTo(data, len, IPAddress(ip), port);
+}
+
+uint32_t FederationManager::_groupHash(const String& group) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < group.length(); i++) {
+        crc ^= (uint8_t)group[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+// ============================================================================
+// JSON
+// ============================================================================
+
+void FederationManager::toJson(JsonObject out) {
+    out["enabled"] = _enabled;
+    if (!_enabled) {
+        return;
+    }
+
+    char macStr[18];
+    snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+             _header.hubId[0], _header.hubId[1], _header.hubId[2],
+             _header.hubId[3], _header.hubId[4], _header.hubId[5]);
+    out["name"] = _name;
+    out["hubId"] = macStr;
+    out["port"] = _port;
+    out["publishedVersion"] = _published;
+    out["framesReceived"] = _framesReceived;
+    out["framesDropped"] = _framesDropped;
+
+    JsonArray peers = out["peers"].to<JsonArray>();
+    uint32_t now = millis();
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < _table.peerCount(); i++) {
+        const FederationTable::Peer& peer = _table.getPeer(i);
+        snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+                 peer.hubId[0], peer.hubId[1], peer.hubId[2],
+                 peer.hubId[3], peer.hubId[4], peer.hubId[5]);
+        JsonObject entry = peers.add<JsonObject>();
+        entry["name"] = peer.name;
+        entry["hubId"] = macStr;
+        entry["address"] = IPAddress(peer.ip).toString();
+        entry["httpPort"] = peer.httpPort;
+        entry["online"] = _table.isOnline(peer, now);
+        entry["lastSeenMs"] = now - peer.lastSeenMs;
+        entry["bootId"] = peer.bootId;
+        entry["version"] = peer.version;
+        entry["devices"] = peer.devices.size();
+    }
+    xSemaphoreGive(_mutex);
+}
+
+void FederationManager::remoteDevicesToJson(JsonArray out) {
+    uint32_t now = millis();
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < _table.peerCount(); i++) {
+        const FederationTable::Peer& peer = _table.getPeer(i);
+        bool online = _table.isOnline(peer, now);
+        String address = IPAddress(peer.ip).toString() + ":" + String(peer.httpPort);
+
+        for (const FederationDeviceRecord& record : peer.devices) {
+            char macStr[18];
+            snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+                     record.mac[0], record.mac[1], record.mac[2],
+                     record.mac[3], record.mac[4], record.mac[5]);
+            char name[FEDERATION_NAME_LEN + 1];
+            memcpy(name, record.name, FEDERATION_NAME_LEN);
+            name[FEDERATION_NAME_LEN] = '\0';
+
+            JsonObject obj = out.add<JsonObject>();
+            obj["mac"] = macStr;
+            obj["type"] = Device::typeName((NodeType)record.type);
+            obj["name"] = name;
+            obj["tankId"] = record.tankId;
+            // A silent hub cannot vouch for its devices
+            obj["status"] = online ? Device::statusName((Device::Status)record.status) : "Unknown";
+            obj["online"] = online && record.status == (uint8_t)Device::Status::ONLINE;
+            obj["health"] = record.health;
+            obj["hub"] = peer.name;
+            obj["hubAddress"] = address;
+            obj["hubOnline"] = online;
+            obj["local"] = false;
+        }
+    }
+    xSemaphoreGive(_mutex);
+}
@@ -0,0 +1,371 @@
+#include "managers/ProvisioningManager.h"
+#include "ESPNowManager.h"
+
+ProvisioningManager& ProvisioningManager::getInstance() {
+    static ProvisioningManager instance;
+    return instance;
+}
+
+ProvisioningManager::ProvisioningManager()
+    : _mutex(xSemaphoreCreateMutex())
+    , _nextId(1)
+    , _nextToken(1) {
+    for (uint8_t i = 0; i < MAX_TRANSACTIONS; i++) {
+        _transactions[i].id = 0;
+    }
+}
+
+// ============================================================================
+// START (web server context)
+// ============================================================================
+
+uint32_t ProvisioningManager::beginProvision(const String& macStr, const String& name, uint8_t tankId,
+                                             DeviceConfigStore::Error& error, Completion onComplete,
+                                             DeviceConfigStore* store) {
+    return _begin(Kind::PROVISION, macStr, name, tankId, error, onComplete, store);
+}
+
+uint32_t ProvisioningManager::beginUnmap(const String& macStr, DeviceConfigStore::Error& error,
+                                         Completion onComplete, DeviceConfigStore* store) {
+    return _begin(Kind::UNMAP, macStr, String(), 0, error, onComplete, store);
+}
+
+uint32_t ProvisioningManager::_begin(Kind kind, const String& macStr, const String& name, uint8_t tankId,
+                                     DeviceConfigStore::Error& error, Completion onComplete,
+                                     DeviceConfigStore* store) {
+    uint8_t mac[6];
+    if (!DeviceConfigStore::parseMac(macStr, mac)) {
+        error = DeviceConfigStore::Error::INVALID_MAC;
+        return 0;
+    }
+    if (kind == Kind::PROVISION && (name.length() == 0 || tankId == 0)) {
+        error = DeviceConfigStore::Error::INVALID_ARGUMENT;
+        return 0;
+    }
+
+    // Reject what the commit would reject, before anything goes on air
+    DeviceConfigStore loaded;
+    if (!store) {
+        loaded.load();
+        store = &loaded;
+    }
+    bool found = kind == Kind::PROVISION ? store->isUnmapped(macStr) : store->isMapped(macStr);
+    if (!found) {
+        error = DeviceConfigStore::Error::NOT_FOUND;
+        return 0;
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    int slot = _allocate(mac, error);
+    if (slot < 0) {
+        xSemaphoreGive(_mutex);
+        return 0;
+    }
+
+    Transaction& transaction = _transactions[slot];
+    transaction.id = _nextId++;
+    transaction.kind = kind;
+    transaction.state = State::PENDING;
+    transaction.macStr = macStr;
+    memcpy(transaction.mac, mac, 6);
+    transaction.name = name;
+    transaction.tankId = tankId;
+    transaction.token = _nextToken;
+    transaction.attempts = 0;
+    transaction.confirmed = false;
+    transaction.startedMs = millis();
+    transaction.lastSendMs = 0;
+    transaction.finishedMs = 0;
+    transaction.error = "";
+    _completions[slot] = onComplete;
+
+    _nextToken = _nextToken == 255 ? 1 : _nextToken + 1;
+    uint32_t id = transaction.id;
+    xSemaphoreGive(_mutex);
+
+    error = DeviceConfigStore::Error::NONE;
+    Serial.printf("[OK] Provisioning %u: %s %s queued\n", id,
+                  kind == Kind::PROVISION ? "provision" : "unmap", macStr.c_str());
+    return id;
+}
+
+int ProvisioningManager::_allocate(const uint8_t* mac, DeviceConfigStore::Error& error) {
+    int freeSlot = -1;
+    int oldestFinished = -1;
+
+    for (uint8_t i = 0; i < MAX_TRANSACTIONS; i++) {
+        const Transaction& transaction = _transactions[i];
+        if (transaction.id == 0) {
+            if (freeSlot < 0) {
+                freeSlot = i;
+            }
+            continue;
+        }
+        if (transaction.state == State::PENDING) {
+            if (memcmp(transaction.mac, mac, 6) == 0) {
+                error = DeviceConfigStore::Error::BUSY;
+                return -1;
+            }
+            continue;
+        }
+        if (oldestFinished < 0 || (int32_t)(transaction.finishedMs - _transactions[oldestFinished].finishedMs) < 0) {
+            oldestFinished = i;
+        }
+    }
+
+    // Evict the oldest settled result rather than refuse new work
+    int slot = freeSlot >= 0 ? freeSlot : oldestFinished;
+    if (slot < 0) {
+        error = DeviceConfigStore::Error::TOO_MANY;
+    }
+    return slot;
+}
+
+bool ProvisioningManager::isPending(const uint8_t* mac) {
+    bool pending = false;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < MAX_TRANSACTIONS; i++) {
+        const Transaction& transaction = _transactions[i];
+        if (transaction.id != 0 && transaction.state == State::PENDING && memcmp(transaction.mac, mac, 6) == 0) {
+            pending = true;
+            break;
+        }
+    }
+    xSemaphoreGive(_mutex);
+    return pending;
+}
+
+// ============================================================================
+// PROGRESS (main loop context)
+// ============================================================================
+
+void ProvisioningManager::update() {
+    enum class Action : uint8_t { NONE, SEND, COMMIT, ROLL_BACK };
+    uint32_t now = millis();
+    uint8_t commits[MAX_TRANSACTIONS];
+    uint8_t commitCount = 0;
+
+    for (uint8_t i = 0; i < MAX_TRANSACTIONS; i++) {
+        Action action = Action::NONE;
+        Transaction snapshot;
+
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        Transaction& transaction = _transactions[i];
+        if (transaction.id != 0) {
+            if (transaction.state != State::PENDING) {
+                if (now - transaction.finishedMs > RESULT_TTL_MS) {
+                    transaction.id = 0;
+                }
+            } else if (transaction.confirmed) {
+                action = Action::COMMIT;
+            } else if (transaction.attempts == 0) {
+                // Offline node: unmap as before, it re-announces as unmapped
+                bool offline = transaction.kind == Kind::UNMAP &&
+                               !ESPNowManager::getInstance().isPeerOnline(transaction.mac);
+                action = offline ? Action::COMMIT : Action::SEND;
+            } else if (now - transaction.lastSendMs >= ATTEMPT_TIMEOUT_MS) {
+                action = transaction.attempts < MAX_ATTEMPTS ? Action::SEND : Action::ROLL_BACK;
+            }
+            if (action == Action::SEND) {
+                transaction.attempts++;
+                transaction.lastSendMs = now;
+                snapshot = transaction;
+            }
+        }
+        xSemaphoreGive(_mutex);
+
+        switch (action) {
+            case Action::SEND:
+                if (!_send(snapshot)) {
+                    Serial.printf("[WARN] Provisioning %u: attempt %u not sent\n", snapshot.id, snapshot.attempts);
+                }
+                break;
+            case Action::COMMIT:
+                commits[commitCount++] = i;
+                break;
+            case Action::ROLL_BACK:
+                _rollBack(i, "No confirmation from device");
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (commitCount > 0) {
+        _commit(commits, commitCount);
+    }
+}
+
+bool ProvisioningManager::handleStatus(const uint8_t* mac, const StatusMessage& msg) {
+    if (msg.statusCode != STATUS_CONFIG_APPLIED && msg.statusCode != STATUS_UNMAP_APPLIED) {
+        return false;
+    }
+    Kind kind = msg.statusCode == STATUS_CONFIG_APPLIED ? Kind::PROVISION : Kind::UNMAP;
+
+    // Only recorded here; the next update() commits everything confirmed
+    // since the last pass together. Duplicates from retried frames and late
+    // confirmations are swallowed too.
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < MAX_TRANSACTIONS; i++) {
+        Transaction& transaction = _transactions[i];
+        if (transaction.id != 0 && transaction.state == State::PENDING && transaction.kind == kind &&
+            transaction.token == msg.commandId && memcmp(transaction.mac, mac, 6) == 0) {
+            transaction.confirmed = true;
+            break;
+        }
+    }
+    xSemaphoreGive(_mutex);
+    return true;
+}
+
+bool ProvisioningManager::_send(const Transaction& transaction) {
+    if (transaction.kind == Kind::PROVISION) {
+        return DeviceConfigStore::sendConfig(transaction.mac, transaction.name, transaction.tankId, transaction.token);
+    }
+    return DeviceConfigStore::sendUnmap(transaction.mac, transaction.token);
+}
+
+// ============================================================================
+// COMMIT / ROLLBACK
+// ============================================================================
+
+void ProvisioningManager::_commit(const uint8_t* slots, uint8_t count) {
+    // The nodes already have their frames; only persistence is left. All
+    // transactions of one pass go into one store load and one write.
+    DeviceConfigStore store;
+    store.load();
+    store.setSendFrames(false);
+
+    const char* failures[MAX_TRANSACTIONS];
+    uint8_t applied = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        Transaction transaction = _transactions[slots[i]];
+        xSemaphoreGive(_mutex);
+
+        DeviceConfigStore::Result result = transaction.kind == Kind::PROVISION
+            ? store.provision(transaction.macStr, transaction.name, transaction.tankId)
+            : store.unmap(transaction.macStr);
+        failures[i] = result.ok() ? nullptr : DeviceConfigStore::errorString(result.error);
+        if (result.ok()) {
+            applied++;
+        }
+    }
+
+    // A failed write persists none of them, so they all fail together
+    if (applied > 0 && !store.commit()) {
+        for (uint8_t i = 0; i < count; i++) {
+            if (!failures[i]) {
+                failures[i] = "Failed to write device configuration";
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (!failures[i]) {
+            _finish(slots[i], State::COMMITTED, nullptr);
+            continue;
+        }
+
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        Transaction transaction = _transactions[slots[i]];
+        xSemaphoreGive(_mutex);
+
+        // Hub files are unchanged: put a provisioned node back into discovery
+        if (transaction.kind == Kind::PROVISION) {
+            DeviceConfigStore::sendUnmap(transaction.mac);
+        }
+        _finish(slots[i], State::FAILED, failures[i]);
+    }
+}
+
+void ProvisioningManager::_rollBack(uint8_t slot, const char* reason) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    Transaction transaction = _transactions[slot];
+    xSemaphoreGive(_mutex);
+
+    // The node may have applied a CONFIG whose confirmation was lost
+    if (transaction.kind == Kind::PROVISION) {
+        DeviceConfigStore::sendUnmap(transaction.mac);
+    }
+    _finish(slot, State::ROLLED_BACK, reason);
+}
+
+void ProvisioningManager::_finish(uint8_t slot, State state, const char* error) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    Transaction& transaction = _transactions[slot];
+    transaction.state = state;
+    transaction.finishedMs = millis();
+    transaction.error = error ? error : "";
+    Transaction result = transaction;
+    Completion completion = _completions[slot];
+    _completions[slot] = nullptr;
+    xSemaphoreGive(_mutex);
+
+    if (state == State::COMMITTED) {
+        Serial.printf("[OK] Provisioning %u: %s committed (%s, %u attempts)\n", result.id,
+                      result.macStr.c_str(), result.confirmed ? "confirmed" : "device offline", result.attempts);
+    } else {
+        Serial.printf("[ERR] Provisioning %u: %s %s: %s\n", result.id, result.macStr.c_str(),
+                      stateString(state), result.error.c_str());
+    }
+
+    if (completion) {
+        completion(result);
+    }
+}
+
+// ============================================================================
+// QUERIES
+// ============================================================================
+
+bool ProvisioningManager::get(uint32_t id, Transaction& out) {
+    bool found = false;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < MAX_TRANSACTIONS; i++) {
+        if (id != 0 && _transactions[i].id == id) {
+            out = _transactions[i];
+            found = true;
+            break;
+        }
+    }
+    xSemaphoreGive(_mutex);
+    return found;
+}
+
+void ProvisioningManager::toJson(JsonArray out) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < MAX_TRANSACTIONS; i++) {
+        if (_transactions[i].id != 0) {
+            toJson(_transactions[i], out.add<JsonObject>());
+        }
+    }
+    xSemaphoreGive(_mutex);
+}
+
+void ProvisioningManager::toJson(const Transaction& transaction, JsonObject out) {
+    out["id"] = transaction.id;
+    out["op"] = transaction.kind == Kind::PROVISION ? "provision" : "unmap";
+    out["state"] = stateString(transaction.state);
+    out["mac"] = transaction.macStr;
+    if (transaction.kind == Kind::PROVISION) {
+        out["name"] = transaction.name;
+        out["tankId"] = transaction.tankId;
+    }
+    out["attempts"] = transaction.attempts;
+    out["confirmed"] = transaction.confirmed;
+    out["elapsedMs"] = (transaction.state == State::PENDING ? millis() : transaction.finishedMs) - transaction.startedMs;
+    if (transaction.error.length() > 0) {
+        out["error"] = transaction.error;
+    }
+}
+
+const char* ProvisioningManager::stateString(State state) {
+    switch (state) {
+        case State::PENDING: return "PENDING";
+        case State::COMMITTED: return "COMMITTED";
+        case State::ROLLED_BACK: return "ROLLED_BACK";
+        case State::FAILED: return "FAILED";
+    }
+    return "UNKNOWN";
+}
@@ -0,0 +1,203 @@
+#include "managers/ScheduleJournal.h"
+#include <LittleFS.h>
+
+ScheduleJournal& ScheduleJournal::getInstance() {
+    static ScheduleJournal instance;
+    return instance;
+}
+
+ScheduleJournal::ScheduleJournal()
+    : _mutex(xSemaphoreCreateMutex())
+    , _ready(false)
+    , _appended(0)
+    , _compactPending(false) {
+}
+
+// ============================================================================
+// LIFECYCLE
+// ============================================================================
+
+bool ScheduleJournal::begin() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _state.clear();
+    _appended = 0;
+    _compactPending = false;
+
+    File file = LittleFS.open(JOURNAL_FILE, "r");
+    if (!file) {
+        // First boot: create it so appends have a file to extend
+        file = LittleFS.open(JOURNAL_FILE, "w");
+        _ready = (bool)file;
+        if (file) {
+            file.close();
+        }
+        xSemaphoreGive(_mutex);
+        if (!_ready) {
+            Serial.println("[ERR] Cannot create schedule journal, firings dedupe in RAM only");
+        }
+        return _ready;
+    }
+
+    // Later records supersede earlier ones for the same schedule
+    JournalRecord record;
+    size_t records = 0;
+    while (file.read((uint8_t*)&record, sizeof(record)) == sizeof(record)) {
+        if (record.crc != _crc16((const uint8_t*)&record, sizeof(record) - sizeof(record.crc))) {
+            _compactPending = true;     // Torn append, rewrite without it
+            break;
+        }
+        FiringState& state = _state[_key(record.mac, record.scheduleId)];
+        if (record.firing >= state.firing) {
+            state.firing = record.firing;
+            state.count = record.count;
+        }
+        records++;
+    }
+    if (file.available() > 0) {
+        _compactPending = true;
+    }
+    file.close();
+
+    _appended = records > COMPACT_RECORDS ? COMPACT_RECORDS : records;
+    _ready = true;
+
+    // Appends must not land behind a torn record, or the next load stops short
+    if (_compactPending || _appended >= COMPACT_RECORDS) {
+        _compactPending = !_compact();
+        if (!_compactPending) {
+            _appended = 0;
+        }
+    }
+    xSemaphoreGive(_mutex);
+
+    Serial.printf("[OK] Schedule journal: %u records, %u schedules\n",
+                  (unsigned)records, (unsigned)_state.size());
+    return true;
+}
+
+// ============================================================================
+// FIRINGS
+// ============================================================================
+
+bool ScheduleJournal::recordFiring(const uint8_t* mac, uint32_t scheduleId, uint32_t firing, uint32_t count) {
+    JournalRecord record;
+    memset(&record, 0, sizeof(record));
+    memcpy(record.mac, mac, 6);
+    record.scheduleId = scheduleId;
+    record.firing = firing;
+    record.count = count;
+    record.crc = _crc16((const uint8_t*)&record, sizeof(record) - sizeof(record.crc));
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    FiringState& state = _state[_key(mac, scheduleId)];
+    state.firing = firing;
+    state.count = count;
+
+    bool written = false;
+    if (_ready) {
+        File file = LittleFS.open(JOURNAL_FILE, "a");
+        if (file) {
+            written = file.write((const uint8_t*)&record, sizeof(record)) == sizeof(record);
+            file.close();
+        }
+        if (written && ++_appended >= COMPACT_RECORDS) {
+            _compactPending = true;
+        }
+    }
+    xSemaphoreGive(_mutex);
+
+    if (_ready && !written) {
+        Serial.printf("[ERR] Schedule %u firing not journaled, may repeat after reboot\n", scheduleId);
+    }
+    return written;
+}
+
+void ScheduleJournal::restore(const uint8_t* mac, Schedule& schedule) const {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    auto it = _state.find(_key(mac, schedule.getId()));
+    if (it != _state.end()) {
+        schedule.restoreExecution(it->second.firing, it->second.count);
+    }
+    xSemaphoreGive(_mutex);
+}
+
+void ScheduleJournal::forget(const uint8_t* mac, uint32_t scheduleId) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _state.erase(_key(mac, scheduleId));
+    xSemaphoreGive(_mutex);
+}
+
+// ============================================================================
+// COMPACTION
+// ============================================================================
+
+void ScheduleJournal::update() {
+    if (!_ready || !_compactPending) {
+        return;
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (_compact()) {
+        _appended = 0;
+        _compactPending = false;
+    }
+    xSemaphoreGive(_mutex);
+}
+
+bool ScheduleJournal::_compact() {
+    String tmpPath = String(JOURNAL_FILE) + ".tmp";
+
+    File file = LittleFS.open(tmpPath, "w");
+    if (!file) {
+        Serial.printf("[ERR] Cannot open %s for writing\n", tmpPath.c_str());
+        return false;
+    }
+
+    bool ok = true;
+    JournalRecord record;
+    for (const auto& entry : _state) {
+        memset(&record, 0, sizeof(record));
+        uint64_t macKey = entry.first.first;
+        for (uint8_t i = 0; i < 6; i++) {
+            record.mac[i] = (macKey >> (8 * (5 - i))) & 0xFF;
+        }
+        record.scheduleId = entry.first.second;
+        record.firing = entry.second.firing;
+        record.count = entry.second.count;
+        record.crc = _crc16((const uint8_t*)&record, sizeof(record) - sizeof(record.crc));
+        ok &= file.write((const uint8_t*)&record, sizeof(record)) == sizeof(record);
+    }
+    file.close();
+
+    if (!ok || !LittleFS.rename(tmpPath, JOURNAL_FILE)) {
+        Serial.printf("[ERR] Failed to compact %s\n", JOURNAL_FILE);
+        LittleFS.remove(tmpPath);
+        return false;
+    }
+
+    Serial.printf("[OK] Schedule journal compacted to %u records\n", (unsigned)_state.size());
+    return true;
+}
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+ScheduleJournal::Key ScheduleJournal::_key(const uint8_t* mac, uint32_t scheduleId) {
+    uint64_t macKey = 0;
+    for (uint8_t i = 0; i < 6; i++) {
+        macKey = (macKey << 8) | mac[i];
+    }
+    return Key(macKey, scheduleId);
+}
+
+uint16_t ScheduleJournal::_crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
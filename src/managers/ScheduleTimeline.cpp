@@ -0,0 +1,310 @@
+#include "managers/ScheduleTimeline.h"
+#include "managers/AquariumManager.h"
+#include <algorithm>
+#include <map>
+#include <time.h>
+
+static const uint32_t SECONDS_PER_WEEK = 7 * 24 * 3600;
+
+ScheduleTimeline& ScheduleTimeline::getInstance() {
+    static ScheduleTimeline instance;
+    return instance;
+}
+
+ScheduleTimeline::ScheduleTimeline()
+    : _builtGeneration(0)
+    , _built(false) {
+}
+
+// ============================================================================
+// INDEX
+// ============================================================================
+
+bool ScheduleTimeline::refresh() {
+    if (_built && _builtGeneration == Schedule::getGeneration()) {
+        return false;
+    }
+
+    _build();
+    return true;
+}
+
+void ScheduleTimeline::_build() {
+    uint32_t startUs = micros();
+
+    _weekly.clear();
+    _sparse.clear();
+
+    std::vector<uint16_t> minutes;
+    std::vector<Device*> devices = AquariumManager::getInstance().getAllDevices();
+
+    for (Device* device : devices) {
+        std::vector<Schedule*> schedules = device->getAllSchedules();
+
+        for (Schedule* schedule : schedules) {
+            if (!schedule->isEnabled() || schedule->getCommandLength() == 0) {
+                continue;
+            }
+
+            if (schedule->getType() == Schedule::Type::ONE_TIME ||
+                schedule->getType() == Schedule::Type::INTERVAL) {
+                SparseRef ref;
+                memcpy(ref.mac, device->getMac(), 6);
+                ref.scheduleId = schedule->getId();
+                _sparse.push_back(ref);
+                continue;
+            }
+
+            minutes.clear();
+            schedule->appendWeekMinutes(minutes);
+
+            Entry entry;
+            memcpy(entry.mac, device->getMac(), 6);
+            entry.nodeType = device->getType();
+            entry.opcode = schedule->getCommandData()[0];
+            entry.scheduleId = schedule->getId();
+            entry.commandHash = _hashCommand(schedule->getCommandData(), schedule->getCommandLength());
+
+            for (uint16_t minute : minutes) {
+                entry.minute = minute;
+                _weekly.push_back(entry);
+            }
+        }
+    }
+
+    std::sort(_weekly.begin(), _weekly.end(), [](const Entry& a, const Entry& b) {
+        if (a.minute != b.minute) {
+            return a.minute < b.minute;
+        }
+        int macOrder = memcmp(a.mac, b.mac, 6);
+        if (macOrder != 0) {
+            return macOrder < 0;
+        }
+        return a.scheduleId < b.scheduleId;
+    });
+
+    _builtGeneration = Schedule::getGeneration();
+    _built = true;
+
+    Serial.printf("[OK] Schedule timeline compiled: %u weekly firings, %u runtime schedules (%lu us)\n",
+                  (unsigned)_weekly.size(), (unsigned)_sparse.size(),
+                  (unsigned long)(micros() - startUs));
+}
+
+// ============================================================================
+// QUERY
+// ============================================================================
+
+bool ScheduleTimeline::query(uint32_t from, uint32_t to, std::vector<Event>& out, size_t maxEvents) {
+    refresh();
+    out.clear();
+
+    if (to <= from) {
+        return false;
+    }
+
+    // Gather one extra event so truncation can be detected
+    size_t limit = maxEvents + 1;
+
+    // Weekly firings: binary search to the first minute >= from, then walk
+    if (!_weekly.empty()) {
+        uint64_t base = _weekStart(from);
+        uint16_t firstMinute = (uint16_t)((from - base + 59) / 60);
+
+        Entry key;
+        key.minute = firstMinute;
+        size_t index = std::lower_bound(_weekly.begin(), _weekly.end(), key,
+            [](const Entry& a, const Entry& b) { return a.minute < b.minute; }) - _weekly.begin();
+
+        while (out.size() < limit) {
+            if (index == _weekly.size()) {
+                index = 0;
+                base += SECONDS_PER_WEEK;
+            }
+
+            const Entry& entry = _weekly[index];
+            uint64_t time = base + (uint32_t)entry.minute * 60;
+            if (time >= to) {
+                break;
+            }
+
+            Event event;
+            event.time = (uint32_t)time;
+            memcpy(event.mac, entry.mac, 6);
+            event.scheduleId = entry.scheduleId;
+            event.commandHash = entry.commandHash;
+            event.opcode = entry.opcode;
+            event.nodeType = entry.nodeType;
+            out.push_back(event);
+
+            index++;
+        }
+    }
+
+    // Runtime-dependent schedules, resolved against the live objects
+    for (const SparseRef& ref : _sparse) {
+        Device* device = AquariumManager::getInstance().getDevice(ref.mac);
+        Schedule* schedule = device ? device->getSchedule(ref.scheduleId) : nullptr;
+        if (schedule && schedule->isEnabled()) {
+            _appendSparse(*schedule, ref, device->getType(), from, to, out, limit);
+        }
+    }
+
+    std::sort(out.begin(), out.end(), [](const Event& a, const Event& b) {
+        if (a.time != b.time) {
+            return a.time < b.time;
+        }
+        int macOrder = memcmp(a.mac, b.mac, 6);
+        if (macOrder != 0) {
+            return macOrder < 0;
+        }
+        return a.scheduleId < b.scheduleId;
+    });
+
+    if (out.size() > maxEvents) {
+        out.resize(maxEvents);
+        return true;
+    }
+    return false;
+}
+
+void ScheduleTimeline::_appendSparse(const Schedule& schedule, const SparseRef& ref, NodeType nodeType,
+                                     uint32_t from, uint32_t to, std::vector<Event>& out, size_t maxEvents) const {
+    Event event;
+    memcpy(event.mac, ref.mac, 6);
+    event.scheduleId = ref.scheduleId;
+    event.commandHash = _hashCommand(schedule.getCommandData(), schedule.getCommandLength());
+    event.opcode = schedule.getCommandData()[0];
+    event.nodeType = nodeType;
+
+    if (schedule.getType() == Schedule::Type::ONE_TIME) {
+        uint32_t time = schedule.getNextExecution();
+        if (schedule.getExecutionCount() == 0 && time > 0 &&
+            time >= from && time < to) {
+            event.time = time;
+            out.push_back(event);
+        }
+        return;
+    }
+
+    uint32_t interval = schedule.getIntervalSeconds();
+    if (interval == 0) {
+        return;
+    }
+
+    // Never executed: isDue() fires it on the next check
+    uint64_t time = schedule.getLastExecution() > 0
+        ? (uint64_t)schedule.getLastExecution() + interval
+        : from;
+    if (time < from) {
+        time += ((from - time + interval - 1) / interval) * interval;
+    }
+
+    // Each source stays in time order, so capping it at maxEvents keeps
+    // the merged result exact up to the cap
+    size_t added = 0;
+    while (time < to && added < maxEvents) {
+        event.time = (uint32_t)time;
+        out.push_back(event);
+        added++;
+        time += interval;
+    }
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+void ScheduleTimeline::toJson(uint32_t from, uint32_t to, JsonObject out) {
+    std::vector<Event> events;
+    bool truncated = query(from, to, events, MAX_EVENTS);
+
+    out["from"] = from;
+    out["to"] = to;
+    out["now"] = (uint32_t)time(nullptr);
+    out["generation"] = Schedule::getGeneration();
+    out["indexed"] = _weekly.size();
+    out["truncated"] = truncated;
+
+    JsonArray list = out["events"].to<JsonArray>();
+    JsonArray conflicts = out["conflicts"].to<JsonArray>();
+    JsonArray redundant = out["redundant"].to<JsonArray>();
+
+    AquariumManager& manager = AquariumManager::getInstance();
+    std::map<uint64_t, size_t> lastByDevice;   // MAC key -> index of previous event
+
+    for (size_t i = 0; i < events.size(); i++) {
+        const Event& event = events[i];
+
+        char macStr[18];
+        snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+                 event.mac[0], event.mac[1], event.mac[2], event.mac[3], event.mac[4], event.mac[5]);
+
+        Device* device = manager.getDevice(event.mac);
+        Schedule* schedule = device ? device->getSchedule(event.scheduleId) : nullptr;
+
+        JsonObject item = list.add<JsonObject>();
+        item["t"] = event.time;
+        item["mac"] = macStr;
+        item["device"] = device ? device->getName() : String("");
+        item["scheduleId"] = event.scheduleId;
+        item["schedule"] = schedule ? schedule->getName() : String("");
+        item["opcode"] = event.opcode;
+
+        uint64_t key = 0;
+        for (int b = 0; b < 6; b++) {
+            key |= ((uint64_t)event.mac[b]) << (b * 8);
+        }
+
+        std::map<uint64_t, size_t>::iterator last = lastByDevice.find(key);
+        if (last != lastByDevice.end()) {
+            const Event& previous = events[last->second];
+            const char* flag = nullptr;
+
+            if (previous.time == event.time) {
+                // Same minute: updateSchedules() sends both, the later one wins
+                flag = (previous.commandHash != event.commandHash) ? "conflict" : "duplicate";
+            } else if (previous.commandHash == event.commandHash && _isStateCommand(event.nodeType)) {
+                flag = "no-change";
+            }
+
+            if (flag) {
+                JsonObject issue = (flag[0] == 'c') ? conflicts.add<JsonObject>() : redundant.add<JsonObject>();
+                issue["t"] = event.time;
+                issue["mac"] = macStr;
+                issue["scheduleId"] = event.scheduleId;
+                issue["with"] = previous.scheduleId;
+                issue["reason"] = flag;
+                item["flag"] = flag;
+            }
+        }
+
+        lastByDevice[key] = i;
+    }
+}
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+uint32_t ScheduleTimeline::_weekStart(uint32_t time) {
+    // Same calendar conversion as Schedule::_firingAtOrBefore()
+    time_t now = time;
+    struct tm* timeinfo = localtime(&now);
+    uint32_t intoWeek = timeinfo->tm_wday * 86400u + timeinfo->tm_hour * 3600u +
+                        timeinfo->tm_min * 60u + timeinfo->tm_sec;
+    return time - intoWeek;
+}
+
+uint32_t ScheduleTimeline::_hashCommand(const uint8_t* data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+bool ScheduleTimeline::_isStateCommand(NodeType type) {
+    // Repeating these changes nothing; feeders and dosers act on every command
+    return type == NodeType::LIGHT || type == NodeType::HEATER || type == NodeType::CO2;
+}
@@ -0,0 +1,501 @@
+#include "managers/TaskExecutor.h"
+
+#if defined(ESP32)
+#include <Arduino.h>
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <stdio.h>
+#endif
+#include <string.h>
+
+// ============================================================================
+// PLATFORM
+// ============================================================================
+
+struct TaskExecutor::Slot {
+    Job job;
+    uint32_t enqueuedUs;
+    uint32_t budgetMs;                             // As submitted, for reruns
+    uint32_t deadlineMs;
+    bool hasDeadline;
+    uint8_t priority;
+    uint8_t key;
+};
+
+struct TaskExecutor::Worker {
+    uint8_t index;
+    Slot queues[PRIORITY_COUNT][QUEUE_CAPACITY];   // Ring per priority
+    uint8_t head[PRIORITY_COUNT];
+    uint8_t count[PRIORITY_COUNT];
+    std::atomic<uint32_t> busyUs;                  // Wraps; only deltas are used
+    std::atomic<bool> running;                     // Inside a job
+
+#if defined(ESP32)
+    SemaphoreHandle_t lock;
+    TaskHandle_t task;
+
+    void acquire() { xSemaphoreTake(lock, portMAX_DELAY); }
+    void release() { xSemaphoreGive(lock); }
+#else
+    std::mutex lock;
+    std::condition_variable wakeup;
+    bool signaled;
+    std::thread thread;
+
+    void acquire() { lock.lock(); }
+    void release() { lock.unlock(); }
+#endif
+};
+
+// Guards the key masks; held for a few instructions only
+#if defined(ESP32)
+static portMUX_TYPE keyMux = portMUX_INITIALIZER_UNLOCKED;
+static void lockKeys() { portENTER_CRITICAL(&keyMux); }
+static void unlockKeys() { portEXIT_CRITICAL(&keyMux); }
+#else
+static std::mutex keyMutex;
+static void lockKeys() { keyMutex.lock(); }
+static void unlockKeys() { keyMutex.unlock(); }
+#endif
+
+uint32_t TaskExecutor::_nowMs() {
+#if defined(ESP32)
+    return millis();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+uint32_t TaskExecutor::_nowUs() {
+#if defined(ESP32)
+    return micros();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void TaskExecutor::_wake(uint8_t worker) {
+    Worker* w = _workers[worker];
+#if defined(ESP32)
+    xTaskNotifyGive(w->task);
+#else
+    {
+        std::lock_guard<std::mutex> guard(w->lock);
+        w->signaled = true;
+    }
+    w->wakeup.notify_one();
+#endif
+}
+
+uint8_t TaskExecutor::_localWorker() {
+#if defined(ESP32)
+    return xPortGetCoreID() % _workerCount;
+#else
+    return _nextWorker.fetch_add(1) % _workerCount;
+#endif
+}
+
+void TaskExecutor::_workerEntry(void* parameter) {
+    Worker* worker = (Worker*)parameter;
+    getInstance()._run(worker->index);
+#if defined(ESP32)
+    vTaskDelete(NULL);
+#endif
+}
+
+// ============================================================================
+// LIFECYCLE
+// ============================================================================
+
+TaskExecutor& TaskExecutor::getInstance() {
+    static TaskExecutor instance;
+    return instance;
+}
+
+TaskExecutor::TaskExecutor()
+    : _workerCount(0)
+    , _stopping(false)
+    , _pendingKeys(0)
+    , _runningKeys(0)
+    , _rerunKeys(0)
+    , _nextWorker(0)
+    , _submitted(0)
+    , _coalesced(0)
+    , _rejected(0)
+    , _executed(0)
+    , _stolen(0)
+    , _late(0)
+    , _latencySumUs(0)
+    , _latencyCount(0)
+    , _latencyMaxUs(0)
+    , _windowStartMs(0) {
+    memset(&_lastStats, 0, sizeof(_lastStats));
+    for (uint8_t i = 0; i < MAX_WORKERS; i++) {
+        _workers[i] = nullptr;
+        _windowBusyUs[i] = 0;
+    }
+}
+
+bool TaskExecutor::begin(uint8_t workers) {
+    if (_workerCount > 0) {
+        return true;
+    }
+    if (workers < 1) {
+        workers = 1;
+    }
+    if (workers > MAX_WORKERS) {
+        workers = MAX_WORKERS;
+    }
+
+    // Queues exist before any worker runs, so stealing never sees a gap
+    _stopping = false;
+    for (uint8_t i = 0; i < workers; i++) {
+        Worker* w = new Worker();
+        w->index = i;
+        memset(w->head, 0, sizeof(w->head));
+        memset(w->count, 0, sizeof(w->count));
+        w->busyUs = 0;
+        w->running = false;
+#if defined(ESP32)
+        w->lock = xSemaphoreCreateMutex();
+        w->task = NULL;
+#else
+        w->signaled = false;
+#endif
+        _workers[i] = w;
+    }
+    _workerCount = workers;
+    _windowStartMs = _nowMs();
+
+    uint8_t started = 0;
+    for (uint8_t i = 0; i < workers; i++) {
+#if defined(ESP32)
+        char name[12];
+        snprintf(name, sizeof(name), "Exec%u", i);
+        if (xTaskCreatePinnedToCore(_workerEntry, name, WORKER_STACK_SIZE, _workers[i],
+                                    WORKER_PRIORITY, &_workers[i]->task, i) != pdPASS) {
+            break;
+        }
+#else
+        _workers[i]->thread = std::thread(_workerEntry, _workers[i]);
+#endif
+        started++;
+    }
+
+    if (started < workers) {
+        // Jobs are only queued on started workers; the rest stay allocated
+#if defined(ESP32)
+        Serial.printf("[ERR] Executor: started %u of %u workers\n", started, workers);
+#else
+        fprintf(stderr, "[ERR] Executor: started %u of %u workers\n", started, workers);
+#endif
+        _workerCount = started;
+    }
+#if defined(ESP32)
+    Serial.printf("[OK] Executor: %u workers (priority %u)\n", _workerCount, (unsigned)WORKER_PRIORITY);
+#endif
+    return _workerCount > 0;
+}
+
+void TaskExecutor::end() {
+    if (_workerCount == 0) {
+        return;
+    }
+    uint8_t workers = _workerCount;
+    _stopping = true;
+    for (uint8_t i = 0; i < workers; i++) {
+        _wake(i);
+    }
+
+#if !defined(ESP32)
+    // Join all before freeing any: a draining worker may still steal
+    for (uint8_t i = 0; i < workers; i++) {
+        _workers[i]->thread.join();
+    }
+    for (uint8_t i = 0; i < workers; i++) {
+        delete _workers[i];
+        _workers[i] = nullptr;
+    }
+#endif
+    // On the hub the tasks delete themselves once drained; their Worker
+    // blocks are left allocated since a task may still be finishing
+    _workerCount = 0;
+}
+
+// ============================================================================
+// QUEUES
+// ============================================================================
+
+bool TaskExecutor::submit(Job job, Priority priority, uint32_t deadlineMs, uint8_t key) {
+    if (key > 31) {
+        key = 0;
+    }
+    _submitted++;
+
+    uint32_t bit = key ? (1u << key) : 0;
+    if (bit) {
+        lockKeys();
+        bool busy = _pendingKeys & bit;
+        if (busy) {
+            // A queued run still sees this change; a running one may not
+            _rerunKeys |= _runningKeys & bit;
+        } else {
+            _pendingKeys |= bit;
+        }
+        unlockKeys();
+        if (busy) {
+            _coalesced++;
+            return true;
+        }
+    }
+
+    Slot slot;
+    slot.job = std::move(job);
+    slot.budgetMs = deadlineMs;
+    slot.priority = (uint8_t)priority;
+    slot.key = key;
+
+    if (_workerCount == 0) {
+        _releaseKey(key);
+        slot.job(JobContext(_nowMs() + deadlineMs, deadlineMs > 0, 0));
+        _executed++;
+        return true;
+    }
+
+    if (!_enqueue(slot, _localWorker())) {
+        _releaseKey(key);
+        _rejected++;
+        return false;
+    }
+    return true;
+}
+
+bool TaskExecutor::_enqueue(Slot& slot, uint8_t first) {
+    slot.enqueuedUs = _nowUs();
+    slot.hasDeadline = slot.budgetMs > 0;
+    slot.deadlineMs = _nowMs() + slot.budgetMs;
+
+    for (uint8_t i = 0; i < _workerCount; i++) {
+        uint8_t target = (first + i) % _workerCount;
+        if (!_push(target, slot, slot.priority)) {
+            continue;
+        }
+        _wake(target);
+
+        // Owner is busy: let an idle worker steal without waiting for its poll
+        if (_workers[target]->running) {
+            for (uint8_t other = 0; other < _workerCount; other++) {
+                if (other != target && !_workers[other]->running) {
+                    _wake(other);
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+void TaskExecutor::_releaseKey(uint8_t key) {
+    if (key) {
+        lockKeys();
+        _pendingKeys &= ~(1u << key);
+        unlockKeys();
+    }
+}
+
+void TaskExecutor::_finishKey(uint8_t self, Slot& slot) {
+    uint32_t bit = 1u << slot.key;
+    lockKeys();
+    _runningKeys &= ~bit;
+    bool rerun = _rerunKeys & bit;
+    _rerunKeys &= ~bit;
+    if (!rerun) {
+        _pendingKeys &= ~bit;
+    }
+    unlockKeys();
+
+    // Submitted again while running: the key stays held through the rerun,
+    // so two runs of one key never overlap
+    if (rerun && !_enqueue(slot, self)) {
+        _releaseKey(slot.key);
+        _rejected++;
+    }
+}
+
+bool TaskExecutor::_push(uint8_t worker, Slot& slot, uint8_t priority) {
+    Worker* w = _workers[worker];
+    w->acquire();
+    if (w->count[priority] >= QUEUE_CAPACITY) {
+        w->release();
+        return false;
+    }
+    uint8_t index = (w->head[priority] + w->count[priority]) % QUEUE_CAPACITY;
+    w->queues[priority][index] = std::move(slot);
+    w->count[priority]++;
+    w->release();
+    return true;
+}
+
+bool TaskExecutor::_take(uint8_t self, Slot& slot, bool& stolen) {
+    for (uint8_t priority = 0; priority < PRIORITY_COUNT; priority++) {
+        // Own queue: oldest first
+        Worker* own = _workers[self];
+        own->acquire();
+        if (own->count[priority] > 0) {
+            Slot& front = own->queues[priority][own->head[priority]];
+            slot = std::move(front);
+            front.job = nullptr;
+            own->head[priority] = (own->head[priority] + 1) % QUEUE_CAPACITY;
+            own->count[priority]--;
+            own->release();
+            stolen = false;
+            return true;
+        }
+        own->release();
+
+        // Steal the newest from another worker, leaving its oldest to the owner
+        for (uint8_t offset = 1; offset < _workerCount; offset++) {
+            Worker* victim = _workers[(self + offset) % _workerCount];
+            victim->acquire();
+            if (victim->count[priority] > 0) {
+                uint8_t index = (victim->head[priority] + victim->count[priority] - 1) % QUEUE_CAPACITY;
+                Slot& back = victim->queues[priority][index];
+                slot = std::move(back);
+                back.job = nullptr;
+                victim->count[priority]--;
+                victim->release();
+                stolen = true;
+                return true;
+            }
+            victim->release();
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// WORKER
+// ============================================================================
+
+void TaskExecutor::_run(uint8_t self) {
+    Worker* w = _workers[self];
+
+    while (true) {
+        Slot slot;
+        bool stolen = false;
+        if (!_take(self, slot, stolen)) {
+            if (_stopping) {
+                break;
+            }
+#if defined(ESP32)
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(IDLE_WAIT_MS));
+#else
+            std::unique_lock<std::mutex> guard(w->lock);
+            w->wakeup.wait_for(guard, std::chrono::milliseconds((uint32_t)IDLE_WAIT_MS),
+                               [w, this]() { return w->signaled || _stopping.load(); });
+            w->signaled = false;
+#endif
+            continue;
+        }
+
+        // From here a submit with this key asks for a rerun
+        if (slot.key) {
+            lockKeys();
+            _runningKeys |= 1u << slot.key;
+            unlockKeys();
+        }
+
+        uint32_t startUs = _nowUs();
+        uint32_t latency = startUs - slot.enqueuedUs;
+        _latencySumUs += latency;
+        _latencyCount++;
+        uint32_t previousMax = _latencyMaxUs.load();
+        while (latency > previousMax && !_latencyMaxUs.compare_exchange_weak(previousMax, latency)) {
+        }
+        if (slot.hasDeadline && (int32_t)(_nowMs() - slot.deadlineMs) > 0) {
+            _late++;
+        }
+        if (stolen) {
+            _stolen++;
+        }
+
+        w->running = true;
+        slot.job(JobContext(slot.deadlineMs, slot.hasDeadline, self));
+        w->running = false;
+
+        w->busyUs += _nowUs() - startUs;
+        _executed++;
+
+        if (slot.key) {
+            _finishKey(self, slot);
+        }
+    }
+}
+
+// ============================================================================
+// JOB CONTEXT
+// ============================================================================
+
+bool TaskExecutor::JobContext::expired() const {
+    return _hasDeadline && (int32_t)(_nowMs() - _deadlineMs) >= 0;
+}
+
+uint32_t TaskExecutor::JobContext::remainingMs() const {
+    if (!_hasDeadline) {
+        return UINT32_MAX;
+    }
+    int32_t remaining = (int32_t)(_deadlineMs - _nowMs());
+    return remaining > 0 ? (uint32_t)remaining : 0;
+}
+
+// ============================================================================
+// METRICS
+// ============================================================================
+
+TaskExecutor::Stats TaskExecutor::getStats() {
+    Stats stats = _lastStats;
+    stats.workers = _workerCount;
+    stats.submitted = _submitted;
+    stats.coalesced = _coalesced;
+    stats.rejected = _rejected;
+    stats.executed = _executed;
+    stats.stolen = _stolen;
+    stats.late = _late;
+
+    stats.queued = 0;
+    for (uint8_t i = 0; i < _workerCount; i++) {
+        Worker* w = _workers[i];
+        w->acquire();
+        for (uint8_t priority = 0; priority < PRIORITY_COUNT; priority++) {
+            stats.queued += w->count[priority];
+        }
+        w->release();
+    }
+
+    // Utilization and latency over a window of at least STATS_WINDOW_MS
+    uint32_t now = _nowMs();
+    uint32_t elapsed = now - _windowStartMs;
+    if (elapsed >= STATS_WINDOW_MS) {
+        for (uint8_t i = 0; i < MAX_WORKERS; i++) {
+            uint32_t busy = i < _workerCount ? _workers[i]->busyUs.load() : 0;
+            uint32_t pct = (busy - _windowBusyUs[i]) / (elapsed * 10);
+            stats.utilizationPct[i] = pct > 100 ? 100 : pct;
+            _windowBusyUs[i] = busy;
+        }
+        uint32_t count = _latencyCount.exchange(0);
+        uint32_t sum = _latencySumUs.exchange(0);
+        stats.avgLatencyUs = count ? sum / count : 0;
+        stats.maxLatencyUs = _latencyMaxUs.exchange(0);
+        stats.windowMs = elapsed;
+        _windowStartMs = now;
+    }
+
+    _lastStats = stats;
+    return stats;
+}
@@ -24,6 +24,10 @@ Aquarium::Aquarium(uint8_t id, const String& name)
     , _currentPh(0.0f)
     , _currentTds(0)
     , _lastSensorUpdate(0)
+    , _temperatureMonitor(SensorStreamMonitor::temperatureConfig())
+    , _phMonitor(SensorStreamMonitor::phConfig())
+    , _tdsMonitor(SensorStreamMonitor::tdsConfig())
+    , _version(0)
 {
     Serial.printf(" Created aquarium: %s (ID: %d)\n", _name.c_str(), _id);
 }
@@ -44,25 +48,54 @@ Aquarium::~Aquarium() {
 /**
  * @brief Update current temperature reading
  */
-void Aquarium::updateTemperature(float temp) {
-    _currentTemperature = temp;
-    _lastSensorUpdate = millis();
+uint8_t Aquarium::updateTemperature(float temp, uint32_t timestampMs, const uint8_t* sourceMac) {
+    if (timestampMs == 0) timestampMs = millis();
+    uint8_t flags = _temperatureMonitor.addSample(temp, timestampMs);
+    if (!_temperatureMonitor.isSuspect()) {
+        _temperatureFusion.addSample(sourceMac, TemperatureFusion::SourceKind::PROBE, temp, timestampMs);
+        _currentTemperature = _temperatureFusion.getEstimate();
+    }
+    _lastSensorUpdate = timestampMs;
+    return flags;
+}
+
+/**
+ * @brief Fuse a heater probe reading
+ */
+TemperatureFusion::Result Aquarium::updateHeaterTemperature(float temp, const uint8_t* heaterMac, uint32_t timestampMs) {
+    if (timestampMs == 0) timestampMs = millis();
+    TemperatureFusion::Result result =
+        _temperatureFusion.addSample(heaterMac, TemperatureFusion::SourceKind::HEATER, temp, timestampMs);
+    if (_temperatureFusion.hasEstimate()) {
+        _currentTemperature = _temperatureFusion.getEstimate();
+    }
+    return result;
 }
 
 /**
  * @brief Update current pH reading
  */
-void Aquarium::updatePh(float ph) {
-    _currentPh = ph;
-    _lastSensorUpdate = millis();
+uint8_t Aquarium::updatePh(float ph, uint32_t timestampMs) {
+    if (timestampMs == 0) timestampMs = millis();
+    uint8_t flags = _phMonitor.addSample(ph, timestampMs);
+    if (!_phMonitor.isSuspect()) {
+        _currentPh = ph;
+    }
+    _lastSensorUpdate = timestampMs;
+    return flags;
 }
 
 /**
  * @brief Update current TDS reading
  */
-void Aquarium::updateTds(uint16_t tds) {
-    _currentTds = tds;
-    _lastSensorUpdate = millis();
+uint8_t Aquarium::updateTds(uint16_t tds, uint32_t timestampMs) {
+    if (timestampMs == 0) timestampMs = millis();
+    uint8_t flags = _tdsMonitor.addSample(tds, timestampMs);
+    if (!_tdsMonitor.isSuspect()) {
+        _currentTds = tds;
+    }
+    _lastSensorUpdate = timestampMs;
+    return flags;
 }
 
 /**
@@ -174,14 +207,14 @@ bool Aquarium::hasDevice(const uint8_t* mac) const {
  * @brief Check if temperature is within safe range
  */
 bool Aquarium::isTemperatureSafe() const {
-    // If no sensor data yet, assume safe
-    if (_lastSensorUpdate == 0) {
+    // No probe has reported: nothing to judge
+    if (!_temperatureFusion.hasEstimate() && _temperatureMonitor.getSampleCount() == 0) {
         return true;
     }
     
-    // Check if reading is recent (within 5 minutes)
-    if (millis() - _lastSensorUpdate > 300000) {
-        return true;  // Assume safe if stale data
+    // Stale or suspect data is not evidence of a safe tank
+    if (!hasTrustedTemperature()) {
+        return false;
     }
     
     return (_currentTemperature >= _minTemperature && 
@@ -192,14 +225,14 @@ bool Aquarium::isTemperatureSafe() const {
  * @brief Check if pH is within safe range
  */
 bool Aquarium::isPhSafe() const {
-    // If no sensor data yet, assume safe
-    if (_lastSensorUpdate == 0) {
+    // No probe has reported: nothing to judge
+    if (_phMonitor.getSampleCount() == 0) {
         return true;
     }
     
-    // Check if reading is recent (within 5 minutes)
-    if (millis() - _lastSensorUpdate > 300000) {
-        return true;  // Assume safe if stale data
+    // Stale or suspect data is not evidence of a safe tank
+    if (!hasTrustedPh()) {
+        return false;
     }
     
     return (_currentPh >= _minPh && _currentPh <= _maxPh);
@@ -256,57 +289,68 @@ uint8_t Aquarium::getHealthScore() const {
 }
 
 /**
- * @brief Convert aquarium to JSON
+ * @brief Write aquarium fields into a JSON object
  */
-String Aquarium::toJson() const {
-    String json = "{";
-    json += "\"id\":" + String(_id) + ",";
-    json += "\"name\":\"" + _name + "\",";
-    json += "\"volumeLiters\":" + String(_volumeLiters) + ",";
-    json += "\"tankType\":\"" + _tankType + "\",";
-    json += "\"location\":\"" + _location + "\",";
-    json += "\"description\":\"" + _description + "\",";
-    json += "\"enabled\":" + String(_enabled ? "true" : "false") + ",";
+void Aquarium::toJsonObject(JsonObject obj) const {
+    obj["id"] = _id;
+    obj["name"] = _name;
+    obj["volumeLiters"] = _volumeLiters;
+    obj["tankType"] = _tankType;
+    obj["location"] = _location;
+    obj["description"] = _description;
+    obj["enabled"] = _enabled;
     
     // Water parameters
-    json += "\"waterParameters\":{";
-    json += "\"temperature\":{";
-    json += "\"target\":" + String(_targetTemperature) + ",";
-    json += "\"min\":" + String(_minTemperature) + ",";
-    json += "\"max\":" + String(_maxTemperature);
-    json += "},";
-    json += "\"ph\":{";
-    json += "\"target\":" + String(_targetPh) + ",";
-    json += "\"min\":" + String(_minPh) + ",";
-    json += "\"max\":" + String(_maxPh);
-    json += "},";
-    json += "\"tds\":{";
-    json += "\"min\":" + String(_minTds) + ",";
-    json += "\"max\":" + String(_maxTds);
-    json += "}";
-    json += "},";
+    JsonObject waterParams = obj["waterParameters"].to<JsonObject>();
+    JsonObject temp = waterParams["temperature"].to<JsonObject>();
+    temp["target"] = _targetTemperature;
+    temp["min"] = _minTemperature;
+    temp["max"] = _maxTemperature;
+    
+    JsonObject ph = waterParams["ph"].to<JsonObject>();
+    ph["target"] = _targetPh;
+    ph["min"] = _minPh;
+    ph["max"] = _maxPh;
+    
+    JsonObject tds = waterParams["tds"].to<JsonObject>();
+    tds["min"] = _minTds;
+    tds["max"] = _maxTds;
     
     // Current readings
-    json += "\"currentReadings\":{";
-    json += "\"temperature\":" + String(_currentTemperature) + ",";
-    json += "\"ph\":" + String(_currentPh) + ",";
-    json += "\"tds\":" + String(_currentTds) + ",";
-    json += "\"lastUpdate\":" + String(_lastSensorUpdate);
-    json += "},";
+    JsonObject currentReadings = obj["currentReadings"].to<JsonObject>();
+    currentReadings["temperature"] = _currentTemperature;
+    currentReadings["temperatureConfidence"] = getTemperatureConfidence();
+    currentReadings["ph"] = _currentPh;
+    currentReadings["tds"] = _currentTds;
+    currentReadings["lastUpdate"] = _lastSensorUpdate;
     
     // Health status
-    json += "\"health\":{";
-    json += "\"score\":" + String(getHealthScore()) + ",";
-    json += "\"temperatureSafe\":" + String(isTemperatureSafe() ? "true" : "false") + ",";
-    json += "\"phSafe\":" + String(isPhSafe() ? "true" : "false") + ",";
-    json += "\"devicesHealthy\":" + String(areDevicesHealthy() ? "true" : "false");
-    json += "},";
+    JsonObject health = obj["health"].to<JsonObject>();
+    health["score"] = getHealthScore();
+    health["temperatureSafe"] = isTemperatureSafe();
+    health["phSafe"] = isPhSafe();
+    health["devicesHealthy"] = areDevicesHealthy();
+    
+    JsonObject probes = health["probes"].to<JsonObject>();
+    _temperatureMonitor.toJsonObject(probes["temperature"].to<JsonObject>());
+    _phMonitor.toJsonObject(probes["ph"].to<JsonObject>());
+    _tdsMonitor.toJsonObject(probes["tds"].to<JsonObject>());
+    _temperatureFusion.toJsonObject(health["temperatureFusion"].to<JsonObject>(), millis());
     
     // Device count
-    json += "\"deviceCount\":" + String(_devices.size());
-    
-    json += "}";
+    obj["deviceCount"] = _devices.size();
+    obj["version"] = _version;
+}
+
+/**
+ * @brief Convert aquarium to JSON
+ */
+String Aquarium::toJson() const {
+    JsonDocument doc;
+    toJsonObject(doc.to<JsonObject>());
     
+    String json;
+    serializeJson(doc, json);
     return json;
 }
 
@@ -347,3 +391,12 @@ uint64_t Aquarium::_macToKey(const uint8_t* mac) const {
     }
     return key;
 }
+
+/**
+ * @brief Reading is recent and not flagged suspect
+ */
+bool Aquarium::_isTrusted(const SensorStreamMonitor& monitor) const {
+    return monitor.getSampleCount() > 0 &&
+           millis() - monitor.getLastSampleTime() <= SENSOR_STALE_MS &&
+           !monitor.isSuspect();
+}
@@ -1,5 +1,8 @@
 #include "models/Device.h"
 #include "ESPNowManager.h"
+#include "managers/AnalyticsManager.h"
+#include "managers/EventJournal.h"
+#include "managers/ScheduleJournal.h"
 
 /**
  * @brief Constructor
@@ -13,15 +16,23 @@ Device::Device(const uint8_t* mac, NodeType type, const String& name)
     , _status(Status::UNKNOWN)
     , _lastHeartbeat(0)
     , _lastCommandSent(0)
+    , _lastCommandId(0)
     , _lastStatusReceived(0)
     , _uptimeMinutes(0)
     , _health(100)
+    , _hasDiagnostics(false)
+    , _linkRateKbps(0)
+    , _linkRssi(0)
+    , _linkDelivery(0)
     , _messagesReceived(0)
     , _messagesSent(0)
     , _commandsSent(0)
     , _errorCount(0)
+    , _version(0)
 {
     memcpy(_mac, mac, 6);
+    memset(&_diagnostics, 0, sizeof(_diagnostics));
+    memset(&_protocol, 0, sizeof(_protocol));
     Serial.printf(" Created device: %s (%s)\n", _name.c_str(), getMacString().c_str());
 }
 
@@ -51,8 +62,8 @@ String Device::getMacString() const {
 /**
  * @brief Get device type name
  */
-String Device::getTypeName() const {
-    switch (_type) {
+const char* Device::typeName(NodeType type) {
+    switch (type) {
         case NodeType::HUB: return "Hub";
         case NodeType::LIGHT: return "Light";
         case NodeType::CO2: return "CO2 Regulator";
@@ -69,8 +80,8 @@ String Device::getTypeName() const {
 /**
  * @brief Get status as string
  */
-String Device::getStatusString() const {
-    switch (_status) {
+const char* Device::statusName(Status status) {
+    switch (status) {
         case Status::UNKNOWN: return "Unknown";
         case Status::ONLINE: return "Online";
         case Status::OFFLINE: return "Offline";
@@ -100,12 +111,44 @@ void Device::updateHeartbeat(uint8_t health, uint16_t uptime) {
  * @brief Check if heartbeat has timed out
  */
 bool Device::hasHeartbeatTimedOut(uint32_t timeoutMs) const {
-    // Never timed out if we haven't received any heartbeat yet
-    if (_lastHeartbeat == 0) {
+    // A STATUS counts too: deep-sleeping nodes report without heartbeats
+    uint32_t lastSeen = (int32_t)(_lastStatusReceived - _lastHeartbeat) > 0 ?
+                        _lastStatusReceived : _lastHeartbeat;
+    
+    // Never timed out if we haven't heard from the device yet
+    if (lastSeen == 0) {
         return false;
     }
     
-    return (millis() - _lastHeartbeat) > timeoutMs;
+    return (millis() - lastSeen) > timeoutMs;
+}
+
+/**
+ * @brief Store heartbeat diagnostics
+ */
+void Device::updateDiagnostics(const HeartbeatDiagnostics& diagnostics) {
+    _diagnostics = diagnostics;
+    _hasDiagnostics = true;
+}
+
+/**
+ * @brief Store link rate, RSSI and delivery
+ */
+void Device::updateLink(uint16_t rateKbps, int8_t rssi, uint8_t deliveryPercent) {
+    _linkRateKbps = rateKbps;
+    _linkRssi = rssi;
+    _linkDelivery = deliveryPercent;
+}
+
+/**
+ * @brief Store the protocol agreed with the node
+ */
+bool Device::setProtocol(const ProtocolInfo& protocol) {
+    if (memcmp(&_protocol, &protocol, sizeof(protocol)) == 0) {
+        return false;
+    }
+    _protocol = protocol;
+    return true;
 }
 
 /**
@@ -117,39 +160,38 @@ bool Device::sendCommand(const uint8_t* commandData, size_t length) {
         return false;
     }
     
-    // Create command message
-    CommandMessage cmd;
-    cmd.header.type = MessageType::COMMAND;
-    cmd.header.tankId = _tankId;
-    cmd.header.nodeType = NodeType::HUB;
-    cmd.header.timestamp = millis();
-    cmd.header.sequenceNum = 0;  // ESPNowManager handles sequence tracking
+    // Transaction ID, wraps 255 -> 1 (0 = unsolicited status)
+    _lastCommandId = (_lastCommandId == 255) ? 1 : _lastCommandId + 1;
+    uint8_t commandId = _lastCommandId;
     
-    cmd.commandId = random(1, 255);  // TODO: Implement proper command ID tracking
-    cmd.commandSeqID = 0;
-    cmd.finalCommand = true;
-    
-    // Copy command data (max 32 bytes)
-    size_t copyLen = (length > 32) ? 32 : length;
-    memcpy(cmd.commandData, commandData, copyLen);
+    // Longest command the device negotiated (32 bytes for older nodes)
+    size_t maxLen = ESPNowManager::getInstance().getMaxCommandLen(_mac);
+    if (length > maxLen) {
+        Serial.printf("[WARN] Command for %s truncated to %u bytes\n", _name.c_str(), (unsigned)maxLen);
+        length = maxLen;
+    }
     
     // Check if peer is online before sending
     if (!ESPNowManager::getInstance().isPeerOnline(_mac)) {
         Serial.printf("  Device %s is OFFLINE, command not sent\n", _name.c_str());
         _errorCount++;
+        EventJournal::getInstance().logCommand(_tankId, _mac, commandId, commandData, length, false);
         return false;
     }
     
-    // Send via ESPNowManager
-    bool success = ESPNowManager::getInstance().send(_mac, (uint8_t*)&cmd, sizeof(cmd), true);
+    // Send via ESPNowManager (one frame or fragments, per the device's protocol)
+    bool success = ESPNowManager::getInstance().sendCommand(_mac, _tankId, commandId, commandData, length, true);
     
     if (success) {
         _lastCommandSent = millis();
         _commandsSent++;
         _messagesSent++;
+        AnalyticsManager::getInstance().onCommand(_tankId, _type, commandData, length);
+        EventJournal::getInstance().logCommand(_tankId, _mac, commandId, commandData, length, true);
         Serial.printf(" Sent command to %s (online check passed)\n", _name.c_str());
     } else {
         _errorCount++;
+        EventJournal::getInstance().logCommand(_tankId, _mac, commandId, commandData, length, false);
         Serial.printf(" Failed to send command to %s\n", _name.c_str());
     }
     
@@ -184,7 +226,11 @@ bool Device::addSchedule(Schedule* schedule) {
         }
     }
     
+    // Resume after the last firing taken before a reboot
+    ScheduleJournal::getInstance().restore(_mac, *schedule);
+    
     _schedules.push_back(schedule);
+    Schedule::touchGeneration();
     Serial.printf(" Added schedule '%s' to device %s\n", 
                  schedule->getName().c_str(), _name.c_str());
     
@@ -197,6 +243,7 @@ bool Device::addSchedule(Schedule* schedule) {
 bool Device::removeSchedule(uint32_t scheduleId) {
     for (auto it = _schedules.begin(); it != _schedules.end(); ++it) {
         if ((*it)->getId() == scheduleId) {
+            ScheduleJournal::getInstance().forget(_mac, scheduleId);
             delete *it;
             _schedules.erase(it);
             Serial.printf("  Removed schedule %d\n", scheduleId);
@@ -255,28 +302,62 @@ void Device::enableSchedules(bool enable) {
                  enable ? "Enabled" : "Disabled", _name.c_str());
 }
 
+/**
+ * @brief Write device fields into a JSON object
+ */
+void Device::toJsonObject(JsonObject obj) const {
+    obj["mac"] = getMacString();
+    obj["type"] = getTypeName();
+    obj["name"] = _name;
+    obj["tankId"] = _tankId;
+    obj["firmwareVersion"] = _firmwareVersion;
+    obj["enabled"] = _enabled;
+    obj["status"] = getStatusString();
+    obj["health"] = _health;
+    obj["uptimeMinutes"] = _uptimeMinutes;
+    obj["lastHeartbeat"] = _lastHeartbeat;
+    obj["messagesReceived"] = _messagesReceived;
+    obj["messagesSent"] = _messagesSent;
+    obj["commandsSent"] = _commandsSent;
+    obj["errorCount"] = _errorCount;
+    obj["scheduleCount"] = _schedules.size();
+    
+    if (_hasDiagnostics) {
+        JsonObject diag = obj["diagnostics"].to<JsonObject>();
+        diag["commandsHandled"] = _diagnostics.commandsHandled;
+        diag["handlerAvgUs"] = _diagnostics.handlerAvgUs;
+        diag["handlerMaxUs"] = _diagnostics.handlerMaxUs;
+        diag["latencyAvgUs"] = _diagnostics.latencyAvgUs;
+        diag["latencyMaxUs"] = _diagnostics.latencyMaxUs;
+        diag["rxDropped"] = _diagnostics.rxDropped;
+    }
+    if (_linkRateKbps) {
+        JsonObject link = obj["link"].to<JsonObject>();
+        link["rateKbps"] = _linkRateKbps;
+        link["longRange"] = _linkRateKbps < 1000;
+        if (_linkRssi) {
+            link["rssi"] = _linkRssi;
+        }
+        link["delivery"] = _linkDelivery;
+    }
+    if (_protocol.version) {
+        JsonObject protocol = obj["protocol"].to<JsonObject>();
+        protocol["version"] = _protocol.version;
+        protocol["fragments"] = (_protocol.features & PROTO_FEAT_FRAGMENTS) != 0;
+        protocol["maxCommandData"] = _protocol.maxCommandData;
+    }
+    obj["version"] = _version;
+}
+
 /**
  * @brief Convert device to JSON
  */
 String Device::toJson() const {
-    String json = "{";
-    json += "\"mac\":\"" + getMacString() + "\",";
-    json += "\"type\":\"" + getTypeName() + "\",";
-    json += "\"name\":\"" + _name + "\",";
-    json += "\"tankId\":" + String(_tankId) + ",";
-    json += "\"firmwareVersion\":" + String(_firmwareVersion) + ",";
-    json += "\"enabled\":" + String(_enabled ? "true" : "false") + ",";
-    json += "\"status\":\"" + getStatusString() + "\",";
-    json += "\"health\":" + String(_health) + ",";
-    json += "\"uptimeMinutes\":" + String(_uptimeMinutes) + ",";
-    json += "\"lastHeartbeat\":" + String(_lastHeartbeat) + ",";
-    json += "\"messagesReceived\":" + String(_messagesReceived) + ",";
-    json += "\"messagesSent\":" + String(_messagesSent) + ",";
-    json += "\"commandsSent\":" + String(_commandsSent) + ",";
-    json += "\"errorCount\":" + String(_errorCount) + ",";
-    json += "\"scheduleCount\":" + String(_schedules.size());
-    json += "}";
+    JsonDocument doc;
+    toJsonObject(doc.to<JsonObject>());
     
+    String json;
+    serializeJson(doc, json);
     return json;
 }
 
@@ -1,6 +1,8 @@
 #include "models/Schedule.h"
 #include <time.h>
 
+uint32_t Schedule::_generation = 0;
+
 /**
  * @brief Constructor
  */
@@ -14,9 +16,12 @@ Schedule::Schedule(uint32_t id, const String& name, Type type)
     , _lastExecution(0)
     , _nextExecution(0)
     , _executionCount(0)
+    , _catchUp(CatchUp::SKIP)
+    , _catchUpWindowSec(DEFAULT_CATCH_UP_WINDOW_SEC)
     , _commandLength(0)
 {
     memset(_commandData, 0, sizeof(_commandData));
+    _generation++;
     Serial.printf(" Created schedule: %s (ID: %d, Type: %d)\n", 
                  _name.c_str(), _id, (int)_type);
 }
@@ -25,6 +30,7 @@ Schedule::Schedule(uint32_t id, const String& name, Type type)
  * @brief Destructor
  */
 Schedule::~Schedule() {
+    _generation++;
     Serial.printf("  Destroying schedule: %s (ID: %d)\n", _name.c_str(), _id);
 }
 
@@ -40,79 +46,112 @@ void Schedule::setCommandData(const uint8_t* data, size_t length) {
     // Limit to max size
     _commandLength = (length > 32) ? 32 : length;
     memcpy(_commandData, data, _commandLength);
+    _generation++;
     
     Serial.printf(" Set command data (%d bytes) for schedule %s\n", 
                  _commandLength, _name.c_str());
 }
 
 /**
- * @brief Check if schedule is due for execution
+ * @brief Firing to run now, after the catch-up policy
  */
-bool Schedule::isDue(uint32_t currentTime) const {
+uint32_t Schedule::dueFiring(uint32_t currentTime) const {
     if (!_enabled) {
-        return false;
+        return 0;
     }
     
-    // Check if already executed recently (within 1 minute to prevent duplicates)
-    if (_lastExecution > 0 && (currentTime - _lastExecution) < 60000) {
-        return false;
+    uint32_t latest = _firingAtOrBefore(currentTime);
+    if (latest == 0 || latest <= _lastExecution) {
+        return 0;  // Nothing new since the last firing taken
     }
     
-    switch (_type) {
-        case Type::ONE_TIME:
-            return currentTime >= _nextExecution && _executionCount == 0;
-            
-        case Type::DAILY:
-            return _isTimeMatching(currentTime);
-            
-        case Type::WEEKLY:
-            return _isDayMatching(currentTime) && _isTimeMatching(currentTime);
-            
-        case Type::INTERVAL:
-            if (_lastExecution == 0) {
-                return true;  // Execute immediately on first run
-            }
-            return (currentTime - _lastExecution) >= (_intervalSeconds * 1000);
-            
-        default:
-            return false;
+    bool onTime = currentTime - latest <= ON_TIME_GRACE_SEC;
+    bool hasHistory = _lastExecution > 0 || _type == Type::ONE_TIME;
+    if (!hasHistory || _catchUp == CatchUp::SKIP) {
+        return onTime ? latest : 0;
+    }
+    
+    uint32_t windowStart = currentTime > _catchUpWindowSec ? currentTime - _catchUpWindowSec : 0;
+    if (latest < windowStart && !onTime) {
+        return 0;
+    }
+    if (_catchUp == CatchUp::LATEST) {
+        return latest;
     }
+    
+    // ALL: oldest firing not yet taken inside the window, one per call
+    uint32_t after = (windowStart > 0) ? windowStart - 1 : 0;
+    if (_lastExecution > after) {
+        after = _lastExecution;
+    }
+    uint32_t oldest = _firingAfter(after);
+    return (oldest != 0 && oldest < latest) ? oldest : latest;
 }
 
 /**
- * @brief Mark schedule as executed
+ * @brief Mark a firing as taken
  */
-void Schedule::markExecuted(uint32_t currentTime) {
-    _lastExecution = currentTime;
+void Schedule::markExecuted(uint32_t firing) {
+    _lastExecution = firing;
     _executionCount++;
     
     // Calculate next execution time
-    _nextExecution = calculateNextExecution(currentTime);
+    if (_type != Type::ONE_TIME) {
+        _nextExecution = calculateNextExecution(firing);
+    }
     
     Serial.printf(" Executed schedule '%s' (count: %d)\n", 
                  _name.c_str(), _executionCount);
 }
 
+/**
+ * @brief Restore execution state persisted before a reboot
+ */
+void Schedule::restoreExecution(uint32_t lastFiring, uint32_t count) {
+    if (lastFiring <= _lastExecution) {
+        return;
+    }
+    
+    _lastExecution = lastFiring;
+    _executionCount = count;
+    if (_type != Type::ONE_TIME) {
+        _nextExecution = calculateNextExecution(lastFiring);
+    }
+}
+
 /**
  * @brief Calculate next execution time
  */
 uint32_t Schedule::calculateNextExecution(uint32_t currentTime) const {
-    switch (_type) {
-        case Type::ONE_TIME:
-            return 0;  // One-time schedules don't repeat
-            
-        case Type::INTERVAL:
-            return currentTime + (_intervalSeconds * 1000);
-            
-        case Type::DAILY:
-        case Type::WEEKLY:
-            // For time-based schedules, next execution is calculated at check time
-            // This is a simplified implementation
-            return currentTime + (24 * 3600 * 1000);  // Next day
-            
-        default:
-            return 0;
+    return _firingAfter(currentTime);
+}
+
+/**
+ * @brief Append weekly firing minutes (DAILY/WEEKLY only)
+ */
+size_t Schedule::appendWeekMinutes(std::vector<uint16_t>& out) const {
+    if (_type != Type::DAILY && _type != Type::WEEKLY) {
+        return 0;
     }
+    
+    // Matches isDue(): DAILY ignores the days mask
+    uint8_t days = (_type == Type::DAILY) ? ALL_DAYS : _daysMask;
+    size_t added = 0;
+    
+    for (uint8_t day = 0; day < 7; day++) {
+        if (!(days & (1 << day))) {
+            continue;
+        }
+        for (const TimeSpec& time : _times) {
+            if (time.hour > 23 || time.minute > 59) {
+                continue;
+            }
+            out.push_back(day * 1440 + time.hour * 60 + time.minute);
+            added++;
+        }
+    }
+    
+    return added;
 }
 
 /**
@@ -173,6 +212,8 @@ String Schedule::toJson() const {
     json += "\"lastExecution\":" + String(_lastExecution) + ",";
     json += "\"nextExecution\":" + String(_nextExecution) + ",";
     json += "\"executionCount\":" + String(_executionCount) + ",";
+    json += "\"catchUp\":" + String((int)_catchUp) + ",";
+    json += "\"catchUpWindow\":" + String(_catchUpWindowSec) + ",";
     json += "\"commandLength\":" + String(_commandLength);
     
     // Add times array
@@ -200,41 +241,111 @@ bool Schedule::fromJson(const String& json) {
 }
 
 /**
- * @brief Check if current day matches daysMask
+ * @brief Latest scheduled firing at or before a time
  */
-bool Schedule::_isDayMatching(uint32_t currentTime) const {
-    // Convert millis to day of week (0=Sunday, 6=Saturday)
-    // This is a simplified implementation
-    // In production, use proper time library or RTC
-    
-    time_t now = currentTime / 1000;
-    struct tm* timeinfo = localtime(&now);
-    uint8_t dayOfWeek = timeinfo->tm_wday;
-    
-    uint8_t dayBit = (1 << dayOfWeek);
-    return (_daysMask & dayBit) != 0;
+uint32_t Schedule::_firingAtOrBefore(uint32_t time) const {
+    switch (_type) {
+        case Type::ONE_TIME:
+            return (_nextExecution > 0 && _nextExecution <= time) ? _nextExecution : 0;
+            
+        case Type::INTERVAL:
+            if (_intervalSeconds == 0) {
+                return 0;
+            }
+            if (_lastExecution == 0) {
+                return time;  // Execute immediately on first run
+            }
+            if (time < _lastExecution) {
+                return _lastExecution;
+            }
+            // Keep the phase of the first run
+            return _lastExecution + ((time - _lastExecution) / _intervalSeconds) * _intervalSeconds;
+            
+        case Type::DAILY:
+        case Type::WEEKLY: {
+            time_t now = time;
+            struct tm local;
+            localtime_r(&now, &local);
+            uint32_t midnight = time - (local.tm_hour * 3600u + local.tm_min * 60u + local.tm_sec);
+            
+            // Today first, then back one day at a time
+            for (uint8_t back = 0; back <= 7; back++) {
+                if (!_isDayEnabled((local.tm_wday + 7 - back) % 7)) {
+                    continue;
+                }
+                uint32_t dayStart = midnight - back * 86400u;
+                uint32_t best = 0;
+                for (const TimeSpec& spec : _times) {
+                    uint32_t firing = dayStart + spec.hour * 3600u + spec.minute * 60u;
+                    if (spec.hour <= 23 && spec.minute <= 59 && firing <= time && firing > best) {
+                        best = firing;
+                    }
+                }
+                if (best > 0) {
+                    return best;
+                }
+            }
+            return 0;
+        }
+            
+        default:
+            return 0;
+    }
 }
 
 /**
- * @brief Check if current time matches any TimeSpec
+ * @brief First scheduled firing strictly after a time
  */
-bool Schedule::_isTimeMatching(uint32_t currentTime) const {
-    if (_times.empty()) {
-        return false;
-    }
-    
-    // Convert millis to hour and minute
-    time_t now = currentTime / 1000;
-    struct tm* timeinfo = localtime(&now);
-    uint8_t currentHour = timeinfo->tm_hour;
-    uint8_t currentMinute = timeinfo->tm_min;
-    
-    // Check if current time matches any scheduled time
-    for (const TimeSpec& time : _times) {
-        if (time.hour == currentHour && time.minute == currentMinute) {
-            return true;
+uint32_t Schedule::_firingAfter(uint32_t time) const {
+    switch (_type) {
+        case Type::ONE_TIME:
+            return (_nextExecution > time && _nextExecution > _lastExecution) ? _nextExecution : 0;
+            
+        case Type::INTERVAL:
+            if (_intervalSeconds == 0 || _lastExecution == 0) {
+                return 0;  // Not anchored until the first run
+            }
+            if (time < _lastExecution) {
+                return _lastExecution;
+            }
+            return _lastExecution + ((time - _lastExecution) / _intervalSeconds + 1) * _intervalSeconds;
+            
+        case Type::DAILY:
+        case Type::WEEKLY: {
+            time_t now = time;
+            struct tm local;
+            localtime_r(&now, &local);
+            uint32_t midnight = time - (local.tm_hour * 3600u + local.tm_min * 60u + local.tm_sec);
+            
+            for (uint8_t ahead = 0; ahead <= 7; ahead++) {
+                if (!_isDayEnabled((local.tm_wday + ahead) % 7)) {
+                    continue;
+                }
+                uint32_t dayStart = midnight + ahead * 86400u;
+                uint32_t best = 0;
+                for (const TimeSpec& spec : _times) {
+                    uint32_t firing = dayStart + spec.hour * 3600u + spec.minute * 60u;
+                    if (spec.hour <= 23 && spec.minute <= 59 && firing > time &&
+                        (best == 0 || firing < best)) {
+                        best = firing;
+                    }
+                }
+                if (best > 0) {
+                    return best;
+                }
+            }
+            return 0;
         }
+            
+        default:
+            return 0;
     }
-    
-    return false;
+}
+
+/**
+ * @brief Check if a day of week is enabled
+ */
+bool Schedule::_isDayEnabled(uint8_t weekday) const {
+    // DAILY ignores the days mask
+    return _type == Type::DAILY || (_daysMask & (1 << weekday)) != 0;
 }
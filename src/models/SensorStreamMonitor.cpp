@@ -0,0 +1,211 @@
+#include "models/SensorStreamMonitor.h"
+#include <math.h>
+
+// ============================================================================
+// DEFAULT TUNING
+// ============================================================================
+// Readings arrive every 5-30 s. Flatline runs are long enough that a healthy
+// but quiet probe (ADC jitter of a count or two) never trips them.
+
+SensorStreamMonitor::Config SensorStreamMonitor::temperatureConfig() {
+    Config config;
+    config.alpha = 0.1f;
+    config.alphaSlow = 0.01f;
+    config.minSigma = 0.05f;        // DS18B20 resolution is 0.0625 C
+    config.spikeSigma = 6.0f;
+    config.maxRatePerMin = 0.5f;    // A heater cannot move a tank faster
+    config.flatEpsilon = 0.0f;
+    config.flatSamples = 240;       // Temperature can legitimately sit still
+    config.cusumK = 0.5f;
+    config.cusumH = 10.0f;
+    config.warmupSamples = 20;
+    config.persistSamples = 4;
+    return config;
+}
+
+SensorStreamMonitor::Config SensorStreamMonitor::phConfig() {
+    Config config;
+    config.alpha = 0.1f;
+    config.alphaSlow = 0.01f;
+    config.minSigma = 0.01f;
+    config.spikeSigma = 6.0f;
+    config.maxRatePerMin = 0.2f;    // CO2 injection moves pH slowly
+    config.flatEpsilon = 0.0f;      // A live electrode always jitters
+    config.flatSamples = 60;
+    config.cusumK = 0.5f;
+    config.cusumH = 10.0f;
+    config.warmupSamples = 20;
+    config.persistSamples = 4;
+    return config;
+}
+
+SensorStreamMonitor::Config SensorStreamMonitor::tdsConfig() {
+    Config config;
+    config.alpha = 0.1f;
+    config.alphaSlow = 0.01f;
+    config.minSigma = 2.0f;
+    config.spikeSigma = 6.0f;
+    config.maxRatePerMin = 50.0f;   // Water change / dosing
+    config.flatEpsilon = 0.0f;
+    config.flatSamples = 60;
+    config.cusumK = 0.5f;
+    config.cusumH = 10.0f;
+    config.warmupSamples = 20;
+    config.persistSamples = 4;
+    return config;
+}
+
+// ============================================================================
+// DETECTOR
+// ============================================================================
+
+SensorStreamMonitor::SensorStreamMonitor(const Config& config)
+    : _config(config) {
+    reset();
+}
+
+void SensorStreamMonitor::reset() {
+    _count = 0;
+    _mean = 0.0f;
+    _variance = 0.0f;
+    _baseline = 0.0f;
+    _baselineVar = 0.0f;
+    _cusumHigh = 0.0f;
+    _cusumLow = 0.0f;
+    _lastValue = 0.0f;
+    _lastTime = 0;
+    _flatRun = 0;
+    _outlierRun = 0;
+    _flags = 0;
+}
+
+float SensorStreamMonitor::getSigma() const {
+    float sigma = sqrtf(_variance);
+    return sigma > _config.minSigma ? sigma : _config.minSigma;
+}
+
+uint8_t SensorStreamMonitor::addSample(float value, uint32_t timestampMs) {
+    if (_count == 0) {
+        _mean = value;
+        _baseline = value;
+        _baselineVar = 0.0f;
+        _lastValue = value;
+        _lastTime = timestampMs;
+        _flatRun = 1;
+        _count = 1;
+        _flags = 0;
+        return _flags;
+    }
+
+    uint8_t flags = 0;
+    float delta = value - _lastValue;
+    float sigma = getSigma();
+    bool warm = _count >= _config.warmupSamples;
+
+    // Rate of change since the previous reading, with room for noise
+    uint32_t elapsedMs = timestampMs - _lastTime;
+    float allowed = _config.maxRatePerMin * elapsedMs / 60000.0f + 3.0f * sigma;
+    if (warm && fabsf(delta) > allowed) {
+        flags |= FLAG_RATE;
+    }
+
+    // Stuck probe: identical (within epsilon) readings in a row
+    _flatRun = fabsf(delta) <= _config.flatEpsilon ?
+               (_flatRun < 0xFFFF ? _flatRun + 1 : _flatRun) : 1;
+    if (_flatRun >= _config.flatSamples) {
+        flags |= FLAG_FLATLINE;
+    }
+
+    // Spike against the fast EWMA spread
+    float residual = value - _mean;
+    if (warm && fabsf(residual) > _config.spikeSigma * sigma) {
+        flags |= FLAG_SPIKE;
+    }
+
+    bool outlier = (flags & (FLAG_SPIKE | FLAG_RATE)) != 0;
+    if (outlier) {
+        // A persistent same-signed outlier is a real step, not a glitch
+        int8_t sign = residual >= 0 ? 1 : -1;
+        _outlierRun = (_outlierRun * sign > 0) ? _outlierRun + sign : sign;
+        if (_outlierRun * sign >= _config.persistSamples) {
+            // Re-seed and warm up again around the new level
+            _mean = value;
+            _baseline = value;
+            _baselineVar = 0.0f;
+            _variance = 0.0f;
+            _cusumHigh = 0.0f;
+            _cusumLow = 0.0f;
+            _outlierRun = 0;
+            _count = 1;
+            warm = false;
+            flags &= ~(FLAG_SPIKE | FLAG_RATE);
+            outlier = false;
+        }
+    } else {
+        _outlierRun = 0;
+    }
+
+    if (!outlier) {
+        // EWMA mean/variance (West's incremental form)
+        float diff = value - _mean;
+        float increment = _config.alpha * diff;
+        _mean += increment;
+        _variance = (1.0f - _config.alpha) * (_variance + diff * increment);
+
+        float baseDiff = value - _baseline;
+        if (!warm) {
+            // Baseline starts as the plain mean/variance of the warm-up readings
+            float n = (float)(_count + 1);
+            _baseline += baseDiff / n;
+            _baselineVar += (baseDiff * (value - _baseline) - _baselineVar) / n;
+        } else {
+            // CUSUM in (slow) sigmas against the slow baseline; capped so recovery is quick
+            float baseSigma = sqrtf(_baselineVar);
+            float z = baseDiff / (baseSigma > _config.minSigma ? baseSigma : _config.minSigma);
+            float cap = 2.0f * _config.cusumH;
+            _cusumHigh = fminf(cap, fmaxf(0.0f, _cusumHigh + z - _config.cusumK));
+            _cusumLow = fminf(cap, fmaxf(0.0f, _cusumLow - z - _config.cusumK));
+            
+            float increment = _config.alphaSlow * baseDiff;
+            _baseline += increment;
+            _baselineVar = (1.0f - _config.alphaSlow) * (_baselineVar + baseDiff * increment);
+        }
+    }
+
+    if (warm && _cusumHigh > _config.cusumH) {
+        flags |= FLAG_DRIFT_UP;
+    }
+    if (warm && _cusumLow > _config.cusumH) {
+        flags |= FLAG_DRIFT_DOWN;
+    }
+
+    _lastValue = value;
+    _lastTime = timestampMs;
+    if (_count < 0xFFFFFFFF) {
+        _count++;
+    }
+    _flags = flags;
+    return flags;
+}
+
+// ============================================================================
+// SERIALIZATION
+// ============================================================================
+
+void SensorStreamMonitor::flagsToJson(uint8_t flags, JsonArray out) {
+    if (flags & FLAG_SPIKE) out.add("spike");
+    if (flags & FLAG_RATE) out.add("rate");
+    if (flags & FLAG_FLATLINE) out.add("flatline");
+    if (flags & FLAG_DRIFT_UP) out.add("driftUp");
+    if (flags & FLAG_DRIFT_DOWN) out.add("driftDown");
+}
+
+void SensorStreamMonitor::toJsonObject(JsonObject obj) const {
+    obj["suspect"] = isSuspect();
+    flagsToJson(_flags, obj["flags"].to<JsonArray>());
+    obj["mean"] = _mean;
+    obj["sigma"] = getSigma();
+    obj["baseline"] = _baseline;
+    obj["samples"] = _count;
+    obj["lastSample"] = _lastTime;
+}
@@ -0,0 +1,209 @@
+#include "models/TemperatureFusion.h"
+#include <math.h>
+
+// ============================================================================
+// DEFAULT TUNING
+// ============================================================================
+// processNoise lets a healthy estimate (variance ~0.005) decay to 0.5
+// confidence in about five minutes without readings, matching the stale
+// limit used for the other streams.
+
+TemperatureFusion::Config TemperatureFusion::defaultConfig() {
+    Config config;
+    config.processNoise = 0.0002f;
+    config.probeNoise = 0.01f;         // 0.1 C
+    config.heaterNoise = 0.09f;        // 0.3 C, probe sits near the element
+    config.minNoise = 0.004f;          // DS18B20 resolution is 0.0625 C
+    config.maxNoise = 4.0f;            // 2 C
+    config.noiseAlpha = 0.05f;
+    config.gateSigma = 4.0f;
+    config.usefulVariance = 0.0625f;   // 0.25 C
+    config.freshMs = 120000;
+    config.persistSamples = 4;
+    return config;
+}
+
+// ============================================================================
+// FILTER
+// ============================================================================
+
+TemperatureFusion::TemperatureFusion()
+    : _config(defaultConfig()) {
+    reset();
+}
+
+TemperatureFusion::TemperatureFusion(const Config& config)
+    : _config(config) {
+    reset();
+}
+
+void TemperatureFusion::reset() {
+    _hasEstimate = false;
+    _estimate = 0.0f;
+    _variance = 0.0f;
+    _lastUpdate = 0;
+    _lastSource = -1;
+    memset(_sources, 0, sizeof(_sources));
+}
+
+float TemperatureFusion::getVariance(uint32_t nowMs) const {
+    if (!_hasEstimate) {
+        return _config.maxNoise;
+    }
+    int32_t ageMs = (int32_t)(nowMs - _lastUpdate);
+    return _variance + (ageMs > 0 ? _config.processNoise * ageMs / 1000.0f : 0.0f);
+}
+
+float TemperatureFusion::getConfidence(uint32_t nowMs) const {
+    if (!_hasEstimate) {
+        return 0.0f;
+    }
+    return _config.usefulVariance / (_config.usefulVariance + getVariance(nowMs));
+}
+
+TemperatureFusion::Result TemperatureFusion::addSample(const uint8_t* mac, SourceKind kind,
+                                                       float value, uint32_t timestampMs) {
+    Source* source = _findSource(mac, kind);
+    if (!source) {
+        return Result::NO_SLOT;
+    }
+
+    if (!_hasEstimate) {
+        _seed(source, value, timestampMs);
+        return Result::RESEEDED;
+    }
+
+    // Predict; readings older than the estimate (batched samples) add no drift
+    float prior = getVariance(timestampMs);
+    float innovationVar = prior + source->noise;
+    float innovation = value - _estimate;
+
+    source->lastValue = value;
+    source->lastTime = timestampMs;
+
+    if (innovation * innovation > _config.gateSigma * _config.gateSigma * innovationVar) {
+        source->rejected++;
+        source->rejectRun++;
+        if (source->rejectRun < _config.persistSamples) {
+            return Result::REJECTED;
+        }
+
+        source->rejectRun = 0;
+        if (!_otherSourceLive(source, timestampMs)) {
+            // Nobody contradicts it: the tank really moved
+            _seed(source, value, timestampMs);
+            return Result::RESEEDED;
+        }
+
+        // Others agree with the estimate: trust this probe less from now on
+        source->noise = fminf(_config.maxNoise, source->noise * 4.0f);
+        return Result::REJECTED;
+    }
+
+    float gain = prior / innovationVar;
+    _estimate += gain * innovation;
+    _variance = (1.0f - gain) * prior;
+
+    // Noise estimate from the post-fit residual (Mehra-style)
+    float residual = value - _estimate;
+    float observed = residual * residual + _variance;
+    source->noise += _config.noiseAlpha * (observed - source->noise);
+    source->noise = fminf(_config.maxNoise, fmaxf(_config.minNoise, source->noise));
+
+    source->accepted++;
+    source->rejectRun = 0;
+    if ((int32_t)(timestampMs - _lastUpdate) > 0) {
+        _lastUpdate = timestampMs;
+    }
+    _lastSource = (int8_t)(source - _sources);
+    return Result::ACCEPTED;
+}
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+TemperatureFusion::Source* TemperatureFusion::_findSource(const uint8_t* mac, SourceKind kind) {
+    static const uint8_t anonymous[6] = {0};
+    if (!mac) {
+        mac = anonymous;
+    }
+
+    Source* freeSlot = nullptr;
+    for (uint8_t i = 0; i < MAX_SOURCES; i++) {
+        Source& source = _sources[i];
+        if (source.used && source.kind == kind && memcmp(source.mac, mac, 6) == 0) {
+            return &source;
+        }
+        if (!source.used && !freeSlot) {
+            freeSlot = &source;
+        }
+    }
+
+    if (!freeSlot) {
+        return nullptr;
+    }
+    freeSlot->used = true;
+    memcpy(freeSlot->mac, mac, 6);
+    freeSlot->kind = kind;
+    freeSlot->noise = (kind == SourceKind::HEATER) ? _config.heaterNoise : _config.probeNoise;
+    return freeSlot;
+}
+
+bool TemperatureFusion::_otherSourceLive(const Source* source, uint32_t nowMs) const {
+    for (uint8_t i = 0; i < MAX_SOURCES; i++) {
+        const Source& other = _sources[i];
+        if (&other != source && other.used && other.accepted > 0 &&
+            (int32_t)(nowMs - other.lastTime) <= (int32_t)_config.freshMs) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TemperatureFusion::_seed(Source* source, float value, uint32_t timestampMs) {
+    _hasEstimate = true;
+    _estimate = value;
+    _variance = source->noise;
+    _lastUpdate = timestampMs;
+    _lastSource = (int8_t)(source - _sources);
+
+    source->lastValue = value;
+    source->lastTime = timestampMs;
+    source->accepted++;
+    source->rejectRun = 0;
+}
+
+// ============================================================================
+// SERIALIZATION
+// ============================================================================
+
+void TemperatureFusion::toJsonObject(JsonObject obj, uint32_t nowMs) const {
+    obj["estimate"] = _estimate;
+    obj["sigma"] = sqrtf(getVariance(nowMs));
+    obj["confidence"] = getConfidence(nowMs);
+    obj["lastUpdate"] = _lastUpdate;
+
+    JsonArray sources = obj["sources"].to<JsonArray>();
+    for (uint8_t i = 0; i < MAX_SOURCES; i++) {
+        const Source& source = _sources[i];
+        if (!source.used) {
+            continue;
+        }
+
+        char macStr[18];
+        snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+                 source.mac[0], source.mac[1], source.mac[2],
+                 source.mac[3], source.mac[4], source.mac[5]);
+
+        JsonObject entry = sources.add<JsonObject>();
+        entry["mac"] = macStr;
+        entry["kind"] = source.kind == SourceKind::HEATER ? "heater" : "probe";
+        entry["value"] = source.lastValue;
+        entry["sigma"] = sqrtf(source.noise);
+        entry["accepted"] = source.accepted;
+        entry["rejected"] = source.rejected;
+        entry["lastSample"] = source.lastTime;
+        entry["latest"] = (i == _lastSource);
+    }
+}
@@ -0,0 +1,79 @@
+#include "models/devices/CO2Device.h"
+
+// ============================================================================
+// CONTROL
+// ============================================================================
+// Payloads are encoded with CO2Protocol (protocol/commands.h).
+
+/**
+ * @brief Start injection (0 = until stopped)
+ */
+bool CO2Device::startInjection(uint32_t durationSeconds) {
+    if (durationSeconds > 0) {
+        return timedInjection(durationSeconds);
+    }
+
+    uint8_t commandData[CO2Protocol::Start::SIZE];
+    size_t length = CO2Protocol::Start::encode(commandData);
+
+    if (!sendCommand(commandData, length)) {
+        return false;
+    }
+
+    _state = InjectionState::ON;
+    _injectionStartTime = millis();
+    _injectionDuration = 0;
+    _injectionCount++;
+    return true;
+}
+
+/**
+ * @brief Stop injection
+ */
+bool CO2Device::stopInjection() {
+    uint8_t commandData[CO2Protocol::Stop::SIZE];
+    size_t length = CO2Protocol::Stop::encode(commandData);
+
+    if (!sendCommand(commandData, length)) {
+        return false;
+    }
+
+    _state = InjectionState::OFF;
+    return true;
+}
+
+/**
+ * @brief Timed injection, capped at the safety limit
+ */
+bool CO2Device::timedInjection(uint32_t durationSeconds) {
+    if (durationSeconds == 0 || durationSeconds > _maxInjectionDuration ||
+        durationSeconds > CO2Safety::MAX_INJECTION_DURATION_SEC) {
+        Serial.printf("[ERR] CO2 duration %lus outside safe range\n", (unsigned long)durationSeconds);
+        return false;
+    }
+
+    uint8_t commandData[CO2Protocol::Timed::SIZE];
+    size_t length = CO2Protocol::Timed::encode(commandData, (uint16_t)durationSeconds);
+
+    if (!sendCommand(commandData, length)) {
+        return false;
+    }
+
+    _state = InjectionState::TIMED;
+    _injectionStartTime = millis();
+    _injectionDuration = durationSeconds;
+    _injectionCount++;
+    return true;
+}
+
+/**
+ * @brief Emergency stop
+ */
+bool CO2Device::emergencyStop() {
+    uint8_t commandData[CO2Protocol::EmergencyStop::SIZE];
+    size_t length = CO2Protocol::EmergencyStop::encode(commandData);
+
+    // Assume closed even if the send fails; the node fails safe on its own
+    _state = InjectionState::OFF;
+    return sendCommand(commandData, length);
+}
@@ -0,0 +1,42 @@
+#include "models/devices/FeederDevice.h"
+
+// ============================================================================
+// CONTROL
+// ============================================================================
+// Payloads are encoded with FeederProtocol (protocol/commands.h).
+
+/**
+ * @brief Dispense portions
+ */
+bool FeederDevice::feed(uint8_t portions) {
+    if (portions < FeederSafety::MIN_PORTIONS || portions > _maxPortionsPerFeed ||
+        portions > FeederSafety::MAX_PORTIONS_PER_FEED) {
+        Serial.printf("[ERR] Feeder portions %d outside safe range\n", portions);
+        return false;
+    }
+
+    uint8_t commandData[FeederProtocol::Feed::SIZE];
+    size_t length = FeederProtocol::Feed::encode(commandData, portions);
+
+    return sendCommand(commandData, length);
+}
+
+/**
+ * @brief Run the mechanism once
+ */
+bool FeederDevice::testFeed() {
+    uint8_t commandData[FeederProtocol::Test::SIZE];
+    size_t length = FeederProtocol::Test::encode(commandData);
+
+    return sendCommand(commandData, length);
+}
+
+/**
+ * @brief Cancel an ongoing feed
+ */
+bool FeederDevice::cancelFeed() {
+    uint8_t commandData[FeederProtocol::Cancel::SIZE];
+    size_t length = FeederProtocol::Cancel::encode(commandData);
+
+    return sendCommand(commandData, length);
+}
@@ -0,0 +1,120 @@
+#include "models/devices/HeaterDevice.h"
+
+// ============================================================================
+// CONTROL
+// ============================================================================
+// Payloads are encoded with HeaterProtocol (protocol/commands.h).
+// Temperatures travel as centi-degrees so the node needs no float parsing.
+
+static int16_t toCenti(float celsius) {
+    return (int16_t)(celsius * 100.0f + (celsius >= 0 ? 0.5f : -0.5f));
+}
+
+/**
+ * @brief Set heater mode
+ */
+bool HeaterDevice::setMode(Mode mode) {
+    if (mode == Mode::ERROR) {
+        return false;
+    }
+
+    uint8_t commandData[HeaterProtocol::SetMode::SIZE];
+    size_t length = HeaterProtocol::SetMode::encode(commandData, (uint8_t)mode);
+
+    if (!sendCommand(commandData, length)) {
+        return false;
+    }
+
+    _mode = mode;
+    return true;
+}
+
+/**
+ * @brief Set auto-mode target temperature
+ */
+bool HeaterDevice::setTargetTemperature(float temperature) {
+    if (temperature < HeaterSafety::MIN_SAFE_TEMPERATURE || temperature > _maxSafeTemperature) {
+        Serial.printf("[ERR] Heater target %.2fC outside safe range\n", temperature);
+        return false;
+    }
+
+    uint8_t commandData[HeaterProtocol::SetTarget::SIZE];
+    size_t length = HeaterProtocol::SetTarget::encode(commandData, toCenti(temperature));
+
+    if (!sendCommand(commandData, length)) {
+        return false;
+    }
+
+    _targetTemperature = temperature;
+    return true;
+}
+
+/**
+ * @brief Set auto-mode hysteresis
+ */
+bool HeaterDevice::setHysteresis(float hysteresis) {
+    if (hysteresis <= 0.0f || hysteresis > 2.0f) {
+        return false;
+    }
+
+    uint8_t commandData[HeaterProtocol::SetHysteresis::SIZE];
+    size_t length = HeaterProtocol::SetHysteresis::encode(commandData, (uint16_t)toCenti(hysteresis));
+
+    if (!sendCommand(commandData, length)) {
+        return false;
+    }
+
+    _hysteresis = hysteresis;
+    return true;
+}
+
+/**
+ * @brief Manual on (override)
+ */
+bool HeaterDevice::manualOn() {
+    uint8_t commandData[HeaterProtocol::ManualOn::SIZE];
+    size_t length = HeaterProtocol::ManualOn::encode(commandData);
+
+    if (!sendCommand(commandData, length)) {
+        return false;
+    }
+
+    _mode = Mode::ON;
+    return true;
+}
+
+/**
+ * @brief Manual off
+ */
+bool HeaterDevice::manualOff() {
+    uint8_t commandData[HeaterProtocol::ManualOff::SIZE];
+    size_t length = HeaterProtocol::ManualOff::encode(commandData);
+
+    if (!sendCommand(commandData, length)) {
+        return false;
+    }
+
+    _mode = Mode::OFF;
+    return true;
+}
+
+/**
+ * @brief Enable auto mode with a target
+ */
+bool HeaterDevice::enableAuto(float targetTemp) {
+    if (targetTemp < HeaterSafety::MIN_SAFE_TEMPERATURE || targetTemp > _maxSafeTemperature) {
+        Serial.printf("[ERR] Heater target %.2fC outside safe range\n", targetTemp);
+        return false;
+    }
+
+    uint8_t commandData[HeaterProtocol::EnableAuto::SIZE];
+    size_t length = HeaterProtocol::EnableAuto::encode(commandData, toCenti(targetTemp));
+
+    if (!sendCommand(commandData, length)) {
+        return false;
+    }
+
+    _mode = Mode::AUTO;
+    _targetTemperature = targetTemp;
+    return true;
+}
@@ -0,0 +1,110 @@
+#include "models/devices/LightDevice.h"
+
+// ============================================================================
+// CONTROL
+// ============================================================================
+// Payloads are encoded with LightProtocol (protocol/commands.h), the same
+// schema the lighting node decodes. The node has no fade support yet, so
+// transition times are not sent.
+
+/**
+ * @brief Set all three channels
+ */
+bool LightDevice::setLevels(uint8_t white, uint8_t blue, uint8_t red, uint16_t transition) {
+    uint8_t commandData[LightProtocol::AllOn::SIZE];
+    size_t length = LightProtocol::AllOn::encode(commandData, white, blue, red);
+
+    if (!sendCommand(commandData, length)) {
+        return false;
+    }
+
+    _targetState.white = white;
+    _targetState.blue = blue;
+    _targetState.red = red;
+    _targetState.isOn = true;
+    _transitionTimeMs = transition;
+    return true;
+}
+
+/**
+ * @brief Set a single channel (level 0 turns it off)
+ */
+bool LightDevice::setChannel(Channel channel, uint8_t level, uint16_t transition) {
+    uint8_t commandData[2];
+    size_t length = 0;
+
+    switch (channel) {
+        case Channel::WHITE:
+            length = level ? LightProtocol::WhiteOn::encode(commandData, level)
+                           : LightProtocol::WhiteOff::encode(commandData);
+            break;
+        case Channel::BLUE:
+            length = level ? LightProtocol::BlueOn::encode(commandData, level)
+                           : LightProtocol::BlueOff::encode(commandData);
+            break;
+        case Channel::RED:
+            length = level ? LightProtocol::RedOn::encode(commandData, level)
+                           : LightProtocol::RedOff::encode(commandData);
+            break;
+    }
+
+    if (length == 0 || !sendCommand(commandData, length)) {
+        return false;
+    }
+
+    switch (channel) {
+        case Channel::WHITE: _targetState.white = level; break;
+        case Channel::BLUE:  _targetState.blue = level;  break;
+        case Channel::RED:   _targetState.red = level;   break;
+    }
+    _transitionTimeMs = transition;
+    return true;
+}
+
+/**
+ * @brief Turn all channels on (at the target levels) or off
+ */
+bool LightDevice::setOnOff(bool on, uint16_t transition) {
+    if (on) {
+        LightState levels = _targetState;
+        if (levels.white == 0 && levels.blue == 0 && levels.red == 0) {
+            levels.white = levels.blue = levels.red = 255;
+        }
+        return setLevels(levels.white, levels.blue, levels.red, transition);
+    }
+
+    uint8_t commandData[LightProtocol::AllOff::SIZE];
+    size_t length = LightProtocol::AllOff::encode(commandData);
+
+    if (!sendCommand(commandData, length)) {
+        return false;
+    }
+
+    _targetState.isOn = false;
+    _transitionTimeMs = transition;
+    return true;
+}
+
+// ============================================================================
+// EFFECTS
+// ============================================================================
+
+/**
+ * @brief Start a node-side lighting effect
+ */
+bool LightDevice::startEffect(const LightEffects::EffectParams& params) {
+    uint8_t commandData[LightProtocol::EffectStart::SIZE];
+    size_t length = LightProtocol::EffectStart::encode(commandData, params);
+
+    return sendCommand(commandData, length);
+}
+
+/**
+ * @brief Stop a node-side lighting effect
+ */
+bool LightDevice::stopEffect(LightEffects::EffectType type) {
+    uint8_t commandData[LightProtocol::EffectStop::SIZE];
+    size_t length = LightProtocol::EffectStop::encode(commandData, (uint8_t)type);
+
+    return sendCommand(commandData, length);
+}
@@ -0,0 +1,100 @@
+#include "models/devices/SensorDevice.h"
+
+// ============================================================================
+// CONTROL
+// ============================================================================
+// Payloads are encoded with SensorProtocol (protocol/commands.h).
+
+/**
+ * @brief Request an immediate reading
+ */
+bool SensorDevice::requestReading() {
+    uint8_t commandData[SensorProtocol::RequestReading::SIZE];
+    size_t length = SensorProtocol::RequestReading::encode(commandData);
+
+    return sendCommand(commandData, length);
+}
+
+/**
+ * @brief Set the reading interval
+ */
+bool SensorDevice::setReadingInterval(uint32_t seconds) {
+    if (seconds == 0 || seconds > 0xFFFF) {
+        return false;
+    }
+
+    uint8_t commandData[SensorProtocol::SetInterval::SIZE];
+    size_t length = SensorProtocol::SetInterval::encode(commandData, (uint16_t)seconds);
+
+    if (!sendCommand(commandData, length)) {
+        return false;
+    }
+
+    _readingInterval = seconds;
+    return true;
+}
+
+/**
+ * @brief Push compiled calibration tables
+ */
+bool SensorDevice::setCalibration(const Calibration& calibration) {
+    const SensorCalibration::Table* tables[] = { &calibration.ph, &calibration.tds };
+    bool sent = false;
+
+    for (const SensorCalibration::Table* table : tables) {
+        if (!SensorCalibration::isValid(*table)) {
+            continue;
+        }
+
+        uint8_t commandData[MAX_COMMAND_DATA_LEN];
+        size_t length = SensorCalibration::encode(commandData, *table);
+        if (!sendCommand(commandData, length)) {
+            return false;
+        }
+        sent = true;
+    }
+
+    if (sent) {
+        _calibration = calibration;
+    }
+    return sent;
+}
+
+/**
+ * @brief Reset node calibration to defaults
+ */
+bool SensorDevice::resetCalibration() {
+    uint8_t commandData[SensorProtocol::ResetCalibration::SIZE];
+    size_t length = SensorProtocol::ResetCalibration::encode(commandData);
+
+    if (!sendCommand(commandData, length)) {
+        return false;
+    }
+
+    _calibration = Calibration();
+    return true;
+}
+
+/**
+ * @brief Trim the pH table against a reference solution
+ */
+bool SensorDevice::calibratePh(float knownPh) {
+    if (knownPh < 0.0f || knownPh > 14.0f) {
+        return false;
+    }
+
+    uint8_t commandData[SensorProtocol::CalibratePh::SIZE];
+    size_t length = SensorProtocol::CalibratePh::encode(commandData, (uint16_t)(knownPh * 100.0f + 0.5f));
+
+    return sendCommand(commandData, length);
+}
+
+/**
+ * @brief Trim the TDS table against a reference solution
+ */
+bool SensorDevice::calibrateTds(uint16_t knownTds) {
+    uint8_t commandData[SensorProtocol::CalibrateTds::SIZE];
+    size_t length = SensorProtocol::CalibrateTds::encode(commandData, knownTds);
+
+    return sendCommand(commandData, length);
+}
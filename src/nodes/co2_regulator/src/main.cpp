@@ -1,4 +1,5 @@
 #include "node_base.h"
+#include "protocol/commands.h"
 
 // ============================================================================
 // CO2 REGULATOR NODE - Controls CO2 injection
@@ -51,29 +52,46 @@ void enterFailSafeMode() {
 }
 
 void handleCommand(const CommandMessage* msg) {
-    Serial.printf("  Command ID: %d\n", msg->commandId);
+    const uint8_t* data = msg->commandData;
+    size_t len = msg->commandLen;
+    Serial.printf("  Command ID: %d, opcode: %d\n", msg->commandId, len ? data[0] : 0);
     
-    switch (msg->commandId) {
-        case 1: // Open solenoid for duration
-            {
-                uint16_t durationSec = (msg->commandData[0] << 8) | msg->commandData[1];
-                if (durationSec > 0 && durationSec <= 3600) {  // Max 1 hour
-                    co2State.solenoidOpen = true;
-                    co2State.onDurationMs = durationSec * 1000;
-                    co2State.onStartTime = millis();
-                    Serial.printf("  CO2 ON for %d seconds\n", durationSec);
-                }
+    if (len == 0) {
+        return;
+    }
+    
+    switch (data[0]) {
+        case CO2Protocol::Start::OPCODE:
+            if (CO2Protocol::Start::decode(data, len)) {
+                co2State.solenoidOpen = true;
+                co2State.onDurationMs = 0;  // Until stopped
+                co2State.onStartTime = millis();
+                Serial.println("  CO2 ON");
+            }
+            break;
+            
+        case CO2Protocol::Timed::OPCODE: {
+            uint16_t durationSec;
+            if (CO2Protocol::Timed::decode(data, len, durationSec) &&
+                durationSec > 0 && durationSec <= 3600) {  // Max 1 hour
+                co2State.solenoidOpen = true;
+                co2State.onDurationMs = durationSec * 1000UL;
+                co2State.onStartTime = millis();
+                Serial.printf("  CO2 ON for %d seconds\n", durationSec);
             }
             break;
+        }
             
-        case 2: // Close solenoid immediately
+        case CO2Protocol::Stop::OPCODE:
+        case CO2Protocol::EmergencyStop::OPCODE:
+            // Closing is always safe, so accept the opcode regardless of length
             co2State.solenoidOpen = false;
             co2State.onDurationMs = 0;
             Serial.println("  CO2 OFF");
             break;
             
         default:
-            Serial.printf("  Unknown command ID: %d\n", msg->commandId);
+            Serial.printf("  Unknown opcode: %d\n", data[0]);
             break;
     }
 }
@@ -1,4 +1,5 @@
 #include "node_base.h"
+#include "protocol/commands.h"
 
 // ============================================================================
 // FISH FEEDER NODE - Automated fish feeding
@@ -51,26 +52,52 @@ void enterFailSafeMode() {
     // Better to miss one feeding than to overfeed
 }
 
+void startFeeding(uint8_t portions) {
+    if (feederState.feedInProgress) {
+        Serial.println("  Feeding already in progress");
+        return;
+    }
+    
+    if (portions == 0) portions = 1;
+    if (portions > 5) portions = 5;  // Safety limit
+    
+    feederState.portionCount = portions;
+    feederState.feedInProgress = true;
+    feederState.feedStartTime = millis();
+    Serial.printf("  Feeding %d portions\n", feederState.portionCount);
+}
+
 void handleCommand(const CommandMessage* msg) {
-    Serial.printf("  Command ID: %d\n", msg->commandId);
+    const uint8_t* data = msg->commandData;
+    size_t len = msg->commandLen;
+    Serial.printf("  Command ID: %d, opcode: %d\n", msg->commandId, len ? data[0] : 0);
+    
+    if (len == 0) {
+        return;
+    }
     
-    switch (msg->commandId) {
-        case 1: // Dispense food
-            if (!feederState.feedInProgress) {
-                feederState.portionCount = msg->commandData[0];
-                if (feederState.portionCount == 0) feederState.portionCount = 1;
-                if (feederState.portionCount > 5) feederState.portionCount = 5;  // Safety limit
-                
-                feederState.feedInProgress = true;
-                feederState.feedStartTime = millis();
-                Serial.printf("  Feeding %d portions\n", feederState.portionCount);
-            } else {
-                Serial.println("  Feeding already in progress");
+    switch (data[0]) {
+        case FeederProtocol::Feed::OPCODE: {
+            uint8_t portions;
+            if (FeederProtocol::Feed::decode(data, len, portions)) {
+                startFeeding(portions);
             }
             break;
+        }
+            
+        case FeederProtocol::Test::OPCODE:
+            if (FeederProtocol::Test::decode(data, len)) {
+                startFeeding(1);
+            }
+            break;
+            
+        case FeederProtocol::Cancel::OPCODE:
+            feederState.feedInProgress = false;
+            Serial.println("  Feeding cancelled");
+            break;
             
         default:
-            Serial.printf("  Unknown command ID: %d\n", msg->commandId);
+            Serial.printf("  Unknown opcode: %d\n", data[0]);
             break;
     }
 }
@@ -1,4 +1,5 @@
 #include "node_base.h"
+#include "protocol/commands.h"
 
 // ============================================================================
 // HEATER NODE - Temperature control
@@ -29,10 +30,25 @@ uint8_t messageSequence = 0;
 // Heater state
 struct HeaterState {
     bool heaterOn;
-    float currentTemp;
+    float currentTemp;          // Own probe
+    bool probeValid;            // currentTemp is a real reading
     float targetTemp;
+    float hysteresis;
     bool autoMode;
-} heaterState = {false, 0.0, 25.0, false};
+    float referenceTemp;        // Hub's fused tank temperature
+    uint32_t referenceExpiresMs; // millis() after which referenceTemp is ignored
+    bool referenceValid;
+} heaterState = {false, 0.0, false, 25.0, 0.5, false, 0.0, 0, false};
+
+// Own probe above this cuts the relay whatever the reference says
+const float LOCAL_CUTOFF_TEMP = 32.0;
+const uint32_t STATUS_INTERVAL_MS = 30000;
+uint32_t lastStatusSent = 0;
+
+// Mode values match HeaterDevice::Mode on the hub
+const uint8_t MODE_OFF = 0;
+const uint8_t MODE_ON = 1;
+const uint8_t MODE_AUTO = 2;
 
 // ============================================================================
 // Hardware Implementation
@@ -53,53 +69,153 @@ void enterFailSafeMode() {
     digitalWrite(PIN_HEATER_RELAY, LOW);
     heaterState.heaterOn = false;
     heaterState.autoMode = false;
+    heaterState.referenceValid = false;
+}
+
+bool setTargetCenti(int16_t centi) {
+    float temp = centi / 100.0f;
+    if (temp < 18.0 || temp > 32.0) {  // Reasonable aquarium range
+        Serial.printf("  Target temp %.2fC out of range\n", temp);
+        return false;
+    }
+    heaterState.targetTemp = temp;
+    Serial.printf("  Target temp set to: %.2fC\n", temp);
+    return true;
 }
 
 void handleCommand(const CommandMessage* msg) {
-    Serial.printf("  Command ID: %d\n", msg->commandId);
+    const uint8_t* data = msg->commandData;
+    size_t len = msg->commandLen;
+    Serial.printf("  Command ID: %d, opcode: %d\n", msg->commandId, len ? data[0] : 0);
     
-    switch (msg->commandId) {
-        case 1: // Set target temperature
-            {
-                float temp = *((float*)msg->commandData);
-                if (temp >= 18.0 && temp <= 32.0) {  // Reasonable aquarium range
-                    heaterState.targetTemp = temp;
-                    Serial.printf("  Target temp set to: %.1fC\n", temp);
+    if (len == 0) {
+        return;
+    }
+    
+    switch (data[0]) {
+        case HeaterProtocol::SetMode::OPCODE: {
+            uint8_t mode;
+            if (HeaterProtocol::SetMode::decode(data, len, mode)) {
+                heaterState.autoMode = (mode == MODE_AUTO);
+                if (!heaterState.autoMode) {
+                    heaterState.heaterOn = (mode == MODE_ON);
                 }
+                Serial.printf("  Mode: %d\n", mode);
             }
             break;
-            
-        case 2: // Enable auto mode
-            heaterState.autoMode = msg->commandData[0] != 0;
-            Serial.printf("  Auto mode: %s\n", heaterState.autoMode ? "ON" : "OFF");
+        }
+        
+        case HeaterProtocol::SetTarget::OPCODE: {
+            int16_t centi;
+            if (HeaterProtocol::SetTarget::decode(data, len, centi)) {
+                setTargetCenti(centi);
+            }
             break;
-            
-        case 3: // Manual heater control
-            if (!heaterState.autoMode) {
-                heaterState.heaterOn = msg->commandData[0] != 0;
+        }
+        
+        case HeaterProtocol::SetHysteresis::OPCODE: {
+            uint16_t centi;
+            if (HeaterProtocol::SetHysteresis::decode(data, len, centi) && centi > 0 && centi <= 200) {
+                heaterState.hysteresis = centi / 100.0f;
+                Serial.printf("  Hysteresis: %.2fC\n", heaterState.hysteresis);
+            }
+            break;
+        }
+        
+        case HeaterProtocol::ManualOn::OPCODE:
+        case HeaterProtocol::ManualOff::OPCODE:
+            if (HeaterProtocol::ManualOn::decode(data, len) || HeaterProtocol::ManualOff::decode(data, len)) {
+                heaterState.autoMode = false;
+                heaterState.heaterOn = (data[0] == HeaterProtocol::ManualOn::OPCODE);
                 Serial.printf("  Manual heater: %s\n", heaterState.heaterOn ? "ON" : "OFF");
             }
             break;
             
+        case HeaterProtocol::SetReference::OPCODE: {
+            int16_t centi;
+            uint16_t validSec;
+            if (HeaterProtocol::SetReference::decode(data, len, centi, validSec) && validSec > 0) {
+                if (validSec > HeaterProtocol::MAX_REFERENCE_VALID_SEC) {
+                    validSec = HeaterProtocol::MAX_REFERENCE_VALID_SEC;
+                }
+                heaterState.referenceTemp = centi / 100.0f;
+                heaterState.referenceExpiresMs = millis() + validSec * 1000UL;
+                heaterState.referenceValid = true;
+            }
+            break;
+        }
+        
+        case HeaterProtocol::EnableAuto::OPCODE: {
+            int16_t centi;
+            if (HeaterProtocol::EnableAuto::decode(data, len, centi) && setTargetCenti(centi)) {
+                heaterState.autoMode = true;
+                Serial.println("  Auto mode: ON");
+            }
+            break;
+        }
+            
         default:
-            Serial.printf("  Unknown command ID: %d\n", msg->commandId);
+            Serial.printf("  Unknown opcode: %d\n", data[0]);
             break;
     }
 }
 
+// Fused hub temperature while fresh, own probe otherwise
+bool controlTemperature(float& temp) {
+    if (heaterState.referenceValid && (int32_t)(millis() - heaterState.referenceExpiresMs) >= 0) {
+        heaterState.referenceValid = false;
+        Serial.println("  Hub reference expired, using own probe");
+    }
+    if (heaterState.referenceValid) {
+        temp = heaterState.referenceTemp;
+        return true;
+    }
+    if (heaterState.probeValid) {
+        temp = heaterState.currentTemp;
+        return true;
+    }
+    return false;
+}
+
+void sendHeaterStatus(float controlTemp) {
+    HeaterProtocol::Status status;
+    status.mode = heaterState.autoMode ? MODE_AUTO : (heaterState.heaterOn ? MODE_ON : MODE_OFF);
+    status.flags = (heaterState.heaterOn ? HeaterProtocol::STATUS_HEATING : 0) |
+                   (heaterState.probeValid ? HeaterProtocol::STATUS_PROBE_OK : 0) |
+                   (heaterState.referenceValid ? HeaterProtocol::STATUS_REFERENCE : 0);
+    status.probeX100 = (int16_t)lroundf(heaterState.currentTemp * 100.0f);
+    status.controlX100 = (int16_t)lroundf(controlTemp * 100.0f);
+    sendStatus(0, 0, (const uint8_t*)&status, sizeof(status));
+}
+
 void updateHardware() {
     // TODO: Read temperature sensor
     // heaterState.currentTemp = readTemperature();
+    // heaterState.probeValid = (read succeeded);
     
     // Auto temperature control
+    float controlTemp = 0.0;
+    bool haveTemp = controlTemperature(controlTemp);
     if (heaterState.autoMode) {
-        if (heaterState.currentTemp < heaterState.targetTemp - 0.5) {
+        if (!haveTemp) {
+            heaterState.heaterOn = false;  // Never heat blind
+        } else if (controlTemp < heaterState.targetTemp - heaterState.hysteresis) {
             heaterState.heaterOn = true;
-        } else if (heaterState.currentTemp > heaterState.targetTemp + 0.5) {
+        } else if (controlTemp > heaterState.targetTemp + heaterState.hysteresis) {
             heaterState.heaterOn = false;
         }
     }
     
+    // Local over-temperature cut-off, independent of the hub
+    if (heaterState.probeValid && heaterState.currentTemp > LOCAL_CUTOFF_TEMP) {
+        heaterState.heaterOn = false;
+    }
+    
+    if (currentState == NodeState::CONNECTED && millis() - lastStatusSent >= STATUS_INTERVAL_MS) {
+        lastStatusSent = millis();
+        sendHeaterStatus(controlTemp);
+    }
+    
     // Apply heater state (only when connected to hub for safety)
     if (currentState == NodeState::CONNECTED) {
         digitalWrite(PIN_HEATER_RELAY, heaterState.heaterOn ? HIGH : LOW);
@@ -0,0 +1,271 @@
+#include "light_effects.h"
+
+using LightEffects::EffectType;
+using LightEffects::EffectParams;
+
+LightEffectEngine::LightEffectEngine()
+    : _lastFrameMs(0) {
+    memset(_layers, 0, sizeof(_layers));
+}
+
+// ============================================================================
+// LAYER CONTROL
+// ============================================================================
+
+bool LightEffectEngine::start(const EffectParams& params, uint32_t nowMs) {
+    uint8_t type = (uint8_t)params.type;
+    if (type < (uint8_t)EffectType::CLOUDS || type > (uint8_t)EffectType::MOONLIGHT) {
+        return false;
+    }
+
+    Layer& layer = _layers[type - 1];
+    memset(&layer, 0, sizeof(layer));
+    memcpy(&layer.params, &params, sizeof(params));
+    layer.active = true;
+    layer.startMs = nowMs;
+
+    // xorshift32 must never be seeded with 0
+    layer.rng = params.seed ? params.seed : 0x2545F491u;
+
+    if (params.type == EffectType::STORM) {
+        const LightEffects::StormArgs* storm = (const LightEffects::StormArgs*)layer.params.args;
+        if (storm->flashRate > 0) {
+            layer.nextBurstMs = nowMs + 1000 + _xorshift(layer.rng) % (60000u / storm->flashRate);
+        }
+    }
+
+    return true;
+}
+
+void LightEffectEngine::stop(EffectType type) {
+    if (type == EffectType::NONE) {
+        for (uint8_t i = 0; i < 3; i++) {
+            _layers[i].active = false;
+        }
+        return;
+    }
+
+    uint8_t index = (uint8_t)type;
+    if (index >= 1 && index <= 3) {
+        _layers[index - 1].active = false;
+    }
+}
+
+uint8_t LightEffectEngine::activeMask() const {
+    uint8_t mask = 0;
+    for (uint8_t i = 0; i < 3; i++) {
+        if (_layers[i].active) {
+            mask |= (1 << (i + 1));
+        }
+    }
+    return mask;
+}
+
+// ============================================================================
+// FRAME RENDERING
+// ============================================================================
+
+bool LightEffectEngine::update(uint32_t nowMs, const uint8_t base[CHANNEL_COUNT], uint8_t out[CHANNEL_COUNT]) {
+    if (nowMs - _lastFrameMs < TICK_MS) {
+        return false;
+    }
+    _lastFrameMs = nowMs;
+
+    uint16_t mul[CHANNEL_COUNT] = {256, 256, 256};     // Q8, 256 = unchanged
+    uint16_t add[CHANNEL_COUNT] = {0, 0, 0};           // Additive flash
+    uint8_t floorLevel[CHANNEL_COUNT] = {0, 0, 0};     // Minimum (moonlight)
+
+    for (uint8_t i = 0; i < 3; i++) {
+        Layer& layer = _layers[i];
+        if (!layer.active) {
+            continue;
+        }
+
+        // Auto-expire timed effects
+        if (layer.params.durationSec > 0 &&
+            nowMs - layer.startMs >= (uint32_t)layer.params.durationSec * 1000u) {
+            layer.active = false;
+            continue;
+        }
+
+        switch (layer.params.type) {
+            case EffectType::CLOUDS:
+                _renderClouds(layer, nowMs, mul);
+                break;
+            case EffectType::STORM:
+                _renderStorm(layer, nowMs, mul, add);
+                break;
+            case EffectType::MOONLIGHT:
+                _renderMoon(layer, nowMs, floorLevel);
+                break;
+            default:
+                break;
+        }
+    }
+
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) {
+        uint32_t level = (((uint32_t)base[ch] * mul[ch]) >> 8) + add[ch];
+        if (level > 255) {
+            level = 255;
+        }
+        if (level < floorLevel[ch]) {
+            level = floorLevel[ch];
+        }
+        out[ch] = (uint8_t)level;
+    }
+
+    return true;
+}
+
+void LightEffectEngine::_renderClouds(const Layer& layer, uint32_t nowMs, uint16_t mul[CHANNEL_COUNT]) {
+    const LightEffects::CloudArgs* clouds = (const LightEffects::CloudArgs*)layer.params.args;
+    if (clouds->coverage == 0 || clouds->depth == 0) {
+        return;
+    }
+
+    // Position along the noise line in Q16 cells; speed = cells per minute
+    uint64_t posQ16 = ((uint64_t)(nowMs - layer.startMs) * clouds->speed << 16) / 60000u;
+
+    // Two octaves: broad cloud banks plus finer edges
+    uint16_t coarse = _valueNoise(layer.params.seed, posQ16);
+    uint16_t fine = _valueNoise(layer.params.seed ^ 0x9E3779B9u, posQ16 << 1);
+    uint16_t noise = (coarse * 3 + fine) >> 2;
+
+    // Only noise above the coverage threshold becomes cloud
+    uint16_t threshold = 255 - clouds->coverage;
+    if (noise <= threshold) {
+        return;
+    }
+    uint16_t shade = ((noise - threshold) * 255u) / clouds->coverage;
+    uint16_t dim = (shade * clouds->depth) >> 8;
+
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) {
+        if (layer.params.channelMask & (1 << ch)) {
+            mul[ch] = (mul[ch] * (256 - dim)) >> 8;
+        }
+    }
+}
+
+void LightEffectEngine::_renderStorm(Layer& layer, uint32_t nowMs, uint16_t mul[CHANNEL_COUNT], uint16_t add[CHANNEL_COUNT]) {
+    const LightEffects::StormArgs* storm = (const LightEffects::StormArgs*)layer.params.args;
+
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) {
+        if (layer.params.channelMask & (1 << ch)) {
+            mul[ch] = (mul[ch] * (256 - storm->darkness)) >> 8;
+        }
+    }
+
+    if (storm->flashRate == 0 || storm->flashLevel == 0) {
+        return;
+    }
+
+    // Start a new burst when due and idle
+    if (layer.flashLengthMs == 0 && (int32_t)(nowMs - layer.nextBurstMs) >= 0) {
+        uint8_t maxBurst = storm->maxBurst ? storm->maxBurst : 1;
+        layer.flashesLeft = 1 + _xorshift(layer.rng) % maxBurst;
+        layer.flashStartMs = nowMs;
+        layer.flashLengthMs = 20 + _xorshift(layer.rng) % 80;
+
+        // Next burst 0.25x-1.75x the mean interval after this one
+        uint32_t meanMs = 60000u / storm->flashRate;
+        layer.nextBurstMs = nowMs + meanMs / 4 + _xorshift(layer.rng) % (meanMs * 3 / 2 + 1);
+    }
+
+    if (layer.flashLengthMs == 0) {
+        return;
+    }
+
+    int32_t age = (int32_t)(nowMs - layer.flashStartMs);
+    if (age < 0) {
+        return;  // Gap between flashes in a burst
+    }
+
+    if (age >= layer.flashLengthMs) {
+        if (layer.flashesLeft > 1) {
+            layer.flashesLeft--;
+            layer.flashStartMs = nowMs + 40 + _xorshift(layer.rng) % 110;
+            layer.flashLengthMs = 20 + _xorshift(layer.rng) % 80;
+        } else {
+            layer.flashesLeft = 0;
+            layer.flashLengthMs = 0;
+        }
+        return;
+    }
+
+    // Sharp attack, linear decay
+    uint16_t level = ((uint32_t)storm->flashLevel * (layer.flashLengthMs - age)) / layer.flashLengthMs;
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) {
+        if (layer.params.channelMask & (1 << ch)) {
+            add[ch] += level;
+        }
+    }
+}
+
+void LightEffectEngine::_renderMoon(const Layer& layer, uint32_t nowMs, uint8_t floorLevel[CHANNEL_COUNT]) {
+    const LightEffects::MoonArgs* moon = (const LightEffects::MoonArgs*)layer.params.args;
+
+    // Illuminated fraction (1 - cos(2*pi*phase)) / 2 in Q8
+    int32_t cosine = _sineQ15((uint16_t)((moon->phase << 8) + 16384));
+    uint32_t illumination = (uint32_t)(32768 - cosine) >> 8;
+    int32_t level = ((uint32_t)moon->level * illumination) >> 8;
+
+    // Shimmer dips the glow by up to shimmerDepth over one period
+    if (moon->shimmerPeriod > 0 && moon->shimmerDepth > 0) {
+        uint32_t periodMs = (uint32_t)moon->shimmerPeriod * 1000u;
+        uint16_t phase = (uint16_t)((((uint64_t)((nowMs - layer.startMs) % periodMs)) << 16) / periodMs);
+        int32_t amplitude = (level * moon->shimmerDepth) >> 9;
+        level = level - amplitude + ((amplitude * _sineQ15(phase)) >> 15);
+    }
+
+    if (level < 0) {
+        level = 0;
+    } else if (level > 255) {
+        level = 255;
+    }
+
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) {
+        if ((layer.params.channelMask & (1 << ch)) && level > floorLevel[ch]) {
+            floorLevel[ch] = (uint8_t)level;
+        }
+    }
+}
+
+// ============================================================================
+// FIXED-POINT HELPERS
+// ============================================================================
+
+uint32_t LightEffectEngine::_xorshift(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+uint8_t LightEffectEngine::_hashNoise(uint32_t seed, uint32_t cell) {
+    uint32_t h = seed ^ (cell * 0x9E3779B1u);
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return (uint8_t)h;
+}
+
+uint8_t LightEffectEngine::_valueNoise(uint32_t seed, uint64_t posQ16) {
+    uint32_t cell = (uint32_t)(posQ16 >> 16);
+    int32_t frac = (int32_t)((posQ16 >> 8) & 0xFF);
+
+    // Smoothstep 3f^2 - 2f^3 in Q8
+    int32_t smooth = (frac * frac * (768 - 2 * frac)) >> 16;
+
+    int32_t a = _hashNoise(seed, cell);
+    int32_t b = _hashNoise(seed, cell + 1);
+    return (uint8_t)(a + (((b - a) * smooth) >> 8));
+}
+
+int32_t LightEffectEngine::_sineQ15(uint16_t phase) {
+    // Parabolic approximation, peak error ~5% - plenty for light levels
+    int32_t half = phase & 0x7FFF;
+    int32_t y = (half * (32768 - half)) >> 13;
+    return (phase & 0x8000) ? -y : y;
+}
@@ -0,0 +1,82 @@
+#ifndef LIGHT_EFFECTS_ENGINE_H
+#define LIGHT_EFFECTS_ENGINE_H
+
+#include <Arduino.h>
+#include "protocol/light_effects.h"
+
+// ============================================================================
+// LIGHT EFFECT ENGINE - procedural effects rendered locally on the node
+// ============================================================================
+// Each effect type owns one layer. Every frame (TICK_MS) the engine turns
+// the base channel levels into output levels:
+//
+//   out = max(moonFloor, base * cloudMul * stormMul + flash)
+//
+// All maths is integer (Q8 multipliers, Q16 phase) so a frame costs a few
+// microseconds on the ESP8266 and needs no float support.
+// ============================================================================
+
+class LightEffectEngine {
+public:
+    static constexpr uint8_t CHANNEL_COUNT = 3;     // White, Blue, Red
+    static constexpr uint32_t TICK_MS = 20;         // 50 Hz frame rate
+
+    LightEffectEngine();
+
+    /**
+     * @brief Start (or replace) the layer for params.type
+     * @param params Effect parameters from CMD_EFFECT_START
+     * @param nowMs Current millis()
+     * @return true if the effect type is supported
+     */
+    bool start(const LightEffects::EffectParams& params, uint32_t nowMs);
+
+    /**
+     * @brief Stop one layer, or all of them with EffectType::NONE
+     */
+    void stop(LightEffects::EffectType type);
+
+    /**
+     * @brief Bitmask of active layers (bit n = EffectType n)
+     */
+    uint8_t activeMask() const;
+
+    bool isActive() const { return activeMask() != 0; }
+
+    /**
+     * @brief Render a frame if TICK_MS has elapsed
+     * @param nowMs Current millis()
+     * @param base Base levels (0 when lights are off)
+     * @param out Output levels, written only when a frame is rendered
+     * @return true if out was updated
+     */
+    bool update(uint32_t nowMs, const uint8_t base[CHANNEL_COUNT], uint8_t out[CHANNEL_COUNT]);
+
+private:
+    struct Layer {
+        LightEffects::EffectParams params;
+        bool active;
+        uint32_t startMs;
+
+        // Storm burst state
+        uint32_t rng;               // xorshift32 state
+        uint32_t nextBurstMs;       // Start of next burst
+        uint32_t flashStartMs;      // Current flash start
+        uint16_t flashLengthMs;     // Current flash length (0 = none)
+        uint8_t flashesLeft;        // Remaining flashes in burst
+    };
+
+    Layer _layers[3];               // Indexed by EffectType - 1
+    uint32_t _lastFrameMs;
+
+    void _renderClouds(const Layer& layer, uint32_t nowMs, uint16_t mul[CHANNEL_COUNT]);
+    void _renderStorm(Layer& layer, uint32_t nowMs, uint16_t mul[CHANNEL_COUNT], uint16_t add[CHANNEL_COUNT]);
+    void _renderMoon(const Layer& layer, uint32_t nowMs, uint8_t floorLevel[CHANNEL_COUNT]);
+
+    static uint32_t _xorshift(uint32_t& state);
+    static uint8_t _hashNoise(uint32_t seed, uint32_t cell);
+    static uint8_t _valueNoise(uint32_t seed, uint64_t posQ16);
+    static int32_t _sineQ15(uint16_t phase);
+};
+
+#endif // LIGHT_EFFECTS_ENGINE_H
@@ -8,7 +8,9 @@
     #define LittleFS LITTLEFS
 #endif
 #include "protocol/messages.h"
+#include "protocol/commands.h"
 #include "ESPNowManager.h"
+#include "light_effects.h"
 
 // ============================================================================
 // LIGHTING NODE - Controls aquarium lighting
@@ -51,6 +53,9 @@ struct LightingState {
     bool enabled;
 } lightState = {0, 0, 0, false};
 
+// Procedural effects (clouds, storm, moonlight) layered over lightState
+LightEffectEngine effects;
+
 // ============================================================================
 // CONFIGURATION LOADER
 // ============================================================================
@@ -172,6 +177,18 @@ void enterFailSafeMode() {
     lightState.enabled = false;
 }
 
+/**
+ * @brief Decode a channel ON command; a bare opcode means full brightness
+ */
+template <typename ChannelOn>
+bool decodeChannelOn(const uint8_t* data, size_t len, uint8_t& level) {
+    if (len == 1) {
+        level = 255;
+        return true;
+    }
+    return ChannelOn::decode(data, len, level);
+}
+
 void onCommandReceived(const uint8_t* mac, const uint8_t* data, size_t len) {
     if (config.debugESPNOW) {
         Serial.println("+========================================================+");
@@ -198,7 +215,7 @@ void onCommandReceived(const uint8_t* mac, const uint8_t* data, size_t len) {
     bool success = true;
     
     switch (commandType) {
-        case 0: // All 3 channels OFF
+        case LightProtocol::AllOff::OPCODE:
             lightState.whiteLevel = 0;
             lightState.blueLevel = 0;
             lightState.redLevel = 0;
@@ -208,78 +225,89 @@ void onCommandReceived(const uint8_t* mac, const uint8_t* data, size_t len) {
             }
             break;
             
-        case 1: // All 3 channels ON (to last known levels or max)
-            if (len >= 4) {
-                // Use provided levels
-                lightState.whiteLevel = data[1];
-                lightState.blueLevel = data[2];
-                lightState.redLevel = data[3];
-            } else {
-                // Default to max if no levels provided
-                lightState.whiteLevel = 255;
-                lightState.blueLevel = 255;
-                lightState.redLevel = 255;
+        case LightProtocol::AllOn::OPCODE: {
+            // Bare opcode = full brightness
+            uint8_t white = 255, blue = 255, red = 255;
+            if (len > 1 && !LightProtocol::AllOn::decode(data, len, white, blue, red)) {
+                success = false;
+                break;
             }
+            lightState.whiteLevel = white;
+            lightState.blueLevel = blue;
+            lightState.redLevel = red;
             lightState.enabled = true;
             if (config.debugESPNOW) {
                 Serial.printf("| [OK] All channels ON: W=%d B=%d R=%d\n",
                               lightState.whiteLevel, lightState.blueLevel, lightState.redLevel);
             }
             break;
+        }
             
-        case 10: // Channel 1 (White) OFF
+        case LightProtocol::WhiteOff::OPCODE:
             lightState.whiteLevel = 0;
             if (config.debugESPNOW) {
                 Serial.println("| [OK] Channel 1 (White) OFF");
             }
             break;
             
-        case 11: // Channel 1 (White) ON
-            if (len >= 2) {
-                lightState.whiteLevel = data[1];
-            } else {
-                lightState.whiteLevel = 255;  // Default to max
-            }
+        case LightProtocol::WhiteOn::OPCODE:
+            success = decodeChannelOn<LightProtocol::WhiteOn>(data, len, lightState.whiteLevel);
             if (config.debugESPNOW) {
-                Serial.printf("| [OK] Channel 1 (White) ON: %d\n", lightState.whiteLevel);
+                Serial.printf("| [%s] Channel 1 (White) ON: %d\n", success ? "OK" : "ERROR", lightState.whiteLevel);
             }
             break;
             
-        case 20: // Channel 2 (Blue) OFF
+        case LightProtocol::BlueOff::OPCODE:
             lightState.blueLevel = 0;
             if (config.debugESPNOW) {
                 Serial.println("| [OK] Channel 2 (Blue) OFF");
             }
             break;
             
-        case 21: // Channel 2 (Blue) ON
-            if (len >= 2) {
-                lightState.blueLevel = data[1];
-            } else {
-                lightState.blueLevel = 255;  // Default to max
-            }
+        case LightProtocol::BlueOn::OPCODE:
+            success = decodeChannelOn<LightProtocol::BlueOn>(data, len, lightState.blueLevel);
             if (config.debugESPNOW) {
-                Serial.printf("| [OK] Channel 2 (Blue) ON: %d\n", lightState.blueLevel);
+                Serial.printf("| [%s] Channel 2 (Blue) ON: %d\n", success ? "OK" : "ERROR", lightState.blueLevel);
             }
             break;
             
-        case 30: // Channel 3 (Red) OFF
+        case LightProtocol::RedOff::OPCODE:
             lightState.redLevel = 0;
             if (config.debugESPNOW) {
                 Serial.println("| [OK] Channel 3 (Red) OFF");
             }
             break;
             
-        case 31: // Channel 3 (Red) ON
-            if (len >= 2) {
-                lightState.redLevel = data[1];
-            } else {
-                lightState.redLevel = 255;  // Default to max
+        case LightProtocol::RedOn::OPCODE:
+            success = decodeChannelOn<LightProtocol::RedOn>(data, len, lightState.redLevel);
+            if (config.debugESPNOW) {
+                Serial.printf("| [%s] Channel 3 (Red) ON: %d\n", success ? "OK" : "ERROR", lightState.redLevel);
             }
+            break;
+            
+        case LightProtocol::EffectStart::OPCODE: {
+            LightEffects::EffectParams params;
+            success = LightProtocol::EffectStart::decode(data, len, params) &&
+                      effects.start(params, millis());
             if (config.debugESPNOW) {
-                Serial.printf("| [OK] Channel 3 (Red) ON: %d\n", lightState.redLevel);
+                Serial.printf("| [%s] Effect %d start\n", success ? "OK" : "ERROR", len >= 2 ? data[1] : 0);
             }
             break;
+        }
+            
+        case LightProtocol::EffectStop::OPCODE: {
+            // Bare opcode = stop all
+            uint8_t type = (uint8_t)LightEffects::EffectType::NONE;
+            if (len > 1 && !LightProtocol::EffectStop::decode(data, len, type)) {
+                success = false;
+                break;
+            }
+            effects.stop((LightEffects::EffectType)type);
+            if (config.debugESPNOW) {
+                Serial.printf("| [OK] Effect stop (active mask=0x%02X)\n", effects.activeMask());
+            }
+            break;
+        }
             
         default:
             if (config.debugESPNOW) {
@@ -300,7 +328,7 @@ void onCommandReceived(const uint8_t* mac, const uint8_t* data, size_t len) {
     status.header.nodeType = NodeType::LIGHT;
     status.header.timestamp = millis();
     status.header.sequenceNum = messageSequence++;
-    status.commandId = commandType;  // Echo command type as command ID
+    status.commandId = ESPNowManager::getInstance().getCurrentCommandId();  // Echo transaction ID
     status.statusCode = success ? 0 : 1;
     
     // Pack current state into status data (placeholder format)
@@ -308,12 +336,15 @@ void onCommandReceived(const uint8_t* mac, const uint8_t* data, size_t len) {
     // Byte 1: Channel 2 level (0-255)
     // Byte 2: Channel 3 level (0-255)
     // Byte 3: Enabled (0=off, 1=on)
+    // Byte 4: Active effect mask (bit n = LightEffects::EffectType n)
     status.statusData[0] = lightState.whiteLevel;   // Channel 1
     status.statusData[1] = lightState.blueLevel;    // Channel 2
     status.statusData[2] = lightState.redLevel;     // Channel 3
     status.statusData[3] = lightState.enabled ? 1 : 0;
+    status.statusData[4] = effects.activeMask();
+    status.statusLen = 5;
     
-    ESPNowManager::getInstance().send(mac, (uint8_t*)&status, sizeof(status));
+    ESPNowManager::getInstance().send(mac, (uint8_t*)&status, statusFrameSize(status));
     
     if (config.debugESPNOW) {
         Serial.printf("[TX] STATUS sent (code=%d)\n\n", status.statusCode);
@@ -321,8 +352,23 @@ void onCommandReceived(const uint8_t* mac, const uint8_t* data, size_t len) {
 }
 
 void updateHardware() {
-    // Apply lighting levels
-    if (lightState.enabled) {
+    // Effects render locally at 50 Hz on top of the base levels, so the hub
+    // never streams per-frame values over ESP-NOW
+    if (effects.isActive()) {
+        uint8_t base[LightEffectEngine::CHANNEL_COUNT] = {0, 0, 0};
+        if (lightState.enabled) {
+            base[0] = lightState.whiteLevel;
+            base[1] = lightState.blueLevel;
+            base[2] = lightState.redLevel;
+        }
+        
+        uint8_t out[LightEffectEngine::CHANNEL_COUNT];
+        if (effects.update(millis(), base, out)) {
+            analogWrite(PIN_LED_WHITE, out[0]);
+            analogWrite(PIN_LED_BLUE, out[1]);
+            analogWrite(PIN_LED_RED, out[2]);
+        }
+    } else if (lightState.enabled) {
         analogWrite(PIN_LED_WHITE, lightState.whiteLevel);
         analogWrite(PIN_LED_BLUE, lightState.blueLevel);
         analogWrite(PIN_LED_RED, lightState.redLevel);
@@ -370,19 +416,54 @@ void onAckReceived(const uint8_t* mac, const AckMessage& msg) {
     }
 }
 
+/**
+ * @brief Confirm an applied CONFIG or UNMAP so the hub commits its transaction
+ * @param token Transaction token from header.sequenceNum (0 = legacy frame, no reply)
+ */
+void sendProvisioningStatus(const uint8_t* mac, uint8_t token, uint8_t statusCode) {
+    if (token == 0) {
+        return;
+    }
+    
+    StatusMessage statusMsg = {};
+    statusMsg.header.type = MessageType::STATUS;
+    statusMsg.header.tankId = config.tankId;
+    statusMsg.header.nodeType = NodeType::LIGHT;
+    statusMsg.header.timestamp = millis();
+    statusMsg.header.sequenceNum = messageSequence++;
+    statusMsg.commandId = token;  // Echo transaction token
+    statusMsg.statusCode = statusCode;
+    statusMsg.statusLen = 0;
+    
+    ESPNowManager::getInstance().send(mac, (uint8_t*)&statusMsg, statusFrameSize(statusMsg));
+}
+
 void onConfigReceived(const uint8_t* mac, const ConfigMessage& msg) {
+    char name[MAX_NODE_NAME_LEN] = {};
+    memcpy(name, msg.deviceName, MAX_NODE_NAME_LEN - 1);
+    
     if (config.debugESPNOW) {
         Serial.println("+========================================================+");
         Serial.printf("| [CFG]  CONFIG received from %02X:%02X:%02X:%02X:%02X:%02X\n",
                       mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
         Serial.printf("| Assigned Tank ID: %d\n", msg.header.tankId);
-        Serial.printf("| Device Name: %s\n", msg.deviceName);
+        Serial.printf("| Device Name: %s\n", name);
         Serial.println("+========================================================+");
     }
     
+    // Retried CONFIG whose confirmation was lost: this configuration was
+    // already saved (and booted with), so confirm again without a rewrite
+    if (msg.header.tankId == config.tankId && config.nodeName == name &&
+        LittleFS.exists("/node_config.txt")) {
+        Serial.printf("[OK] Configuration already applied (Tank %d, Name '%s') - confirming\n",
+                      config.tankId, config.nodeName.c_str());
+        sendProvisioningStatus(mac, msg.header.sequenceNum, STATUS_CONFIG_APPLIED);
+        return;
+    }
+    
     // Update runtime configuration
     config.tankId = msg.header.tankId;
-    config.nodeName = String(msg.deviceName);
+    config.nodeName = String(name);
     
     // Save to LittleFS for persistence
     File file = LittleFS.open("/node_config.txt", "w");
@@ -402,23 +483,15 @@ void onConfigReceived(const uint8_t* mac, const ConfigMessage& msg) {
         file.close();
         
         Serial.println("[OK] Configuration saved to /node_config.txt");
+        
+        // Confirm before the restart; the hub commits on this STATUS
+        sendProvisioningStatus(mac, msg.header.sequenceNum, STATUS_CONFIG_APPLIED);
+        Serial.printf("[OK] Node provisioned: Tank %d, Name '%s'\n", config.tankId, config.nodeName.c_str());
     } else {
+        // Not confirmed: the restart reloads the stored configuration and the hub retries
         Serial.println("[ERROR] Failed to save configuration to file");
     }
     
-    // Send STATUS acknowledgment
-    StatusMessage statusMsg = {};
-    statusMsg.header.type = MessageType::STATUS;
-    statusMsg.header.tankId = config.tankId;
-    statusMsg.header.nodeType = NodeType::LIGHT;
-    statusMsg.header.timestamp = millis();
-    statusMsg.header.sequenceNum = messageSequence++;
-    statusMsg.commandId = 0;  // CONFIG doesn't have commandId
-    statusMsg.statusCode = 0x00;  // SUCCESS
-    
-    ESPNowManager::getInstance().send(mac, (uint8_t*)&statusMsg, sizeof(statusMsg));
-    
-    Serial.printf("[OK] Node provisioned: Tank %d, Name '%s'\n", config.tankId, config.nodeName.c_str());
     Serial.println("[RST] Restarting in 2 seconds to apply configuration...\n");
     
     delay(2000);
@@ -434,6 +507,15 @@ void onUnmapReceived(const uint8_t* mac, const UnmapMessage& msg) {
         Serial.println("+========================================================+");
     }
     
+    // Confirm first so the hub commits even though we restart
+    sendProvisioningStatus(mac, msg.header.sequenceNum, STATUS_UNMAP_APPLIED);
+    
+    // Retried UNMAP after the restart: already in discovery mode
+    if (config.tankId == 0 && !LittleFS.exists("/node_config.txt")) {
+        Serial.println("[OK] Already unmapped - confirmed again");
+        return;
+    }
+    
     // Reset to discovery mode
     config.tankId = 0;  // Unmapped
     config.nodeName = "UnmappedLight";
@@ -522,7 +604,7 @@ void setup() {
     Serial.println("-----------------------------------------");
     Serial.flush();
     
-    bool success = ESPNowManager::getInstance().begin(config.espnowChannel, false);
+    bool success = ESPNowManager::getInstance().begin(config.espnowChannel);
     Serial.printf("[3] ESP-NOW init returned: %s\n", success ? "SUCCESS" : "FAILED");
     Serial.flush();
     
@@ -556,6 +638,7 @@ void setup() {
     announce.header.sequenceNum = messageSequence++;
     announce.firmwareVersion = config.firmwareVersion;
     announce.capabilities = 0;
+    announce.protocol = ESPNowManager::protocolOffer();  // Fragments, full-frame commands
     
     uint8_t broadcast[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
     ESPNowManager::getInstance().send(broadcast, (uint8_t*)&announce, sizeof(announce));
@@ -605,6 +688,7 @@ void loop() {
         announce.header.sequenceNum = messageSequence++;
         announce.firmwareVersion = config.firmwareVersion;
         announce.capabilities = 0;
+        announce.protocol = ESPNowManager::protocolOffer();
         
         uint8_t broadcast[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
         ESPNowManager::getInstance().send(broadcast, (uint8_t*)&announce, sizeof(announce));
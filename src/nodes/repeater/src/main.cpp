@@ -68,6 +68,25 @@ void onDataReceived(uint8_t *senderMAC, uint8_t *data, uint8_t len) {
         }
     }
     
+    // CONFIG/UNMAP from the hub are addressed to the repeater itself. Name
+    // and tank are fixed in firmware, so confirm and let the hub commit.
+    if (hubRegistered && memcmp(senderMAC, hubMAC, 6) == 0 && len >= sizeof(MessageHeader) &&
+        (header->type == MessageType::CONFIG || header->type == MessageType::UNMAP)) {
+        if (header->sequenceNum != 0) {
+            StatusMessage status = {};
+            status.header.type = MessageType::STATUS;
+            status.header.tankId = TANK_ID;
+            status.header.nodeType = NodeType::UNKNOWN;
+            status.header.timestamp = millis();
+            status.commandId = header->sequenceNum;  // Echo transaction token
+            status.statusCode = header->type == MessageType::CONFIG ? STATUS_CONFIG_APPLIED : STATUS_UNMAP_APPLIED;
+            status.statusLen = 0;
+            esp_now_send(hubMAC, (uint8_t*)&status, statusFrameSize(status));
+            Serial.println("[TX] STATUS (provisioning confirmed)");
+        }
+        return;
+    }
+    
     // Forward message
     if (hubRegistered) {
         // If message is from hub, broadcast it (for nodes to receive)
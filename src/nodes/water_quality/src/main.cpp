@@ -1,4 +1,7 @@
+#include <EEPROM.h>
 #include "node_base.h"
+#include "protocol/commands.h"
+#include "protocol/sensor_calibration.h"
 
 // ============================================================================
 // WATER QUALITY SENSOR NODE - Multi-sensor monitoring
@@ -27,25 +30,109 @@ uint8_t messageSequence = 0;
 #define PIN_TDS_SENSOR A1
 #define PIN_TEMP_SENSOR D1
 
-// Sensor state
+// Sensor state (fixed point - no floats between ADC and radio)
 struct SensorData {
-    float pH;
-    float tds;           // Total dissolved solids (ppm)
-    float temperature;   // C
+    uint16_t phX100;     // pH x100
+    uint16_t tdsPpm;     // Total dissolved solids (ppm)
+    int16_t tempX100;    // C x100
+    uint16_t phRaw;      // Filtered ADC counts (reported for hub-side calibration)
+    uint16_t tdsRaw;
     uint32_t lastReadTime;
-} sensorData = {7.0, 0.0, 25.0, 0};
+} sensorData = {700, 0, 2500, 0, 0, 0};
+
+// Calibration tables compiled by the hub (protocol/sensor_calibration.h).
+// Kept in EEPROM so they survive resets and deep sleep.
+const uint32_t CALIBRATION_MAGIC = 0x314C4143;  // "CAL1"
+
+struct StoredCalibration {
+    uint32_t magic;
+    SensorCalibration::Table ph;
+    SensorCalibration::Table tds;
+} calibration;
 
 const uint32_t SENSOR_READ_INTERVAL_MS = 5000;  // Read every 5 seconds
+const uint8_t SENSOR_BURST_SAMPLES = 9;         // ADC reads per channel, median kept
+uint32_t sensorIntervalMs = SENSOR_READ_INTERVAL_MS;
+
+void readSensors();
+void sendSensorData();
+
+#ifdef NODE_DEEP_SLEEP
+// ============================================================================
+// Deep Sleep Cycle
+// ============================================================================
+// Each wake: one filtered burst, queued in RTC memory. Once batchSize samples
+// are queued (or the queue is full) they go out in one READINGS_BATCH STATUS.
+// Keep intervalSec x batchSize under the hub's 60 s heartbeat timeout.
+// ============================================================================
+
+const uint16_t DEEP_SLEEP_INTERVAL_SEC = 10;
+const uint8_t DEEP_SLEEP_BATCH = 3;             // 1..SensorProtocol::MAX_BATCH_SAMPLES
+const uint32_t DEEP_SLEEP_JOIN_TIMEOUT_MS = 3000;  // Give up on the hub for this wake
+const uint32_t DEEP_SLEEP_MIN_MS = 1000;
+
+struct WaterQualityRtc {
+    uint16_t intervalSec;
+    uint8_t batchSize;
+    uint8_t count;
+    SensorProtocol::BatchSample samples[SensorProtocol::MAX_BATCH_SAMPLES];
+} __attribute__((packed));
+
+static_assert(sizeof(WaterQualityRtc) <= RTC_USER_DATA_LEN, "Sample queue exceeds RTC user data");
+
+WaterQualityRtc* rtcData = nullptr;
+bool cycleReported = false;
+#endif
 
 // ============================================================================
 // Hardware Implementation
 // ============================================================================
 
+void loadCalibration() {
+    EEPROM.begin(sizeof(calibration));
+    EEPROM.get(0, calibration);
+    
+    if (calibration.magic != CALIBRATION_MAGIC) {
+        memset(&calibration, 0, sizeof(calibration));
+        calibration.magic = CALIBRATION_MAGIC;
+    }
+    Serial.printf(" Calibration: pH %s, TDS %s\n",
+                  SensorCalibration::isValid(calibration.ph) ? "table" : "default",
+                  SensorCalibration::isValid(calibration.tds) ? "table" : "default");
+}
+
+void saveCalibration() {
+    EEPROM.put(0, calibration);
+    if (!EEPROM.commit()) {
+        Serial.println("[ERR] Failed to store calibration");
+    }
+}
+
+SensorCalibration::Table* calibrationFor(SensorCalibration::Probe probe) {
+    return probe == SensorCalibration::Probe::PH ? &calibration.ph : &calibration.tds;
+}
+
+// Single-point trim of an existing table against a reference solution
+void trimCalibration(SensorCalibration::Probe probe, uint16_t knownValue) {
+    SensorCalibration::Table* table = calibrationFor(probe);
+    if (!SensorCalibration::isValid(*table)) {
+        Serial.println("[WARN] No calibration table to trim - send a multi-point calibration first");
+        return;
+    }
+    
+    readSensors();
+    uint16_t raw = probe == SensorCalibration::Probe::PH ? sensorData.phRaw : sensorData.tdsRaw;
+    SensorCalibration::applyOffset(*table, raw, knownValue);
+    saveCalibration();
+    Serial.printf("[OK] Calibration trimmed: raw %u -> %u\n", raw, knownValue);
+}
+
 void setupHardware() {
     pinMode(PIN_PH_SENSOR, INPUT);
     pinMode(PIN_TDS_SENSOR, INPUT);
     pinMode(PIN_TEMP_SENSOR, INPUT);
     
+    loadCalibration();
     Serial.println(" Water quality sensors initialized");
 }
 
@@ -55,38 +142,113 @@ void enterFailSafeMode() {
 }
 
 void handleCommand(const CommandMessage* msg) {
-    Serial.printf("  Command ID: %d\n", msg->commandId);
+    const uint8_t* data = msg->commandData;
+    size_t len = msg->commandLen;
+    Serial.printf("  Command ID: %d, opcode: %d\n", msg->commandId, len ? data[0] : 0);
     
-    switch (msg->commandId) {
-        case 1: // Request immediate sensor reading
-            readSensors();
-            sendSensorData();
+    if (len == 0) {
+        return;
+    }
+    
+    switch (data[0]) {
+        case SensorProtocol::RequestReading::OPCODE:
+            if (SensorProtocol::RequestReading::decode(data, len)) {
+                readSensors();
+                sendSensorData();
+            }
+            break;
+            
+        case SensorProtocol::SetInterval::OPCODE: {
+            uint16_t seconds;
+            if (SensorProtocol::SetInterval::decode(data, len, seconds) && seconds > 0) {
+                sensorIntervalMs = (uint32_t)seconds * 1000;
+                #ifdef NODE_DEEP_SLEEP
+                    rtcData->intervalSec = seconds;
+                #endif
+                Serial.printf("  Reading interval set to %u s\n", seconds);
+            }
+            break;
+        }
+            
+        case SensorProtocol::SET_CALIBRATION: {
+            SensorCalibration::Table table;
+            if (SensorCalibration::decode(data, len, table)) {
+                *calibrationFor(table.probe) = table;
+                saveCalibration();
+                Serial.printf("[OK] %s calibration stored (%u points)\n",
+                              table.probe == SensorCalibration::Probe::PH ? "pH" : "TDS", table.count);
+            } else {
+                Serial.println("[ERR] Invalid calibration table");
+            }
+            break;
+        }
+            
+        case SensorProtocol::ResetCalibration::OPCODE:
+            if (SensorProtocol::ResetCalibration::decode(data, len)) {
+                memset(&calibration.ph, 0, sizeof(calibration.ph));
+                memset(&calibration.tds, 0, sizeof(calibration.tds));
+                saveCalibration();
+                Serial.println("[OK] Calibration reset to defaults");
+            }
+            break;
+            
+        case SensorProtocol::CalibratePh::OPCODE: {
+            uint16_t phX100;
+            if (SensorProtocol::CalibratePh::decode(data, len, phX100)) {
+                trimCalibration(SensorCalibration::Probe::PH, phX100);
+            }
             break;
+        }
             
-        case 2: // Calibrate pH sensor
-            Serial.println("  pH calibration requested (TODO: implement)");
+        case SensorProtocol::CalibrateTds::OPCODE: {
+            uint16_t ppm;
+            if (SensorProtocol::CalibrateTds::decode(data, len, ppm)) {
+                trimCalibration(SensorCalibration::Probe::TDS, ppm);
+            }
             break;
+        }
             
         default:
-            Serial.printf("  Unknown command ID: %d\n", msg->commandId);
+            Serial.printf("  Unknown opcode: %d\n", data[0]);
             break;
     }
 }
 
+// Median of a short ADC burst - rejects single-sample spikes
+int readFiltered(uint8_t pin) {
+    int samples[SENSOR_BURST_SAMPLES];
+    
+    for (uint8_t i = 0; i < SENSOR_BURST_SAMPLES; i++) {
+        int value = analogRead(pin);
+        uint8_t j = i;
+        while (j > 0 && samples[j - 1] > value) {
+            samples[j] = samples[j - 1];
+            j--;
+        }
+        samples[j] = value;
+    }
+    return samples[SENSOR_BURST_SAMPLES / 2];
+}
+
 void readSensors() {
-    // TODO: Implement actual sensor reading
-    // For now, use dummy values
+    // Temperature first: pH and TDS are compensated with it
+    // sensorData.tempX100 = readDS18B20();
     
     // pH reading (typical range 6.0-8.5 for aquariums)
-    int phRaw = analogRead(PIN_PH_SENSOR);
-    sensorData.pH = map(phRaw, 0, 1023, 4.0 * 100, 10.0 * 100) / 100.0;
+    sensorData.phRaw = readFiltered(PIN_PH_SENSOR);
+    if (SensorCalibration::isValid(calibration.ph)) {
+        sensorData.phX100 = SensorCalibration::convert(calibration.ph, sensorData.phRaw, sensorData.tempX100);
+    } else {
+        sensorData.phX100 = map(sensorData.phRaw, 0, 1023, 400, 1000);
+    }
     
     // TDS reading (typical range 100-500 ppm)
-    int tdsRaw = analogRead(PIN_TDS_SENSOR);
-    sensorData.tds = map(tdsRaw, 0, 1023, 0, 1000);
-    
-    // Temperature reading
-    // sensorData.temperature = readDS18B20();
+    sensorData.tdsRaw = readFiltered(PIN_TDS_SENSOR);
+    if (SensorCalibration::isValid(calibration.tds)) {
+        sensorData.tdsPpm = SensorCalibration::convert(calibration.tds, sensorData.tdsRaw, sensorData.tempX100);
+    } else {
+        sensorData.tdsPpm = map(sensorData.tdsRaw, 0, 1023, 0, 1000);
+    }
     
     sensorData.lastReadTime = millis();
 }
@@ -95,27 +257,115 @@ void sendSensorData() {
     // Pack sensor data into status message
     uint8_t sensorDataPayload[32] = {0};
     
-    // Pack data: [pH_int, pH_frac, TDS_low, TDS_high, Temp_int, Temp_frac, ...]
-    sensorDataPayload[0] = (uint8_t)sensorData.pH;  // Integer part
-    sensorDataPayload[1] = (uint8_t)((sensorData.pH - (int)sensorData.pH) * 100);  // Fractional
+    // Pack data: [pH_int, pH_frac, TDS_low, TDS_high, Temp_int, Temp_frac,
+    //             pHRaw_low, pHRaw_high, TDSRaw_low, TDSRaw_high]
+    sensorDataPayload[0] = sensorData.phX100 / 100;  // Integer part
+    sensorDataPayload[1] = sensorData.phX100 % 100;  // Fractional
+    
+    sensorDataPayload[2] = sensorData.tdsPpm & 0xFF;        // TDS low byte
+    sensorDataPayload[3] = (sensorData.tdsPpm >> 8) & 0xFF; // TDS high byte
     
-    uint16_t tdsInt = (uint16_t)sensorData.tds;
-    sensorDataPayload[2] = tdsInt & 0xFF;        // TDS low byte
-    sensorDataPayload[3] = (tdsInt >> 8) & 0xFF; // TDS high byte
+    sensorDataPayload[4] = (uint8_t)(sensorData.tempX100 / 100);
+    sensorDataPayload[5] = (uint8_t)(sensorData.tempX100 % 100);
     
-    sensorDataPayload[4] = (uint8_t)sensorData.temperature;
-    sensorDataPayload[5] = (uint8_t)((sensorData.temperature - (int)sensorData.temperature) * 100);
+    // Raw counts let the hub build calibration tables from buffer readings
+    sensorDataPayload[6] = sensorData.phRaw & 0xFF;
+    sensorDataPayload[7] = (sensorData.phRaw >> 8) & 0xFF;
+    sensorDataPayload[8] = sensorData.tdsRaw & 0xFF;
+    sensorDataPayload[9] = (sensorData.tdsRaw >> 8) & 0xFF;
     
     // Send as STATUS message (commandId=0 means unsolicited sensor reading)
-    sendStatus(0, 0, sensorDataPayload, 6);
+    sendStatus(0, 0, sensorDataPayload, 10);
+    
+    Serial.printf(" Sensors: pH=%u.%02u (raw %u), TDS=%u ppm (raw %u), Temp=%d.%02dC\n", 
+                 sensorData.phX100 / 100, sensorData.phX100 % 100, sensorData.phRaw,
+                 sensorData.tdsPpm, sensorData.tdsRaw,
+                 sensorData.tempX100 / 100, abs(sensorData.tempX100 % 100));
+}
+
+#ifdef NODE_DEEP_SLEEP
+static uint16_t saturate16(uint32_t value) {
+    return value > 0xFFFF ? 0xFFFF : (uint16_t)value;
+}
+
+// Append the current reading; a full queue drops its oldest sample
+void queueSample() {
+    if (rtcData->count >= SensorProtocol::MAX_BATCH_SAMPLES) {
+        memmove(&rtcData->samples[0], &rtcData->samples[1],
+                sizeof(rtcData->samples[0]) * (SensorProtocol::MAX_BATCH_SAMPLES - 1));
+        rtcData->count = SensorProtocol::MAX_BATCH_SAMPLES - 1;
+    }
+    
+    SensorProtocol::BatchSample& sample = rtcData->samples[rtcData->count++];
+    sample.phX100 = sensorData.phX100;
+    sample.tdsPpm = sensorData.tdsPpm;
+    sample.tempX100 = sensorData.tempX100;
+}
+
+void sendSampleBatch() {
+    uint8_t payload[MAX_STATUS_DATA_LEN];
+    SensorProtocol::BatchHeader header;
+    header.format = SensorProtocol::READINGS_BATCH;
+    header.count = rtcData->count;
+    header.intervalSec = rtcData->intervalSec;
+    header.cycleAwakeMs = saturate16(getLastCycleAwakeMs());
+    header.cycleAvgMicroAmps = saturate16(getLastCycleAvgMicroAmps());
+    
+    size_t samplesLen = sizeof(rtcData->samples[0]) * rtcData->count;
+    memcpy(payload, &header, sizeof(header));
+    memcpy(payload + sizeof(header), rtcData->samples, samplesLen);
+    sendStatus(0, 0, payload, sizeof(header) + samplesLen);
+    
+    Serial.printf(" Batch of %u sent at %lu ms after boot (last cycle: %u ms awake, ~%u uA avg)\n",
+                  header.count, millis(), header.cycleAwakeMs, header.cycleAvgMicroAmps);
+    rtcData->count = 0;
+}
+
+void setupDeepSleepCycle() {
+    bool resumed = restoreRtcState();
+    currentState = resumed ? NodeState::CONNECTED : NodeState::ANNOUNCING;
     
-    Serial.printf(" Sensors: pH=%.2f, TDS=%.0f ppm, Temp=%.1fC\n", 
-                 sensorData.pH, sensorData.tds, sensorData.temperature);
+    rtcData = (WaterQualityRtc*)rtcUserData();
+    if (rtcData->intervalSec == 0 || rtcData->batchSize == 0 ||
+        rtcData->batchSize > SensorProtocol::MAX_BATCH_SAMPLES ||
+        rtcData->count > SensorProtocol::MAX_BATCH_SAMPLES) {
+        rtcData->intervalSec = DEEP_SLEEP_INTERVAL_SEC;
+        rtcData->batchSize = DEEP_SLEEP_BATCH;
+        rtcData->count = 0;
+    }
+    sensorIntervalMs = (uint32_t)rtcData->intervalSec * 1000;
+    
+    readSensors();
+    queueSample();
+}
+
+void updateDeepSleepCycle() {
+    if (currentState == NodeState::CONNECTED && !cycleReported) {
+        if (rtcData->count >= rtcData->batchSize) {
+            sendSampleBatch();
+        }
+        cycleReported = true;
+    }
+    
+    bool ready = cycleReported && deepSleepReady();
+    if (!ready && millis() < DEEP_SLEEP_JOIN_TIMEOUT_MS) {
+        return;
+    }
+    if (!ready) {
+        Serial.println("[WARN] Hub not reached this wake - keeping samples");
+    }
+    
+    // Hold the sample cadence: subtract this wake's time from the interval
+    uint32_t elapsedMs = millis() + DEEP_SLEEP_BOOT_MS;
+    uint32_t sleepMs = sensorIntervalMs > elapsedMs + DEEP_SLEEP_MIN_MS ?
+                       sensorIntervalMs - elapsedMs : DEEP_SLEEP_MIN_MS;
+    enterDeepSleep(sleepMs);
 }
+#endif
 
 void updateHardware() {
     // Periodic sensor readings
-    if (millis() - sensorData.lastReadTime > SENSOR_READ_INTERVAL_MS) {
+    if (millis() - sensorData.lastReadTime > sensorIntervalMs) {
         readSensors();
         
         // Send data to hub if connected
@@ -129,6 +379,21 @@ void updateHardware() {
 // Arduino Entry Points
 // ============================================================================
 
+#ifdef NODE_DEEP_SLEEP
+void setup() {
+    // Timer wake: no banner, no settle delay - straight to the sensor burst
+    Serial.begin(115200);
+    
+    setupHardware();
+    setupESPNow();
+    setupDeepSleepCycle();
+}
+
+void loop() {
+    nodeLoop();  // Handle ESP-NOW communication
+    updateDeepSleepCycle();  // Report, then sleep once the hub is done with us
+}
+#else
 void setup() {
     Serial.begin(115200);
     delay(1000);
@@ -151,3 +416,4 @@ void loop() {
     updateHardware();  // Read and report sensors
     delay(100);
 }
+#endif
@@ -0,0 +1,72 @@
+#ifndef NATIVE_ARDUINO_STUB_H
+#define NATIVE_ARDUINO_STUB_H
+
+// Just enough of the Arduino core for hub code that is unit tested in
+// the native environment (pio test -e native). Not a port: add only what
+// the code under test uses.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+class String {
+public:
+    String() {}
+    String(const char* text) : _text(text ? text : "") {}
+    String(const std::string& text) : _text(text) {}
+
+    const char* c_str() const { return _text.c_str(); }
+    unsigned int length() const { return _text.size(); }
+    bool reserve(unsigned int size) { _text.reserve(size); return true; }
+
+    char operator[](unsigned int index) const { return _text[index]; }
+    String& operator+=(const String& other) { _text += other._text; return *this; }
+    String& operator+=(const char* other) { _text += other; return *this; }
+    String& operator+=(char c) { _text += c; return *this; }
+    bool operator==(const String& other) const { return _text == other._text; }
+    bool operator==(const char* other) const { return _text == other; }
+    bool operator!=(const String& other) const { return _text != other._text; }
+
+    int indexOf(char c) const {
+        size_t pos = _text.find(c);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    String substring(unsigned int from) const { return String(_text.substr(from)); }
+    String substring(unsigned int from, unsigned int to) const {
+        return String(_text.substr(from, to - from));
+    }
+
+private:
+    std::string _text;
+};
+
+class HardwareSerial {
+public:
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        int written = vprintf(format, args);
+        va_end(args);
+        return written > 0 ? written : 0;
+    }
+    size_t println(const char* text) { return ::printf("%s\n", text); }
+};
+
+static HardwareSerial Serial __attribute__((unused));
+
+inline unsigned long millis() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline unsigned long micros() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif // NATIVE_ARDUINO_STUB_H
@@ -0,0 +1,84 @@
+#ifndef NATIVE_ASYNC_WEB_SERVER_STUB_H
+#define NATIVE_ASYNC_WEB_SERVER_STUB_H
+
+// Request/response doubles for testing AsyncWebHandler subclasses
+// natively. Responses are recorded on the request instead of sent.
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+
+typedef enum {
+    HTTP_GET     = 0b00000001,
+    HTTP_POST    = 0b00000010,
+    HTTP_DELETE  = 0b00000100,
+    HTTP_PUT     = 0b00001000,
+    HTTP_PATCH   = 0b00010000,
+    HTTP_HEAD    = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY     = 0b01111111,
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServerResponse {
+public:
+    AsyncWebServerResponse(int code, const String& contentType, const String& content)
+        : code(code), contentType(contentType), content(content) {}
+
+    void addHeader(const String& name, const String& value) {
+        headers[name.c_str()] = value.c_str();
+    }
+
+    int code;
+    String contentType;
+    String content;
+    std::map<std::string, std::string> headers;
+};
+
+class AsyncWebServerRequest {
+public:
+    AsyncWebServerRequest(WebRequestMethodComposite method, const char* url)
+        : _tempObject(nullptr), _method(method), _url(url), _response(nullptr) {}
+    ~AsyncWebServerRequest() {
+        delete _response;
+        free(_tempObject);
+    }
+
+    WebRequestMethodComposite method() const { return _method; }
+    const String& url() const { return _url; }
+    void addInterestingHeader(const String&) {}
+
+    AsyncWebServerResponse* beginResponse(int code, const String& contentType = String(),
+                                          const String& content = String()) {
+        return new AsyncWebServerResponse(code, contentType, content);
+    }
+    void send(AsyncWebServerResponse* response) {
+        delete _response;
+        _response = response;
+    }
+    void send(int code, const String& contentType = String(), const String& content = String()) {
+        send(beginResponse(code, contentType, content));
+    }
+
+    // Test access: the last response sent, nullptr if none
+    const AsyncWebServerResponse* response() const { return _response; }
+
+    void* _tempObject;
+
+private:
+    WebRequestMethodComposite _method;
+    String _url;
+    AsyncWebServerResponse* _response;
+};
+
+class AsyncWebHandler {
+public:
+    virtual ~AsyncWebHandler() {}
+    virtual bool canHandle(AsyncWebServerRequest*) { return false; }
+    virtual void handleRequest(AsyncWebServerRequest*) {}
+    virtual void handleBody(AsyncWebServerRequest*, uint8_t*, size_t, size_t, size_t) {}
+    virtual bool isRequestHandlerTrivial() { return true; }
+};
+
+#endif // NATIVE_ASYNC_WEB_SERVER_STUB_H
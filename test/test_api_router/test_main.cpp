@@ -0,0 +1,341 @@
+#include <unity.h>
+#include <chrono>
+#include <regex>
+#include <string>
+#include <vector>
+#include "api/ApiRouter.h"
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static void noop(AsyncWebServerRequest*, const ApiRouter::Params&) {}
+
+static int matchPath(const ApiRouter& router, const char* path, WebRequestMethodComposite method,
+                     ApiRouter::Params& params, WebRequestMethodComposite& allowed) {
+    return router.match(path, strlen(path), method, params, allowed);
+}
+
+static int matchPath(const ApiRouter& router, const char* path, WebRequestMethodComposite method) {
+    ApiRouter::Params params;
+    WebRequestMethodComposite allowed;
+    return matchPath(router, path, method, params, allowed);
+}
+
+/**
+ * @brief The hub's own /api table plus generated routes, one sample path each
+ */
+struct RouteTable {
+    struct Entry {
+        std::string pattern;
+        WebRequestMethodComposite method;
+        std::string sample;         // Path below /api that must match this route
+        std::string regex;          // Equivalent AsyncCallbackWebHandler uri ("" = literal)
+    };
+    std::vector<Entry> entries;
+
+    void add(const std::string& pattern, WebRequestMethodComposite method,
+             const std::string& sample, const std::string& regex = "") {
+        Entry entry = {pattern, method, sample, regex};
+        entries.push_back(entry);
+    }
+
+    explicit RouteTable(size_t total) {
+        const char* fixed[] = {"/status", "/reboot", "/changes", "/timeline", "/aquariums",
+                               "/unmapped-devices", "/devices", "/provision-device", "/unmap-device",
+                               "/devices/batch", "/sensors/calibration", "/analytics", "/events",
+                               "/executor", "/federation", "/failover"};
+        for (const char* path : fixed) {
+            add(path, HTTP_GET, path);
+        }
+        add("/aquariums/{id:uint}", HTTP_GET, "/aquariums/3", "^/api/aquariums/([0-9]+)$");
+        add("/aquariums/{id:uint}", HTTP_DELETE, "/aquariums/3", "^/api/aquariums/([0-9]+)$");
+        add("/aquariums/{id:uint}/readings", HTTP_GET, "/aquariums/3/readings",
+            "^/api/aquariums/([0-9]+)/readings$");
+        add("/devices/{mac:mac}/command", HTTP_POST, "/devices/AA:BB:CC:DD:EE:01/command",
+            "^/api/devices/([0-9A-Fa-f:]{17})/command$");
+
+        char pattern[64], sample[64], regex[96];
+        for (size_t i = 0; entries.size() < total; i++) {
+            switch (i % 3) {
+                case 0:
+                    snprintf(pattern, sizeof(pattern), "/tanks/{id:uint}/res%zu", i);
+                    snprintf(sample, sizeof(sample), "/tanks/2/res%zu", i);
+                    snprintf(regex, sizeof(regex), "^/api/tanks/([0-9]+)/res%zu$", i);
+                    add(pattern, HTTP_GET, sample, regex);
+                    break;
+                case 1:
+                    snprintf(pattern, sizeof(pattern), "/devices/{mac:mac}/op%zu", i);
+                    snprintf(sample, sizeof(sample), "/devices/aa:bb:cc:dd:ee:%02zx/op%zu", i & 0xFF, i);
+                    snprintf(regex, sizeof(regex), "^/api/devices/([0-9A-Fa-f:]{17})/op%zu$", i);
+                    add(pattern, HTTP_GET, sample, regex);
+                    break;
+                default:
+                    snprintf(pattern, sizeof(pattern), "/config/section%zu", i);
+                    add(pattern, HTTP_GET, pattern);
+                    break;
+            }
+        }
+    }
+
+    void registerAll(ApiRouter& router) const {
+        for (const Entry& entry : entries) {
+            TEST_ASSERT_TRUE_MESSAGE(router.on(entry.pattern.c_str(), entry.method, noop),
+                                     entry.pattern.c_str());
+        }
+    }
+};
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================================================
+// MATCHING
+// ============================================================================
+
+void test_typed_params_are_parsed(void) {
+    ApiRouter router("/api");
+    router.on("/aquariums/{id:uint}", HTTP_GET, noop);
+    router.on("/devices/{mac:mac}/schedules/{name}", HTTP_GET, noop);
+
+    ApiRouter::Params params;
+    WebRequestMethodComposite allowed;
+    TEST_ASSERT_EQUAL(0, matchPath(router, "/aquariums/4294967295", HTTP_GET, params, allowed));
+    TEST_ASSERT_EQUAL_UINT32(4294967295u, params.getUint("id"));
+
+    TEST_ASSERT_EQUAL(1, matchPath(router, "/devices/aa:BB:cc:DD:ee:0F/schedules/dawn", HTTP_GET,
+                                   params, allowed));
+    TEST_ASSERT_EQUAL(2, params.count());
+    const uint8_t expected[6] = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0x0F};
+    TEST_ASSERT_NOT_NULL(params.getMac("mac"));
+    TEST_ASSERT_EQUAL_MEMORY(expected, params.getMac("mac"), 6);
+    TEST_ASSERT_EQUAL_STRING("dawn", params.getString("name").c_str());
+    TEST_ASSERT_NULL(params.getMac("name"));        // Wrong type
+    TEST_ASSERT_FALSE(params.has("id"));
+}
+
+void test_bad_param_values_do_not_match(void) {
+    ApiRouter router("/api");
+    router.on("/aquariums/{id:uint}", HTTP_GET, noop);
+    router.on("/devices/{mac:mac}", HTTP_GET, noop);
+
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "/aquariums/4x", HTTP_GET));
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "/aquariums/4294967296", HTTP_GET));   // > 32 bits
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "/aquariums/", HTTP_GET));
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "/devices/AA:BB:CC:DD:EE", HTTP_GET));
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "/devices/AA:BB:CC:DD:EE:GG", HTTP_GET));
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "/devices/AA-BB-CC-DD-EE-FF", HTTP_GET));
+}
+
+void test_literal_wins_then_backtracks_to_param(void) {
+    ApiRouter router("/api");
+    int literal = router.getRouteCount();
+    router.on("/items/new/create", HTTP_POST, noop);
+    int param = router.getRouteCount();
+    router.on("/items/{name}/info", HTTP_GET, noop);
+    int deep = router.getRouteCount();
+    router.on("/items/{name}/info/{id:uint}", HTTP_GET, noop);
+
+    ApiRouter::Params params;
+    WebRequestMethodComposite allowed;
+    TEST_ASSERT_EQUAL(literal, matchPath(router, "/items/new/create", HTTP_POST, params, allowed));
+    TEST_ASSERT_EQUAL(0, params.count());
+
+    // "new" takes the literal branch, which has no "info": back out to {name}
+    TEST_ASSERT_EQUAL(param, matchPath(router, "/items/new/info", HTTP_GET, params, allowed));
+    TEST_ASSERT_EQUAL_STRING("new", params.getString("name").c_str());
+
+    // A param that fails deeper down leaves no stale values behind
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "/items/new/info/x", HTTP_GET, params, allowed));
+    TEST_ASSERT_EQUAL(deep, matchPath(router, "/items/new/info/7", HTTP_GET, params, allowed));
+    TEST_ASSERT_EQUAL(2, params.count());
+    TEST_ASSERT_EQUAL_UINT32(7, params.getUint("id"));
+}
+
+void test_trailing_slash_and_empty_segments(void) {
+    ApiRouter router("/api");
+    router.on("/status", HTTP_GET, noop);
+
+    TEST_ASSERT_EQUAL(0, matchPath(router, "/status", HTTP_GET));
+    TEST_ASSERT_EQUAL(0, matchPath(router, "/status/", HTTP_GET));
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "//status", HTTP_GET));
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "/status//", HTTP_GET));
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "/stat", HTTP_GET));
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "/statuses", HTTP_GET));
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "", HTTP_GET));             // Namespace root
+}
+
+void test_wrong_method_reports_allowed(void) {
+    ApiRouter router("/api");
+    router.on("/aquariums/{id:uint}", HTTP_GET, noop);
+    router.on("/aquariums/{id:uint}", HTTP_DELETE | HTTP_PUT, noop);
+
+    ApiRouter::Params params;
+    WebRequestMethodComposite allowed;
+    TEST_ASSERT_EQUAL(1, matchPath(router, "/aquariums/2", HTTP_PUT, params, allowed));
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "/aquariums/2", HTTP_POST, params, allowed));
+    TEST_ASSERT_EQUAL(HTTP_GET | HTTP_DELETE | HTTP_PUT, allowed);
+
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "/aquarium/2", HTTP_POST, params, allowed));
+    TEST_ASSERT_EQUAL(0, allowed);
+}
+
+void test_registration_errors(void) {
+    ApiRouter router("/api");
+    TEST_ASSERT_TRUE(router.on("/aquariums/{id:uint}", HTTP_GET, noop));
+    TEST_ASSERT_FALSE(router.on("/aquariums/{id:uint}", HTTP_GET | HTTP_POST, noop));   // GET taken
+    TEST_ASSERT_FALSE(router.on("/aquariums/{name}", HTTP_POST, noop));                // Conflicts
+    TEST_ASSERT_FALSE(router.on("/aquariums/{id:float}", HTTP_POST, noop));
+    TEST_ASSERT_FALSE(router.on("/a/b/c/d/e/f/g/h/i", HTTP_GET, noop));                 // > MAX_DEPTH
+    TEST_ASSERT_FALSE(router.on("/{a}/{b}/{c}/{d}/{e}", HTTP_GET, noop));               // > MAX_PARAMS
+    TEST_ASSERT_EQUAL(1, router.getRouteCount());
+}
+
+// ============================================================================
+// ASYNC WEB HANDLER
+// ============================================================================
+
+void test_handler_answers_namespace_only(void) {
+    ApiRouter router("/api");
+    int calls = 0;
+    uint32_t seenId = 0;
+    router.on("/aquariums/{id:uint}", HTTP_GET | HTTP_DELETE,
+              [&](AsyncWebServerRequest*, const ApiRouter::Params& params) {
+                  calls++;
+                  seenId = params.getUint("id");
+              });
+
+    AsyncWebServerRequest outside(HTTP_GET, "/apix/aquariums/1");
+    TEST_ASSERT_FALSE(router.canHandle(&outside));
+    AsyncWebServerRequest web(HTTP_GET, "/index.html");
+    TEST_ASSERT_FALSE(router.canHandle(&web));
+
+    AsyncWebServerRequest hit(HTTP_DELETE, "/api/aquariums/9");
+    TEST_ASSERT_TRUE(router.canHandle(&hit));
+    router.handleRequest(&hit);
+    TEST_ASSERT_EQUAL(1, calls);
+    TEST_ASSERT_EQUAL_UINT32(9, seenId);
+    TEST_ASSERT_NULL(hit.response());                   // Left to the route handler
+}
+
+void test_handler_sends_404_and_405_with_allow(void) {
+    ApiRouter router("/api");
+    router.on("/aquariums/{id:uint}", HTTP_GET, noop);
+    router.on("/aquariums/{id:uint}", HTTP_DELETE, noop);
+
+    AsyncWebServerRequest missing(HTTP_GET, "/api/aquariums/x");
+    TEST_ASSERT_TRUE(router.canHandle(&missing));
+    router.handleRequest(&missing);
+    TEST_ASSERT_NOT_NULL(missing.response());
+    TEST_ASSERT_EQUAL(404, missing.response()->code);
+
+    AsyncWebServerRequest wrongMethod(HTTP_POST, "/api/aquariums/1");
+    router.handleRequest(&wrongMethod);
+    TEST_ASSERT_NOT_NULL(wrongMethod.response());
+    TEST_ASSERT_EQUAL(405, wrongMethod.response()->code);
+    TEST_ASSERT_EQUAL_STRING("GET, DELETE", wrongMethod.response()->headers.at("Allow").c_str());
+}
+
+// ============================================================================
+// SCALING
+// ============================================================================
+
+void test_every_route_matches_with_64_routes(void) {
+    RouteTable table(64);
+    ApiRouter router("/api");
+    table.registerAll(router);
+    TEST_ASSERT_EQUAL(64, router.getRouteCount());
+
+    for (size_t i = 0; i < table.entries.size(); i++) {
+        TEST_ASSERT_EQUAL_INT_MESSAGE((int)i, matchPath(router, table.entries[i].sample.c_str(),
+                                                        table.entries[i].method),
+                                      table.entries[i].sample.c_str());
+    }
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "/tanks/2/res1", HTTP_GET));
+    TEST_ASSERT_EQUAL(-1, matchPath(router, "/config/section0", HTTP_GET));
+}
+
+/**
+ * @brief Lookup cost as the table grows, against the per-handler scan it replaced
+ *
+ * The baseline tries each route in registration order the way
+ * AsyncCallbackWebHandler does (exact uri, or regex for parameters), so
+ * its cost grows with the route count while a trie walk depends on the
+ * path depth. Timings are reported, not asserted.
+ */
+static double trieNsPerLookup(const RouteTable& table, const ApiRouter& router, int iterations) {
+    volatile long sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int k = 0; k < iterations; k++) {
+        for (const RouteTable::Entry& entry : table.entries) {
+            sink += matchPath(router, entry.sample.c_str(), entry.method);
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(elapsed).count() /
+           ((double)iterations * table.entries.size());
+}
+
+static double scanNsPerLookup(const RouteTable& table, int iterations) {
+    std::vector<std::regex> compiled;
+    for (const RouteTable::Entry& entry : table.entries) {
+        compiled.push_back(std::regex(entry.regex.empty() ? std::string("^$") : entry.regex));
+    }
+
+    volatile long sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int k = 0; k < iterations; k++) {
+        for (const RouteTable::Entry& request : table.entries) {
+            std::string url = "/api" + request.sample;
+            for (size_t h = 0; h < table.entries.size(); h++) {
+                const RouteTable::Entry& handler = table.entries[h];
+                if (!(handler.method & request.method)) {
+                    continue;
+                }
+                bool hit = handler.regex.empty() ? url == "/api" + handler.pattern
+                                                 : std::regex_search(url, compiled[h]);
+                if (hit) {
+                    sink += h;
+                    break;
+                }
+            }
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(elapsed).count() /
+           ((double)iterations * table.entries.size());
+}
+
+void test_benchmark_lookup(void) {
+    const size_t sizes[] = {20, 50, 128};
+    char line[128];
+    for (size_t total : sizes) {
+        RouteTable table(total);
+        ApiRouter router("/api");
+        table.registerAll(router);
+
+        double trie = trieNsPerLookup(table, router, 2000);
+        double scan = scanNsPerLookup(table, 20);
+        snprintf(line, sizeof(line), "%zu routes, %zu nodes: trie %.0f ns/lookup, handler scan %.0f ns/lookup",
+                 router.getRouteCount(), router.getNodeCount(), trie, scan);
+        TEST_MESSAGE(line);
+        TEST_ASSERT_LESS_THAN(scan, trie);
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_typed_params_are_parsed);
+    RUN_TEST(test_bad_param_values_do_not_match);
+    RUN_TEST(test_literal_wins_then_backtracks_to_param);
+    RUN_TEST(test_trailing_slash_and_empty_segments);
+    RUN_TEST(test_wrong_method_reports_allowed);
+    RUN_TEST(test_registration_errors);
+    RUN_TEST(test_handler_answers_namespace_only);
+    RUN_TEST(test_handler_sends_404_and_405_with_allow);
+    RUN_TEST(test_every_route_matches_with_64_routes);
+    RUN_TEST(test_benchmark_lookup);
+    return UNITY_END();
+}
@@ -0,0 +1,242 @@
+#include <unity.h>
+#include <string.h>
+#include "protocol/commands.h"
+
+using LightEffects::EffectParams;
+using LightEffects::EffectType;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static EffectParams storm() {
+    EffectParams params;
+    memset(&params, 0, sizeof(params));
+    params.type = EffectType::STORM;
+    params.channelMask = LightEffects::CHANNEL_WHITE | LightEffects::CHANNEL_BLUE;
+    params.seed = 0xA1B2C3D4;
+    params.durationSec = 900;
+    params.args[0] = 180;       // darkness
+    params.args[1] = 6;         // flashRate
+    params.args[2] = 255;       // flashLevel
+    params.args[3] = 3;         // maxBurst
+    return params;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================================================
+// TESTS
+// ============================================================================
+
+void test_light_round_trip(void) {
+    uint8_t buf[LightProtocol::AllOn::SIZE];
+    TEST_ASSERT_EQUAL(4, (int)LightProtocol::AllOn::encode(buf, 200, 100, 50));
+    TEST_ASSERT_EQUAL_UINT8(1, buf[0]);
+
+    uint8_t white = 0;
+    uint8_t blue = 0;
+    uint8_t red = 0;
+    TEST_ASSERT_TRUE(LightProtocol::AllOn::decode(buf, sizeof(buf), white, blue, red));
+    TEST_ASSERT_EQUAL_UINT8(200, white);
+    TEST_ASSERT_EQUAL_UINT8(100, blue);
+    TEST_ASSERT_EQUAL_UINT8(50, red);
+
+    // No-argument commands are the opcode alone
+    uint8_t off[LightProtocol::AllOff::SIZE];
+    TEST_ASSERT_EQUAL(1, (int)LightProtocol::AllOff::encode(off));
+    TEST_ASSERT_TRUE(LightProtocol::AllOff::decode(off, sizeof(off)));
+
+    uint8_t level = 0;
+    uint8_t on[LightProtocol::BlueOn::SIZE];
+    LightProtocol::BlueOn::encode(on, 77);
+    TEST_ASSERT_TRUE(LightProtocol::BlueOn::decode(on, sizeof(on), level));
+    TEST_ASSERT_EQUAL_UINT8(77, level);
+}
+
+void test_heater_round_trip(void) {
+    uint8_t buf[HeaterProtocol::SetReference::SIZE];
+    TEST_ASSERT_EQUAL(5, (int)HeaterProtocol::SetReference::encode(buf, 2480, 300));
+
+    int16_t centi = 0;
+    uint16_t validSec = 0;
+    TEST_ASSERT_TRUE(HeaterProtocol::SetReference::decode(buf, sizeof(buf), centi, validSec));
+    TEST_ASSERT_EQUAL(2480, (int)centi);
+    TEST_ASSERT_EQUAL_UINT16(300, validSec);
+
+    uint8_t mode[HeaterProtocol::SetMode::SIZE];
+    uint8_t value = 0;
+    HeaterProtocol::SetMode::encode(mode, 2);
+    TEST_ASSERT_TRUE(HeaterProtocol::SetMode::decode(mode, sizeof(mode), value));
+    TEST_ASSERT_EQUAL_UINT8(2, value);
+
+    uint8_t hysteresis[HeaterProtocol::SetHysteresis::SIZE];
+    uint16_t band = 0;
+    HeaterProtocol::SetHysteresis::encode(hysteresis, 50);
+    TEST_ASSERT_TRUE(HeaterProtocol::SetHysteresis::decode(hysteresis, sizeof(hysteresis), band));
+    TEST_ASSERT_EQUAL_UINT16(50, band);
+}
+
+void test_heater_target_is_signed_little_endian(void) {
+    uint8_t buf[HeaterProtocol::SetTarget::SIZE];
+    TEST_ASSERT_EQUAL(3, (int)HeaterProtocol::SetTarget::SIZE);
+
+    // 25.50 C = 2550 = 0x09F6
+    HeaterProtocol::SetTarget::encode(buf, 2550);
+    const uint8_t positive[] = {0x02, 0xF6, 0x09};
+    TEST_ASSERT_EQUAL_MEMORY(positive, buf, sizeof(positive));
+
+    // -1.50 C = -150 = 0xFF6A (two's complement)
+    HeaterProtocol::SetTarget::encode(buf, -150);
+    const uint8_t negative[] = {0x02, 0x6A, 0xFF};
+    TEST_ASSERT_EQUAL_MEMORY(negative, buf, sizeof(negative));
+
+    int16_t centi = 0;
+    TEST_ASSERT_TRUE(HeaterProtocol::SetTarget::decode(buf, sizeof(buf), centi));
+    TEST_ASSERT_EQUAL(-150, (int)centi);
+
+    HeaterProtocol::SetTarget::encode(buf, -32768);
+    TEST_ASSERT_TRUE(HeaterProtocol::SetTarget::decode(buf, sizeof(buf), centi));
+    TEST_ASSERT_EQUAL(-32768, (int)centi);
+}
+
+void test_co2_round_trip(void) {
+    uint8_t buf[CO2Protocol::Timed::SIZE];
+    CO2Protocol::Timed::encode(buf, 3600);
+    const uint8_t expected[] = {0x03, 0x10, 0x0E};
+    TEST_ASSERT_EQUAL_MEMORY(expected, buf, sizeof(expected));
+
+    uint16_t seconds = 0;
+    TEST_ASSERT_TRUE(CO2Protocol::Timed::decode(buf, sizeof(buf), seconds));
+    TEST_ASSERT_EQUAL_UINT16(3600, seconds);
+
+    uint8_t stop[CO2Protocol::EmergencyStop::SIZE];
+    CO2Protocol::EmergencyStop::encode(stop);
+    TEST_ASSERT_EQUAL_UINT8(0xFF, stop[0]);
+    TEST_ASSERT_TRUE(CO2Protocol::EmergencyStop::decode(stop, sizeof(stop)));
+}
+
+void test_feeder_round_trip(void) {
+    uint8_t buf[FeederProtocol::Feed::SIZE];
+    FeederProtocol::Feed::encode(buf, 3);
+
+    uint8_t portions = 0;
+    TEST_ASSERT_TRUE(FeederProtocol::Feed::decode(buf, sizeof(buf), portions));
+    TEST_ASSERT_EQUAL_UINT8(3, portions);
+
+    uint8_t cancel[FeederProtocol::Cancel::SIZE];
+    FeederProtocol::Cancel::encode(cancel);
+    TEST_ASSERT_TRUE(FeederProtocol::Cancel::decode(cancel, sizeof(cancel)));
+}
+
+void test_sensor_round_trip(void) {
+    uint8_t buf[SensorProtocol::CalibratePh::SIZE];
+    SensorProtocol::CalibratePh::encode(buf, 686);
+
+    uint16_t phX100 = 0;
+    TEST_ASSERT_TRUE(SensorProtocol::CalibratePh::decode(buf, sizeof(buf), phX100));
+    TEST_ASSERT_EQUAL_UINT16(686, phX100);
+
+    uint8_t tds[SensorProtocol::CalibrateTds::SIZE];
+    uint16_t ppm = 0;
+    SensorProtocol::CalibrateTds::encode(tds, 1413);
+    TEST_ASSERT_TRUE(SensorProtocol::CalibrateTds::decode(tds, sizeof(tds), ppm));
+    TEST_ASSERT_EQUAL_UINT16(1413, ppm);
+
+    uint8_t interval[SensorProtocol::SetInterval::SIZE];
+    uint16_t seconds = 0;
+    SensorProtocol::SetInterval::encode(interval, 60);
+    TEST_ASSERT_TRUE(SensorProtocol::SetInterval::decode(interval, sizeof(interval), seconds));
+    TEST_ASSERT_EQUAL_UINT16(60, seconds);
+
+    uint8_t request[SensorProtocol::RequestReading::SIZE];
+    SensorProtocol::RequestReading::encode(request);
+    TEST_ASSERT_TRUE(SensorProtocol::RequestReading::decode(request, sizeof(request)));
+    TEST_ASSERT_FALSE(SensorProtocol::ResetCalibration::decode(request, sizeof(request)));
+}
+
+void test_wrong_opcode_is_rejected(void) {
+    uint8_t buf[SensorProtocol::CalibratePh::SIZE];
+    SensorProtocol::CalibratePh::encode(buf, 700);
+
+    // Same layout, different command
+    uint16_t ppm = 1234;
+    TEST_ASSERT_FALSE(SensorProtocol::CalibrateTds::decode(buf, sizeof(buf), ppm));
+    TEST_ASSERT_EQUAL_UINT16(1234, ppm);
+    TEST_ASSERT_TRUE(SensorProtocol::CalibratePh::matches(buf, sizeof(buf)));
+    TEST_ASSERT_FALSE(SensorProtocol::CalibrateTds::matches(buf, sizeof(buf)));
+    TEST_ASSERT_FALSE(SensorProtocol::CalibratePh::matches(buf, 0));
+}
+
+void test_short_and_long_payloads_are_rejected(void) {
+    uint8_t buf[HeaterProtocol::SetReference::SIZE + 1];
+    HeaterProtocol::SetReference::encode(buf, 2500, 60);
+    buf[HeaterProtocol::SetReference::SIZE] = 0;
+
+    int16_t centi = 7;
+    uint16_t validSec = 8;
+    TEST_ASSERT_FALSE(HeaterProtocol::SetReference::decode(buf, HeaterProtocol::SetReference::SIZE - 1, centi, validSec));
+    TEST_ASSERT_FALSE(HeaterProtocol::SetReference::decode(buf, HeaterProtocol::SetReference::SIZE + 1, centi, validSec));
+    TEST_ASSERT_FALSE(HeaterProtocol::SetReference::decode(buf, 1, centi, validSec));
+
+    // Arguments are left untouched on failure
+    TEST_ASSERT_EQUAL(7, (int)centi);
+    TEST_ASSERT_EQUAL_UINT16(8, validSec);
+
+    // A no-argument command carries nothing after the opcode
+    uint8_t stop[2] = {CO2Protocol::Stop::OPCODE, 0};
+    TEST_ASSERT_FALSE(CO2Protocol::Stop::decode(stop, sizeof(stop)));
+    TEST_ASSERT_TRUE(CO2Protocol::Stop::decode(stop, 1));
+}
+
+void test_effect_params_copied_as_wire_struct(void) {
+    const EffectParams params = storm();
+    uint8_t buf[LightProtocol::EffectStart::SIZE];
+    TEST_ASSERT_EQUAL(1 + (int)sizeof(EffectParams), (int)LightProtocol::EffectStart::SIZE);
+    LightProtocol::EffectStart::encode(buf, params);
+
+    // Field<EffectParams> is a raw copy of the packed struct, not per-field
+    TEST_ASSERT_EQUAL_UINT8(40, buf[0]);
+    TEST_ASSERT_EQUAL_MEMORY(&params, buf + 1, sizeof(EffectParams));
+
+    // Layout the node expects: type, mask, seed LE, duration LE, args
+    const uint8_t expected[] = {
+        0x02, 0x03,
+        0xD4, 0xC3, 0xB2, 0xA1,
+        0x84, 0x03,
+        180, 6, 255, 3
+    };
+    TEST_ASSERT_EQUAL(sizeof(expected), sizeof(EffectParams));
+    TEST_ASSERT_EQUAL_MEMORY(expected, buf + 1, sizeof(expected));
+
+    EffectParams decoded;
+    memset(&decoded, 0, sizeof(decoded));
+    TEST_ASSERT_TRUE(LightProtocol::EffectStart::decode(buf, sizeof(buf), decoded));
+    TEST_ASSERT_EQUAL((int)EffectType::STORM, (int)decoded.type);
+    TEST_ASSERT_EQUAL_UINT32(0xA1B2C3D4, decoded.seed);
+    TEST_ASSERT_EQUAL_UINT16(900, decoded.durationSec);
+    TEST_ASSERT_EQUAL_MEMORY(params.args, decoded.args, sizeof(params.args));
+
+    uint8_t stop[LightProtocol::EffectStop::SIZE];
+    uint8_t type = 0xFF;
+    LightProtocol::EffectStop::encode(stop, (uint8_t)EffectType::NONE);
+    TEST_ASSERT_FALSE(LightProtocol::EffectStart::decode(stop, sizeof(stop), decoded));
+    TEST_ASSERT_TRUE(LightProtocol::EffectStop::decode(stop, sizeof(stop), type));
+    TEST_ASSERT_EQUAL_UINT8(0, type);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_light_round_trip);
+    RUN_TEST(test_heater_round_trip);
+    RUN_TEST(test_heater_target_is_signed_little_endian);
+    RUN_TEST(test_co2_round_trip);
+    RUN_TEST(test_feeder_round_trip);
+    RUN_TEST(test_sensor_round_trip);
+    RUN_TEST(test_wrong_opcode_is_rejected);
+    RUN_TEST(test_short_and_long_payloads_are_rejected);
+    RUN_TEST(test_effect_params_copied_as_wire_struct);
+    return UNITY_END();
+}
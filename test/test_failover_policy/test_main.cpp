@@ -0,0 +1,264 @@
+#include <unity.h>
+#include <string.h>
+#include "managers/FailoverPolicy.h"
+
+typedef FailoverPolicy::Event Event;
+typedef FailoverPolicy::Role Role;
+typedef FailoverPolicy::Identity Identity;
+
+static const uint32_t LISTEN_MS = 4000;
+static const uint32_t TAKEOVER_MS = 3000;
+static const uint32_t STEP_MS = 100;           // Beacon interval of the simulation
+
+static const uint8_t MAC_A[6] = {0x24, 0, 0, 0, 0, 0x01};
+static const uint8_t MAC_B[6] = {0x24, 0, 0, 0, 0, 0x02};
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static Identity noIdentity() {
+    Identity identity;
+    memset(&identity, 0, sizeof(identity));
+    return identity;
+}
+
+static Identity identity(const uint8_t* hubId, uint16_t generation) {
+    Identity result;
+    memcpy(result.hubId, hubId, 6);
+    result.generation = generation;
+    result.known = true;
+    return result;
+}
+
+/**
+ * @brief One hub of a simulated pair, wired the way FailoverManager is
+ */
+struct Hub {
+    const uint8_t* mac;
+    FailoverPolicy policy;
+    Identity saved;             // What the hub persisted
+    bool up;
+    int stepDowns;
+
+    explicit Hub(const uint8_t* ownMac) : mac(ownMac), saved(noIdentity()), up(false), stepDowns(0) {}
+
+    void boot(bool preferStandby, uint32_t now) {
+        policy.begin(mac, preferStandby, saved, LISTEN_MS, TAKEOVER_MS, now);
+        up = true;
+    }
+
+    void persist() {
+        if (policy.takeDirty()) {
+            saved = policy.getIdentity();
+        }
+    }
+};
+
+/**
+ * @brief Advance both hubs one beacon interval; active hubs beacon to the partner
+ */
+static void step(Hub& a, Hub& b, uint32_t now, bool linked = true) {
+    Hub* hubs[2] = {&a, &b};
+    for (int i = 0; i < 2; i++) {
+        Hub& hub = *hubs[i];
+        Hub& partner = *hubs[1 - i];
+        if (!hub.up) {
+            continue;
+        }
+        hub.policy.update(now);
+        hub.persist();
+
+        if (hub.policy.isActive() && partner.up && linked) {
+            const Identity& id = hub.policy.getIdentity();
+            Event event = partner.policy.onPeerBeacon(hub.mac, id.hubId, id.generation, now);
+            partner.persist();
+            if (event == Event::STEP_DOWN) {
+                // FailoverManager restarts to drop live state
+                partner.stepDowns++;
+                partner.boot(false, now);
+            }
+        }
+    }
+}
+
+static uint32_t run(Hub& a, Hub& b, uint32_t now, uint32_t durationMs, bool linked = true) {
+    uint32_t end = now + durationMs;
+    while (now < end) {
+        now += STEP_MS;
+        step(a, b, now, linked);
+    }
+    return now;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================================================
+// TESTS
+// ============================================================================
+
+void test_primary_activates_after_listen_window(void) {
+    FailoverPolicy policy;
+    policy.begin(MAC_A, false, noIdentity(), LISTEN_MS, TAKEOVER_MS, 1000);
+
+    TEST_ASSERT_EQUAL(Event::NONE, policy.update(1000 + LISTEN_MS - 1));
+    TEST_ASSERT_EQUAL(Role::LISTENING, policy.getRole());
+    TEST_ASSERT_EQUAL(Event::BECAME_ACTIVE, policy.update(1000 + LISTEN_MS));
+
+    // First activation founds the identity on its own MAC
+    TEST_ASSERT_TRUE(policy.getIdentity().known);
+    TEST_ASSERT_EQUAL_MEMORY(MAC_A, policy.getIdentity().hubId, 6);
+    TEST_ASSERT_EQUAL_UINT16(1, policy.getIdentity().generation);
+    TEST_ASSERT_TRUE(policy.takeDirty());
+    TEST_ASSERT_FALSE(policy.takeDirty());
+}
+
+void test_standby_adopts_partner_identity(void) {
+    FailoverPolicy policy;
+    policy.begin(MAC_B, true, noIdentity(), LISTEN_MS, TAKEOVER_MS, 0);
+
+    TEST_ASSERT_EQUAL(Event::BECAME_STANDBY, policy.onPeerBeacon(MAC_A, MAC_A, 1, 500));
+    TEST_ASSERT_EQUAL(Role::STANDBY, policy.getRole());
+    TEST_ASSERT_EQUAL_MEMORY(MAC_A, policy.getIdentity().hubId, 6);
+    TEST_ASSERT_EQUAL_UINT16(1, policy.getIdentity().generation);
+    TEST_ASSERT_TRUE(policy.takeDirty());
+
+    // Repeated beacons of the same identity change nothing
+    TEST_ASSERT_EQUAL(Event::NONE, policy.onPeerBeacon(MAC_A, MAC_A, 1, 600));
+    TEST_ASSERT_FALSE(policy.takeDirty());
+}
+
+void test_takeover_timing_after_primary_loss(void) {
+    FailoverPolicy policy;
+    policy.begin(MAC_B, true, noIdentity(), LISTEN_MS, TAKEOVER_MS, 0);
+    policy.onPeerBeacon(MAC_A, MAC_A, 1, 500);
+    policy.takeDirty();
+
+    // Last beacon from the primary at 10 s
+    policy.onPeerBeacon(MAC_A, MAC_A, 1, 10000);
+    TEST_ASSERT_EQUAL(Event::NONE, policy.update(10000 + TAKEOVER_MS - 1));
+    TEST_ASSERT_FALSE(policy.isActive());
+    TEST_ASSERT_EQUAL(Event::BECAME_ACTIVE, policy.update(10000 + TAKEOVER_MS));
+
+    // Same logical hub, next generation
+    TEST_ASSERT_EQUAL_MEMORY(MAC_A, policy.getIdentity().hubId, 6);
+    TEST_ASSERT_EQUAL_UINT16(2, policy.getIdentity().generation);
+    TEST_ASSERT_TRUE(policy.takeDirty());
+    TEST_ASSERT_EQUAL(Event::NONE, policy.update(20000));
+}
+
+void test_standby_without_identity_never_takes_over(void) {
+    FailoverPolicy policy;
+    policy.begin(MAC_B, true, noIdentity(), LISTEN_MS, TAKEOVER_MS, 0);
+
+    TEST_ASSERT_EQUAL(Event::BECAME_STANDBY, policy.update(LISTEN_MS));
+    TEST_ASSERT_EQUAL(Event::NONE, policy.update(LISTEN_MS + 10 * TAKEOVER_MS));
+    TEST_ASSERT_EQUAL(Role::STANDBY, policy.getRole());
+}
+
+void test_active_steps_down_to_higher_generation(void) {
+    FailoverPolicy policy;
+    policy.begin(MAC_A, false, identity(MAC_A, 2), LISTEN_MS, TAKEOVER_MS, 0);
+    TEST_ASSERT_EQUAL(Event::BECAME_ACTIVE, policy.update(LISTEN_MS));
+
+    // Stale partner is ignored, newer one wins
+    TEST_ASSERT_EQUAL(Event::NONE, policy.onPeerBeacon(MAC_B, MAC_A, 1, 5000));
+    TEST_ASSERT_TRUE(policy.isActive());
+    TEST_ASSERT_EQUAL(Event::STEP_DOWN, policy.onPeerBeacon(MAC_B, MAC_A, 3, 5100));
+    TEST_ASSERT_EQUAL(Role::STANDBY, policy.getRole());
+    TEST_ASSERT_EQUAL_UINT16(3, policy.getIdentity().generation);
+}
+
+void test_equal_generation_lower_mac_wins(void) {
+    FailoverPolicy a;
+    FailoverPolicy b;
+    a.begin(MAC_A, false, identity(MAC_A, 5), LISTEN_MS, TAKEOVER_MS, 0);
+    b.begin(MAC_B, false, identity(MAC_A, 5), LISTEN_MS, TAKEOVER_MS, 0);
+    a.update(LISTEN_MS);
+    b.update(LISTEN_MS);
+
+    TEST_ASSERT_EQUAL(Event::NONE, a.onPeerBeacon(MAC_B, MAC_A, 5, 5000));
+    TEST_ASSERT_EQUAL(Event::STEP_DOWN, b.onPeerBeacon(MAC_A, MAC_A, 5, 5000));
+    TEST_ASSERT_TRUE(a.isActive());
+    TEST_ASSERT_FALSE(b.isActive());
+}
+
+void test_active_ignores_other_installation(void) {
+    const uint8_t otherHub[6] = {0x30, 0, 0, 0, 0, 0x09};
+    FailoverPolicy policy;
+    policy.begin(MAC_A, false, identity(MAC_A, 1), LISTEN_MS, TAKEOVER_MS, 0);
+    policy.update(LISTEN_MS);
+
+    TEST_ASSERT_EQUAL(Event::NONE, policy.onPeerBeacon(MAC_B, otherHub, 40, 5000));
+    TEST_ASSERT_TRUE(policy.isActive());
+    TEST_ASSERT_EQUAL_MEMORY(MAC_A, policy.getIdentity().hubId, 6);
+}
+
+void test_generation_wraps(void) {
+    FailoverPolicy policy;
+    policy.begin(MAC_A, false, identity(MAC_A, 0xFFFF), LISTEN_MS, TAKEOVER_MS, 0);
+    policy.update(LISTEN_MS);
+
+    TEST_ASSERT_EQUAL(Event::STEP_DOWN, policy.onPeerBeacon(MAC_B, MAC_A, 0, 5000));
+    TEST_ASSERT_EQUAL_UINT16(0, policy.getIdentity().generation);
+}
+
+void test_pair_failover_and_rejoin(void) {
+    Hub a(MAC_A);
+    Hub b(MAC_B);
+    uint32_t now = 0;
+    a.boot(false, now);
+    b.boot(true, now);
+    now = run(a, b, now, 6000);
+
+    TEST_ASSERT_TRUE(a.policy.isActive());
+    TEST_ASSERT_EQUAL(Role::STANDBY, b.policy.getRole());
+    TEST_ASSERT_EQUAL_MEMORY(MAC_A, b.saved.hubId, 6);
+    TEST_ASSERT_EQUAL_UINT16(1, b.saved.generation);
+
+    // Primary dies; standby takes over one takeover window after the last beacon
+    uint32_t lastBeacon = now;
+    a.up = false;
+    while (!b.policy.isActive()) {
+        now += STEP_MS;
+        step(a, b, now);
+        TEST_ASSERT_TRUE(now - lastBeacon <= TAKEOVER_MS);
+    }
+    TEST_ASSERT_EQUAL_UINT32(TAKEOVER_MS, now - lastBeacon);
+    TEST_ASSERT_EQUAL_MEMORY(MAC_A, b.saved.hubId, 6);
+    TEST_ASSERT_EQUAL_UINT16(2, b.saved.generation);
+
+    // Old primary comes back with its stale saved identity and joins as standby
+    a.boot(false, now);
+    now = run(a, b, now, 6000);
+    TEST_ASSERT_TRUE(b.policy.isActive());
+    TEST_ASSERT_EQUAL(Role::STANDBY, a.policy.getRole());
+    TEST_ASSERT_EQUAL_UINT16(2, a.saved.generation);
+
+    // Split: A takes over too (gen 3); when the link heals B yields to it
+    now = run(a, b, now, 5000, false);
+    TEST_ASSERT_TRUE(a.policy.isActive());
+    TEST_ASSERT_TRUE(b.policy.isActive());
+    now = run(a, b, now, 6000);
+    TEST_ASSERT_TRUE(a.policy.isActive());
+    TEST_ASSERT_FALSE(b.policy.isActive());
+    TEST_ASSERT_EQUAL(1, b.stepDowns);
+    TEST_ASSERT_EQUAL_UINT16(3, b.saved.generation);
+    TEST_ASSERT_EQUAL_MEMORY(MAC_A, b.saved.hubId, 6);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_primary_activates_after_listen_window);
+    RUN_TEST(test_standby_adopts_partner_identity);
+    RUN_TEST(test_takeover_timing_after_primary_loss);
+    RUN_TEST(test_standby_without_identity_never_takes_over);
+    RUN_TEST(test_active_steps_down_to_higher_generation);
+    RUN_TEST(test_equal_generation_lower_mac_wins);
+    RUN_TEST(test_active_ignores_other_installation);
+    RUN_TEST(test_generation_wraps);
+    RUN_TEST(test_pair_failover_and_rejoin);
+    return UNITY_END();
+}
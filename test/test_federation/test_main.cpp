@@ -0,0 +1,616 @@
+#include <unity.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "managers/FederationTable.h"
+
+// Hubs on 127.0.0.1, each with its own UDP socket and FederationTable,
+// wired the way FederationManager wires them (HELLO, DELTA, SYNC, COMMAND,
+// RESULT). Device state is a plain list standing in for AquariumManager.
+
+static const uint32_t GROUP = 0x1234;
+static const uint32_t HELLO_MS = 200;
+static const uint32_t PUBLISH_MS = 50;
+static const uint32_t COMMAND_TIMEOUT_MS = 400;
+static const uint8_t STATUS_ONLINE = 1;
+static const uint8_t STATUS_OFFLINE = 2;
+
+static uint32_t nowMs() {
+    using namespace std::chrono;
+    static steady_clock::time_point start = steady_clock::now();
+    return (uint32_t)duration_cast<milliseconds>(steady_clock::now() - start).count();
+}
+
+// ============================================================================
+// SIMULATED HUB
+// ============================================================================
+
+struct Hub {
+    struct Device {
+        uint8_t mac[6];
+        uint8_t status;
+        uint8_t health;
+        uint32_t version;
+        std::string name;
+    };
+
+    struct Tombstone {
+        uint8_t mac[6];
+        uint32_t version;
+    };
+
+    // Forwarded command: result code, or -1 while waiting / TIMED_OUT
+    struct Pending {
+        uint32_t sentMs;
+        int result;
+        uint8_t commandId;
+    };
+    static const int TIMED_OUT = 100;
+
+    std::string name;
+    uint8_t hubId[6];
+    uint32_t bootId;
+    int fd;
+    uint16_t port;
+    std::vector<uint16_t> peerPorts;
+    bool up;
+
+    uint32_t stateVersion;
+    uint32_t published;
+    std::vector<Device> devices;
+    std::vector<Tombstone> tombstones;
+    FederationTable table;
+
+    uint32_t lastHelloMs;
+    uint32_t lastPublishMs;
+    int syncsSent;
+    int fullReplies;
+    bool dropDeltas;                // Lose incoming incremental DELTAs
+    uint16_t nextTicket;
+    uint8_t lastCommandId;
+    std::map<uint16_t, Pending> pending;
+    std::vector<uint8_t> executed;  // Opcodes run for other hubs
+
+    Hub(const char* hubName, uint8_t index)
+        : name(hubName), bootId(1000 + index), fd(-1), port(0), up(true),
+          stateVersion(0), published(0), lastHelloMs(0), lastPublishMs(0),
+          syncsSent(0), fullReplies(0), dropDeltas(false), nextTicket(1), lastCommandId(0) {
+        const uint8_t id[6] = {0x24, 0, 0, 0, 0, index};
+        memcpy(hubId, id, 6);
+
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(fd, (sockaddr*)&addr, sizeof(addr));
+        socklen_t addrLen = sizeof(addr);
+        getsockname(fd, (sockaddr*)&addr, &addrLen);
+        port = ntohs(addr.sin_port);
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+    }
+
+    ~Hub() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    Device& addDevice(uint8_t id, const std::string& deviceName) {
+        Device device;
+        const uint8_t mac[6] = {0xAA, 0, 0, 0, hubId[5], id};
+        memcpy(device.mac, mac, 6);
+        device.status = STATUS_ONLINE;
+        device.health = 100;
+        device.version = ++stateVersion;
+        device.name = deviceName;
+        devices.push_back(device);
+        return devices.back();
+    }
+
+    void touch(Device& device) {
+        device.version = ++stateVersion;
+    }
+
+    void removeDevice(size_t index) {
+        Tombstone tombstone;
+        memcpy(tombstone.mac, devices[index].mac, 6);
+        tombstone.version = ++stateVersion;
+        tombstones.push_back(tombstone);
+        devices.erase(devices.begin() + index);
+    }
+
+    void restart(uint32_t newBootId) {
+        bootId = newBootId;
+        stateVersion = 0;
+        published = 0;
+        tombstones.clear();
+        for (Device& device : devices) {
+            touch(device);
+        }
+    }
+
+    // ----- Sending -----
+
+    void fill(FederationHeader& header, FederationType type) const {
+        memset(&header, 0, sizeof(header));
+        header.magic[0] = 'A';
+        header.magic[1] = 'F';
+        header.version = FEDERATION_PROTOCOL_VERSION;
+        header.type = type;
+        header.group = GROUP;
+        memcpy(header.hubId, hubId, 6);
+        header.bootId = bootId;
+    }
+
+    void sendTo(const void* data, size_t len, uint32_t ip, uint16_t toPort) const {
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(ip);
+        addr.sin_port = htons(toPort);
+        sendto(fd, data, len, 0, (sockaddr*)&addr, sizeof(addr));
+    }
+
+    void sendToPeers(const void* data, size_t len) const {
+        for (uint16_t peerPort : peerPorts) {
+            sendTo(data, len, INADDR_LOOPBACK, peerPort);
+        }
+    }
+
+    void collect(uint32_t since, bool full, std::vector<FederationDeviceRecord>& out) const {
+        for (const Device& device : devices) {
+            if (!full && device.version <= since) {
+                continue;
+            }
+            FederationDeviceRecord record;
+            memset(&record, 0, sizeof(record));
+            memcpy(record.mac, device.mac, 6);
+            record.status = device.status;
+            record.health = device.health;
+            record.version = device.version;
+            strncpy(record.name, device.name.c_str(), FEDERATION_NAME_LEN);
+            out.push_back(record);
+        }
+        if (full) {
+            return;
+        }
+        for (const Tombstone& tombstone : tombstones) {
+            if (tombstone.version > since) {
+                FederationDeviceRecord record;
+                memset(&record, 0, sizeof(record));
+                memcpy(record.mac, tombstone.mac, 6);
+                record.status = FEDERATION_STATUS_REMOVED;
+                record.version = tombstone.version;
+                out.push_back(record);
+            }
+        }
+    }
+
+    void sendDelta(uint32_t fromVersion, uint32_t toVersion, bool full,
+                   const std::vector<FederationDeviceRecord>& records, uint32_t ip, uint16_t toPort) const {
+        uint8_t buffer[FEDERATION_MAX_FRAME];
+        FederationDelta delta;
+        fill(delta.header, FederationType::DELTA);
+        delta.fromVersion = fromVersion;
+        delta.toVersion = toVersion;
+        delta.flags = full ? FEDERATION_DELTA_FULL : 0;
+        delta.count = (uint8_t)records.size();
+        delta.reserved = 0;
+        memcpy(buffer, &delta, sizeof(delta));
+        memcpy(buffer + sizeof(delta), records.data(), records.size() * sizeof(FederationDeviceRecord));
+
+        if (ip == 0) {
+            sendToPeers(buffer, federationDeltaSize(delta.count));
+        } else {
+            sendTo(buffer, federationDeltaSize(delta.count), ip, toPort);
+        }
+    }
+
+    void publish() {
+        std::vector<FederationDeviceRecord> records;
+        collect(published, false, records);
+        if (records.empty()) {
+            return;
+        }
+        uint32_t toVersion = stateVersion;
+        FederationTable::selectDelta(records, toVersion);
+        sendDelta(published, toVersion, false, records, 0, 0);
+        published = toVersion;
+    }
+
+    void hello() const {
+        FederationHello frame;
+        fill(frame.header, FederationType::HELLO);
+        frame.publishedVersion = published;
+        frame.httpPort = 80;
+        frame.deviceCount = (uint8_t)devices.size();
+        frame.reserved = 0;
+        memset(frame.name, 0, sizeof(frame.name));
+        strncpy(frame.name, name.c_str(), FEDERATION_NAME_LEN);
+        sendToPeers(&frame, sizeof(frame));
+    }
+
+    void sync(const FederationTable::Peer& peer) {
+        FederationSync frame;
+        fill(frame.header, FederationType::SYNC);
+        frame.knownBootId = peer.bootId;
+        frame.since = peer.version;
+        sendTo(&frame, sizeof(frame), peer.ip, peer.port);
+        syncsSent++;
+    }
+
+    /**
+     * @brief Forward a command to the hub that owns mac
+     * @return Ticket, 0 if no hub is known to own it
+     */
+    uint16_t command(const uint8_t* mac, uint8_t opcode) {
+        uint32_t now = nowMs();
+        int owner = table.findOwner(mac, now);
+        if (owner < 0) {
+            return 0;
+        }
+        const FederationTable::Peer& peer = table.getPeer(owner);
+
+        FederationCommand frame;
+        memset(&frame, 0, sizeof(frame));
+        fill(frame.header, FederationType::COMMAND);
+        frame.ticket = nextTicket++;
+        memcpy(frame.mac, mac, 6);
+        frame.commandLen = 1;
+        frame.commandData[0] = opcode;
+        sendTo(&frame, sizeof(frame), peer.ip, peer.port);
+
+        Pending entry = {now, -1, 0};
+        pending[frame.ticket] = entry;
+        return frame.ticket;
+    }
+
+    // ----- Receiving -----
+
+    void handle(const uint8_t* data, size_t len, uint32_t ip, uint16_t fromPort, uint32_t now) {
+        if (len < sizeof(FederationHeader)) {
+            return;
+        }
+        FederationHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (header.group != GROUP || memcmp(header.hubId, hubId, 6) == 0) {
+            return;
+        }
+
+        uint8_t index;
+        switch (header.type) {
+            case FederationType::HELLO: {
+                FederationHello frame;
+                memcpy(&frame, data, sizeof(frame));
+                if (table.onHello(frame, ip, fromPort, now, index) == FederationTable::Action::REQUEST_SYNC) {
+                    sync(table.getPeer(index));
+                }
+                break;
+            }
+
+            case FederationType::DELTA: {
+                FederationDelta delta;
+                memcpy(&delta, data, sizeof(delta));
+                if (len != federationDeltaSize(delta.count)) {
+                    return;
+                }
+                if (dropDeltas && !(delta.flags & FEDERATION_DELTA_FULL)) {
+                    return;
+                }
+                FederationDeviceRecord records[FEDERATION_MAX_RECORDS];
+                memcpy(records, data + sizeof(delta), delta.count * sizeof(FederationDeviceRecord));
+                if (table.onDelta(delta, records, ip, fromPort, now, index) == FederationTable::Action::REQUEST_SYNC) {
+                    sync(table.getPeer(index));
+                }
+                break;
+            }
+
+            case FederationType::SYNC: {
+                FederationSync frame;
+                memcpy(&frame, data, sizeof(frame));
+                bool full = frame.knownBootId != bootId || (int32_t)(frame.since - stateVersion) > 0;
+                std::vector<FederationDeviceRecord> records;
+                collect(full ? 0 : frame.since, full, records);
+                uint32_t toVersion = stateVersion;
+                FederationTable::selectDelta(records, toVersion);
+                sendDelta(full ? 0 : frame.since, toVersion, full, records, ip, fromPort);
+                if (full) {
+                    fullReplies++;
+                }
+                break;
+            }
+
+            case FederationType::COMMAND: {
+                FederationCommand frame;
+                memcpy(&frame, data, sizeof(frame));
+                if (table.findPeer(frame.header.hubId) < 0) {
+                    return;
+                }
+                FederationCommandResult reply;
+                fill(reply.header, FederationType::RESULT);
+                reply.ticket = frame.ticket;
+                reply.result = FederationResult::NOT_FOUND;
+                reply.commandId = 0;
+                for (const Device& device : devices) {
+                    if (memcmp(device.mac, frame.mac, 6) != 0) {
+                        continue;
+                    }
+                    if (device.status != STATUS_ONLINE) {
+                        reply.result = FederationResult::OFFLINE;
+                    } else {
+                        reply.result = FederationResult::SENT;
+                        reply.commandId = ++lastCommandId;
+                        executed.push_back(frame.commandData[0]);
+                    }
+                }
+                sendTo(&reply, sizeof(reply), ip, fromPort);
+                break;
+            }
+
+            case FederationType::RESULT: {
+                FederationCommandResult frame;
+                memcpy(&frame, data, sizeof(frame));
+                std::map<uint16_t, Pending>::iterator it = pending.find(frame.ticket);
+                if (it != pending.end() && it->second.result < 0) {
+                    it->second.result = (int)frame.result;
+                    it->second.commandId = frame.commandId;
+                }
+                break;
+            }
+        }
+    }
+
+    void poll(uint32_t now) {
+        uint8_t buffer[2048];
+        sockaddr_in addr;
+        socklen_t addrLen = sizeof(addr);
+        ssize_t len;
+        while ((len = recvfrom(fd, buffer, sizeof(buffer), 0, (sockaddr*)&addr, &addrLen)) > 0) {
+            if (up) {
+                handle(buffer, (size_t)len, ntohl(addr.sin_addr.s_addr), ntohs(addr.sin_port), now);
+            }
+            addrLen = sizeof(addr);
+        }
+        if (!up) {
+            return;
+        }
+
+        if (now - lastHelloMs >= HELLO_MS) {
+            lastHelloMs = now;
+            hello();
+            table.expire(now);
+        }
+        if (now - lastPublishMs >= PUBLISH_MS) {
+            lastPublishMs = now;
+            publish();
+        }
+        for (std::map<uint16_t, Pending>::iterator it = pending.begin(); it != pending.end(); ++it) {
+            if (it->second.result < 0 && now - it->second.sentMs >= COMMAND_TIMEOUT_MS) {
+                it->second.result = TIMED_OUT;
+            }
+        }
+    }
+
+    // ----- Queries -----
+
+    size_t remoteCount() const {
+        size_t count = 0;
+        for (size_t i = 0; i < table.peerCount(); i++) {
+            count += table.getPeer(i).devices.size();
+        }
+        return count;
+    }
+
+    const FederationDeviceRecord* remote(const uint8_t* mac) const {
+        for (size_t i = 0; i < table.peerCount(); i++) {
+            for (const FederationDeviceRecord& record : table.getPeer(i).devices) {
+                if (memcmp(record.mac, mac, 6) == 0) {
+                    return &record;
+                }
+            }
+        }
+        return nullptr;
+    }
+};
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static std::vector<Hub*> hubs;
+
+static void run(uint32_t durationMs) {
+    uint32_t end = nowMs() + durationMs;
+    while (nowMs() < end) {
+        for (Hub* hub : hubs) {
+            hub->poll(nowMs());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+/**
+ * @brief Three hubs with three devices each, converged
+ */
+void setUp(void) {
+    const char* names[3] = {"rack-a", "rack-b", "rack-c"};
+    for (uint8_t i = 0; i < 3; i++) {
+        Hub* hub = new Hub(names[i], i + 1);
+        for (uint8_t j = 0; j < 3; j++) {
+            hub->addDevice(j, std::string(names[i]) + "-dev" + std::to_string(j));
+        }
+        hubs.push_back(hub);
+    }
+    for (Hub* hub : hubs) {
+        for (Hub* other : hubs) {
+            if (other != hub) {
+                hub->peerPorts.push_back(other->port);
+            }
+        }
+    }
+    run(600);
+}
+
+void tearDown(void) {
+    for (Hub* hub : hubs) {
+        delete hub;
+    }
+    hubs.clear();
+}
+
+// ============================================================================
+// TESTS
+// ============================================================================
+
+void test_hubs_learn_each_others_devices(void) {
+    for (Hub* hub : hubs) {
+        TEST_ASSERT_EQUAL(2, (int)hub->table.peerCount());
+        TEST_ASSERT_EQUAL(6, (int)hub->remoteCount());
+    }
+    Hub& a = *hubs[0];
+    Hub& b = *hubs[1];
+    const FederationDeviceRecord* record = a.remote(b.devices[2].mac);
+    TEST_ASSERT_NOT_NULL(record);
+    TEST_ASSERT_EQUAL_STRING("rack-b-dev2", record->name);
+    TEST_ASSERT_EQUAL_UINT32(b.stateVersion, a.table.getPeer(a.table.findPeer(b.hubId)).version);
+}
+
+void test_delta_applies_change_and_removal(void) {
+    Hub& a = *hubs[0];
+    Hub& b = *hubs[1];
+    Hub& c = *hubs[2];
+
+    b.devices[1].status = STATUS_OFFLINE;
+    b.touch(b.devices[1]);
+    b.stateVersion += 2;            // Changes that are not device records
+    run(150);
+    TEST_ASSERT_EQUAL_UINT8(STATUS_OFFLINE, a.remote(b.devices[1].mac)->status);
+    TEST_ASSERT_EQUAL_UINT8(STATUS_OFFLINE, c.remote(b.devices[1].mac)->status);
+
+    uint8_t removed[6];
+    memcpy(removed, a.devices[0].mac, 6);
+    a.removeDevice(0);
+    run(150);
+    TEST_ASSERT_NULL(b.remote(removed));
+    TEST_ASSERT_NULL(c.remote(removed));
+    TEST_ASSERT_EQUAL(5, (int)b.remoteCount());
+}
+
+void test_lost_delta_recovered_by_sync(void) {
+    Hub& b = *hubs[1];
+    Hub& c = *hubs[2];
+    int syncsBefore = c.syncsSent;
+
+    c.dropDeltas = true;
+    b.devices[2].health = 40;
+    b.touch(b.devices[2]);
+    run(100);
+    TEST_ASSERT_EQUAL_UINT8(100, c.remote(b.devices[2].mac)->health);
+
+    // The next HELLO shows C it is behind
+    c.dropDeltas = false;
+    run(HELLO_MS * 3);
+    TEST_ASSERT_EQUAL_UINT8(40, c.remote(b.devices[2].mac)->health);
+    TEST_ASSERT_GREATER_THAN(syncsBefore, c.syncsSent);
+}
+
+void test_older_record_never_rolls_back(void) {
+    Hub& a = *hubs[0];
+    Hub& b = *hubs[1];
+
+    b.devices[0].health = 55;
+    b.touch(b.devices[0]);
+    run(150);
+    TEST_ASSERT_EQUAL_UINT8(55, a.remote(b.devices[0].mac)->health);
+    uint32_t known = a.table.getPeer(a.table.findPeer(b.hubId)).version;
+
+    // A delayed DELTA overlapping what A has, carrying the device's old state
+    std::vector<FederationDeviceRecord> records;
+    FederationDeviceRecord stale = *a.remote(b.devices[0].mac);
+    stale.health = 100;
+    stale.version = b.devices[0].version - 1;
+    records.push_back(stale);
+    b.sendDelta(known - 1, known - 1, false, records, INADDR_LOOPBACK, a.port);
+    run(50);
+
+    TEST_ASSERT_EQUAL_UINT8(55, a.remote(b.devices[0].mac)->health);
+    TEST_ASSERT_EQUAL_UINT32(known, a.table.getPeer(a.table.findPeer(b.hubId)).version);
+}
+
+void test_restart_with_new_boot_resyncs(void) {
+    Hub& a = *hubs[0];
+    Hub& b = *hubs[1];
+    int fullBefore = b.fullReplies;
+
+    // Versions restart below what the others hold; bootId tells them apart
+    b.restart(5555);
+    b.devices.pop_back();
+    run(HELLO_MS * 4);
+
+    TEST_ASSERT_GREATER_THAN(fullBefore, b.fullReplies);
+    const FederationTable::Peer& peer = a.table.getPeer(a.table.findPeer(b.hubId));
+    TEST_ASSERT_EQUAL_UINT32(5555, peer.bootId);
+    TEST_ASSERT_EQUAL_UINT32(b.stateVersion, peer.version);
+    TEST_ASSERT_EQUAL(2, (int)peer.devices.size());
+    TEST_ASSERT_EQUAL(5, (int)a.remoteCount());
+}
+
+void test_command_forwarded_to_owning_hub(void) {
+    Hub& a = *hubs[0];
+    Hub& c = *hubs[2];
+
+    uint16_t ticket = a.command(c.devices[1].mac, 0x01);
+    TEST_ASSERT_NOT_EQUAL(0, ticket);
+    run(100);
+    TEST_ASSERT_EQUAL((int)FederationResult::SENT, a.pending[ticket].result);
+    TEST_ASSERT_EQUAL_UINT8(c.lastCommandId, a.pending[ticket].commandId);
+    TEST_ASSERT_EQUAL(1, (int)c.executed.size());
+    TEST_ASSERT_EQUAL_UINT8(0x01, c.executed[0]);
+    TEST_ASSERT_EQUAL(0, (int)hubs[1]->executed.size());
+
+    // Owner reports its own device state
+    c.devices[2].status = STATUS_OFFLINE;
+    c.touch(c.devices[2]);
+    run(100);
+    ticket = a.command(c.devices[2].mac, 0x02);
+    run(100);
+    TEST_ASSERT_EQUAL((int)FederationResult::OFFLINE, a.pending[ticket].result);
+
+    // Unknown device has no owner to forward to
+    const uint8_t unknown[6] = {0xAA, 0, 0, 0, 9, 9};
+    TEST_ASSERT_EQUAL(0, a.command(unknown, 0x01));
+}
+
+void test_command_to_silent_owner_times_out(void) {
+    Hub& a = *hubs[0];
+    Hub& c = *hubs[2];
+
+    c.up = false;
+    uint16_t ticket = a.command(c.devices[0].mac, 0x01);
+    TEST_ASSERT_NOT_EQUAL(0, ticket);
+    run(COMMAND_TIMEOUT_MS + 100);
+    TEST_ASSERT_EQUAL(Hub::TIMED_OUT, a.pending[ticket].result);
+    TEST_ASSERT_EQUAL(0, (int)c.executed.size());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_hubs_learn_each_others_devices);
+    RUN_TEST(test_delta_applies_change_and_removal);
+    RUN_TEST(test_lost_delta_recovered_by_sync);
+    RUN_TEST(test_older_record_never_rolls_back);
+    RUN_TEST(test_restart_with_new_boot_resyncs);
+    RUN_TEST(test_command_forwarded_to_owning_hub);
+    RUN_TEST(test_command_to_silent_owner_times_out);
+    return UNITY_END();
+}
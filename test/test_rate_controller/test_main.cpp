@@ -0,0 +1,268 @@
+#include <unity.h>
+#include "RateController.h"
+
+typedef RateController RC;
+typedef RateController::Rate Rate;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+/**
+ * @brief Feed count sends stepMs apart starting at now
+ * @return Number of calls that changed the rate
+ */
+static int send(RC::State& state, int count, bool delivered, uint32_t& now, uint32_t stepMs = 100) {
+    int changes = 0;
+    for (int i = 0; i < count; i++) {
+        if (RC::onTxResult(state, delivered, now)) {
+            changes++;
+        }
+        now += stepMs;
+    }
+    return changes;
+}
+
+/**
+ * @brief Clean link until the next step up (fails the test if none within limitMs)
+ */
+static void stepUp(RC::State& state, uint32_t& now, uint32_t limitMs = 2 * RC::DWELL_MS) {
+    uint32_t end = now + limitMs;
+    while (now < end) {
+        bool changed = RC::onTxResult(state, true, now);
+        now += 100;
+        if (changed) {
+            return;
+        }
+    }
+    TEST_FAIL_MESSAGE("no step up");
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================================================
+// TESTS
+// ============================================================================
+
+void test_starts_at_1m(void) {
+    RC::State state;
+    RC::reset(state, true, 0);
+    TEST_ASSERT_EQUAL((int)Rate::B_1M, (int)state.rate);
+    TEST_ASSERT_EQUAL_UINT16(RC::DELIVERY_ONE, state.delivery);
+    TEST_ASSERT_EQUAL_UINT16(0, state.changes);
+}
+
+void test_step_up_waits_for_dwell_and_samples(void) {
+    RC::State state;
+    RC::reset(state, false, 0);
+    uint32_t now = 0;
+
+    // Plenty of samples, but not DWELL_MS at the rate yet
+    TEST_ASSERT_EQUAL(0, send(state, 90, true, now));
+    TEST_ASSERT_EQUAL((int)Rate::B_1M, (int)state.rate);
+
+    // Dwell passed: the next clean send steps up one rung
+    now = RC::DWELL_MS;
+    TEST_ASSERT_TRUE(RC::onTxResult(state, true, now));
+    TEST_ASSERT_EQUAL((int)Rate::B_2M, (int)state.rate);
+    TEST_ASSERT_TRUE(state.steppedUp);
+
+    // Too few samples after a long idle period
+    now += 5 * RC::DWELL_MS;
+    TEST_ASSERT_EQUAL(0, send(state, RC::MIN_SAMPLES - 1, true, now));
+    TEST_ASSERT_TRUE(RC::onTxResult(state, true, now));
+    TEST_ASSERT_EQUAL((int)Rate::G_6M, (int)state.rate);
+}
+
+void test_fail_streak_steps_down(void) {
+    RC::State state;
+    RC::reset(state, false, 0);
+    uint32_t now = RC::DWELL_MS;
+    send(state, RC::MIN_SAMPLES, true, now);
+    TEST_ASSERT_EQUAL((int)Rate::B_2M, (int)state.rate);
+
+    now += RC::PROBE_MS;           // Step up held; not a failed probe
+    TEST_ASSERT_EQUAL(0, send(state, RC::FAIL_STREAK - 1, false, now));
+    TEST_ASSERT_TRUE(RC::onTxResult(state, false, now));
+    TEST_ASSERT_EQUAL((int)Rate::B_1M, (int)state.rate);
+    TEST_ASSERT_EQUAL((int)Rate::COUNT, (int)state.blockedRate);
+}
+
+void test_poor_delivery_steps_down_without_streak(void) {
+    RC::State state;
+    RC::reset(state, true, 0);
+    uint32_t now = 0;
+
+    // Three losses in four, never FAIL_STREAK in a row
+    int changes = 0;
+    for (int i = 0; i < 10 && changes == 0; i++) {
+        changes += send(state, 1, true, now);
+        changes += send(state, 3, false, now);
+    }
+    TEST_ASSERT_EQUAL(1, changes);
+    TEST_ASSERT_EQUAL((int)Rate::LR_500K, (int)state.rate);
+}
+
+void test_failed_probe_backs_off_and_doubles(void) {
+    RC::State state;
+    RC::reset(state, false, 0);
+    uint32_t now = 0;
+    stepUp(state, now);
+    TEST_ASSERT_EQUAL((int)Rate::B_2M, (int)state.rate);
+
+    // 2M fails right after the step up
+    send(state, RC::FAIL_STREAK, false, now);
+    uint32_t failedAt = now - 100;
+    TEST_ASSERT_EQUAL((int)Rate::B_1M, (int)state.rate);
+    TEST_ASSERT_EQUAL((int)Rate::B_2M, (int)state.blockedRate);
+    TEST_ASSERT_EQUAL_UINT32(failedAt + RC::BACKOFF_MS, state.blockedUntil);
+    TEST_ASSERT_EQUAL_UINT32(2 * RC::BACKOFF_MS, state.backoffMs);
+
+    // Clean link, but 2M stays blocked until the backoff ends
+    while (now < state.blockedUntil) {
+        TEST_ASSERT_FALSE(RC::onTxResult(state, true, now));
+        now += 100;
+    }
+    TEST_ASSERT_TRUE(RC::onTxResult(state, true, now));
+    TEST_ASSERT_EQUAL((int)Rate::B_2M, (int)state.rate);
+
+    // Failing again doubles the block
+    send(state, RC::FAIL_STREAK, false, now);
+    TEST_ASSERT_EQUAL_UINT32(now - 100 + 2 * RC::BACKOFF_MS, state.blockedUntil);
+    TEST_ASSERT_EQUAL_UINT32(4 * RC::BACKOFF_MS, state.backoffMs);
+}
+
+void test_rssi_hysteresis(void) {
+    RC::State state;
+    RC::reset(state, false, 0);
+    uint32_t now = 0;
+    stepUp(state, now);
+    TEST_ASSERT_EQUAL((int)Rate::B_2M, (int)state.rate);
+
+    // 2M needs -84 to step up; it is left only below -84 - HYSTERESIS_DB
+    int dropAt = RC::minRssi(Rate::B_2M) - RC::HYSTERESIS_DB;
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_FALSE(RC::onRssi(state, (int8_t)dropAt, now));
+    }
+    TEST_ASSERT_EQUAL((int)Rate::B_2M, (int)state.rate);
+
+    // Back at 2M's minimum, one weak frame is smoothed; a run of them steps down
+    for (int i = 0; i < 10; i++) {
+        RC::onRssi(state, RC::minRssi(Rate::B_2M), now);
+    }
+    TEST_ASSERT_FALSE(RC::onRssi(state, (int8_t)(dropAt - 3), now));
+    int changes = 0;
+    for (int i = 0; i < 10; i++) {
+        changes += RC::onRssi(state, (int8_t)(dropAt - 3), now) ? 1 : 0;
+    }
+    TEST_ASSERT_EQUAL(1, changes);
+    TEST_ASSERT_EQUAL((int)Rate::B_1M, (int)state.rate);
+}
+
+void test_rssi_gates_step_up(void) {
+    RC::State state;
+    RC::reset(state, false, 0);
+    uint32_t now = 0;
+
+    // Delivery is perfect, but the signal would not carry 2M
+    RC::onRssi(state, (int8_t)(RC::minRssi(Rate::B_2M) - 2), now);
+    TEST_ASSERT_EQUAL(0, send(state, 200, true, now));
+    TEST_ASSERT_EQUAL((int)Rate::B_1M, (int)state.rate);
+
+    // Stronger signal lets it through
+    for (int i = 0; i < 10; i++) {
+        RC::onRssi(state, (int8_t)(RC::minRssi(Rate::B_2M) + 2), now);
+    }
+    TEST_ASSERT_TRUE(RC::onTxResult(state, true, now));
+    TEST_ASSERT_EQUAL((int)Rate::B_2M, (int)state.rate);
+}
+
+void test_stale_rssi_is_ignored(void) {
+    RC::State state;
+    RC::reset(state, false, 0);
+    uint32_t now = 0;
+    RC::onRssi(state, (int8_t)(RC::minRssi(Rate::B_2M) - 2), now);
+
+    // The weak sample holds the rate until it is RSSI_STALE_MS old
+    while (now < RC::RSSI_STALE_MS) {
+        TEST_ASSERT_FALSE(RC::onTxResult(state, true, now));
+        now += 100;
+    }
+    TEST_ASSERT_FALSE(RC::rssiBelow(state, 0, now));
+    TEST_ASSERT_TRUE(RC::onTxResult(state, true, now));
+    TEST_ASSERT_EQUAL((int)Rate::B_2M, (int)state.rate);
+}
+
+void test_long_range_fallback(void) {
+    RC::State lr;
+    RC::State plain;
+    RC::reset(lr, true, 0);
+    RC::reset(plain, false, 0);
+    uint32_t now = 0;
+
+    // Far peer: below 1M's minimum minus hysteresis
+    int8_t far = (int8_t)(RC::minRssi(Rate::B_1M) - RC::HYSTERESIS_DB - 1);
+    TEST_ASSERT_TRUE(RC::onRssi(lr, far, now));
+    TEST_ASSERT_EQUAL((int)Rate::LR_500K, (int)lr.rate);
+    TEST_ASSERT_TRUE(RC::isLongRange(lr.rate));
+
+    // A peer without LR has no lower rung
+    TEST_ASSERT_FALSE(RC::onRssi(plain, far, now));
+    TEST_ASSERT_EQUAL(0, send(plain, 20, false, now));
+    TEST_ASSERT_EQUAL((int)Rate::B_1M, (int)plain.rate);
+
+    // Losses at 500K fall back to 250K, the floor
+    TEST_ASSERT_EQUAL(1, send(lr, RC::FAIL_STREAK, false, now));
+    TEST_ASSERT_EQUAL((int)Rate::LR_250K, (int)lr.rate);
+    TEST_ASSERT_EQUAL(0, send(lr, 20, false, now));
+    TEST_ASSERT_EQUAL((int)Rate::LR_250K, (int)lr.rate);
+
+    // Peer re-announces without LR
+    TEST_ASSERT_TRUE(RC::setLongRange(lr, false, now));
+    TEST_ASSERT_EQUAL((int)Rate::B_1M, (int)lr.rate);
+    TEST_ASSERT_FALSE(RC::setLongRange(lr, false, now));
+}
+
+void test_walk_away_ends_on_long_range(void) {
+    // Sensitivity per rate; a send is delivered when RSSI is above it
+    const int sensitivity[] = {-105, -102, -98, -95, -93, -89, -83, -75};
+    RC::State state;
+    RC::reset(state, true, 0);
+
+    Rate best = Rate::B_1M;
+    uint32_t delivered = 0;
+    uint32_t sent = 0;
+    for (uint32_t t = 0; t < 1800000; t += 500) {
+        int rssi = -50 - (int)(50 * (uint64_t)t / 1800000);
+        if (t % 1000 == 0) {
+            RC::onRssi(state, (int8_t)rssi, t);
+        }
+        bool ok = rssi > sensitivity[(int)state.rate];
+        RC::onTxResult(state, ok, t);
+        delivered += ok ? 1 : 0;
+        sent++;
+        if (state.rate > best) {
+            best = state.rate;
+        }
+    }
+    TEST_ASSERT_EQUAL((int)Rate::G_54M, (int)best);
+    TEST_ASSERT_TRUE(RC::isLongRange(state.rate));
+    TEST_ASSERT_GREATER_THAN(sent * 9 / 10, delivered);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_starts_at_1m);
+    RUN_TEST(test_step_up_waits_for_dwell_and_samples);
+    RUN_TEST(test_fail_streak_steps_down);
+    RUN_TEST(test_poor_delivery_steps_down_without_streak);
+    RUN_TEST(test_failed_probe_backs_off_and_doubles);
+    RUN_TEST(test_rssi_hysteresis);
+    RUN_TEST(test_rssi_gates_step_up);
+    RUN_TEST(test_stale_rssi_is_ignored);
+    RUN_TEST(test_long_range_fallback);
+    RUN_TEST(test_walk_away_ends_on_long_range);
+    return UNITY_END();
+}
@@ -0,0 +1,131 @@
+#include <unity.h>
+#include "models/ReadingMatcher.h"
+
+typedef ReadingMatcher::Reading Reading;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static Reading reading(float temperature) {
+    Reading value;
+    value.temperature = temperature;
+    value.ph = 7.0f;
+    value.tds = 300;
+    return value;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================================================
+// TESTS
+// ============================================================================
+
+void test_answer_then_ack_matches(void) {
+    ReadingMatcher match;
+    match.expect(12);
+
+    TEST_ASSERT_FALSE(match.onReading(40, reading(25.5f)));
+    TEST_ASSERT_FALSE(match.isMatched());
+    TEST_ASSERT_TRUE(match.onAck(12, 41));
+    TEST_ASSERT_TRUE(match.isMatched());
+    TEST_ASSERT_EQUAL_FLOAT(25.5f, match.getReading().temperature);
+}
+
+void test_periodic_reading_in_flight_is_not_the_answer(void) {
+    ReadingMatcher match;
+    match.expect(12);
+
+    // Periodic reading sent before the node saw the request
+    TEST_ASSERT_FALSE(match.onReading(37, reading(24.0f)));
+    // The answer, then its ACK
+    TEST_ASSERT_FALSE(match.onReading(38, reading(25.0f)));
+    TEST_ASSERT_TRUE(match.onAck(12, 39));
+    TEST_ASSERT_EQUAL_FLOAT(25.0f, match.getReading().temperature);
+}
+
+void test_ack_without_answer_waits_for_it(void) {
+    ReadingMatcher match;
+    match.expect(12);
+
+    TEST_ASSERT_FALSE(match.onReading(37, reading(24.0f)));     // Stale
+    TEST_ASSERT_FALSE(match.onAck(12, 39));
+    TEST_ASSERT_TRUE(match.isAcked());
+    TEST_ASSERT_FALSE(match.isMatched());
+
+    // Answer delivered after its ACK
+    TEST_ASSERT_TRUE(match.onReading(38, reading(25.0f)));
+    TEST_ASSERT_EQUAL_FLOAT(25.0f, match.getReading().temperature);
+}
+
+void test_lost_answer_is_not_replaced_by_later_reading(void) {
+    ReadingMatcher match;
+    match.expect(12);
+
+    TEST_ASSERT_FALSE(match.onAck(12, 39));
+    TEST_ASSERT_FALSE(match.onReading(40, reading(26.0f)));     // Next periodic one
+    TEST_ASSERT_FALSE(match.isMatched());
+}
+
+void test_other_command_ack_is_ignored(void) {
+    ReadingMatcher match;
+    match.expect(12);
+
+    TEST_ASSERT_FALSE(match.onReading(40, reading(25.0f)));
+    TEST_ASSERT_FALSE(match.onAck(11, 41));
+    TEST_ASSERT_FALSE(match.isAcked());
+    TEST_ASSERT_FALSE(match.onReading(42, reading(25.2f)));
+    TEST_ASSERT_TRUE(match.onAck(12, 43));
+    TEST_ASSERT_EQUAL_FLOAT(25.2f, match.getReading().temperature);
+}
+
+void test_sequence_wraps(void) {
+    ReadingMatcher match;
+    match.expect(255);
+
+    TEST_ASSERT_FALSE(match.onReading(255, reading(25.0f)));
+    TEST_ASSERT_TRUE(match.onAck(255, 0));
+    TEST_ASSERT_EQUAL_FLOAT(25.0f, match.getReading().temperature);
+}
+
+void test_matched_answer_is_kept(void) {
+    ReadingMatcher match;
+    match.expect(3);
+
+    match.onReading(9, reading(25.0f));
+    TEST_ASSERT_TRUE(match.onAck(3, 10));
+    TEST_ASSERT_FALSE(match.onReading(9, reading(30.0f)));      // Duplicate frame
+    TEST_ASSERT_FALSE(match.onAck(3, 10));
+    TEST_ASSERT_EQUAL_FLOAT(25.0f, match.getReading().temperature);
+}
+
+void test_nothing_matches_before_expect(void) {
+    ReadingMatcher match;
+
+    TEST_ASSERT_FALSE(match.onReading(0, reading(25.0f)));
+    TEST_ASSERT_FALSE(match.onAck(0, 1));
+    TEST_ASSERT_FALSE(match.isMatched());
+
+    // expect() forgets a previous round
+    match.expect(4);
+    match.onReading(5, reading(25.0f));
+    match.onAck(4, 6);
+    match.expect(5);
+    TEST_ASSERT_FALSE(match.isMatched());
+    TEST_ASSERT_FALSE(match.onAck(5, 6));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_answer_then_ack_matches);
+    RUN_TEST(test_periodic_reading_in_flight_is_not_the_answer);
+    RUN_TEST(test_ack_without_answer_waits_for_it);
+    RUN_TEST(test_lost_answer_is_not_replaced_by_later_reading);
+    RUN_TEST(test_other_command_ack_is_ignored);
+    RUN_TEST(test_sequence_wraps);
+    RUN_TEST(test_matched_answer_is_kept);
+    RUN_TEST(test_nothing_matches_before_expect);
+    return UNITY_END();
+}
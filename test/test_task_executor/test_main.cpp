@@ -0,0 +1,267 @@
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "managers/TaskExecutor.h"
+
+typedef TaskExecutor::Priority Priority;
+typedef TaskExecutor::JobContext JobContext;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static bool waitFor(std::function<bool()> condition, uint32_t timeoutMs = 2000) {
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > end) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+/**
+ * @brief Job that holds its worker until opened
+ */
+struct Gate {
+    std::atomic<bool> open;
+    std::atomic<int> entered;
+    std::atomic<int> worker;
+
+    Gate() : open(false), entered(0), worker(-1) {}
+
+    TaskExecutor::Job job() {
+        return [this](const JobContext& context) {
+            worker = context.getWorker();
+            entered++;
+            waitFor([this]() { return open.load(); }, 5000);
+        };
+    }
+};
+
+static TaskExecutor& executor() {
+    return TaskExecutor::getInstance();
+}
+
+void setUp(void) {}
+
+void tearDown(void) {
+    executor().end();
+}
+
+// ============================================================================
+// TESTS
+// ============================================================================
+
+void test_runs_inline_before_begin(void) {
+    int ran = 0;
+    TEST_ASSERT_FALSE(executor().isRunning());
+    TEST_ASSERT_TRUE(executor().submit([&](const JobContext&) { ran++; }));
+    TEST_ASSERT_EQUAL(1, ran);
+}
+
+void test_idle_worker_steals_from_blocked_one(void) {
+    TEST_ASSERT_TRUE(executor().begin(2));
+    uint32_t stolenBefore = executor().getStats().stolen;
+
+    Gate gate;
+    executor().submit(gate.job());
+    TEST_ASSERT_TRUE(waitFor([&]() { return gate.entered.load() == 1; }));
+
+    // Round-robin puts half of these behind the gate; all must still run
+    std::atomic<int> done(0);
+    std::atomic<int> onGateWorker(0);
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT_TRUE(executor().submit([&](const JobContext& context) {
+            if (context.getWorker() == gate.worker) {
+                onGateWorker++;
+            }
+            done++;
+        }));
+    }
+    TEST_ASSERT_TRUE(waitFor([&]() { return done.load() == 8; }));
+    TEST_ASSERT_EQUAL(0, onGateWorker.load());
+    TEST_ASSERT_GREATER_OR_EQUAL(stolenBefore + 4, executor().getStats().stolen);
+
+    gate.open = true;
+}
+
+void test_priority_order_then_fifo(void) {
+    TEST_ASSERT_TRUE(executor().begin(1));
+
+    Gate gate;
+    executor().submit(gate.job());
+    TEST_ASSERT_TRUE(waitFor([&]() { return gate.entered.load() == 1; }));
+
+    std::mutex lock;
+    std::vector<int> order;
+    const Priority priorities[] = {Priority::BACKGROUND, Priority::NORMAL, Priority::URGENT};
+    for (int i = 0; i < 9; i++) {
+        int id = (int)priorities[i % 3] * 10 + i / 3;      // Expected rank
+        executor().submit([&, id](const JobContext&) {
+            std::lock_guard<std::mutex> guard(lock);
+            order.push_back(id);
+        }, priorities[i % 3]);
+    }
+
+    gate.open = true;
+    TEST_ASSERT_TRUE(waitFor([&]() {
+        std::lock_guard<std::mutex> guard(lock);
+        return order.size() == 9;
+    }));
+    const int expected[] = {0, 1, 2, 10, 11, 12, 20, 21, 22};
+    for (int i = 0; i < 9; i++) {
+        TEST_ASSERT_EQUAL(expected[i], order[i]);
+    }
+}
+
+void test_deadline_expiry_and_late_count(void) {
+    TEST_ASSERT_TRUE(executor().begin(1));
+    uint32_t lateBefore = executor().getStats().late;
+
+    Gate gate;
+    executor().submit(gate.job());
+    TEST_ASSERT_TRUE(waitFor([&]() { return gate.entered.load() == 1; }));
+
+    std::atomic<int> shortExpired(-1), longExpired(-1), noneExpired(-1);
+    std::atomic<uint32_t> shortRemaining(1), longRemaining(0), noneRemaining(0);
+    executor().submit([&](const JobContext& context) {
+        shortRemaining = context.remainingMs();
+        shortExpired = context.expired();
+    }, Priority::NORMAL, 5);
+    executor().submit([&](const JobContext& context) {
+        longRemaining = context.remainingMs();
+        longExpired = context.expired();
+    }, Priority::NORMAL, 60000);
+    executor().submit([&](const JobContext& context) {
+        noneRemaining = context.remainingMs();
+        noneExpired = context.expired();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    gate.open = true;
+    TEST_ASSERT_TRUE(waitFor([&]() { return noneExpired.load() >= 0; }));
+
+    TEST_ASSERT_EQUAL(1, shortExpired.load());
+    TEST_ASSERT_EQUAL_UINT32(0, shortRemaining.load());
+    TEST_ASSERT_EQUAL(0, longExpired.load());
+    TEST_ASSERT_GREATER_THAN(50000u, longRemaining.load());
+    TEST_ASSERT_EQUAL(0, noneExpired.load());
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, noneRemaining.load());
+    TEST_ASSERT_EQUAL_UINT32(lateBefore + 1, executor().getStats().late);
+}
+
+void test_key_coalesces_while_queued(void) {
+    TEST_ASSERT_TRUE(executor().begin(1));
+    uint32_t coalescedBefore = executor().getStats().coalesced;
+
+    Gate gate;
+    executor().submit(gate.job());
+    TEST_ASSERT_TRUE(waitFor([&]() { return gate.entered.load() == 1; }));
+
+    std::atomic<int> runs(0);
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_TRUE(executor().submit([&](const JobContext&) { runs++; }, Priority::NORMAL, 0, 5));
+    }
+    gate.open = true;
+    TEST_ASSERT_TRUE(waitFor([&]() { return executor().getStats().queued == 0 && runs.load() > 0; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    TEST_ASSERT_EQUAL(1, runs.load());
+    TEST_ASSERT_EQUAL_UINT32(coalescedBefore + 9, executor().getStats().coalesced);
+}
+
+void test_key_reruns_once_without_overlap(void) {
+    TEST_ASSERT_TRUE(executor().begin(2));
+
+    std::atomic<int> runs(0), active(0), maxActive(0);
+    std::atomic<bool> release(false);
+    TaskExecutor::Job save = [&](const JobContext&) {
+        int now = ++active;
+        if (now > maxActive) {
+            maxActive = now;
+        }
+        runs++;
+        waitFor([&]() { return release.load(); }, 5000);
+        active--;
+    };
+
+    TEST_ASSERT_TRUE(executor().submit(save, Priority::NORMAL, 0, 7));
+    TEST_ASSERT_TRUE(waitFor([&]() { return runs.load() == 1; }));
+
+    // The other worker is idle, but must not start a second run of key 7
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(executor().submit(save, Priority::NORMAL, 0, 7));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    TEST_ASSERT_EQUAL(1, runs.load());
+
+    release = true;
+    TEST_ASSERT_TRUE(waitFor([&]() { return runs.load() == 2 && active.load() == 0; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    TEST_ASSERT_EQUAL(2, runs.load());          // One rerun for the five submits
+    TEST_ASSERT_EQUAL(1, maxActive.load());
+
+    // Key is free again
+    TEST_ASSERT_TRUE(executor().submit(save, Priority::NORMAL, 0, 7));
+    TEST_ASSERT_TRUE(waitFor([&]() { return runs.load() == 3 && active.load() == 0; }));
+}
+
+void test_full_queue_rejects_and_frees_key(void) {
+    TEST_ASSERT_TRUE(executor().begin(1));
+    uint32_t rejectedBefore = executor().getStats().rejected;
+
+    Gate gate;
+    executor().submit(gate.job());
+    TEST_ASSERT_TRUE(waitFor([&]() { return gate.entered.load() == 1; }));
+
+    std::atomic<int> runs(0);
+    for (uint8_t i = 0; i < TaskExecutor::QUEUE_CAPACITY; i++) {
+        TEST_ASSERT_TRUE(executor().submit([&](const JobContext&) { runs++; }));
+    }
+    TEST_ASSERT_FALSE(executor().submit([&](const JobContext&) { runs++; }));
+    TEST_ASSERT_FALSE(executor().submit([&](const JobContext&) { runs++; }, Priority::NORMAL, 0, 9));
+    TEST_ASSERT_EQUAL_UINT32(rejectedBefore + 2, executor().getStats().rejected);
+
+    // Other priorities have their own queues
+    TEST_ASSERT_TRUE(executor().submit([&](const JobContext&) { runs++; }, Priority::URGENT));
+
+    gate.open = true;
+    TEST_ASSERT_TRUE(waitFor([&]() { return runs.load() == TaskExecutor::QUEUE_CAPACITY + 1; }));
+
+    // The rejected keyed job did not leave key 9 held
+    TEST_ASSERT_TRUE(executor().submit([&](const JobContext&) { runs++; }, Priority::NORMAL, 0, 9));
+    TEST_ASSERT_TRUE(waitFor([&]() { return runs.load() == TaskExecutor::QUEUE_CAPACITY + 2; }));
+}
+
+void test_end_drains_queued_jobs(void) {
+    TEST_ASSERT_TRUE(executor().begin(2));
+    std::atomic<int> runs(0);
+    for (int i = 0; i < 20; i++) {
+        executor().submit([&](const JobContext&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            runs++;
+        }, Priority::BACKGROUND);
+    }
+    executor().end();
+    TEST_ASSERT_EQUAL(20, runs.load());
+    TEST_ASSERT_FALSE(executor().isRunning());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_runs_inline_before_begin);
+    RUN_TEST(test_idle_worker_steals_from_blocked_one);
+    RUN_TEST(test_priority_order_then_fifo);
+    RUN_TEST(test_deadline_expiry_and_late_count);
+    RUN_TEST(test_key_coalesces_while_queued);
+    RUN_TEST(test_key_reruns_once_without_overlap);
+    RUN_TEST(test_full_queue_rejects_and_frees_key);
+    RUN_TEST(test_end_drains_queued_jobs);
+    return UNITY_END();
+}